@@ -0,0 +1,271 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "benchmarkenvironment.h"
+#include "fakewindowmanager.h"
+#include "nettesthelper.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QTemporaryFile>
+#include <QTest>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+#include <cstring>
+
+// system
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+static BenchmarkEnvironment *s_self = nullptr;
+
+BenchmarkEnvironment::BenchmarkEnvironment()
+{
+    s_self = this;
+}
+
+BenchmarkEnvironment::~BenchmarkEnvironment()
+{
+    m_windowManager.reset();
+    if (m_server > 0) {
+        kill(m_server, SIGTERM);
+        waitpid(m_server, nullptr, 0);
+    }
+    s_self = nullptr;
+}
+
+BenchmarkEnvironment *BenchmarkEnvironment::self()
+{
+    return s_self;
+}
+
+FakeWindowManager *BenchmarkEnvironment::windowManager() const
+{
+    return m_windowManager.get();
+}
+
+QByteArray BenchmarkEnvironment::display() const
+{
+    return m_display;
+}
+
+bool BenchmarkEnvironment::startServer()
+{
+    // there is no QCoreApplication yet, which rules out QProcess
+    const QString xvfbExec = QStandardPaths::findExecutable(QStringLiteral("Xvfb"));
+    if (xvfbExec.isEmpty()) {
+        qCritical("Xvfb is needed to run the benchmarks");
+        return false;
+    }
+
+    // use pipe to pass fd to Xvfb to get back the display id
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0) {
+        return false;
+    }
+    const QByteArray executable = QFile::encodeName(xvfbExec);
+    const QByteArray displayFd = QByteArray::number(pipeFds[1]);
+    // a fixed screen keeps the work area and the icon scaling the same on every machine
+    const char *const arguments[] =
+        {executable.constData(), "-displayfd", displayFd.constData(), "-screen", "0", "1920x1080x24", "-nolisten", "tcp", nullptr};
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addclose(&actions, pipeFds[0]);
+    const int error = posix_spawn(&m_server, executable.constData(), &actions, nullptr, const_cast<char *const *>(arguments), environ);
+    posix_spawn_file_actions_destroy(&actions);
+
+    // reads from pipe, closes write side
+    close(pipeFds[1]);
+    if (error != 0) {
+        close(pipeFds[0]);
+        m_server = 0;
+        qCritical("Could not start Xvfb: %s", strerror(error));
+        return false;
+    }
+
+    QFile readPipe;
+    if (!readPipe.open(pipeFds[0], QIODevice::ReadOnly, QFileDevice::AutoCloseHandle)) {
+        return false;
+    }
+    const QByteArray displayNumber = readPipe.readLine().trimmed();
+    readPipe.close();
+    if (displayNumber.isEmpty()) {
+        qCritical("Xvfb did not report a display");
+        return false;
+    }
+
+    m_display = QByteArrayLiteral(":") + displayNumber;
+    qputenv("DISPLAY", m_display);
+    qputenv("QT_QPA_PLATFORM", QByteArrayLiteral("xcb"));
+    return true;
+}
+
+bool BenchmarkEnvironment::startWindowManager()
+{
+    m_windowManager = std::make_unique<FakeWindowManager>(m_display);
+    if (!m_windowManager->isValid()) {
+        qCritical("Could not start the window manager on %s", m_display.constData());
+        m_windowManager.reset();
+        return false;
+    }
+    return true;
+}
+
+void BenchmarkEnvironment::stopWindowManager()
+{
+    m_windowManager.reset();
+}
+
+int BenchmarkEnvironment::exec(QObject *testObject, int argc, char **argv)
+{
+    if (!startWindowManager()) {
+        return 1;
+    }
+
+    QStringList arguments;
+    for (int i = 0; i < argc; ++i) {
+        arguments << QString::fromLocal8Bit(argv[i]);
+    }
+    QString jsonFile;
+    const int jsonIndex = arguments.indexOf(QLatin1String("-json"));
+    if (jsonIndex > 0 && jsonIndex + 1 < arguments.count()) {
+        jsonFile = arguments.at(jsonIndex + 1);
+        arguments.remove(jsonIndex, 2);
+    }
+
+    // QtTest has no JSON logger, so the results are taken from its XML output
+    QTemporaryFile xmlFile;
+    if (!jsonFile.isEmpty()) {
+        if (!xmlFile.open()) {
+            return 1;
+        }
+        arguments << QStringLiteral("-o") << xmlFile.fileName() + QLatin1String(",xml") << QStringLiteral("-o") << QStringLiteral("-,txt");
+    }
+
+    int result = QTest::qExec(testObject, arguments);
+    if (!jsonFile.isEmpty() && !writeJson(xmlFile.fileName(), jsonFile) && result == 0) {
+        result = 1;
+    }
+
+    // the notifier of the window manager must not outlive the application
+    stopWindowManager();
+    return result;
+}
+
+bool BenchmarkEnvironment::writeJson(const QString &xmlFile, const QString &jsonFile)
+{
+    QFile xml(xmlFile);
+    if (!xml.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QString testCase;
+    QString function;
+    QJsonArray results;
+    QXmlStreamReader reader(&xml);
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (!reader.isStartElement()) {
+            continue;
+        }
+        const QXmlStreamAttributes attributes = reader.attributes();
+        if (reader.name() == QLatin1String("TestCase")) {
+            testCase = attributes.value(QLatin1String("name")).toString();
+        } else if (reader.name() == QLatin1String("TestFunction")) {
+            function = attributes.value(QLatin1String("name")).toString();
+        } else if (reader.name() == QLatin1String("BenchmarkResult")) {
+            results.append(QJsonObject{
+                {QStringLiteral("function"), function},
+                {QStringLiteral("tag"), attributes.value(QLatin1String("tag")).toString()},
+                {QStringLiteral("metric"), attributes.value(QLatin1String("metric")).toString()},
+                {QStringLiteral("value"), attributes.value(QLatin1String("value")).toDouble()},
+                {QStringLiteral("iterations"), attributes.value(QLatin1String("iterations")).toInt()},
+            });
+        }
+    }
+    if (reader.hasError()) {
+        qWarning("Could not read the results of %s: %s", qPrintable(xmlFile), qPrintable(reader.errorString()));
+        return false;
+    }
+
+    const QJsonObject document{
+        {QStringLiteral("testCase"), testCase},
+        {QStringLiteral("qtVersion"), QString::fromLatin1(qVersion())},
+        {QStringLiteral("timestamp"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate)},
+        {QStringLiteral("results"), results},
+    };
+    QFile json(jsonFile);
+    if (!json.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning("Could not write %s", qPrintable(jsonFile));
+        return false;
+    }
+    json.write(QJsonDocument(document).toJson());
+    return true;
+}
+
+QList<xcb_window_t> BenchmarkEnvironment::createClients(xcb_connection_t *c, int count)
+{
+    KXUtils::Atom netWmName(c, QByteArrayLiteral("_NET_WM_NAME"));
+    KXUtils::Atom utf8String(c, QByteArrayLiteral("UTF8_STRING"));
+    const xcb_window_t root = KXUtils::rootWindow(c, 0);
+
+    QList<xcb_window_t> windows;
+    windows.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const xcb_window_t window = xcb_generate_id(c);
+        xcb_create_window(c,
+                          XCB_COPY_FROM_PARENT,
+                          window,
+                          root,
+                          0,
+                          0,
+                          100,
+                          100,
+                          0,
+                          XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                          XCB_COPY_FROM_PARENT,
+                          0,
+                          nullptr);
+        const QByteArray title = QByteArrayLiteral("client ") + QByteArray::number(i);
+        xcb_change_property(c, XCB_PROP_MODE_REPLACE, window, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, title.length(), title.constData());
+        xcb_change_property(c, XCB_PROP_MODE_REPLACE, window, netWmName, utf8String, 8, title.length(), title.constData());
+        xcb_map_window(c, window);
+        windows << window;
+    }
+    xcb_flush(c);
+
+    const bool managed = QTest::qWaitFor(
+        [this, &windows] {
+            return std::all_of(windows.cbegin(), windows.cend(), [this](xcb_window_t window) {
+                return m_windowManager->manages(window);
+            });
+        },
+        10000);
+    if (!managed) {
+        qWarning("The window manager did not pick up all clients");
+        destroyClients(c, windows);
+        return {};
+    }
+    return windows;
+}
+
+void BenchmarkEnvironment::destroyClients(xcb_connection_t *c, const QList<xcb_window_t> &windows)
+{
+    for (xcb_window_t window : windows) {
+        xcb_destroy_window(c, window);
+    }
+    xcb_flush(c);
+}
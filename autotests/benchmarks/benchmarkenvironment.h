@@ -0,0 +1,72 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#ifndef BENCHMARKENVIRONMENT_H
+#define BENCHMARKENVIRONMENT_H
+
+#include <QApplication>
+#include <QByteArray>
+#include <QList>
+
+#include <memory>
+#include <sys/types.h>
+#include <xcb/xcb.h>
+
+class FakeWindowManager;
+
+/*
+ * Runs a benchmark against a private Xvfb with FakeWindowManager managing it, so that
+ * the numbers neither depend on nor disturb the session the build happens to run in.
+ *
+ * Besides the usual QtTest options the benchmarks accept "-json <file>", which writes
+ * every benchmark result together with the Qt version and a timestamp to the given
+ * file, for keeping track of the results over time.
+ */
+class BenchmarkEnvironment
+{
+public:
+    BenchmarkEnvironment();
+    ~BenchmarkEnvironment();
+
+    // has to be called before the QApplication is created, which then connects to the server
+    bool startServer();
+    // done by exec(), only needed by tools that don't run a test object; the window
+    // manager has to be stopped before the QApplication goes away
+    bool startWindowManager();
+    void stopWindowManager();
+    int exec(QObject *testObject, int argc, char **argv);
+
+    static BenchmarkEnvironment *self();
+
+    FakeWindowManager *windowManager() const;
+    QByteArray display() const;
+
+    // creates and maps count top level windows on c, returns once all of them are managed
+    QList<xcb_window_t> createClients(xcb_connection_t *c, int count);
+    void destroyClients(xcb_connection_t *c, const QList<xcb_window_t> &windows);
+
+private:
+    static bool writeJson(const QString &xmlFile, const QString &jsonFile);
+
+    pid_t m_server = 0;
+    QByteArray m_display;
+    std::unique_ptr<FakeWindowManager> m_windowManager;
+};
+
+#define KWINDOWSYSTEM_BENCHMARK_MAIN(TestObject)                                                                                                               \
+    int main(int argc, char *argv[])                                                                                                                           \
+    {                                                                                                                                                          \
+        BenchmarkEnvironment environment;                                                                                                                      \
+        if (!environment.startServer()) {                                                                                                                      \
+            return 1;                                                                                                                                          \
+        }                                                                                                                                                      \
+        QApplication app(argc, argv);                                                                                                                          \
+        app.setAttribute(Qt::AA_Use96Dpi, true);                                                                                                               \
+        TestObject tc;                                                                                                                                         \
+        return environment.exec(&tc, argc, argv);                                                                                                              \
+    }
+
+#endif
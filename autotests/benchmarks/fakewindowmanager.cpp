@@ -0,0 +1,205 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "fakewindowmanager.h"
+#include "nettesthelper.h"
+
+#include <netwm.h>
+
+#include <QSocketNotifier>
+
+#include <xcb/xcb_icccm.h>
+
+static const char *s_wmName = "kwindowsystem-benchmark-wm";
+
+FakeWindowManager::FakeWindowManager(const QByteArray &display)
+{
+    int screen = 0;
+    m_connection = xcb_connect(display.constData(), &screen);
+    if (xcb_connection_has_error(m_connection)) {
+        return;
+    }
+    xcb_screen_iterator_t it = xcb_setup_roots_iterator(xcb_get_setup(m_connection));
+    for (; it.rem && screen > 0; --screen) {
+        xcb_screen_next(&it);
+    }
+    m_rootWindow = it.data->root;
+    m_screenGeometry = QRect(0, 0, it.data->width_in_pixels, it.data->height_in_pixels);
+
+    // only one client can redirect the root window, fail if somebody else already manages the screen
+    uint32_t values[] = {XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY};
+    UniqueCPointer<xcb_generic_error_t> error(
+        xcb_request_check(m_connection, xcb_change_window_attributes_checked(m_connection, m_rootWindow, XCB_CW_EVENT_MASK, values)));
+    if (error) {
+        return;
+    }
+
+    // create support window
+    values[0] = true;
+    m_supportWindow = xcb_generate_id(m_connection);
+    xcb_create_window(m_connection,
+                      XCB_COPY_FROM_PARENT,
+                      m_supportWindow,
+                      m_rootWindow,
+                      0,
+                      0,
+                      1,
+                      1,
+                      0,
+                      XCB_COPY_FROM_PARENT,
+                      XCB_COPY_FROM_PARENT,
+                      XCB_CW_OVERRIDE_REDIRECT,
+                      values);
+    const uint32_t lowerValues[] = {XCB_STACK_MODE_BELOW};
+    // we need to do the lower window with a roundtrip, otherwise NETRootInfo is not functioning
+    error.reset(xcb_request_check(m_connection, xcb_configure_window_checked(m_connection, m_supportWindow, XCB_CONFIG_WINDOW_STACK_MODE, lowerValues)));
+    if (error) {
+        return;
+    }
+
+    KXUtils::Atom wmState(m_connection, QByteArrayLiteral("WM_STATE"));
+    m_rootInfo = std::make_unique<NETRootInfo>(m_connection,
+                                               m_supportWindow,
+                                               s_wmName,
+                                               NET::ClientList | NET::ClientListStacking | NET::NumberOfDesktops | NET::DesktopGeometry | NET::CurrentDesktop
+                                                   | NET::WorkArea | NET::ActiveWindow | NET::WMName | NET::WMVisibleName | NET::WMDesktop | NET::WMWindowType
+                                                   | NET::WMState | NET::WMStrut | NET::WMIcon | NET::WMFrameExtents,
+                                               NET::NormalMask | NET::DockMask,
+                                               NET::States(),
+                                               NET::WM2ExtendedStrut | NET::WM2WindowClass | NET::WM2IconPixmap,
+                                               NET::Actions(),
+                                               screen);
+    m_rootInfo->setNumberOfDesktops(desktops);
+    m_rootInfo->setDesktopGeometry(NETSize(m_screenGeometry.size()));
+    m_rootInfo->setCurrentDesktop(1);
+    const QRect area = workArea();
+    for (int desktop = 1; desktop <= desktops; ++desktop) {
+        m_rootInfo->setWorkArea(desktop, NETRect(area));
+    }
+    m_wmState = wmState;
+
+    m_notifier = std::make_unique<QSocketNotifier>(xcb_get_file_descriptor(m_connection), QSocketNotifier::Read);
+    QObject::connect(m_notifier.get(), &QSocketNotifier::activated, m_notifier.get(), [this] {
+        readEvents();
+    });
+    // the round trips above may already have queued map requests
+    readEvents();
+}
+
+FakeWindowManager::~FakeWindowManager()
+{
+    m_notifier.reset();
+    m_rootInfo.reset();
+    if (m_supportWindow != XCB_WINDOW_NONE) {
+        xcb_destroy_window(m_connection, m_supportWindow);
+    }
+    xcb_disconnect(m_connection);
+}
+
+bool FakeWindowManager::isValid() const
+{
+    return m_rootInfo != nullptr;
+}
+
+bool FakeWindowManager::manages(xcb_window_t window) const
+{
+    return m_clients.contains(window);
+}
+
+QRect FakeWindowManager::workArea() const
+{
+    return m_screenGeometry.adjusted(0, 0, 0, -panelHeight);
+}
+
+void FakeWindowManager::readEvents()
+{
+    while (UniqueCPointer<xcb_generic_event_t> event{xcb_poll_for_event(m_connection)}) {
+        handleEvent(event.get());
+    }
+    xcb_flush(m_connection);
+}
+
+void FakeWindowManager::handleEvent(xcb_generic_event_t *event)
+{
+    switch (event->response_type & ~0x80) {
+    case XCB_MAP_REQUEST:
+        manage(reinterpret_cast<xcb_map_request_event_t *>(event)->window);
+        break;
+    case XCB_CONFIGURE_REQUEST: {
+        // grant everything the way it was asked for
+        auto *request = reinterpret_cast<xcb_configure_request_event_t *>(event);
+        uint32_t values[7];
+        int count = 0;
+        if (request->value_mask & XCB_CONFIG_WINDOW_X) {
+            values[count++] = uint32_t(request->x);
+        }
+        if (request->value_mask & XCB_CONFIG_WINDOW_Y) {
+            values[count++] = uint32_t(request->y);
+        }
+        if (request->value_mask & XCB_CONFIG_WINDOW_WIDTH) {
+            values[count++] = request->width;
+        }
+        if (request->value_mask & XCB_CONFIG_WINDOW_HEIGHT) {
+            values[count++] = request->height;
+        }
+        if (request->value_mask & XCB_CONFIG_WINDOW_BORDER_WIDTH) {
+            values[count++] = request->border_width;
+        }
+        if (request->value_mask & XCB_CONFIG_WINDOW_SIBLING) {
+            values[count++] = request->sibling;
+        }
+        if (request->value_mask & XCB_CONFIG_WINDOW_STACK_MODE) {
+            values[count++] = request->stack_mode;
+        }
+        xcb_configure_window(m_connection, request->window, request->value_mask, values);
+        break;
+    }
+    case XCB_UNMAP_NOTIFY:
+        unmanage(reinterpret_cast<xcb_unmap_notify_event_t *>(event)->window, true);
+        break;
+    case XCB_DESTROY_NOTIFY:
+        unmanage(reinterpret_cast<xcb_destroy_notify_event_t *>(event)->window, false);
+        break;
+    default:
+        break;
+    }
+}
+
+void FakeWindowManager::manage(xcb_window_t window)
+{
+    xcb_map_window(m_connection, window);
+    if (m_clients.contains(window)) {
+        return;
+    }
+
+    const uint32_t normalState[] = {XCB_ICCCM_WM_STATE_NORMAL, XCB_WINDOW_NONE};
+    xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, window, m_wmState, m_wmState, 32, 2, normalState);
+    NETWinInfo info(m_connection, window, m_rootWindow, NET::Properties(), NET::Properties2(), NET::WindowManager);
+    info.setDesktop(m_rootInfo->currentDesktop());
+    info.setFrameExtents(NETStrut());
+
+    m_clients.append(window);
+    updateClientList();
+}
+
+void FakeWindowManager::unmanage(xcb_window_t window, bool withdraw)
+{
+    if (!m_clients.removeOne(window)) {
+        return;
+    }
+    if (withdraw) {
+        const uint32_t withdrawnState[] = {XCB_ICCCM_WM_STATE_WITHDRAWN, XCB_WINDOW_NONE};
+        xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, window, m_wmState, m_wmState, 32, 2, withdrawnState);
+    }
+    updateClientList();
+}
+
+void FakeWindowManager::updateClientList()
+{
+    m_rootInfo->setClientList(m_clients.constData(), m_clients.count());
+    m_rootInfo->setClientListStacking(m_clients.constData(), m_clients.count());
+    xcb_flush(m_connection);
+}
@@ -0,0 +1,61 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#ifndef FAKEWINDOWMANAGER_H
+#define FAKEWINDOWMANAGER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QRect>
+
+#include <memory>
+#include <xcb/xcb.h>
+
+class NETRootInfo;
+class QSocketNotifier;
+
+/*
+ * Minimal window manager for the benchmarks, built on the support window setup of
+ * netrootinfotestwm.
+ *
+ * It runs on a connection of its own in the main thread, so it only reacts while the
+ * event loop spins. Every window it is asked to map gets mapped right away, marked as
+ * NormalState and appended to _NET_CLIENT_LIST and _NET_CLIENT_LIST_STACKING. The root
+ * window announces four desktops and a work area that leaves room for a panel at the
+ * bottom of the screen.
+ */
+class FakeWindowManager
+{
+public:
+    explicit FakeWindowManager(const QByteArray &display);
+    ~FakeWindowManager();
+
+    bool isValid() const;
+    bool manages(xcb_window_t window) const;
+
+    QRect workArea() const;
+
+    static constexpr int desktops = 4;
+    static constexpr int panelHeight = 30;
+
+private:
+    void readEvents();
+    void handleEvent(xcb_generic_event_t *event);
+    void manage(xcb_window_t window);
+    void unmanage(xcb_window_t window, bool withdraw);
+    void updateClientList();
+
+    xcb_connection_t *m_connection = nullptr;
+    xcb_window_t m_rootWindow = XCB_WINDOW_NONE;
+    xcb_window_t m_supportWindow = XCB_WINDOW_NONE;
+    xcb_atom_t m_wmState = XCB_ATOM_NONE;
+    QRect m_screenGeometry;
+    std::unique_ptr<NETRootInfo> m_rootInfo;
+    std::unique_ptr<QSocketNotifier> m_notifier;
+    QList<xcb_window_t> m_clients;
+};
+
+#endif
@@ -0,0 +1,142 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "benchmarkenvironment.h"
+
+#include <kkeyserver.h>
+
+#include <QKeyCombination>
+#include <QTest>
+#include <private/qtx11extras_p.h>
+
+#include <X11/keysym.h>
+#include <xcb/xcb_keysyms.h>
+
+#include <vector>
+
+// Each case converts the whole table of shortcuts, which resembles what a global
+// shortcut daemon does when (re)grabbing its keys
+class KKeyServerBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void benchmarkKeyQtToSymX();
+    void benchmarkKeyQtToCodeX();
+    void benchmarkKeyQtToModX();
+    void benchmarkSymXModXToKeyQt();
+    void benchmarkKeyPressEventToQt();
+
+private:
+    struct Shortcut {
+        int keyQt;
+        uint modX;
+        int keySymX;
+    };
+    std::vector<Shortcut> m_shortcuts;
+    std::vector<xcb_key_press_event_t> m_events;
+};
+
+void KKeyServerBenchmark::initTestCase()
+{
+    const std::pair<QKeyCombination, int> shortcuts[] = {
+        {QKeyCombination(Qt::Key_A), XK_A},
+        {QKeyCombination(Qt::ControlModifier, Qt::Key_F1), XK_F1},
+        {QKeyCombination(Qt::ControlModifier, Qt::Key_1), XK_1},
+        {QKeyCombination(Qt::ControlModifier | Qt::KeypadModifier, Qt::Key_1), XK_KP_1},
+        {QKeyCombination(Qt::ControlModifier | Qt::ShiftModifier | Qt::KeypadModifier, Qt::Key_End), XK_KP_End},
+        {QKeyCombination(Qt::AltModifier | Qt::ShiftModifier, Qt::Key_Right), XK_Right},
+        {QKeyCombination(Qt::MetaModifier | Qt::ShiftModifier, Qt::Key_Print), XK_Print},
+        {QKeyCombination(Qt::AltModifier, Qt::Key_Tab), XK_Tab},
+        {QKeyCombination(Qt::AltModifier | Qt::ShiftModifier, Qt::Key_Tab), XK_Tab},
+        {QKeyCombination(Qt::MetaModifier, Qt::Key_D), XK_D},
+        {QKeyCombination(Qt::ControlModifier | Qt::AltModifier, Qt::Key_Delete), XK_Delete},
+        {QKeyCombination(Qt::ControlModifier | Qt::AltModifier, Qt::Key_T), XK_T},
+        {QKeyCombination(Qt::MetaModifier, Qt::Key_Space), XK_space},
+        {QKeyCombination(Qt::Key_VolumeUp), 0},
+        {QKeyCombination(Qt::Key_MediaPlay), 0},
+        {QKeyCombination(Qt::Key_Calculator), 0},
+    };
+
+    xcb_key_symbols_t *keySymbols = xcb_key_symbols_alloc(QX11Info::connection());
+    QVERIFY(keySymbols);
+    for (const auto &[combination, keySymX] : shortcuts) {
+        const int keyQt = combination.toCombined();
+        uint modX = 0;
+        QVERIFY(KKeyServer::keyQtToModX(keyQt, &modX));
+        m_shortcuts.push_back({keyQt, modX, keySymX});
+
+        if (!keySymX) {
+            continue;
+        }
+        xcb_keycode_t *keyCodes = xcb_key_symbols_get_keycode(keySymbols, keySymX);
+        if (!keyCodes) {
+            continue;
+        }
+        xcb_key_press_event_t event = {};
+        event.response_type = XCB_KEY_PRESS;
+        event.detail = keyCodes[0];
+        event.state = uint16_t(modX);
+        m_events.push_back(event);
+        free(keyCodes);
+    }
+    xcb_key_symbols_free(keySymbols);
+    QVERIFY(!m_events.empty());
+}
+
+void KKeyServerBenchmark::benchmarkKeyQtToSymX()
+{
+    QBENCHMARK {
+        for (const Shortcut &shortcut : m_shortcuts) {
+            (void)KKeyServer::keyQtToSymXs(shortcut.keyQt);
+        }
+    }
+}
+
+void KKeyServerBenchmark::benchmarkKeyQtToCodeX()
+{
+    QBENCHMARK {
+        for (const Shortcut &shortcut : m_shortcuts) {
+            (void)KKeyServer::keyQtToCodeXs(shortcut.keyQt);
+        }
+    }
+}
+
+void KKeyServerBenchmark::benchmarkKeyQtToModX()
+{
+    QBENCHMARK {
+        for (const Shortcut &shortcut : m_shortcuts) {
+            uint modX;
+            KKeyServer::keyQtToModX(shortcut.keyQt, &modX);
+        }
+    }
+}
+
+void KKeyServerBenchmark::benchmarkSymXModXToKeyQt()
+{
+    QBENCHMARK {
+        for (const Shortcut &shortcut : m_shortcuts) {
+            if (shortcut.keySymX) {
+                int keyQt;
+                KKeyServer::symXModXToKeyQt(shortcut.keySymX, shortcut.modX, &keyQt);
+            }
+        }
+    }
+}
+
+void KKeyServerBenchmark::benchmarkKeyPressEventToQt()
+{
+    QBENCHMARK {
+        for (xcb_key_press_event_t &event : m_events) {
+            int keyQt;
+            KKeyServer::xcbKeyPressEventToQt(&event, &keyQt);
+        }
+    }
+}
+
+KWINDOWSYSTEM_BENCHMARK_MAIN(KKeyServerBenchmark)
+
+#include "kkeyserverbenchmark.moc"
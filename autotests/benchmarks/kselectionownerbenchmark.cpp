@@ -0,0 +1,63 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "benchmarkenvironment.h"
+
+#include <kselectionowner.h>
+
+#include <QEventLoop>
+#include <QTest>
+#include <QTimer>
+
+#include <memory>
+#include <vector>
+
+// Measures the claim-to-ready latency of several selections claimed at once, like a session start does.
+class KSelectionOwnerBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void benchmarkClaim_data();
+    void benchmarkClaim();
+};
+
+void KSelectionOwnerBenchmark::benchmarkClaim_data()
+{
+    QTest::addColumn<int>("selections");
+
+    QTest::newRow("1") << 1;
+    QTest::newRow("4") << 4;
+    QTest::newRow("16") << 16;
+}
+
+void KSelectionOwnerBenchmark::benchmarkClaim()
+{
+    QFETCH(int, selections);
+
+    QBENCHMARK {
+        std::vector<std::unique_ptr<KSelectionOwner>> owners;
+        QEventLoop loop;
+        int claimed = 0;
+        for (int i = 0; i < selections; ++i) {
+            const QByteArray name = QByteArrayLiteral("_KDE_KSELECTIONOWNERBENCHMARK_") + QByteArray::number(i);
+            owners.push_back(std::make_unique<KSelectionOwner>(name.constData()));
+            connect(owners.back().get(), &KSelectionOwner::claimedOwnership, &loop, [&]() {
+                if (++claimed == selections) {
+                    loop.quit();
+                }
+            });
+            owners.back()->claim(false);
+        }
+        // QTRY_COMPARE would round the latency up to its polling interval
+        QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+        loop.exec();
+        QCOMPARE(claimed, selections);
+    }
+}
+
+KWINDOWSYSTEM_BENCHMARK_MAIN(KSelectionOwnerBenchmark)
+
+#include "kselectionownerbenchmark.moc"
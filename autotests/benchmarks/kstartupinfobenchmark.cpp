@@ -0,0 +1,100 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "benchmarkenvironment.h"
+
+#include <kstartupinfo.h>
+
+#include <QTest>
+
+// Sends startup notifications from a connection of their own and measures until the
+// listener has reassembled and parsed all of them
+class KStartupInfoBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkMessages_data();
+    void benchmarkMessages();
+
+private:
+    xcb_connection_t *m_connection = nullptr;
+};
+
+void KStartupInfoBenchmark::initTestCase()
+{
+    m_connection = xcb_connect(BenchmarkEnvironment::self()->display().constData(), nullptr);
+    QVERIFY(!xcb_connection_has_error(m_connection));
+}
+
+void KStartupInfoBenchmark::cleanupTestCase()
+{
+    xcb_disconnect(m_connection);
+}
+
+void KStartupInfoBenchmark::benchmarkMessages_data()
+{
+    QTest::addColumn<int>("startups");
+    QTest::addColumn<bool>("fullData");
+
+    QTest::newRow("1, id only") << 1 << false;
+    QTest::newRow("1") << 1 << true;
+    QTest::newRow("10") << 10 << true;
+    QTest::newRow("100") << 100 << true;
+}
+
+void KStartupInfoBenchmark::benchmarkMessages()
+{
+    QFETCH(int, startups);
+    QFETCH(bool, fullData);
+
+    KStartupInfo listener(KStartupInfo::CleanOnCantDetect);
+    int newStartups = 0;
+    int removedStartups = 0;
+    connect(&listener, &KStartupInfo::gotNewStartup, this, [&newStartups] {
+        ++newStartups;
+    });
+    connect(&listener, &KStartupInfo::gotRemoveStartup, this, [&removedStartups] {
+        ++removedStartups;
+    });
+
+    KStartupInfoData data;
+    if (fullData) {
+        // long values span several 20 byte client messages
+        data.setApplicationId(QStringLiteral("/usr/share/applications/org.kde.kstartupinfobenchmark.desktop"));
+        data.setIcon(QStringLiteral("/dir with space/kstartupinfobenchmark.png"));
+        data.setDescription(QStringLiteral("Launching \"KStartupInfo Benchmark\""));
+        data.setName(QStringLiteral("KStartupInfo Benchmark"));
+        data.setBin(QStringLiteral("kstartupinfobenchmark"));
+        data.addPid(12345);
+        data.setDesktop(1);
+        data.setWMClass(QByteArrayLiteral("kstartupinfobenchmark"));
+    }
+
+    QBENCHMARK {
+        newStartups = 0;
+        removedStartups = 0;
+        QList<KStartupInfoId> ids;
+        for (int i = 0; i < startups; ++i) {
+            KStartupInfoId id;
+            id.initId(KStartupInfo::createNewStartupId());
+            KStartupInfo::sendStartupXcb(m_connection, 0, id, data);
+            ids << id;
+        }
+        for (const KStartupInfoId &id : std::as_const(ids)) {
+            KStartupInfo::sendFinishXcb(m_connection, 0, id);
+        }
+        xcb_flush(m_connection);
+        QVERIFY(QTest::qWaitFor([&] {
+            return newStartups == startups && removedStartups == startups;
+        }));
+    }
+}
+
+KWINDOWSYSTEM_BENCHMARK_MAIN(KStartupInfoBenchmark)
+
+#include "kstartupinfobenchmark.moc"
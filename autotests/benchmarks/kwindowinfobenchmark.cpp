@@ -0,0 +1,102 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "benchmarkenvironment.h"
+
+#include <kwindowinfo.h>
+#include <netwm.h>
+
+#include <QFuture>
+#include <QTest>
+
+#include <algorithm>
+
+static const int s_windowCount = 50;
+
+class KWindowInfoBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkConstruction_data();
+    void benchmarkConstruction();
+    void benchmarkFetch_data();
+    void benchmarkFetch();
+
+private:
+    xcb_connection_t *m_connection = nullptr;
+    QList<xcb_window_t> m_windows;
+};
+
+void KWindowInfoBenchmark::initTestCase()
+{
+    m_connection = xcb_connect(BenchmarkEnvironment::self()->display().constData(), nullptr);
+    QVERIFY(!xcb_connection_has_error(m_connection));
+    m_windows = BenchmarkEnvironment::self()->createClients(m_connection, s_windowCount);
+    QCOMPARE(m_windows.count(), s_windowCount);
+}
+
+void KWindowInfoBenchmark::cleanupTestCase()
+{
+    BenchmarkEnvironment::self()->destroyClients(m_connection, m_windows);
+    xcb_disconnect(m_connection);
+}
+
+void KWindowInfoBenchmark::benchmarkConstruction_data()
+{
+    QTest::addColumn<uint>("properties");
+    QTest::addColumn<uint>("properties2");
+
+    QTest::newRow("state") << uint(NET::WMState | NET::XAWMState) << 0u;
+    QTest::newRow("name") << uint(NET::WMName | NET::WMVisibleName) << 0u;
+    QTest::newRow("geometry") << uint(NET::WMGeometry | NET::WMFrameExtents) << 0u;
+    QTest::newRow("taskmanager") << uint(NET::WMName | NET::WMVisibleName | NET::WMState | NET::XAWMState | NET::WMDesktop | NET::WMWindowType | NET::WMGeometry)
+                                 << uint(NET::WM2WindowClass | NET::WM2Activities | NET::WM2DesktopFileName);
+    QTest::newRow("all") << uint(NET::WMAllProperties) << uint(NET::WM2AllProperties);
+}
+
+void KWindowInfoBenchmark::benchmarkConstruction()
+{
+    QFETCH(uint, properties);
+    QFETCH(uint, properties2);
+
+    QBENCHMARK {
+        for (xcb_window_t window : std::as_const(m_windows)) {
+            KWindowInfo info(window, NET::Properties(properties), NET::Properties2(properties2));
+            QVERIFY(info.valid());
+        }
+    }
+}
+
+void KWindowInfoBenchmark::benchmarkFetch_data()
+{
+    benchmarkConstruction_data();
+}
+
+void KWindowInfoBenchmark::benchmarkFetch()
+{
+    QFETCH(uint, properties);
+    QFETCH(uint, properties2);
+
+    QBENCHMARK {
+        QList<QFuture<KWindowInfo>> futures;
+        futures.reserve(m_windows.count());
+        for (xcb_window_t window : std::as_const(m_windows)) {
+            futures << KWindowInfo::fetch(window, NET::Properties(properties), NET::Properties2(properties2));
+        }
+        QVERIFY(QTest::qWaitFor([&futures] {
+            return std::all_of(futures.cbegin(), futures.cend(), [](const QFuture<KWindowInfo> &future) {
+                return future.isFinished();
+            });
+        }));
+        QVERIFY(futures.last().result().valid());
+    }
+}
+
+KWINDOWSYSTEM_BENCHMARK_MAIN(KWindowInfoBenchmark)
+
+#include "kwindowinfobenchmark.moc"
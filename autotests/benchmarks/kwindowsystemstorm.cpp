@@ -0,0 +1,378 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "benchmarkenvironment.h"
+#include "nettesthelper.h"
+
+#include <kx11extras.h>
+#include <netwm.h>
+
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTest>
+#include <QTimer>
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+/*
+ * Load generator for the X11 backend: spawns a number of clients on the benchmark Xvfb
+ * and keeps changing their names, icons, states and struts at the given rates, while
+ * measuring how long it takes from the change until KX11Extras::windowChanged reports it:
+ *
+ *   kwindowsystemstorm --windows 500 --duration 30 --name-rate 2000 --json storm.json
+ *
+ * The changes come from a connection of their own, the rates are per second over all
+ * windows. A change of a window that is still waiting for the previous change of the
+ * same kind to be reported is counted as coalesced and not measured, as X may hand out
+ * a single PropertyNotify for both.
+ */
+enum Kind {
+    Name,
+    Icon,
+    State,
+    Strut,
+    KindCount,
+};
+
+static const char *const s_kindNames[KindCount] = {"name", "icon", "state", "strut"};
+
+static bool reports(Kind kind, NET::Properties properties)
+{
+    switch (kind) {
+    case Name:
+        return properties & NET::WMName;
+    case Icon:
+        return properties & NET::WMIcon;
+    case State:
+        return properties & NET::WMState;
+    case Strut:
+        return properties & NET::WMStrut;
+    case KindCount:
+        break;
+    }
+    return false;
+}
+
+struct KindStatistics {
+    double rate = 0;
+    qint64 sent = 0;
+    qint64 coalesced = 0;
+    qint64 lost = 0;
+    QList<qint64> latencies;
+};
+
+// in ms, latencies have to be sorted
+static double percentile(const QList<qint64> &latencies, double p)
+{
+    if (latencies.isEmpty()) {
+        return 0;
+    }
+    const qsizetype index = std::min(latencies.size() - 1, qsizetype(p * latencies.size()));
+    return latencies.at(index) / 1e6;
+}
+
+class WindowStorm
+{
+public:
+    WindowStorm(int windowCount, int duration, const double (&rates)[KindCount]);
+    ~WindowStorm();
+
+    bool run();
+    void report(const QString &jsonFile);
+
+private:
+    void tick();
+    void change(Kind kind, int index);
+    void changed(WId window, NET::Properties properties);
+
+    struct Client {
+        xcb_window_t window = XCB_WINDOW_NONE;
+        std::unique_ptr<NETWinInfo> info;
+        // the state is set by the window manager
+        std::unique_ptr<NETWinInfo> managed;
+        int changes[KindCount] = {};
+    };
+
+    int m_windowCount;
+    int m_duration;
+    KindStatistics m_statistics[KindCount];
+    qsizetype m_next[KindCount] = {};
+    xcb_connection_t *m_connection = nullptr;
+    QList<xcb_window_t> m_windows;
+    // in the order of m_windows
+    std::vector<Client> m_clients;
+    // changes waiting to be reported, with the time they were sent at
+    QHash<QPair<xcb_window_t, int>, qint64> m_pending;
+    QElapsedTimer m_clock;
+    QTimer m_timer;
+};
+
+WindowStorm::WindowStorm(int windowCount, int duration, const double (&rates)[KindCount])
+    : m_windowCount(windowCount)
+    , m_duration(duration)
+{
+    for (int kind = 0; kind < KindCount; ++kind) {
+        m_statistics[kind].rate = rates[kind];
+    }
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.setInterval(5);
+    QObject::connect(&m_timer, &QTimer::timeout, [this] {
+        tick();
+    });
+}
+
+WindowStorm::~WindowStorm()
+{
+    if (m_connection) {
+        m_clients.clear();
+        BenchmarkEnvironment::self()->destroyClients(m_connection, m_windows);
+        xcb_disconnect(m_connection);
+    }
+}
+
+bool WindowStorm::run()
+{
+    const QByteArray display = BenchmarkEnvironment::self()->display();
+    m_connection = xcb_connect(display.constData(), nullptr);
+    if (xcb_connection_has_error(m_connection)) {
+        return false;
+    }
+    const xcb_window_t root = KXUtils::rootWindow(m_connection, 0);
+
+    // connecting starts the window tracking of KX11Extras
+    QObject::connect(KX11Extras::self(), &KX11Extras::windowChanged, [this](WId window, NET::Properties properties) {
+        changed(window, properties);
+    });
+
+    m_windows = BenchmarkEnvironment::self()->createClients(m_connection, m_windowCount);
+    if (m_windows.size() != m_windowCount) {
+        return false;
+    }
+    const bool tracked = QTest::qWaitFor(
+        [this] {
+            return std::all_of(m_windows.cbegin(), m_windows.cend(), [](xcb_window_t window) {
+                return KX11Extras::hasWId(window);
+            });
+        },
+        10000);
+    if (!tracked) {
+        fprintf(stderr, "KX11Extras did not pick up all clients\n");
+        return false;
+    }
+
+    m_clients.resize(m_windows.size());
+    for (qsizetype i = 0; i < m_windows.size(); ++i) {
+        const xcb_window_t window = m_windows.at(i);
+        Client &client = m_clients[i];
+        client.window = window;
+        client.info = std::make_unique<NETWinInfo>(m_connection, window, root, NET::Properties(), NET::Properties2());
+        client.managed = std::make_unique<NETWinInfo>(m_connection, window, root, NET::WMState, NET::Properties2(), NET::WindowManager);
+    }
+
+    printf("Changing %d windows for %d s\n", m_windowCount, m_duration);
+    m_clock.start();
+    m_timer.start();
+    QTest::qWait(m_duration * 1000);
+    m_timer.stop();
+
+    // whatever is not reported by then is not going to be
+    QTest::qWaitFor(
+        [this] {
+            return m_pending.isEmpty();
+        },
+        5000);
+    for (auto it = m_pending.cbegin(); it != m_pending.cend(); ++it) {
+        ++m_statistics[it.key().second].lost;
+    }
+    m_pending.clear();
+    return true;
+}
+
+void WindowStorm::tick()
+{
+    const double elapsed = m_clock.nsecsElapsed() / 1e9;
+    for (int kind = 0; kind < KindCount; ++kind) {
+        KindStatistics &statistics = m_statistics[kind];
+        const qint64 due = qint64(statistics.rate * elapsed);
+        while (statistics.sent < due) {
+            change(Kind(kind), m_next[kind]);
+            m_next[kind] = (m_next[kind] + 1) % m_windows.size();
+        }
+    }
+    xcb_flush(m_connection);
+}
+
+void WindowStorm::change(Kind kind, int index)
+{
+    Client &client = m_clients[index];
+    const int round = client.changes[kind]++;
+
+    const QPair<xcb_window_t, int> key(client.window, kind);
+    if (m_pending.contains(key)) {
+        ++m_statistics[kind].coalesced;
+    } else {
+        m_pending.insert(key, m_clock.nsecsElapsed());
+    }
+    ++m_statistics[kind].sent;
+
+    switch (kind) {
+    case Name:
+        client.info->setName((QByteArrayLiteral("storm ") + QByteArray::number(round)).constData());
+        break;
+    case Icon: {
+        uint32_t argb[16 * 16];
+        std::fill(std::begin(argb), std::end(argb), 0xff000000 | (round & 0xffffff));
+        NETIcon icon;
+        icon.size.width = icon.size.height = 16;
+        icon.data = reinterpret_cast<unsigned char *>(argb);
+        client.info->setIcon(icon);
+        break;
+    }
+    case State:
+        client.managed->setState(round % 2 ? NET::States() : NET::DemandsAttention, NET::DemandsAttention);
+        break;
+    case Strut: {
+        NETStrut strut;
+        strut.top = 1 + round % 2;
+        client.info->setStrut(strut);
+        break;
+    }
+    case KindCount:
+        break;
+    }
+}
+
+void WindowStorm::changed(WId window, NET::Properties properties)
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    for (int kind = 0; kind < KindCount; ++kind) {
+        if (!reports(Kind(kind), properties)) {
+            continue;
+        }
+        const auto it = m_pending.constFind(qMakePair(xcb_window_t(window), kind));
+        if (it != m_pending.cend()) {
+            m_statistics[kind].latencies << now - it.value();
+            m_pending.erase(it);
+        }
+    }
+}
+
+void WindowStorm::report(const QString &jsonFile)
+{
+    printf("%-6s %10s %10s %10s %10s %10s %10s %10s %10s\n", "kind", "sent", "measured", "coalesced", "lost", "p50 ms", "p90 ms", "p99 ms", "max ms");
+    QJsonArray results;
+    for (int kind = 0; kind < KindCount; ++kind) {
+        KindStatistics &statistics = m_statistics[kind];
+        if (statistics.rate <= 0) {
+            continue;
+        }
+        std::sort(statistics.latencies.begin(), statistics.latencies.end());
+        const double max = statistics.latencies.isEmpty() ? 0 : statistics.latencies.last() / 1e6;
+        printf("%-6s %10lld %10lld %10lld %10lld %10.3f %10.3f %10.3f %10.3f\n",
+               s_kindNames[kind],
+               statistics.sent,
+               qlonglong(statistics.latencies.size()),
+               statistics.coalesced,
+               statistics.lost,
+               percentile(statistics.latencies, 0.5),
+               percentile(statistics.latencies, 0.9),
+               percentile(statistics.latencies, 0.99),
+               max);
+        results.append(QJsonObject{
+            {QStringLiteral("kind"), QString::fromLatin1(s_kindNames[kind])},
+            {QStringLiteral("rate"), statistics.rate},
+            {QStringLiteral("sent"), statistics.sent},
+            {QStringLiteral("measured"), statistics.latencies.size()},
+            {QStringLiteral("coalesced"), statistics.coalesced},
+            {QStringLiteral("lost"), statistics.lost},
+            {QStringLiteral("p50"), percentile(statistics.latencies, 0.5)},
+            {QStringLiteral("p90"), percentile(statistics.latencies, 0.9)},
+            {QStringLiteral("p99"), percentile(statistics.latencies, 0.99)},
+            {QStringLiteral("max"), max},
+        });
+    }
+
+    if (jsonFile.isEmpty()) {
+        return;
+    }
+    const QJsonObject document{
+        {QStringLiteral("testCase"), QStringLiteral("kwindowsystemstorm")},
+        {QStringLiteral("qtVersion"), QString::fromLatin1(qVersion())},
+        {QStringLiteral("timestamp"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate)},
+        {QStringLiteral("windows"), m_windowCount},
+        {QStringLiteral("duration"), m_duration},
+        {QStringLiteral("results"), results},
+    };
+    QFile json(jsonFile);
+    if (!json.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        fprintf(stderr, "Could not write %s\n", qPrintable(jsonFile));
+        return;
+    }
+    json.write(QJsonDocument(document).toJson());
+}
+
+int main(int argc, char **argv)
+{
+    BenchmarkEnvironment environment;
+    if (!environment.startServer()) {
+        return 1;
+    }
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption windowsOption(QStringLiteral("windows"), QStringLiteral("Number of client windows."), QStringLiteral("count"), QStringLiteral("100"));
+    const QCommandLineOption durationOption(QStringLiteral("duration"), QStringLiteral("Seconds to keep changing them."), QStringLiteral("seconds"), QStringLiteral("10"));
+    const QCommandLineOption rateOptions[KindCount] = {
+        QCommandLineOption(QStringLiteral("name-rate"), QStringLiteral("Name changes per second."), QStringLiteral("rate"), QStringLiteral("500")),
+        QCommandLineOption(QStringLiteral("icon-rate"), QStringLiteral("Icon changes per second."), QStringLiteral("rate"), QStringLiteral("100")),
+        QCommandLineOption(QStringLiteral("state-rate"), QStringLiteral("State changes per second."), QStringLiteral("rate"), QStringLiteral("200")),
+        QCommandLineOption(QStringLiteral("strut-rate"), QStringLiteral("Strut changes per second."), QStringLiteral("rate"), QStringLiteral("10")),
+    };
+    const QCommandLineOption jsonOption(QStringLiteral("json"), QStringLiteral("Also write the results to <file>."), QStringLiteral("file"));
+    parser.addOption(windowsOption);
+    parser.addOption(durationOption);
+    for (const QCommandLineOption &option : rateOptions) {
+        parser.addOption(option);
+    }
+    parser.addOption(jsonOption);
+    parser.process(app);
+
+    double rates[KindCount];
+    for (int kind = 0; kind < KindCount; ++kind) {
+        rates[kind] = parser.value(rateOptions[kind]).toDouble();
+    }
+    const int windowCount = parser.value(windowsOption).toInt();
+    if (windowCount <= 0) {
+        fprintf(stderr, "At least one window is needed\n");
+        return 1;
+    }
+
+    if (!environment.startWindowManager()) {
+        return 1;
+    }
+    int result = 0;
+    {
+        WindowStorm storm(windowCount, parser.value(durationOption).toInt(), rates);
+        if (storm.run()) {
+            storm.report(parser.value(jsonOption));
+        } else {
+            result = 1;
+        }
+    }
+    environment.stopWindowManager();
+    return result;
+}
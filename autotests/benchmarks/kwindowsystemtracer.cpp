@@ -0,0 +1,79 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "kxcbtrace_p.h"
+#include "nettesthelper.h"
+#include "nettracer.h"
+
+#include <QCoreApplication>
+#include <QDeadlineTimer>
+
+#include <csignal>
+#include <cstdio>
+
+#include <poll.h>
+
+/*
+ * Records the window tracking of the running session into a trace, which
+ * kxcbtracereplaybenchmark replays when given in KWINDOWSYSTEM_BENCHMARK_TRACE:
+ *
+ *   kwindowsystemtracer storm.trace [seconds]
+ *
+ * Records until interrupted unless a duration is given.
+ */
+static volatile std::sig_atomic_t s_interrupted = 0;
+
+static void interrupt(int)
+{
+    s_interrupted = 1;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    const QStringList arguments = app.arguments();
+    if (arguments.size() < 2 || arguments.size() > 3) {
+        fprintf(stderr, "Usage: %s <trace file> [seconds]\n", argv[0]);
+        return 1;
+    }
+    QDeadlineTimer deadline = arguments.size() == 3 ? QDeadlineTimer(arguments.at(2).toInt() * 1000) : QDeadlineTimer(QDeadlineTimer::Forever);
+
+    int screen = 0;
+    xcb_connection_t *c = xcb_connect(nullptr, &screen);
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "Cannot connect to the X server\n");
+        return 1;
+    }
+    if (!KXcbTrace::startRecording(c, KXUtils::rootWindow(c, screen), arguments.at(1))) {
+        fprintf(stderr, "Cannot write %s\n", qPrintable(arguments.at(1)));
+        return 1;
+    }
+
+    std::signal(SIGINT, interrupt);
+    std::signal(SIGTERM, interrupt);
+
+    qsizetype events = 0;
+    {
+        NETTracer tracer(c);
+        xcb_flush(c);
+        pollfd fd = {xcb_get_file_descriptor(c), POLLIN, 0};
+        while (!s_interrupted && !deadline.hasExpired() && !xcb_connection_has_error(c)) {
+            while (xcb_generic_event_t *event = xcb_poll_for_event(c)) {
+                KXcbTrace::recordEvent(c, event);
+                tracer.process(event);
+                free(event);
+                ++events;
+            }
+            xcb_flush(c);
+            poll(&fd, 1, deadline.isForever() ? 1000 : qBound(0, int(deadline.remainingTime()), 1000));
+        }
+        printf("Recorded %lld events, %lld changes of %lld windows\n", qlonglong(events), qlonglong(tracer.changes().size()), qlonglong(tracer.trackedClients().size()));
+    }
+
+    KXcbTrace::stopRecording();
+    xcb_disconnect(c);
+    return 0;
+}
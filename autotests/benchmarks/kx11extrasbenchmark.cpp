@@ -0,0 +1,258 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "benchmarkenvironment.h"
+#include "fakewindowmanager.h"
+#include "nettesthelper.h"
+
+#include <kx11extras.h>
+#include <netwm.h>
+
+#include <QPixmap>
+#include <QTest>
+
+#include <algorithm>
+#include <vector>
+
+#include <xcb/xcb_icccm.h>
+
+static const int s_stormWindowCount = 100;
+static const int s_iconWindowCount = 20;
+
+class KX11ExtrasBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkIcon_data();
+    void benchmarkIcon();
+    void benchmarkWMHintsIcons_data();
+    void benchmarkWMHintsIcons();
+    void benchmarkWorkArea();
+    void benchmarkStrutWorkArea();
+    void benchmarkPropertyNotifyStorm_data();
+    void benchmarkPropertyNotifyStorm();
+
+private:
+    void setNetIcon(xcb_window_t window);
+    void setPixmapIcon(xcb_window_t window);
+    void setPanelStrut(xcb_window_t window);
+
+    xcb_connection_t *m_connection = nullptr;
+    xcb_pixmap_t m_iconPixmap = XCB_PIXMAP_NONE;
+    xcb_window_t m_netIconWindow = XCB_WINDOW_NONE;
+    xcb_window_t m_pixmapIconWindow = XCB_WINDOW_NONE;
+    QList<WId> m_pixmapIconWindows;
+    QList<xcb_window_t> m_windows;
+};
+
+void KX11ExtrasBenchmark::initTestCase()
+{
+    m_connection = xcb_connect(BenchmarkEnvironment::self()->display().constData(), nullptr);
+    QVERIFY(!xcb_connection_has_error(m_connection));
+    m_windows = BenchmarkEnvironment::self()->createClients(m_connection, s_stormWindowCount);
+    QCOMPARE(m_windows.count(), s_stormWindowCount);
+
+    m_netIconWindow = m_windows.at(0);
+    m_pixmapIconWindow = m_windows.at(1);
+    setNetIcon(m_netIconWindow);
+    setPixmapIcon(m_pixmapIconWindow);
+    setPanelStrut(m_windows.at(2));
+    for (int i = 3; i < 3 + s_iconWindowCount; ++i) {
+        setPixmapIcon(m_windows.at(i));
+        m_pixmapIconWindows << m_windows.at(i);
+    }
+    xcb_flush(m_connection);
+
+    // start tracking, so that the storm hits windows KX11Extras knows about
+    QVERIFY(QTest::qWaitFor([this] {
+        return std::all_of(m_windows.cbegin(), m_windows.cend(), [](xcb_window_t window) {
+            return KX11Extras::hasWId(window);
+        });
+    }));
+}
+
+void KX11ExtrasBenchmark::cleanupTestCase()
+{
+    BenchmarkEnvironment::self()->destroyClients(m_connection, m_windows);
+    if (m_iconPixmap != XCB_PIXMAP_NONE) {
+        xcb_free_pixmap(m_connection, m_iconPixmap);
+    }
+    xcb_disconnect(m_connection);
+}
+
+void KX11ExtrasBenchmark::setNetIcon(xcb_window_t window)
+{
+    NETWinInfo info(m_connection, window, KXUtils::rootWindow(m_connection, 0), NET::Properties(), NET::Properties2());
+    // the usual set of sizes, so that picking the best match has something to choose from
+    bool replace = true;
+    for (int size : {16, 22, 32, 48, 64, 128}) {
+        std::vector<uint32_t> argb(size * size, 0xff3daee9);
+        NETIcon icon;
+        icon.size.width = size;
+        icon.size.height = size;
+        icon.data = reinterpret_cast<unsigned char *>(argb.data());
+        info.setIcon(icon, replace);
+        replace = false;
+    }
+}
+
+// all windows share the same pixmap
+void KX11ExtrasBenchmark::setPixmapIcon(xcb_window_t window)
+{
+    if (m_iconPixmap == XCB_PIXMAP_NONE) {
+        const xcb_screen_t *screen = xcb_setup_roots_iterator(xcb_get_setup(m_connection)).data;
+        m_iconPixmap = xcb_generate_id(m_connection);
+        xcb_create_pixmap(m_connection, screen->root_depth, m_iconPixmap, screen->root, 48, 48);
+        const xcb_gcontext_t gc = xcb_generate_id(m_connection);
+        const uint32_t foreground[] = {screen->white_pixel};
+        xcb_create_gc(m_connection, gc, m_iconPixmap, XCB_GC_FOREGROUND, foreground);
+        const xcb_rectangle_t rect = {0, 0, 48, 48};
+        xcb_poly_fill_rectangle(m_connection, m_iconPixmap, gc, 1, &rect);
+        xcb_free_gc(m_connection, gc);
+    }
+
+    xcb_icccm_wm_hints_t hints = {};
+    xcb_icccm_wm_hints_set_icon_pixmap(&hints, m_iconPixmap);
+    xcb_icccm_set_wm_hints(m_connection, window, &hints);
+}
+
+void KX11ExtrasBenchmark::setPanelStrut(xcb_window_t window)
+{
+    const QRect workArea = BenchmarkEnvironment::self()->windowManager()->workArea();
+    NETWinInfo info(m_connection, window, KXUtils::rootWindow(m_connection, 0), NET::Properties(), NET::Properties2());
+    NETStrut strut;
+    strut.bottom = FakeWindowManager::panelHeight;
+    info.setStrut(strut);
+    NETExtendedStrut extendedStrut;
+    extendedStrut.bottom_width = FakeWindowManager::panelHeight;
+    extendedStrut.bottom_start = workArea.left();
+    extendedStrut.bottom_end = workArea.right();
+    info.setExtendedStrut(extendedStrut);
+}
+
+void KX11ExtrasBenchmark::benchmarkIcon_data()
+{
+    QTest::addColumn<bool>("pixmap");
+    QTest::addColumn<int>("size");
+    QTest::addColumn<bool>("scale");
+    QTest::addColumn<int>("flags");
+
+    QTest::newRow("NETWM exact") << false << 32 << false << int(KX11Extras::NETWM);
+    QTest::newRow("NETWM scaled") << false << 40 << true << int(KX11Extras::NETWM);
+    QTest::newRow("WMHints") << true << 48 << false << int(KX11Extras::WMHints);
+    QTest::newRow("WMHints scaled") << true << 32 << true << int(KX11Extras::WMHints);
+}
+
+void KX11ExtrasBenchmark::benchmarkIcon()
+{
+    QFETCH(bool, pixmap);
+    QFETCH(int, size);
+    QFETCH(bool, scale);
+    QFETCH(int, flags);
+
+    const WId window = pixmap ? m_pixmapIconWindow : m_netIconWindow;
+    QBENCHMARK {
+        const QPixmap icon = KX11Extras::icon(window, size, size, scale, flags);
+        QVERIFY(!icon.isNull());
+    }
+}
+
+void KX11ExtrasBenchmark::benchmarkWMHintsIcons_data()
+{
+    QTest::addColumn<bool>("batched");
+
+    QTest::newRow("one by one") << false;
+    QTest::newRow("batched") << true;
+}
+
+// the legacy icons of a whole task bar
+void KX11ExtrasBenchmark::benchmarkWMHintsIcons()
+{
+    QFETCH(bool, batched);
+
+    const QList<QPixmap> icons = KX11Extras::wmHintsIcons(m_pixmapIconWindows, 32, 32, true);
+    QCOMPARE(icons.size(), m_pixmapIconWindows.size());
+    QCOMPARE(icons.first().toImage(), KX11Extras::icon(m_pixmapIconWindows.first(), 32, 32, true, KX11Extras::WMHints).toImage());
+
+    QBENCHMARK {
+        if (batched) {
+            (void)KX11Extras::wmHintsIcons(m_pixmapIconWindows, 32, 32, true);
+        } else {
+            for (WId window : std::as_const(m_pixmapIconWindows)) {
+                (void)KX11Extras::icon(window, 32, 32, true, KX11Extras::WMHints);
+            }
+        }
+    }
+}
+
+void KX11ExtrasBenchmark::benchmarkWorkArea()
+{
+    QCOMPARE(KX11Extras::workArea(), BenchmarkEnvironment::self()->windowManager()->workArea());
+    QBENCHMARK {
+        (void)KX11Extras::workArea();
+    }
+}
+
+void KX11ExtrasBenchmark::benchmarkStrutWorkArea()
+{
+    // computed from the struts of all windows instead of _NET_WORKAREA
+    QTRY_COMPARE(KX11Extras::workArea(QList<WId>()), BenchmarkEnvironment::self()->windowManager()->workArea());
+    QBENCHMARK {
+        (void)KX11Extras::workArea(QList<WId>());
+    }
+}
+
+void KX11ExtrasBenchmark::benchmarkPropertyNotifyStorm_data()
+{
+    QTest::addColumn<int>("windows");
+    QTest::addColumn<int>("rounds");
+
+    QTest::newRow("10 windows") << 10 << 10;
+    QTest::newRow("100 windows") << 100 << 10;
+    QTest::newRow("100 windows, 100 rounds") << 100 << 100;
+}
+
+void KX11ExtrasBenchmark::benchmarkPropertyNotifyStorm()
+{
+    QFETCH(int, windows);
+    QFETCH(int, rounds);
+
+    KXUtils::Atom netWmName(m_connection, QByteArrayLiteral("_NET_WM_NAME"));
+    KXUtils::Atom utf8String(m_connection, QByteArrayLiteral("UTF8_STRING"));
+    const WId last = m_windows.at(windows - 1);
+
+    // events arrive in order, once the last change is seen all others have been handled
+    bool lastChanged = false;
+    QMetaObject::Connection connection =
+        connect(KX11Extras::self(), &KX11Extras::windowChanged, this, [&lastChanged, last](WId window, NET::Properties properties) {
+            if (window == last && properties.testFlag(NET::WMName)) {
+                lastChanged = true;
+            }
+        });
+
+    int serial = 0;
+    QBENCHMARK {
+        lastChanged = false;
+        for (int round = 0; round < rounds; ++round) {
+            const QByteArray title = QByteArrayLiteral("storm ") + QByteArray::number(++serial);
+            for (int i = 0; i < windows; ++i) {
+                xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, m_windows.at(i), netWmName, utf8String, 8, title.length(), title.constData());
+            }
+        }
+        xcb_flush(m_connection);
+        QVERIFY(QTest::qWaitFor([&lastChanged] {
+            return lastChanged;
+        }));
+    }
+
+    disconnect(connection);
+}
+
+KWINDOWSYSTEM_BENCHMARK_MAIN(KX11ExtrasBenchmark)
+
+#include "kx11extrasbenchmark.moc"
@@ -0,0 +1,42 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "benchmarkenvironment.h"
+#include "kx11extras.h"
+#include "nettesthelper.h"
+
+#include <QTest>
+#include <private/qtx11extras_p.h>
+
+class KX11ExtrasStartupBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void benchmarkFirstUse();
+    void testCompositingState();
+};
+
+void KX11ExtrasStartupBenchmark::benchmarkFirstUse()
+{
+    // the event filter is created once per process, so only the first call measures startup
+    QBENCHMARK_ONCE {
+        (void)KX11Extras::stackingOrder();
+    }
+}
+
+void KX11ExtrasStartupBenchmark::testCompositingState()
+{
+    // the compositing state gathered during the pipelined startup has to match the server
+    xcb_connection_t *c = QX11Info::connection();
+    KXUtils::Atom netWmCm(c, QByteArrayLiteral("_NET_WM_CM_S") + QByteArray::number(QX11Info::appScreen()));
+    UniqueCPointer<xcb_get_selection_owner_reply_t> owner(xcb_get_selection_owner_reply(c, xcb_get_selection_owner_unchecked(c, netWmCm), nullptr));
+    QVERIFY(owner);
+    QCOMPARE(KX11Extras::compositingActive(), owner->owner != XCB_WINDOW_NONE);
+}
+
+KWINDOWSYSTEM_BENCHMARK_MAIN(KX11ExtrasStartupBenchmark)
+
+#include "kx11extrasstartupbenchmark.moc"
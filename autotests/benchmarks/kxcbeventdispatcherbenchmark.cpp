@@ -0,0 +1,109 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "benchmarkenvironment.h"
+#include "cptr_p.h"
+#include "kxcbevent_p.h"
+
+#include <kselectionowner.h>
+#include <kselectionwatcher.h>
+
+#include <QAbstractEventDispatcher>
+#include <QSignalSpy>
+#include <QTest>
+#include <private/qtx11extras_p.h>
+
+#include <memory>
+#include <vector>
+
+// Measures how the cost of an event that nobody is interested in grows with the number of
+// selection watchers. Every watcher used to inspect every event of the connection.
+class KXcbEventDispatcherBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testWatcherNotified();
+    void benchmarkUnrelatedEvents_data();
+    void benchmarkUnrelatedEvents();
+
+private:
+    static xcb_atom_t internAtom(const QByteArray &name);
+};
+
+xcb_atom_t KXcbEventDispatcherBenchmark::internAtom(const QByteArray &name)
+{
+    xcb_connection_t *c = QX11Info::connection();
+    UniqueCPointer<xcb_intern_atom_reply_t> reply(xcb_intern_atom_reply(c, xcb_intern_atom(c, false, name.length(), name.constData()), nullptr));
+    return reply ? reply->atom : XCB_ATOM_NONE;
+}
+
+void KXcbEventDispatcherBenchmark::testWatcherNotified()
+{
+    // the routed events still reach the watchers they are meant for
+    KSelectionWatcher watcher("_KDE_KXCBEVENTDISPATCHERBENCHMARK", -1);
+    KSelectionWatcher otherWatcher("_KDE_KXCBEVENTDISPATCHERBENCHMARK_OTHER", -1);
+    QSignalSpy newOwnerSpy(&watcher, &KSelectionWatcher::newOwner);
+    QSignalSpy lostOwnerSpy(&watcher, &KSelectionWatcher::lostOwner);
+    QSignalSpy otherNewOwnerSpy(&otherWatcher, &KSelectionWatcher::newOwner);
+
+    auto owner = std::make_unique<KSelectionOwner>("_KDE_KXCBEVENTDISPATCHERBENCHMARK", -1);
+    QSignalSpy claimedSpy(owner.get(), &KSelectionOwner::claimedOwnership);
+    owner->claim(false);
+    QVERIFY(claimedSpy.wait());
+    QVERIFY(newOwnerSpy.wait());
+    QCOMPARE(newOwnerSpy.first().first().value<xcb_window_t>(), owner->ownerWindow());
+
+    owner.reset();
+    QVERIFY(lostOwnerSpy.wait());
+    QVERIFY(otherNewOwnerSpy.isEmpty());
+}
+
+void KXcbEventDispatcherBenchmark::benchmarkUnrelatedEvents_data()
+{
+    QTest::addColumn<int>("watchers");
+
+    QTest::newRow("1") << 1;
+    QTest::newRow("10") << 10;
+    QTest::newRow("100") << 100;
+}
+
+void KXcbEventDispatcherBenchmark::benchmarkUnrelatedEvents()
+{
+    QFETCH(int, watchers);
+
+    std::vector<std::unique_ptr<KSelectionWatcher>> selectionWatchers;
+    for (int i = 0; i < watchers; ++i) {
+        const xcb_atom_t selection = internAtom(QByteArrayLiteral("_KDE_KXCBEVENTDISPATCHERBENCHMARK_") + QByteArray::number(i));
+        selectionWatchers.push_back(std::make_unique<KSelectionWatcher>(selection, -1));
+    }
+
+    // a property change on some other client and a client message of an unrelated type
+    KXcbEvent<xcb_property_notify_event_t> propertyNotify;
+    propertyNotify.response_type = XCB_PROPERTY_NOTIFY;
+    propertyNotify.window = QX11Info::appRootWindow() + 1;
+    propertyNotify.atom = XCB_ATOM_WM_NAME;
+
+    KXcbEvent<xcb_client_message_event_t> clientMessage;
+    clientMessage.response_type = XCB_CLIENT_MESSAGE;
+    clientMessage.format = 32;
+    clientMessage.window = QX11Info::appRootWindow();
+    clientMessage.type = internAtom(QByteArrayLiteral("_KDE_KXCBEVENTDISPATCHERBENCHMARK_UNRELATED"));
+
+    QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance();
+    QVERIFY(dispatcher);
+    qintptr result = 0;
+
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i) {
+            dispatcher->filterNativeEvent(QByteArrayLiteral("xcb_generic_event_t"), &propertyNotify, &result);
+            dispatcher->filterNativeEvent(QByteArrayLiteral("xcb_generic_event_t"), &clientMessage, &result);
+        }
+    }
+}
+
+KWINDOWSYSTEM_BENCHMARK_MAIN(KXcbEventDispatcherBenchmark)
+
+#include "kxcbeventdispatcherbenchmark.moc"
@@ -0,0 +1,139 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "benchmarkenvironment.h"
+#include "kxcbtrace_p.h"
+#include "kxcbtracereplay.h"
+#include "nettesthelper.h"
+#include "nettracer.h"
+
+#include <netwm.h>
+
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+
+static const int s_stormWindowCount = 100;
+static const int s_stormRounds = 20;
+
+// Replays an event storm offline: by default one generated on the benchmark server, or the
+// trace given in KWINDOWSYSTEM_BENCHMARK_TRACE, e.g. one taken with kwindowsystemtracer
+class KXcbTraceReplayBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkReplay();
+
+private:
+    bool recordStorm(const QString &fileName);
+    void process(xcb_connection_t *c, NETTracer *tracer);
+
+    QTemporaryDir m_dir;
+    std::unique_ptr<KXcbTraceReplay> m_replay;
+    // empty when replaying a trace from elsewhere
+    QList<NETTracer::Change> m_recorded;
+};
+
+void KXcbTraceReplayBenchmark::initTestCase()
+{
+    QString fileName = qEnvironmentVariable("KWINDOWSYSTEM_BENCHMARK_TRACE");
+    if (fileName.isEmpty()) {
+        QVERIFY(m_dir.isValid());
+        fileName = m_dir.filePath(QStringLiteral("storm.trace"));
+        QVERIFY(recordStorm(fileName));
+    }
+
+    m_replay = std::make_unique<KXcbTraceReplay>(fileName);
+    QVERIFY2(m_replay->isValid(), qPrintable(m_replay->errorString()));
+    qDebug() << "Replaying" << m_replay->eventCount() << "events and" << m_replay->replyCount() << "replies";
+}
+
+void KXcbTraceReplayBenchmark::cleanupTestCase()
+{
+    m_replay.reset();
+}
+
+void KXcbTraceReplayBenchmark::process(xcb_connection_t *c, NETTracer *tracer)
+{
+    while (xcb_generic_event_t *event = xcb_poll_for_event(c)) {
+        KXcbTrace::recordEvent(c, event);
+        tracer->process(event);
+        free(event);
+    }
+}
+
+// Clients come up, then every one of them changes its name and icon in each round
+bool KXcbTraceReplayBenchmark::recordStorm(const QString &fileName)
+{
+    const QByteArray display = BenchmarkEnvironment::self()->display();
+    xcb_connection_t *c = xcb_connect(display.constData(), nullptr);
+    xcb_connection_t *clients = xcb_connect(display.constData(), nullptr);
+    const xcb_window_t root = KXUtils::rootWindow(c, 0);
+    if (!KXcbTrace::startRecording(c, root, fileName)) {
+        return false;
+    }
+    auto tracer = std::make_unique<NETTracer>(c);
+
+    const QList<xcb_window_t> windows = BenchmarkEnvironment::self()->createClients(clients, s_stormWindowCount);
+    bool tracked = QTest::qWaitFor([&] {
+        process(c, tracer.get());
+        return tracer->trackedClients().size() == windows.size();
+    });
+
+    const QByteArray name = QByteArrayLiteral("storm ");
+    uint32_t argb[16 * 16];
+    for (int round = 0; tracked && round < s_stormRounds; ++round) {
+        std::fill(std::begin(argb), std::end(argb), 0xff000000 | round);
+        for (xcb_window_t window : windows) {
+            NETWinInfo info(clients, window, root, NET::Properties(), NET::Properties2());
+            info.setName((name + QByteArray::number(round)).constData());
+            NETIcon icon;
+            icon.size.width = icon.size.height = 16;
+            icon.data = reinterpret_cast<unsigned char *>(argb);
+            info.setIcon(icon);
+        }
+        free(xcb_get_input_focus_reply(clients, xcb_get_input_focus(clients), nullptr));
+        free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), nullptr));
+        process(c, tracer.get());
+    }
+
+    BenchmarkEnvironment::self()->destroyClients(clients, windows);
+    tracked = tracked && QTest::qWaitFor([&] {
+        process(c, tracer.get());
+        return tracer->trackedClients().isEmpty();
+    });
+
+    KXcbTrace::stopRecording();
+    m_recorded = tracer->changes();
+    tracer.reset();
+    xcb_disconnect(clients);
+    xcb_disconnect(c);
+    return tracked;
+}
+
+void KXcbTraceReplayBenchmark::benchmarkReplay()
+{
+    QBENCHMARK {
+        m_replay->rewind();
+        NETTracer tracer(m_replay->connection());
+        while (xcb_generic_event_t *event = m_replay->nextEvent()) {
+            tracer.process(event);
+        }
+        if (!m_recorded.isEmpty()) {
+            QCOMPARE(tracer.changes().size(), m_recorded.size());
+        }
+    }
+    QCOMPARE(m_replay->missingReplies(), 0);
+}
+
+KWINDOWSYSTEM_BENCHMARK_MAIN(KXcbTraceReplayBenchmark)
+
+#include "kxcbtracereplaybenchmark.moc"
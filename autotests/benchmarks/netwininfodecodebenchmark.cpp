@@ -0,0 +1,179 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "benchmarkenvironment.h"
+#include "nettesthelper.h"
+
+#include <netwm.h>
+
+#include <QTest>
+
+static const int s_messageCount = 1000;
+
+static const char *const s_stateAtoms[] = {
+    "_NET_WM_STATE_MODAL",
+    "_NET_WM_STATE_STICKY",
+    "_NET_WM_STATE_MAXIMIZED_VERT",
+    "_NET_WM_STATE_MAXIMIZED_HORZ",
+    "_NET_WM_STATE_SHADED",
+    "_NET_WM_STATE_SKIP_TASKBAR",
+    "_NET_WM_STATE_SKIP_PAGER",
+    "_KDE_NET_WM_STATE_SKIP_SWITCHER",
+    "_NET_WM_STATE_HIDDEN",
+    "_NET_WM_STATE_FULLSCREEN",
+    "_NET_WM_STATE_ABOVE",
+    "_NET_WM_STATE_BELOW",
+    "_NET_WM_STATE_DEMANDS_ATTENTION",
+    "_NET_WM_STATE_FOCUSED",
+};
+
+static const char *const s_typeAtoms[] = {
+    "_KDE_NET_WM_WINDOW_TYPE_APPLET_POPUP",
+    "_KDE_NET_WM_WINDOW_TYPE_CRITICAL_NOTIFICATION",
+    "_NET_WM_WINDOW_TYPE_DND",
+    "_NET_WM_WINDOW_TYPE_NORMAL",
+};
+
+static const char *const s_actionAtoms[] = {
+    "_NET_WM_ACTION_MOVE",
+    "_NET_WM_ACTION_RESIZE",
+    "_NET_WM_ACTION_MINIMIZE",
+    "_NET_WM_ACTION_SHADE",
+    "_NET_WM_ACTION_STICK",
+    "_NET_WM_ACTION_MAXIMIZE_VERT",
+    "_NET_WM_ACTION_MAXIMIZE_HORZ",
+    "_NET_WM_ACTION_FULLSCREEN",
+    "_NET_WM_ACTION_CHANGE_DESKTOP",
+    "_NET_WM_ACTION_CLOSE",
+};
+
+// Remembers the last state change a client asked for
+class StateRecorder : public NETWinInfo
+{
+public:
+    using NETWinInfo::NETWinInfo;
+
+    NET::States lastMask;
+
+protected:
+    void changeState(NET::States state, NET::States mask) override
+    {
+        Q_UNUSED(state);
+        lastMask = mask;
+    }
+};
+
+// Turning the atoms of _NET_WM_STATE messages, and of the state, window type and
+// allowed actions properties, into the flags NETWinInfo hands out
+class NETWinInfoDecodeBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkStateMessage_data();
+    void benchmarkStateMessage();
+    void benchmarkProperties();
+
+private:
+    xcb_atom_t atom(const char *name) const;
+
+    xcb_connection_t *m_connection = nullptr;
+    xcb_window_t m_rootWindow = XCB_WINDOW_NONE;
+    QList<xcb_window_t> m_windows;
+};
+
+xcb_atom_t NETWinInfoDecodeBenchmark::atom(const char *name) const
+{
+    return KXUtils::Atom(m_connection, QByteArray(name));
+}
+
+void NETWinInfoDecodeBenchmark::initTestCase()
+{
+    m_connection = xcb_connect(BenchmarkEnvironment::self()->display().constData(), nullptr);
+    QVERIFY(!xcb_connection_has_error(m_connection));
+    m_rootWindow = KXUtils::rootWindow(m_connection, 0);
+    m_windows = BenchmarkEnvironment::self()->createClients(m_connection, 1);
+    QCOMPARE(m_windows.count(), 1);
+
+    // a window with everything set, so all the atoms get decoded
+    QList<xcb_atom_t> states;
+    for (const char *name : s_stateAtoms) {
+        states << atom(name);
+    }
+    QList<xcb_atom_t> types;
+    for (const char *name : s_typeAtoms) {
+        types << atom(name);
+    }
+    QList<xcb_atom_t> actions;
+    for (const char *name : s_actionAtoms) {
+        actions << atom(name);
+    }
+    const xcb_window_t window = m_windows.first();
+    xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, window, atom("_NET_WM_STATE"), XCB_ATOM_ATOM, 32, states.size(), states.constData());
+    xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, window, atom("_NET_WM_WINDOW_TYPE"), XCB_ATOM_ATOM, 32, types.size(), types.constData());
+    xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, window, atom("_NET_WM_ALLOWED_ACTIONS"), XCB_ATOM_ATOM, 32, actions.size(), actions.constData());
+    free(xcb_get_input_focus_reply(m_connection, xcb_get_input_focus(m_connection), nullptr));
+}
+
+void NETWinInfoDecodeBenchmark::cleanupTestCase()
+{
+    BenchmarkEnvironment::self()->destroyClients(m_connection, m_windows);
+    xcb_disconnect(m_connection);
+}
+
+void NETWinInfoDecodeBenchmark::benchmarkStateMessage_data()
+{
+    QTest::addColumn<QByteArray>("first");
+    QTest::addColumn<QByteArray>("second");
+    QTest::addColumn<uint>("mask");
+
+    QTest::newRow("modal") << QByteArrayLiteral("_NET_WM_STATE_MODAL") << QByteArray() << uint(NET::Modal);
+    QTest::newRow("maximize") << QByteArrayLiteral("_NET_WM_STATE_MAXIMIZED_VERT") << QByteArrayLiteral("_NET_WM_STATE_MAXIMIZED_HORZ") << uint(NET::Max);
+    QTest::newRow("focused") << QByteArrayLiteral("_NET_WM_STATE_FOCUSED") << QByteArrayLiteral("_NET_WM_STATE_STAYS_ON_TOP")
+                             << uint(NET::Focused | NET::KeepAbove);
+    QTest::newRow("unknown") << QByteArrayLiteral("_BENCHMARK_STATE") << QByteArray() << 0u;
+}
+
+void NETWinInfoDecodeBenchmark::benchmarkStateMessage()
+{
+    QFETCH(QByteArray, first);
+    QFETCH(QByteArray, second);
+    QFETCH(uint, mask);
+
+    StateRecorder info(m_connection, m_windows.first(), m_rootWindow, NET::Properties(), NET::Properties2(), NET::WindowManager);
+
+    xcb_client_message_event_t message = {};
+    message.response_type = XCB_CLIENT_MESSAGE;
+    message.format = 32;
+    message.window = m_windows.first();
+    message.type = atom("_NET_WM_STATE");
+    message.data.data32[0] = 2; // toggle
+    message.data.data32[1] = atom(first.constData());
+    message.data.data32[2] = second.isEmpty() ? XCB_ATOM_NONE : atom(second.constData());
+
+    QBENCHMARK {
+        for (int i = 0; i < s_messageCount; ++i) {
+            info.event(reinterpret_cast<xcb_generic_event_t *>(&message));
+        }
+    }
+    QCOMPARE(info.lastMask, NET::States(mask));
+}
+
+// includes the round trip for the properties
+void NETWinInfoDecodeBenchmark::benchmarkProperties()
+{
+    QBENCHMARK {
+        NETWinInfo info(m_connection, m_windows.first(), m_rootWindow, NET::WMState | NET::WMWindowType, NET::WM2AllowedActions, NET::WindowManager);
+        QCOMPARE(info.windowType(NET::AllTypesMask), NET::AppletPopup);
+        QVERIFY(info.state() & NET::Focused);
+        QVERIFY(info.allowedActions() & NET::ActionClose);
+    }
+}
+
+KWINDOWSYSTEM_BENCHMARK_MAIN(NETWinInfoDecodeBenchmark)
+
+#include "netwininfodecodebenchmark.moc"
@@ -0,0 +1,140 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "benchmarkenvironment.h"
+#include "nettesthelper.h"
+
+#include <netwm.h>
+
+#include <QTest>
+
+#include <memory>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+static const int s_windowCount = 2000;
+
+// Heap used by NETWinInfo objects holding the strings of a window, the way a window
+// manager or task manager keeps one for each window it tracks
+class NETWinInfoMemoryBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkMemory_data();
+    void benchmarkMemory();
+    void benchmarkRename();
+
+private:
+    std::vector<std::unique_ptr<NETWinInfo>> track(NET::Properties properties, NET::Properties2 properties2);
+
+    xcb_connection_t *m_connection = nullptr;
+    xcb_window_t m_rootWindow = XCB_WINDOW_NONE;
+    QList<xcb_window_t> m_windows;
+};
+
+void NETWinInfoMemoryBenchmark::initTestCase()
+{
+    m_connection = xcb_connect(BenchmarkEnvironment::self()->display().constData(), nullptr);
+    QVERIFY(!xcb_connection_has_error(m_connection));
+    m_rootWindow = KXUtils::rootWindow(m_connection, 0);
+    m_windows = BenchmarkEnvironment::self()->createClients(m_connection, s_windowCount);
+    QCOMPARE(m_windows.count(), s_windowCount);
+
+    // what a typical application sets, besides the name createClients() gives it
+    KXUtils::Atom windowRole(m_connection, QByteArrayLiteral("WM_WINDOW_ROLE"));
+    const QByteArray windowClass("benchmark\0Benchmark\0", 20);
+    const QByteArray clientMachine = QByteArrayLiteral("localhost.localdomain");
+    for (xcb_window_t window : std::as_const(m_windows)) {
+        const QByteArray id = QByteArray::number(window);
+        NETWinInfo client(m_connection, window, m_rootWindow, NET::Properties(), NET::Properties2());
+        client.setIconName("benchmark");
+        client.setStartupId(QByteArray("benchmark-startup-" + id).constData());
+        client.setDesktopFileName("org.kde.benchmark");
+        client.setAppMenuServiceName(QByteArray(":1." + id).constData());
+        client.setAppMenuObjectPath(QByteArray("/MenuBar/" + id).constData());
+        client.setActivities("11111111-2222-3333-4444-555555555555");
+        xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, window, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 8, windowClass.size(), windowClass.constData());
+        xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, window, windowRole, XCB_ATOM_STRING, 8, 10, "mainwindow");
+        xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, window, XCB_ATOM_WM_CLIENT_MACHINE, XCB_ATOM_STRING, 8, clientMachine.size(), clientMachine.constData());
+
+        NETWinInfo wm(m_connection, window, m_rootWindow, NET::Properties(), NET::Properties2(), NET::WindowManager);
+        wm.setVisibleName(QByteArray("client " + id + " <2>").constData());
+    }
+    free(xcb_get_input_focus_reply(m_connection, xcb_get_input_focus(m_connection), nullptr));
+}
+
+void NETWinInfoMemoryBenchmark::cleanupTestCase()
+{
+    BenchmarkEnvironment::self()->destroyClients(m_connection, m_windows);
+    xcb_disconnect(m_connection);
+}
+
+std::vector<std::unique_ptr<NETWinInfo>> NETWinInfoMemoryBenchmark::track(NET::Properties properties, NET::Properties2 properties2)
+{
+    std::vector<std::unique_ptr<NETWinInfo>> infos;
+    infos.reserve(m_windows.size());
+    for (xcb_window_t window : std::as_const(m_windows)) {
+        infos.push_back(std::make_unique<NETWinInfo>(m_connection, window, m_rootWindow, properties, properties2, NET::WindowManager));
+    }
+    return infos;
+}
+
+void NETWinInfoMemoryBenchmark::benchmarkMemory_data()
+{
+    QTest::addColumn<bool>("interned");
+    QTest::newRow("copied") << false;
+    QTest::newRow("interned") << true;
+}
+
+void NETWinInfoMemoryBenchmark::benchmarkMemory()
+{
+#if defined(__GLIBC__)
+    QFETCH(bool, interned);
+    NETWinInfo::setStringInterningEnabled(interned);
+    const NET::Properties properties = NET::WMName | NET::WMVisibleName | NET::WMIconName;
+    const NET::Properties2 properties2 = NET::WM2WindowClass | NET::WM2WindowRole | NET::WM2ClientMachine | NET::WM2StartupId | NET::WM2DesktopFileName
+        | NET::WM2AppMenuServiceName | NET::WM2AppMenuObjectPath | NET::WM2Activities;
+
+    // the atoms and the connection buffers are set up by then
+    track(properties, properties2);
+
+    const size_t before = mallinfo2().uordblks;
+    auto infos = track(properties, properties2);
+    const size_t after = mallinfo2().uordblks;
+    NETWinInfo::setStringInterningEnabled(false);
+    QVERIFY(infos.front()->name() && infos.front()->windowClassClass() && infos.front()->appMenuObjectPath());
+    qDebug() << "Heap in use for" << infos.size() << "windows:" << after - before << "bytes";
+
+    // per window
+    QTest::setBenchmarkResult(qreal(after - before) / infos.size(), QTest::BytesAllocated);
+#else
+    QSKIP("Measuring the heap needs glibc");
+#endif
+}
+
+// Every window changes its name, as the strings are replaced the heap gets churned
+void NETWinInfoMemoryBenchmark::benchmarkRename()
+{
+    auto infos = track(NET::WMName | NET::WMVisibleName | NET::WMIconName, NET::WM2WindowClass | NET::WM2DesktopFileName | NET::WM2Activities);
+    int round = 0;
+    QBENCHMARK {
+        const QByteArray name = "renamed " + QByteArray::number(round++);
+        for (const auto &info : infos) {
+            info->setVisibleName(name.constData());
+            info->setVisibleIconName(name.constData());
+        }
+    }
+    xcb_flush(m_connection);
+}
+
+KWINDOWSYSTEM_BENCHMARK_MAIN(NETWinInfoMemoryBenchmark)
+
+#include "netwininfomemorybenchmark.moc"
@@ -0,0 +1,116 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "benchmarkenvironment.h"
+#include <netwm.h>
+
+#include <QTest>
+#include <private/qtx11extras_p.h>
+
+class NetWmInfoUpdateBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testReadBack();
+    void benchmarkWinInfoUpdate();
+    void benchmarkRootInfoUpdate();
+
+private:
+    xcb_window_t m_window = XCB_WINDOW_NONE;
+};
+
+void NetWmInfoUpdateBenchmark::initTestCase()
+{
+    xcb_connection_t *c = QX11Info::connection();
+    QVERIFY(c);
+
+    m_window = xcb_generate_id(c);
+    const uint32_t values[] = {true};
+    xcb_create_window(c,
+                      XCB_COPY_FROM_PARENT,
+                      m_window,
+                      QX11Info::appRootWindow(),
+                      0,
+                      0,
+                      100,
+                      100,
+                      0,
+                      XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                      XCB_COPY_FROM_PARENT,
+                      XCB_CW_OVERRIDE_REDIRECT,
+                      values);
+
+    NETWinInfo client(c, m_window, QX11Info::appRootWindow(), NET::Properties(), NET::Properties2(), NET::Client);
+    client.setName("benchmark");
+    client.setIconName("benchmark icon");
+    client.setPid(4242);
+    client.setWindowType(NET::Dialog);
+    client.setIconGeometry(NETRect(QRect(1, 2, 3, 4)));
+    client.setStartupId("startup");
+    client.setDesktopFileName("org.kde.benchmark");
+    client.setOpacity(0x7fffffff);
+    client.setUserTime(42);
+    client.setBlockingCompositing(true);
+
+    NETWinInfo wm(c, m_window, QX11Info::appRootWindow(), NET::Properties(), NET::Properties2(), NET::WindowManager);
+    NETStrut strut;
+    strut.left = 1;
+    strut.right = 2;
+    strut.top = 3;
+    strut.bottom = 4;
+    wm.setFrameExtents(strut);
+
+    xcb_flush(c);
+}
+
+void NetWmInfoUpdateBenchmark::cleanupTestCase()
+{
+    xcb_destroy_window(QX11Info::connection(), m_window);
+    xcb_flush(QX11Info::connection());
+}
+
+void NetWmInfoUpdateBenchmark::testReadBack()
+{
+    // every row of the property table has to end up in the right field
+    NETWinInfo info(QX11Info::connection(), m_window, QX11Info::appRootWindow(), NET::WMAllProperties, NET::WM2AllProperties);
+    QCOMPARE(info.name(), "benchmark");
+    QCOMPARE(info.iconName(), "benchmark icon");
+    QCOMPARE(info.pid(), 4242);
+    QCOMPARE(info.windowType(NET::AllTypesMask), NET::Dialog);
+    QCOMPARE(info.iconGeometry().pos.x, 1);
+    QCOMPARE(info.iconGeometry().size.height, 4);
+    QCOMPARE(info.startupId(), "startup");
+    QCOMPARE(info.desktopFileName(), "org.kde.benchmark");
+    QCOMPARE(info.opacity(), 0x7fffffffUL);
+    QCOMPARE(info.userTime(), 42u);
+    QVERIFY(info.isBlockingCompositing());
+    QCOMPARE(info.frameExtents().left, 1);
+    QCOMPARE(info.frameExtents().bottom, 4);
+}
+
+void NetWmInfoUpdateBenchmark::benchmarkWinInfoUpdate()
+{
+    xcb_connection_t *c = QX11Info::connection();
+    QBENCHMARK {
+        NETWinInfo info(c, m_window, QX11Info::appRootWindow(), NET::WMAllProperties, NET::WM2AllProperties);
+        QVERIFY(info.name());
+    }
+}
+
+void NetWmInfoUpdateBenchmark::benchmarkRootInfoUpdate()
+{
+    xcb_connection_t *c = QX11Info::connection();
+    QBENCHMARK {
+        NETRootInfo info(c, NET::WMAllProperties, NET::WM2AllProperties);
+        Q_UNUSED(info.numberOfDesktops());
+    }
+}
+
+KWINDOWSYSTEM_BENCHMARK_MAIN(NetWmInfoUpdateBenchmark)
+
+#include "netwminfoupdatebenchmark.moc"
@@ -0,0 +1,114 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "windoweffects.h"
+
+#include <QRasterWindow>
+#include <QTest>
+
+#include <memory>
+
+class WindowEffectsTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testWindowDestroyed();
+    void testSurfaceDestroyed();
+    void testSetAgain();
+
+private:
+    // whether effects keeps anything for window
+    static bool tracks(const WindowEffects &effects, QWindow *window);
+};
+
+bool WindowEffectsTest::tracks(const WindowEffects &effects, QWindow *window)
+{
+    return effects.m_windowDestroyedWatchers.contains(window) || effects.m_surfaceDestroyedWatchers.contains(window) || effects.m_blurRegions.contains(window)
+        || effects.m_backgroundConstrastRegions.contains(window) || effects.m_slideMap.contains(window) || effects.m_blurs.contains(window)
+        || effects.m_contrasts.contains(window) || effects.m_slides.contains(window) || effects.m_blurSurfaces.contains(window)
+        || effects.m_contrastSurfaces.contains(window) || effects.m_slideSurfaces.contains(window) || effects.m_regionCache.contains(window)
+        || effects.m_backgroundEffects.contains(window);
+}
+
+void WindowEffectsTest::testWindowDestroyed()
+{
+    WindowEffects effects;
+    auto window = std::make_unique<QRasterWindow>();
+    window->show();
+    QVERIFY(QTest::qWaitForWindowExposed(window.get()));
+
+    effects.enableBlurBehind(window.get(), true, QRegion(0, 0, 10, 10));
+    effects.enableBackgroundContrast(window.get(), true, 1, 1, 1, QRegion(0, 0, 10, 10));
+    effects.slideWindow(window.get(), KWindowEffects::TopEdge, 0);
+    QVERIFY(tracks(effects, window.get()));
+
+    // nothing is left behind for the address, a later window may get it
+    QWindow *const destroyed = window.get();
+    window.reset();
+    QVERIFY(!tracks(effects, destroyed));
+}
+
+void WindowEffectsTest::testSurfaceDestroyed()
+{
+    WindowEffects effects;
+    QRasterWindow window;
+    window.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&window));
+
+    const QRegion region(0, 0, 10, 10);
+    effects.enableBlurBehind(&window, true, region);
+    effects.slideWindow(&window, KWindowEffects::BottomEdge, 5);
+
+    // the effects are kept for the next surface, only what was sent for the old one is dropped
+    window.destroy();
+    QCOMPARE(effects.m_blurRegions.value(&window), region);
+    QVERIFY(effects.m_slideMap.contains(&window));
+    QVERIFY(!effects.m_blurs.contains(&window));
+    QVERIFY(!effects.m_slides.contains(&window));
+    QVERIFY(!effects.m_blurSurfaces.contains(&window));
+    QVERIFY(!effects.m_slideSurfaces.contains(&window));
+
+    // the new surface is watched again
+    window.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&window));
+    QVERIFY(static_cast<bool>(effects.m_surfaceDestroyedWatchers.value(&window)));
+    QCOMPARE(effects.m_blurRegions.value(&window), region);
+
+    effects.enableBlurBehind(&window, false);
+    effects.slideWindow(&window, KWindowEffects::NoEdge, 0);
+    QVERIFY(!tracks(effects, &window));
+}
+
+void WindowEffectsTest::testSetAgain()
+{
+    WindowEffects effects;
+    auto window = std::make_unique<QRasterWindow>();
+    window->show();
+    QVERIFY(QTest::qWaitForWindowExposed(window.get()));
+
+    // unsetting the only effect forgets the window
+    effects.enableBlurBehind(window.get(), true, QRegion(0, 0, 10, 10));
+    effects.enableBlurBehind(window.get(), false);
+    QVERIFY(!tracks(effects, window.get()));
+
+    effects.enableBlurBehind(window.get(), true, QRegion(0, 0, 20, 20));
+    QCOMPARE(effects.m_blurRegions.value(window.get()), QRegion(0, 0, 20, 20));
+    QVERIFY(effects.m_windowDestroyedWatchers.contains(window.get()));
+
+    // a window replacing a destroyed one starts out without effects
+    window.reset();
+    window = std::make_unique<QRasterWindow>();
+    window->show();
+    QVERIFY(QTest::qWaitForWindowExposed(window.get()));
+    QVERIFY(!effects.m_blurRegions.contains(window.get()));
+    effects.enableBlurBehind(window.get(), true, QRegion(0, 0, 30, 30));
+    QCOMPARE(effects.m_blurRegions.size(), 1);
+    QCOMPARE(effects.m_blurRegions.value(window.get()), QRegion(0, 0, 30, 30));
+}
+
+QTEST_MAIN(WindowEffectsTest)
+
+#include "wayland_windoweffects.moc"
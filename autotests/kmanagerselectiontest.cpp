@@ -35,9 +35,12 @@ void KManagerSelectionTest::claim(KSelectionOwner *owner, bool force, bool force
 {
     QSignalSpy claimSpy(owner, &KSelectionOwner::claimedOwnership);
     owner->claim(force, forceKill);
+    // not owned until the claim is confirmed
+    QVERIFY(owner->ownerWindow() == XCB_WINDOW_NONE);
     xSync();
     QVERIFY(claimSpy.wait());
     QCOMPARE(claimSpy.count(), 1);
+    QVERIFY(owner->ownerWindow() != XCB_WINDOW_NONE);
 }
 
 void KManagerSelectionTest::testAcquireRelease()
@@ -134,6 +137,65 @@ void KManagerSelectionTest::testWatching()
     QVERIFY(sw.lostowner == false);
 }
 
+void KManagerSelectionTest::testAsyncInitiallyOwned()
+{
+    // test that the current owner is announced once the asynchronous queries are answered
+    KSelectionOwner owner(SNAME);
+    claim(&owner);
+    KSelectionWatcher watcher(SNAME, KSelectionWatcher::QueryMode::Asynchronous);
+    QVERIFY(watcher.owner() == XCB_WINDOW_NONE);
+    QSignalSpy newOwnerSpy(&watcher, &KSelectionWatcher::newOwner);
+    QVERIFY(newOwnerSpy.wait());
+    QCOMPARE(newOwnerSpy.first().first().value<xcb_window_t>(), owner.ownerWindow());
+    QCOMPARE(watcher.owner(), owner.ownerWindow());
+
+    QSignalSpy lostOwnerSpy(&watcher, &KSelectionWatcher::lostOwner);
+    owner.release();
+    QVERIFY(lostOwnerSpy.wait(2000));
+    QVERIFY(watcher.owner() == XCB_WINDOW_NONE);
+}
+
+void KManagerSelectionTest::testAsyncWatching()
+{
+    // test that an asynchronous KSelectionWatcher follows ownership changes
+    KSelectionWatcher watcher(SNAME, KSelectionWatcher::QueryMode::Asynchronous);
+    KSelectionOwner owner1(SNAME);
+    KSelectionOwner owner2(SNAME);
+    SigCheckWatcher sw(watcher);
+    QSignalSpy newOwnerSpy(&watcher, &KSelectionWatcher::newOwner);
+    claim(&owner1);
+    QVERIFY(newOwnerSpy.wait());
+    QCOMPARE(watcher.owner(), owner1.ownerWindow());
+
+    newOwnerSpy.clear();
+    claim(&owner2, true, false);
+    QVERIFY(newOwnerSpy.wait());
+    QCOMPARE(watcher.owner(), owner2.ownerWindow());
+    QVERIFY(sw.lostowner == false);
+
+    QSignalSpy lostOwnerSpy(&watcher, &KSelectionWatcher::lostOwner);
+    owner2.release();
+    xSync();
+    QVERIFY(lostOwnerSpy.wait());
+    QVERIFY(sw.lostowner == true);
+    QVERIFY(watcher.owner() == XCB_WINDOW_NONE);
+}
+
+void KManagerSelectionTest::testClaimReportsThroughSignals()
+{
+    // test that claim() never answers synchronously, not even when the selection is taken
+    KSelectionOwner owner1(SNAME);
+    claim(&owner1);
+
+    KSelectionOwner owner2(SNAME);
+    QSignalSpy failedSpy(&owner2, &KSelectionOwner::failedToClaimOwnership);
+    owner2.claim(false);
+    QVERIFY(failedSpy.isEmpty());
+    QVERIFY(failedSpy.wait());
+    QVERIFY(owner2.ownerWindow() == XCB_WINDOW_NONE);
+    QVERIFY(owner1.ownerWindow() != XCB_WINDOW_NONE);
+}
+
 SigCheckOwner::SigCheckOwner(const KSelectionOwner &owner)
     : lostownership(false)
 {
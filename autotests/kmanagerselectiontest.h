@@ -23,6 +23,9 @@ private Q_SLOTS:
     void testInitiallyOwned();
     void testLostOwnership();
     void testWatching();
+    void testAsyncInitiallyOwned();
+    void testAsyncWatching();
+    void testClaimReportsThroughSignals();
 
 private:
     void claim(KSelectionOwner *owner, bool force = false, bool forceKill = true);
@@ -15,6 +15,8 @@
 #include <qtest_widgets.h>
 #include <xcb/xcb.h>
 
+#include <utility>
+
 #include "cptr_p.h"
 
 Q_DECLARE_METATYPE(KWindowEffects::SlideFromLocation)
@@ -31,6 +33,9 @@ private Q_SLOTS:
     void testBlur_data();
     void testBlur();
     void testBlurDisable();
+    void testBlurRegionSwitched();
+    void testBlurRegionPreserved_data();
+    void testBlurRegionPreserved();
     void testEffectAvailable_data();
     void testEffectAvailable();
 
@@ -215,6 +220,63 @@ void KWindowEffectsTest::testBlurDisable()
     performAtomIsRemoveTest(m_window->winId(), m_blur);
 }
 
+void KWindowEffectsTest::testBlurRegionSwitched()
+{
+    // switching back and forth between regions must always write the current one, merged
+    const QRegion first = QRegion(0, 0, 10, 100) + QRegion(20, 0, 10, 5);
+    const QRegion second(5, 5, 30, 30);
+    xcb_connection_t *c = QX11Info::connection();
+    for (const auto &[region, rectCount] : {std::pair(first, 2), std::pair(second, 1), std::pair(first, 2), std::pair(second, 1)}) {
+        KWindowEffects::enableBlurBehind(m_window.get(), true, region);
+        xcb_get_property_cookie_t cookie = xcb_get_property_unchecked(c, false, m_window->winId(), m_blur, XCB_ATOM_CARDINAL, 0, 100);
+        UniqueCPointer<xcb_get_property_reply_t> reply(xcb_get_property_reply(c, cookie, nullptr));
+        QVERIFY(reply);
+        QCOMPARE(reply->value_len, uint32_t(rectCount * 4));
+        const uint32_t *data = static_cast<uint32_t *>(xcb_get_property_value(reply.get()));
+        QRegion written;
+        for (uint32_t i = 0; i < reply->value_len; i += 4) {
+            written += QRect(data[i], data[i + 1], data[i + 2], data[i + 3]);
+        }
+        QCOMPARE(written, region);
+    }
+    KWindowEffects::enableBlurBehind(m_window.get(), false);
+}
+
+void KWindowEffectsTest::testBlurRegionPreserved_data()
+{
+    QTest::addColumn<QRegion>("region");
+    QTest::addColumn<int>("rectCount");
+
+    // the band split of the tall rect is undone
+    QTest::newRow("side by side") << (QRegion(0, 0, 10, 100) + QRegion(20, 0, 10, 5) + QRegion(20, 50, 10, 5)) << 3;
+    QTest::newRow("rounded") << QRegion(0, 0, 64, 64, QRegion::Ellipse) << QRegion(0, 0, 64, 64, QRegion::Ellipse).rectCount();
+    QTest::newRow("frame") << (QRegion(0, 0, 100, 100) - QRegion(10, 10, 80, 80)) << 4;
+}
+
+void KWindowEffectsTest::testBlurRegionPreserved()
+{
+    QFETCH(QRegion, region);
+    QFETCH(int, rectCount);
+
+    KWindowEffects::enableBlurBehind(m_window.get(), true, region);
+    xcb_connection_t *c = QX11Info::connection();
+    xcb_get_property_cookie_t cookie = xcb_get_property_unchecked(c, false, m_window->winId(), m_blur, XCB_ATOM_CARDINAL, 0, 10000);
+    UniqueCPointer<xcb_get_property_reply_t> reply(xcb_get_property_reply(c, cookie, nullptr));
+    QVERIFY(reply);
+    QCOMPARE(reply->value_len, uint32_t(rectCount * 4));
+
+    // merging rects must neither add nor drop a single pixel
+    const uint32_t *data = static_cast<uint32_t *>(xcb_get_property_value(reply.get()));
+    QRegion sent;
+    for (uint32_t i = 0; i < reply->value_len; i += 4) {
+        const QRect rect(data[i], data[i + 1], data[i + 2], data[i + 3]);
+        QVERIFY(!sent.intersects(rect));
+        sent += rect;
+    }
+    QCOMPARE(sent, region);
+    KWindowEffects::enableBlurBehind(m_window.get(), false);
+}
+
 void KWindowEffectsTest::testEffectAvailable_data()
 {
     QTest::addColumn<KWindowEffects::Effect>("effect");
@@ -55,6 +55,8 @@ private Q_SLOTS:
     void testGeometry();
     void testDesktopFileName();
     void testPid();
+    void testFetch();
+    void testFetchInvalidWindow();
 
     // actionSupported is not tested as it's too window manager specific
     // we could write a test against KWin's behavior, but that would fail on
@@ -682,6 +684,39 @@ void KWindowInfoX11Test::testPid()
     QCOMPARE(info.pid(), getpid());
 }
 
+void KWindowInfoX11Test::testFetch()
+{
+    const NET::Properties properties = NET::WMVisibleName | NET::WMState | NET::WMGeometry | NET::WMFrameExtents | NET::WMPid;
+    const NET::Properties2 properties2 = NET::WM2WindowClass | NET::WM2DesktopFileName;
+    const KWindowInfo expected(window->winId(), properties, properties2);
+
+    // several outstanding fetches finish in order
+    QFuture<KWindowInfo> first = KWindowInfo::fetch(window->winId(), properties, properties2);
+    QFuture<KWindowInfo> second = KWindowInfo::fetch(window->winId(), NET::WMName);
+    QVERIFY(!first.isFinished());
+    QTRY_VERIFY(second.isFinished());
+    QVERIFY(first.isFinished());
+
+    const KWindowInfo info = first.result();
+    QVERIFY(info.valid());
+    QCOMPARE(info.win(), window->winId());
+    QCOMPARE(info.visibleName(), expected.visibleName());
+    QCOMPARE(info.state(), expected.state());
+    QCOMPARE(info.geometry(), expected.geometry());
+    QCOMPARE(info.frameGeometry(), expected.frameGeometry());
+    QCOMPARE(info.pid(), expected.pid());
+    QCOMPARE(info.windowClassClass(), expected.windowClassClass());
+    QCOMPARE(info.desktopFileName(), expected.desktopFileName());
+    QCOMPARE(second.result().name(), expected.name());
+}
+
+void KWindowInfoX11Test::testFetchInvalidWindow()
+{
+    QFuture<KWindowInfo> future = KWindowInfo::fetch(XCB_WINDOW_NONE, NET::WMName | NET::WMGeometry);
+    QTRY_VERIFY(future.isFinished());
+    QVERIFY(!future.result().valid(true));
+}
+
 QTEST_MAIN(KWindowInfoX11Test)
 
 #include "kwindowinfox11test.moc"
@@ -18,6 +18,7 @@ private Q_SLOTS:
     void cleanupTestCase();
 
     void testWithHelper();
+    void testWindowEffects();
 
 private:
     std::unique_ptr<QProcess> m_westonProcess;
@@ -79,5 +80,25 @@ void TestKWindowsystemPlatformWayland::testWithHelper()
     QCOMPARE(helper.exitCode(), 0);
 }
 
+void TestKWindowsystemPlatformWayland::testWindowEffects()
+{
+    // the helper is a test of its own, but needs the compositor started here
+    const QString processName = QFINDTESTDATA("kwindowsystem_wayland_windoweffects_helper");
+    if (processName.isEmpty()) {
+        QSKIP("Built without Wayland support");
+    }
+
+    QProcess helper;
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert(QStringLiteral("WAYLAND_DISPLAY"), QStringLiteral("kwindowsystem-platform-wayland-0"));
+    env.insert(QStringLiteral("QT_QPA_PLATFORM"), QStringLiteral("wayland"));
+    helper.setProgram(processName);
+    helper.setProcessEnvironment(env);
+    helper.setProcessChannelMode(QProcess::ForwardedChannels);
+    helper.start();
+    QVERIFY(helper.waitForFinished());
+    QCOMPARE(helper.exitCode(), 0);
+}
+
 QTEST_GUILESS_MAIN(TestKWindowsystemPlatformWayland)
 #include "kwindowsystem_platform_wayland_test.moc"
@@ -44,6 +44,7 @@ public:
     void run() override
     {
         // simulate some activity in another thread gathering window information
+        m_windows = KX11Extras::windows();
         const QList<WId> windows = KX11Extras::stackingOrder();
         for (auto wid : windows) {
             KWindowInfo info(wid, NET::WMVisibleName);
@@ -54,6 +55,7 @@ public:
     }
 
     QStringList m_names;
+    QList<WId> m_windows;
 };
 
 void KWindowSystemThreadTest::initTestCase()
@@ -94,6 +96,7 @@ void KWindowSystemThreadTest::testAccessFromThread()
     listerThread.start();
     QVERIFY(listerThread.wait(5000));
     QVERIFY(!listerThread.m_names.isEmpty());
+    QVERIFY(listerThread.m_windows.contains(m_widget->winId()));
 }
 
 QTEST_MAIN(KWindowSystemThreadTest)
@@ -15,6 +15,7 @@
 #include <private/qtx11extras_p.h>
 
 #include <qtest_widgets.h>
+#include <xcb/xcb_icccm.h>
 Q_DECLARE_METATYPE(WId)
 Q_DECLARE_METATYPE(NET::Properties)
 Q_DECLARE_METATYPE(NET::Properties2)
@@ -29,14 +30,18 @@ private Q_SLOTS:
     void testActiveWindowChanged();
     void testWindowAdded();
     void testWindowRemoved();
+    void testStackingOrderRaised();
     void testDesktopChanged();
     void testNumberOfDesktopsChanged();
     void testDesktopNamesChanged();
     void testShowingDesktopChanged();
     void testSetShowingDesktop();
     void testWorkAreaChanged();
+    void testWorkAreaStruts();
     void testWindowTitleChanged();
+    void testWindowsChangedCoalesced();
     void testMinimizeWindow();
+    void testWMHintsIcons();
     void testPlatformX11();
 };
 
@@ -64,6 +69,7 @@ void KWindowSystemX11Test::testWindowAdded()
     qRegisterMetaType<WId>("WId");
     QSignalSpy spy(KX11Extras::self(), &KX11Extras::windowAdded);
     QSignalSpy stackingOrderSpy(KX11Extras::self(), &KX11Extras::stackingOrderChanged);
+    QSignalSpy stackingOrderUpdatedSpy(KX11Extras::self(), &KX11Extras::stackingOrderUpdated);
     std::unique_ptr<QWidget> widget(new QWidget);
     widget->show();
     QVERIFY(QTest::qWaitForWindowExposed(widget.get()));
@@ -82,6 +88,17 @@ void KWindowSystemX11Test::testWindowAdded()
     QVERIFY(hasWId);
     QVERIFY(KX11Extras::hasWId(widget->winId()));
     QVERIFY(!stackingOrderSpy.isEmpty());
+    bool placed = false;
+    for (const QList<QVariant> &args : std::as_const(stackingOrderUpdatedSpy)) {
+        const auto entries = args.at(1).value<QList<QPair<WId, int>>>();
+        for (const auto &entry : entries) {
+            if (entry.first == widget->winId()) {
+                placed = true;
+                QVERIFY(entry.second >= 0);
+            }
+        }
+    }
+    QVERIFY(placed);
 }
 
 void KWindowSystemX11Test::testWindowRemoved()
@@ -99,6 +116,32 @@ void KWindowSystemX11Test::testWindowRemoved()
     QTRY_VERIFY_WITH_TIMEOUT(!KX11Extras::hasWId(widget->winId()), 500);
 }
 
+void KWindowSystemX11Test::testStackingOrderRaised()
+{
+    // This test requires a running NETWM-compliant window manager
+    std::unique_ptr<QWidget> lower(new QWidget);
+    lower->show();
+    QVERIFY(QTest::qWaitForWindowExposed(lower.get()));
+    std::unique_ptr<QWidget> upper(new QWidget);
+    upper->show();
+    QVERIFY(QTest::qWaitForWindowExposed(upper.get()));
+    QTRY_VERIFY_WITH_TIMEOUT(KX11Extras::stackingOrder().indexOf(lower->winId()) != -1, 500);
+    QTRY_VERIFY_WITH_TIMEOUT(KX11Extras::stackingOrder().indexOf(upper->winId()) > KX11Extras::stackingOrder().indexOf(lower->winId()), 500);
+
+    QSignalSpy spy(KX11Extras::self(), &KX11Extras::stackingOrderUpdated);
+    lower->raise();
+    QVERIFY(spy.wait());
+
+    // only the raised window moved, everything else keeps its place
+    const QList<WId> removed = spy.last().at(0).value<QList<WId>>();
+    const auto placed = spy.last().at(1).value<QList<QPair<WId, int>>>();
+    QVERIFY(removed.isEmpty());
+    QCOMPARE(placed.count(), 1);
+    QCOMPARE(placed.first().first, lower->winId());
+    QCOMPARE(placed.first().second, KX11Extras::stackingOrder().indexOf(lower->winId()));
+    QCOMPARE(placed.first().second, KX11Extras::stackingOrder().count() - 1);
+}
+
 void KWindowSystemX11Test::testDesktopChanged()
 {
     // This test requires a running NETWM-compliant window manager
@@ -254,6 +297,31 @@ void KWindowSystemX11Test::testWorkAreaChanged()
     QVERIFY(!strutSpy.isEmpty());
 }
 
+void KWindowSystemX11Test::testWorkAreaStruts()
+{
+    QSignalSpy strutSpy(KX11Extras::self(), &KX11Extras::strutChanged);
+
+    QWidget widget;
+    widget.setGeometry(0, 0, 10, 100);
+    widget.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&widget));
+
+    const QList<WId> excludeWidget{widget.winId()};
+    const QRect withoutWidget = KX11Extras::workArea(excludeWidget);
+
+    KX11Extras::setExtendedStrut(widget.winId(), 10, 0, 100, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    QVERIFY(strutSpy.wait());
+    QVERIFY(KX11Extras::workArea(QList<WId>()).left() >= 10);
+    QCOMPARE(KX11Extras::workArea(excludeWidget), withoutWidget);
+
+    // the cached work area has to follow a changed strut
+    strutSpy.clear();
+    KX11Extras::setExtendedStrut(widget.winId(), 20, 0, 100, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    QVERIFY(strutSpy.wait());
+    QVERIFY(KX11Extras::workArea(QList<WId>()).left() >= 20);
+    QCOMPARE(KX11Extras::workArea(excludeWidget), withoutWidget);
+}
+
 void KWindowSystemX11Test::testWindowTitleChanged()
 {
     qRegisterMetaType<WId>("WId");
@@ -308,6 +376,36 @@ void KWindowSystemX11Test::testWindowTitleChanged()
     QCOMPARE(info.iconName(), expectedName);
 }
 
+void KWindowSystemX11Test::testWindowsChangedCoalesced()
+{
+    using WindowChanges = QHash<WId, QPair<NET::Properties, NET::Properties2>>;
+    QWidget widget;
+    widget.setWindowTitle(QStringLiteral("foo"));
+    widget.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&widget));
+
+    // wait till the window is mapped, etc.
+    QTest::qWait(200);
+
+    KX11Extras::setWindowsChangedInterval(200);
+    QSignalSpy windowsChangedSpy(KX11Extras::self(), &KX11Extras::windowsChanged);
+    QVERIFY(windowsChangedSpy.isValid());
+
+    // several title changes in a row end up in one batch
+    for (int i = 0; i < 5; ++i) {
+        widget.setWindowTitle(QStringLiteral("title %1").arg(i));
+        QCoreApplication::processEvents();
+    }
+    QVERIFY(windowsChangedSpy.wait());
+    QCOMPARE(windowsChangedSpy.count(), 1);
+
+    const WindowChanges changes = windowsChangedSpy.first().at(0).value<WindowChanges>();
+    QVERIFY(changes.contains(widget.winId()));
+    QVERIFY(changes.value(widget.winId()).first.testFlag(NET::WMName));
+
+    KX11Extras::setWindowsChangedInterval(0);
+}
+
 void KWindowSystemX11Test::testMinimizeWindow()
 {
     NETRootInfo rootInfo(QX11Info::connection(), NET::Supported | NET::SupportingWMCheck);
@@ -338,6 +436,68 @@ void KWindowSystemX11Test::testMinimizeWindow()
     QVERIFY(!info3.isMinimized());
 }
 
+void KWindowSystemX11Test::testWMHintsIcons()
+{
+    xcb_connection_t *c = QX11Info::connection();
+    const xcb_screen_t *screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+
+    // a white 16x16 icon, a window without WM_HINTS and a black 24x8 icon
+    const QSize sizes[] = {QSize(16, 16), QSize(), QSize(24, 8)};
+    const uint32_t colors[] = {screen->white_pixel, 0, screen->black_pixel};
+    QList<WId> windows;
+    QList<xcb_pixmap_t> pixmaps;
+    for (int i = 0; i < 3; ++i) {
+        const xcb_window_t window = xcb_generate_id(c);
+        xcb_create_window(c, XCB_COPY_FROM_PARENT, window, screen->root, 0, 0, 10, 10, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, 0, nullptr);
+        windows << window;
+        if (!sizes[i].isValid()) {
+            continue;
+        }
+        const xcb_pixmap_t pixmap = xcb_generate_id(c);
+        xcb_create_pixmap(c, screen->root_depth, pixmap, screen->root, sizes[i].width(), sizes[i].height());
+        const xcb_gcontext_t gc = xcb_generate_id(c);
+        xcb_create_gc(c, gc, pixmap, XCB_GC_FOREGROUND, &colors[i]);
+        const xcb_rectangle_t rect = {0, 0, uint16_t(sizes[i].width()), uint16_t(sizes[i].height())};
+        xcb_poly_fill_rectangle(c, pixmap, gc, 1, &rect);
+        xcb_free_gc(c, gc);
+        pixmaps << pixmap;
+
+        xcb_icccm_wm_hints_t hints = {};
+        xcb_icccm_wm_hints_set_icon_pixmap(&hints, pixmap);
+        xcb_icccm_set_wm_hints(c, window, &hints);
+    }
+    xcb_flush(c);
+
+    const QList<QPixmap> icons = KX11Extras::wmHintsIcons(windows);
+    QCOMPARE(icons.size(), windows.size());
+    for (int i = 0; i < windows.size(); ++i) {
+        QCOMPARE(icons.at(i).isNull(), !sizes[i].isValid());
+        if (!sizes[i].isValid()) {
+            continue;
+        }
+        QCOMPARE(icons.at(i).size(), sizes[i]);
+        QCOMPARE(icons.at(i).toImage(), KX11Extras::icon(windows.at(i), -1, -1, false, KX11Extras::WMHints).toImage());
+    }
+    QCOMPARE(icons.first().toImage().pixelColor(0, 0), QColor(Qt::white));
+
+    // scaled like icon() does
+    const QList<QPixmap> scaled = KX11Extras::wmHintsIcons(windows, 32, 32, true);
+    QCOMPARE(scaled.size(), windows.size());
+    QCOMPARE(scaled.at(0).size(), QSize(32, 32));
+    QVERIFY(scaled.at(1).isNull());
+    QCOMPARE(scaled.at(2).size(), QSize(32, 32));
+
+    QVERIFY(KX11Extras::wmHintsIcons({}).isEmpty());
+
+    for (xcb_pixmap_t pixmap : std::as_const(pixmaps)) {
+        xcb_free_pixmap(c, pixmap);
+    }
+    for (WId window : std::as_const(windows)) {
+        xcb_destroy_window(c, window);
+    }
+    xcb_flush(c);
+}
+
 void KWindowSystemX11Test::testPlatformX11()
 {
     QCOMPARE(KWindowSystem::platform(), KWindowSystem::Platform::X11);
@@ -0,0 +1,88 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "kx11extras.h"
+#include "netwm.h"
+
+#include <QSignalSpy>
+#include <QWidget>
+#include <private/qtx11extras_p.h>
+
+#include <qtest_widgets.h>
+
+#include <algorithm>
+#include <memory>
+
+// Runs the window tracking on the worker connection, which has to be chosen before
+// KX11Extras is used for the first time, hence a test of its own
+class KX11ExtrasThreadedTrackingTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testInitialState();
+    void testWindowAddedAndRemoved();
+    void testWindowTitleChanged();
+};
+
+void KX11ExtrasThreadedTrackingTest::initTestCase()
+{
+    QCoreApplication::setAttribute(Qt::AA_ForceRasterWidgets);
+    KX11Extras::setThreadedWindowTracking(true);
+}
+
+void KX11ExtrasThreadedTrackingTest::testInitialState()
+{
+    // the first request only starts the tracking, the state arrives without blocking
+    NETRootInfo rootInfo(QX11Info::connection(), NET::ClientList | NET::ClientListStacking | NET::NumberOfDesktops, NET::Properties2());
+    KX11Extras::windows();
+    QTRY_COMPARE(KX11Extras::numberOfDesktops(), rootInfo.numberOfDesktops());
+    QTRY_COMPARE(KX11Extras::windows().count(), rootInfo.clientListCount());
+    QCOMPARE(KX11Extras::stackingOrder().count(), rootInfo.clientListStackingCount());
+}
+
+void KX11ExtrasThreadedTrackingTest::testWindowAddedAndRemoved()
+{
+    QSignalSpy addedSpy(KX11Extras::self(), &KX11Extras::windowAdded);
+    QSignalSpy removedSpy(KX11Extras::self(), &KX11Extras::windowRemoved);
+
+    std::unique_ptr<QWidget> widget(new QWidget);
+    widget->show();
+    QVERIFY(QTest::qWaitForWindowExposed(widget.get()));
+    const WId window = widget->winId();
+
+    QTRY_VERIFY(KX11Extras::hasWId(window));
+    QVERIFY(std::any_of(addedSpy.cbegin(), addedSpy.cend(), [window](const QList<QVariant> &args) {
+        return args.at(0).value<WId>() == window;
+    }));
+    QTRY_VERIFY(KX11Extras::stackingOrder().contains(window));
+
+    widget->hide();
+    QTRY_VERIFY(!KX11Extras::hasWId(window));
+    QVERIFY(std::any_of(removedSpy.cbegin(), removedSpy.cend(), [window](const QList<QVariant> &args) {
+        return args.at(0).value<WId>() == window;
+    }));
+}
+
+void KX11ExtrasThreadedTrackingTest::testWindowTitleChanged()
+{
+    QWidget widget;
+    widget.setWindowTitle(QStringLiteral("foo"));
+    widget.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&widget));
+    QTRY_VERIFY(KX11Extras::hasWId(widget.winId()));
+
+    QSignalSpy changedSpy(KX11Extras::self(), &KX11Extras::windowChanged);
+    widget.setWindowTitle(QStringLiteral("bar"));
+
+    QTRY_VERIFY(std::any_of(changedSpy.cbegin(), changedSpy.cend(), [&widget](const QList<QVariant> &args) {
+        return args.at(0).value<WId>() == widget.winId() && args.at(1).value<NET::Properties>().testFlag(NET::WMName);
+    }));
+}
+
+QTEST_MAIN(KX11ExtrasThreadedTrackingTest)
+
+#include "kx11extrasthreadedtrackingtest.moc"
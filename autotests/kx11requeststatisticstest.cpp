@@ -0,0 +1,122 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "kwindowinfo.h"
+#include "kx11extras.h"
+#include "netwm.h"
+
+#include <QWidget>
+#include <private/qtx11extras_p.h>
+
+#include <qtest_widgets.h>
+
+#include <memory>
+
+class KX11RequestStatisticsTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testDisabled();
+    void testKWindowInfo();
+    void testNestedCallsAccountedToOuter();
+    void testWorkArea();
+
+private:
+    std::unique_ptr<QWidget> m_widget;
+};
+
+void KX11RequestStatisticsTest::initTestCase()
+{
+    QCoreApplication::setAttribute(Qt::AA_ForceRasterWidgets);
+}
+
+void KX11RequestStatisticsTest::init()
+{
+    m_widget.reset(new QWidget);
+    m_widget->show();
+    QVERIFY(QTest::qWaitForWindowExposed(m_widget.get()));
+    KX11Extras::resetRequestStatistics();
+}
+
+void KX11RequestStatisticsTest::cleanup()
+{
+    KX11Extras::setRequestStatisticsEnabled(false);
+    m_widget.reset();
+}
+
+void KX11RequestStatisticsTest::testDisabled()
+{
+    QVERIFY(!KX11Extras::requestStatisticsEnabled());
+    KWindowInfo info(m_widget->winId(), NET::WMName);
+    QVERIFY(info.valid());
+    QVERIFY(KX11Extras::requestStatistics().isEmpty());
+}
+
+void KX11RequestStatisticsTest::testKWindowInfo()
+{
+    KX11Extras::setRequestStatisticsEnabled(true);
+    QVERIFY(KX11Extras::requestStatisticsEnabled());
+    {
+        KWindowInfo info(m_widget->winId(), NET::WMName | NET::WMState);
+        QVERIFY(info.valid());
+    }
+    {
+        KWindowInfo info(m_widget->winId(), NET::WMName | NET::WMState);
+        QVERIFY(info.valid());
+    }
+
+    const auto statistics = KX11Extras::requestStatistics();
+    QVERIFY(statistics.contains(QStringLiteral("KWindowInfo::KWindowInfo")));
+    const KX11Extras::RequestStatistics windowInfo = statistics.value(QStringLiteral("KWindowInfo::KWindowInfo"));
+    QCOMPARE(windowInfo.calls, quint64(2));
+    // at least two properties per call
+    QVERIFY(windowInfo.requests >= 4);
+    QVERIFY(windowInfo.replies >= 2);
+    QVERIFY(windowInfo.blockingWaits >= 2);
+    QVERIFY(windowInfo.blockingWaits <= windowInfo.replies);
+    QVERIFY(windowInfo.bytesSent > 0);
+    QVERIFY(windowInfo.bytesReceived > 0);
+
+    KX11Extras::resetRequestStatistics();
+    QVERIFY(KX11Extras::requestStatistics().isEmpty());
+}
+
+void KX11RequestStatisticsTest::testNestedCallsAccountedToOuter()
+{
+    KX11Extras::setRequestStatisticsEnabled(true);
+    (void)KX11Extras::icon(m_widget->winId(), 16, 16, true);
+
+    // the NETWinInfo behind icon() does not show up on its own
+    const auto statistics = KX11Extras::requestStatistics();
+    QVERIFY(statistics.contains(QStringLiteral("KX11Extras::icon")));
+    QCOMPARE(statistics.value(QStringLiteral("KX11Extras::icon")).calls, quint64(1));
+    QVERIFY(!statistics.contains(QStringLiteral("NETWinInfo::update")));
+
+    // while one used on its own does
+    NETWinInfo info(QX11Info::connection(), m_widget->winId(), QX11Info::appRootWindow(), NET::WMName, NET::Properties2());
+    QCOMPARE(KX11Extras::requestStatistics().value(QStringLiteral("NETWinInfo::update")).calls, quint64(1));
+}
+
+void KX11RequestStatisticsTest::testWorkArea()
+{
+    // start the tracking outside of the recording
+    (void)KX11Extras::workArea();
+
+    KX11Extras::setRequestStatisticsEnabled(true);
+    (void)KX11Extras::workArea();
+    const KX11Extras::RequestStatistics workArea = KX11Extras::requestStatistics().value(QStringLiteral("KX11Extras::workArea"));
+    QCOMPARE(workArea.calls, quint64(1));
+    // answered from the cached root information
+    QCOMPARE(workArea.requests, quint64(0));
+    QCOMPARE(workArea.blockingWaits, quint64(0));
+}
+
+QTEST_MAIN(KX11RequestStatisticsTest)
+
+#include "kx11requeststatisticstest.moc"
@@ -0,0 +1,342 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "kxcbtracereplay.h"
+#include "atoms_p.h"
+#include "kxcbtrace_p.h"
+
+#include <QFile>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+static bool readFully(int fd, void *data, size_t size)
+{
+    char *bytes = static_cast<char *>(data);
+    while (size > 0) {
+        const ssize_t count = read(fd, bytes, size);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        bytes += count;
+        size -= count;
+    }
+    return true;
+}
+
+static bool writeFully(int fd, const void *data, size_t size)
+{
+    const char *bytes = static_cast<const char *>(data);
+    while (size > 0) {
+        const ssize_t count = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        bytes += count;
+        size -= count;
+    }
+    return true;
+}
+
+// The setup of a server with a single screen and no visuals, just enough for xcb
+static QByteArray stubSetup(xcb_window_t rootWindow, uint16_t width, uint16_t height)
+{
+    static const char vendor[] = "KXcbTraceReplay";
+    const int vendorLength = sizeof(vendor) - 1;
+    const int vendorPadding = (4 - vendorLength % 4) % 4;
+
+    xcb_setup_t setup = {};
+    setup.status = 1;
+    setup.protocol_major_version = 11;
+    setup.length = (sizeof(xcb_setup_t) - 8 + vendorLength + vendorPadding + sizeof(xcb_screen_t)) / 4;
+    setup.resource_id_base = 0x00200000;
+    setup.resource_id_mask = 0x001fffff;
+    setup.vendor_len = vendorLength;
+    setup.maximum_request_length = 0xffff;
+    setup.roots_len = 1;
+    setup.bitmap_format_scanline_unit = 32;
+    setup.bitmap_format_scanline_pad = 32;
+    setup.min_keycode = 8;
+    setup.max_keycode = 255;
+
+    xcb_screen_t screen = {};
+    screen.root = rootWindow;
+    screen.width_in_pixels = width;
+    screen.height_in_pixels = height;
+    screen.root_depth = 24;
+
+    QByteArray data;
+    data.append(reinterpret_cast<const char *>(&setup), sizeof(setup));
+    data.append(vendor, vendorLength);
+    data.append(vendorPadding, '\0');
+    data.append(reinterpret_cast<const char *>(&screen), sizeof(screen));
+    return data;
+}
+
+// Swallows the requests. Only extension queries get an answer, not present, and the
+// input focus, which xcb uses to sync
+static void serveStub(int fd)
+{
+    uint8_t setup[12];
+    if (!readFully(fd, setup, sizeof(setup))) {
+        return;
+    }
+    uint16_t nameLength;
+    uint16_t dataLength;
+    std::memcpy(&nameLength, setup + 6, sizeof(nameLength));
+    std::memcpy(&dataLength, setup + 8, sizeof(dataLength));
+    QByteArray request(((nameLength + 3) & ~3) + ((dataLength + 3) & ~3), Qt::Uninitialized);
+    if (!readFully(fd, request.data(), request.size())) {
+        return;
+    }
+
+    uint16_t sequence = 0;
+    for (;;) {
+        uint8_t header[4];
+        if (!readFully(fd, header, sizeof(header))) {
+            return;
+        }
+        ++sequence;
+
+        uint16_t length;
+        std::memcpy(&length, header + 2, sizeof(length));
+        size_t remaining = length * 4 - sizeof(header);
+        if (length == 0) {
+            // BIG-REQUESTS, the actual length follows
+            uint32_t bigLength;
+            if (!readFully(fd, &bigLength, sizeof(bigLength)) || bigLength < 2) {
+                return;
+            }
+            remaining = bigLength * 4 - sizeof(header) - sizeof(bigLength);
+        }
+        request.resize(remaining);
+        if (!readFully(fd, request.data(), remaining)) {
+            return;
+        }
+
+        if (header[0] == XCB_QUERY_EXTENSION || header[0] == XCB_GET_INPUT_FOCUS) {
+            uint8_t reply[32] = {};
+            reply[0] = 1;
+            std::memcpy(reply + 2, &sequence, sizeof(sequence));
+            if (!writeFully(fd, reply, sizeof(reply))) {
+                return;
+            }
+        }
+    }
+}
+
+KXcbTraceReplay::KXcbTraceReplay(const QString &fileName)
+{
+    if (!load(fileName) || !connectStub()) {
+        return;
+    }
+    m_replaying = KXcbTrace::startReplaying(m_connection, m_atomTable, [this] {
+        return takeReply();
+    });
+    if (!m_replaying) {
+        m_errorString = QStringLiteral("Another trace is already being replayed");
+    }
+}
+
+KXcbTraceReplay::~KXcbTraceReplay()
+{
+    if (m_replaying) {
+        KXcbTrace::stopReplaying(m_connection);
+    }
+    if (m_connection) {
+        // closes the other end of the stub
+        xcb_disconnect(m_connection);
+    }
+    if (m_stub.joinable()) {
+        m_stub.join();
+    }
+    if (m_stubFd != -1) {
+        close(m_stubFd);
+    }
+}
+
+bool KXcbTraceReplay::load(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_errorString = file.errorString();
+        return false;
+    }
+    m_data = file.readAll();
+
+    KXcbTrace::Header header;
+    if (m_data.size() < qsizetype(sizeof(header))) {
+        m_errorString = QStringLiteral("Not a trace file");
+        return false;
+    }
+    std::memcpy(&header, m_data.constData(), sizeof(header));
+    if (std::memcmp(header.magic, KXcbTrace::s_magic, sizeof(KXcbTrace::s_magic)) != 0 || header.version != KXcbTrace::s_version) {
+        m_errorString = QStringLiteral("Not a trace file");
+        return false;
+    }
+    if (header.byteOrder != KXcbTrace::s_byteOrder) {
+        m_errorString = QStringLiteral("The trace was recorded with another byte order");
+        return false;
+    }
+    if (header.atomCount != quint32(KwsAtomCount)) {
+        m_errorString = QStringLiteral("The trace was recorded by another version of the library");
+        return false;
+    }
+    m_rootWindow = header.rootWindow;
+    m_width = header.width;
+    m_height = header.height;
+
+    qsizetype offset = sizeof(header);
+    const qsizetype atomsSize = header.atomCount * sizeof(xcb_atom_t);
+    if (m_data.size() - offset < atomsSize) {
+        m_errorString = QStringLiteral("The trace is truncated");
+        return false;
+    }
+    m_atomTable.resize(header.atomCount);
+    std::memcpy(m_atomTable.data(), m_data.constData() + offset, atomsSize);
+    offset += atomsSize;
+
+    while (offset < m_data.size()) {
+        const char type = m_data.at(offset++);
+        switch (type) {
+        case KXcbTrace::EventRecord:
+            if (m_data.size() - offset < KXcbTrace::s_eventSize) {
+                m_errorString = QStringLiteral("The trace is truncated");
+                return false;
+            }
+            m_events.append(offset);
+            offset += KXcbTrace::s_eventSize;
+            break;
+        case KXcbTrace::ReplyRecord: {
+            quint32 size;
+            if (m_data.size() - offset < qsizetype(sizeof(size))) {
+                m_errorString = QStringLiteral("The trace is truncated");
+                return false;
+            }
+            std::memcpy(&size, m_data.constData() + offset, sizeof(size));
+            if (size < 32 || m_data.size() - offset - qsizetype(sizeof(size)) < qsizetype(size)) {
+                m_errorString = QStringLiteral("The trace is truncated");
+                return false;
+            }
+            m_replies.append(offset);
+            offset += sizeof(size) + size;
+            break;
+        }
+        case KXcbTrace::NoReplyRecord:
+            m_replies.append(-1);
+            break;
+        default:
+            m_errorString = QStringLiteral("The trace is corrupt");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool KXcbTraceReplay::connectStub()
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        return false;
+    }
+    m_stubFd = fds[0];
+
+    // xcb waits for the setup while connecting, so it is queued up front
+    const QByteArray setup = stubSetup(m_rootWindow, m_width, m_height);
+    if (!writeFully(m_stubFd, setup.constData(), setup.size())) {
+        close(fds[1]);
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        return false;
+    }
+    m_connection = xcb_connect_to_fd(fds[1], nullptr);
+    if (xcb_connection_has_error(m_connection)) {
+        m_errorString = QStringLiteral("Cannot connect to the stub server");
+        return false;
+    }
+    m_stub = std::thread(serveStub, m_stubFd);
+    return true;
+}
+
+bool KXcbTraceReplay::isValid() const
+{
+    return m_connection && m_errorString.isEmpty();
+}
+
+QString KXcbTraceReplay::errorString() const
+{
+    return m_errorString;
+}
+
+xcb_connection_t *KXcbTraceReplay::connection() const
+{
+    return m_connection;
+}
+
+xcb_window_t KXcbTraceReplay::rootWindow() const
+{
+    return m_rootWindow;
+}
+
+qsizetype KXcbTraceReplay::eventCount() const
+{
+    return m_events.size();
+}
+
+qsizetype KXcbTraceReplay::replyCount() const
+{
+    return m_replies.size();
+}
+
+xcb_generic_event_t *KXcbTraceReplay::nextEvent()
+{
+    if (m_nextEvent >= m_events.size()) {
+        return nullptr;
+    }
+    std::memset(m_event, 0, sizeof(m_event));
+    std::memcpy(m_event, m_data.constData() + m_events.at(m_nextEvent++), KXcbTrace::s_eventSize);
+    return reinterpret_cast<xcb_generic_event_t *>(m_event);
+}
+
+void KXcbTraceReplay::rewind()
+{
+    m_nextEvent = 0;
+    m_nextReply = 0;
+    m_missingReplies = 0;
+}
+
+qsizetype KXcbTraceReplay::missingReplies() const
+{
+    return m_missingReplies;
+}
+
+void *KXcbTraceReplay::takeReply()
+{
+    if (m_nextReply >= m_replies.size()) {
+        ++m_missingReplies;
+        return nullptr;
+    }
+    const qsizetype offset = m_replies.at(m_nextReply++);
+    if (offset < 0) {
+        return nullptr;
+    }
+    quint32 size;
+    std::memcpy(&size, m_data.constData() + offset, sizeof(size));
+    // freed by the caller like every xcb reply
+    void *reply = malloc(size);
+    std::memcpy(reply, m_data.constData() + offset + sizeof(size), size);
+    return reply;
+}
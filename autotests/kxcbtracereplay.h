@@ -0,0 +1,81 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#ifndef KXCBTRACEREPLAY_H
+#define KXCBTRACEREPLAY_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+#include <thread>
+#include <xcb/xcb.h>
+
+/*
+ * Plays a trace written by KXcbTrace back. The connection is served by a stub in a
+ * thread of its own which swallows all requests, while the library takes the replies
+ * from the trace in the order they were recorded, see KXcbTrace::startReplaying().
+ * Only a single screen with the recorded root window is announced and no extension is
+ * present.
+ *
+ * Feeding nextEvent() to the same code that ran during the recording, created on
+ * connection(), makes it see exactly what it saw then. If it asks for more replies
+ * than were recorded it gets none, which is counted by missingReplies().
+ *
+ * Only one trace can be replayed at a time.
+ */
+class KXcbTraceReplay
+{
+public:
+    explicit KXcbTraceReplay(const QString &fileName);
+    ~KXcbTraceReplay();
+    KXcbTraceReplay(const KXcbTraceReplay &) = delete;
+    KXcbTraceReplay &operator=(const KXcbTraceReplay &) = delete;
+
+    bool isValid() const;
+    QString errorString() const;
+
+    xcb_connection_t *connection() const;
+    xcb_window_t rootWindow() const;
+    qsizetype eventCount() const;
+    qsizetype replyCount() const;
+
+    // Returns the next recorded event, or nullptr once all of them were returned. It is
+    // valid until the next call.
+    xcb_generic_event_t *nextEvent();
+
+    // Starts over with the first event and reply
+    void rewind();
+
+    qsizetype missingReplies() const;
+
+private:
+    bool load(const QString &fileName);
+    bool connectStub();
+    void *takeReply();
+
+    QString m_errorString;
+    QByteArray m_data;
+    // offsets of the records in m_data, -1 for replies that were missing
+    QList<qsizetype> m_events;
+    QList<qsizetype> m_replies;
+    qsizetype m_nextEvent = 0;
+    qsizetype m_nextReply = 0;
+    qsizetype m_missingReplies = 0;
+    xcb_window_t m_rootWindow = XCB_WINDOW_NONE;
+    uint16_t m_width = 0;
+    uint16_t m_height = 0;
+    QList<xcb_atom_t> m_atomTable;
+    bool m_replaying = false;
+    // the recorded events plus the full_sequence xcb appends
+    alignas(xcb_generic_event_t) uint8_t m_event[sizeof(xcb_generic_event_t)] = {};
+
+    xcb_connection_t *m_connection = nullptr;
+    int m_stubFd = -1;
+    std::thread m_stub;
+};
+
+#endif
@@ -0,0 +1,248 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "kxcbtrace_p.h"
+#include "kxcbtracereplay.h"
+#include "nettesthelper.h"
+#include "nettracer.h"
+#include <netwm.h>
+
+#include <QFile>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <algorithm>
+#include <memory>
+
+// system
+#include <unistd.h>
+
+class KXcbTraceTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testReplayMatchesRecording();
+    void testMissingReplies();
+    void testInvalidTrace();
+
+private:
+    QString record();
+    void process(xcb_connection_t *c, NETTracer *tracer);
+
+    std::unique_ptr<QProcess> m_xvfb;
+    QByteArray m_display;
+    xcb_connection_t *m_wmConnection = nullptr;
+    xcb_window_t m_rootWindow = XCB_WINDOW_NONE;
+    xcb_window_t m_supportWindow = XCB_WINDOW_NONE;
+    QTemporaryDir m_dir;
+    QList<NETTracer::Change> m_recorded;
+};
+
+void KXcbTraceTest::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+
+    const QString xfvbExec = QStandardPaths::findExecutable(QStringLiteral("Xvfb"));
+    QVERIFY(!xfvbExec.isEmpty());
+
+    m_xvfb.reset(new QProcess);
+    // use pipe to pass fd to Xvfb to get back the display id
+    int pipeFds[2];
+    QVERIFY(pipe(pipeFds) == 0);
+    m_xvfb->start(xfvbExec, QStringList{QStringLiteral("-displayfd"), QString::number(pipeFds[1])});
+    QVERIFY(m_xvfb->waitForStarted());
+    QCOMPARE(m_xvfb->state(), QProcess::Running);
+
+    // reads from pipe, closes write side
+    close(pipeFds[1]);
+
+    QFile readPipe;
+    QVERIFY(readPipe.open(pipeFds[0], QIODevice::ReadOnly, QFileDevice::AutoCloseHandle));
+    m_display = readPipe.readLine().trimmed();
+    m_display.prepend(':');
+    readPipe.close();
+
+    int screen = 0;
+    m_wmConnection = xcb_connect(m_display.constData(), &screen);
+    QVERIFY(!xcb_connection_has_error(m_wmConnection));
+    m_rootWindow = KXUtils::rootWindow(m_wmConnection, screen);
+
+    const uint32_t values[] = {true};
+    m_supportWindow = xcb_generate_id(m_wmConnection);
+    xcb_create_window(m_wmConnection,
+                      XCB_COPY_FROM_PARENT,
+                      m_supportWindow,
+                      m_rootWindow,
+                      0,
+                      0,
+                      1,
+                      1,
+                      0,
+                      XCB_COPY_FROM_PARENT,
+                      XCB_COPY_FROM_PARENT,
+                      XCB_CW_OVERRIDE_REDIRECT,
+                      values);
+
+    m_recorded.clear();
+}
+
+void KXcbTraceTest::cleanupTestCase()
+{
+    xcb_disconnect(m_wmConnection);
+    m_xvfb->terminate();
+    m_xvfb->waitForFinished();
+}
+
+// Waits until the server is done with everything the window manager sent and hands the
+// resulting events to the tracer
+void KXcbTraceTest::process(xcb_connection_t *c, NETTracer *tracer)
+{
+    free(xcb_get_input_focus_reply(m_wmConnection, xcb_get_input_focus(m_wmConnection), nullptr));
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), nullptr));
+    while (xcb_generic_event_t *event = xcb_poll_for_event(c)) {
+        KXcbTrace::recordEvent(c, event);
+        tracer->process(event);
+        free(event);
+    }
+}
+
+// A window shows up, gets renamed, shaded and moved to another desktop, then goes away
+QString KXcbTraceTest::record()
+{
+    const QString fileName = m_dir.filePath(QStringLiteral("session.trace"));
+    if (!m_recorded.isEmpty()) {
+        return fileName;
+    }
+
+    NETRootInfo wm(m_wmConnection,
+                   m_supportWindow,
+                   "kxcbtracetest",
+                   NET::ClientList | NET::ClientListStacking | NET::NumberOfDesktops | NET::CurrentDesktop | NET::ActiveWindow,
+                   NET::NormalMask,
+                   NET::Shaded | NET::Sticky,
+                   NET::Properties2(),
+                   NET::Actions());
+    wm.setNumberOfDesktops(4);
+    wm.setCurrentDesktop(1);
+
+    xcb_connection_t *c = xcb_connect(m_display.constData(), nullptr);
+    if (xcb_connection_has_error(c) || !KXcbTrace::startRecording(c, m_rootWindow, fileName)) {
+        return QString();
+    }
+    auto tracer = std::make_unique<NETTracer>(c);
+
+    const xcb_window_t window = xcb_generate_id(m_wmConnection);
+    xcb_create_window(m_wmConnection, XCB_COPY_FROM_PARENT, window, m_rootWindow, 0, 0, 100, 100, 0, XCB_COPY_FROM_PARENT, XCB_COPY_FROM_PARENT, 0, nullptr);
+    NETWinInfo client(m_wmConnection, window, m_rootWindow, NET::Properties(), NET::Properties2());
+    client.setName("first");
+    NETWinInfo managed(m_wmConnection, window, m_rootWindow, NET::WMState | NET::WMDesktop, NET::Properties2(), NET::WindowManager);
+    managed.setDesktop(1);
+    wm.setClientList(&window, 1);
+    wm.setClientListStacking(&window, 1);
+    process(c, tracer.get());
+
+    client.setName("second");
+    managed.setState(NET::Shaded, NET::Shaded);
+    process(c, tracer.get());
+
+    managed.setDesktop(3);
+    wm.setCurrentDesktop(3);
+    wm.setActiveWindow(window);
+    process(c, tracer.get());
+
+    wm.setClientList(nullptr, 0);
+    wm.setClientListStacking(nullptr, 0);
+    xcb_destroy_window(m_wmConnection, window);
+    process(c, tracer.get());
+
+    KXcbTrace::stopRecording();
+    m_recorded = tracer->changes();
+    tracer.reset();
+    xcb_disconnect(c);
+    return fileName;
+}
+
+void KXcbTraceTest::testReplayMatchesRecording()
+{
+    const QString fileName = record();
+    QVERIFY(!fileName.isEmpty());
+
+    // the tracer saw the window come, change and go
+    QVERIFY(std::any_of(m_recorded.cbegin(), m_recorded.cend(), [](const NETTracer::Change &change) {
+        return change.name == "first";
+    }));
+    QVERIFY(std::any_of(m_recorded.cbegin(), m_recorded.cend(), [](const NETTracer::Change &change) {
+        return change.name == "second" && change.state.testFlag(NET::Shaded);
+    }));
+    QVERIFY(std::any_of(m_recorded.cbegin(), m_recorded.cend(), [](const NETTracer::Change &change) {
+        return change.desktop == 3;
+    }));
+
+    KXcbTraceReplay replay(fileName);
+    QVERIFY2(replay.isValid(), qPrintable(replay.errorString()));
+    QCOMPARE(replay.rootWindow(), m_rootWindow);
+    QVERIFY(replay.eventCount() > 0);
+    QVERIFY(replay.replyCount() > 0);
+
+    // twice, to see that rewinding starts over
+    for (int run = 0; run < 2; ++run) {
+        replay.rewind();
+        NETTracer tracer(replay.connection());
+        QCOMPARE(tracer.rootWindow(), m_rootWindow);
+        while (xcb_generic_event_t *event = replay.nextEvent()) {
+            tracer.process(event);
+        }
+        QCOMPARE(tracer.changes().size(), m_recorded.size());
+        QVERIFY(tracer.changes() == m_recorded);
+        QVERIFY(tracer.trackedClients().isEmpty());
+        QCOMPARE(replay.missingReplies(), 0);
+    }
+}
+
+void KXcbTraceTest::testMissingReplies()
+{
+    const QString fileName = record();
+    QVERIFY(!fileName.isEmpty());
+
+    KXcbTraceReplay replay(fileName);
+    QVERIFY2(replay.isValid(), qPrintable(replay.errorString()));
+    {
+        NETTracer tracer(replay.connection());
+        while (xcb_generic_event_t *event = replay.nextEvent()) {
+            tracer.process(event);
+        }
+    }
+    QCOMPARE(replay.missingReplies(), 0);
+
+    // anything asked beyond the recording gets nothing instead of blocking
+    NETRootInfo rootInfo(replay.connection(), NET::NumberOfDesktops);
+    QVERIFY(replay.missingReplies() > 0);
+    QCOMPARE(rootInfo.numberOfDesktops(true), 0);
+}
+
+void KXcbTraceTest::testInvalidTrace()
+{
+    KXcbTraceReplay missing(m_dir.filePath(QStringLiteral("does-not-exist")));
+    QVERIFY(!missing.isValid());
+    QVERIFY(!missing.errorString().isEmpty());
+
+    const QString fileName = m_dir.filePath(QStringLiteral("garbage.trace"));
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QByteArray(64, 'x'));
+    file.close();
+    KXcbTraceReplay garbage(fileName);
+    QVERIFY(!garbage.isValid());
+    QVERIFY(!garbage.connection());
+}
+
+QTEST_GUILESS_MAIN(KXcbTraceTest)
+
+#include "kxcbtracetest.moc"
@@ -45,6 +45,7 @@ private Q_SLOTS:
     void testShowingDesktop();
     void testWorkArea();
     void testActiveWindow();
+    void testTransaction();
     void testVirtualRoots();
     void testDontCrashMapViewports();
 
@@ -574,6 +575,65 @@ void NetRootInfoTestWM::testActiveWindow()
     QCOMPARE(rootInfo.activeWindow(), activeWindow);
 }
 
+void NetRootInfoTestWM::testTransaction()
+{
+    KXUtils::Atom atom(connection(), QByteArrayLiteral("_NET_ACTIVE_WINDOW"));
+    QVERIFY(atom != XCB_ATOM_NONE);
+    NETRootInfo
+        rootInfo(connection(), m_supportWindow, s_wmName, NET::WMAllProperties, NET::AllTypesMask, NET::States(~0u), NET::WM2AllProperties, NET::Actions(~0u));
+
+    auto activeWindowOnServer = [this, &rootInfo, &atom] {
+        xcb_get_property_cookie_t cookie = xcb_get_property_unchecked(connection(), false, rootInfo.rootWindow(), atom, XCB_ATOM_WINDOW, 0, 1);
+        Property reply(xcb_get_property_reply(connection(), cookie, nullptr));
+        if (!reply || reply->value_len != 1) {
+            return xcb_window_t(XCB_WINDOW_NONE);
+        }
+        return reinterpret_cast<xcb_window_t *>(xcb_get_property_value(reply.get()))[0];
+    };
+    // get rid of the events caused by creating the NETRootInfo
+    free(xcb_get_input_focus_reply(connection(), xcb_get_input_focus(connection()), nullptr));
+    while (xcb_generic_event_t *event = xcb_poll_for_event(connection())) {
+        free(event);
+    }
+
+    const xcb_window_t windows[] = {xcb_generate_id(connection()), xcb_generate_id(connection()), xcb_generate_id(connection())};
+    {
+        NETPropertyTransaction transaction(connection());
+        for (xcb_window_t window : windows) {
+            rootInfo.setActiveWindow(window);
+        }
+        // the object knows, the server not yet
+        QCOMPARE(rootInfo.activeWindow(), windows[2]);
+        QCOMPARE(activeWindowOnServer(), xcb_window_t(XCB_WINDOW_NONE));
+
+        // committing a nested transaction writes nothing either
+        NETPropertyTransaction nested(connection());
+        rootInfo.setActiveWindow(windows[1]);
+        nested.commit();
+        QCOMPARE(activeWindowOnServer(), xcb_window_t(XCB_WINDOW_NONE));
+        QCOMPARE(nested.droppedWrites(), 3);
+
+        rootInfo.setActiveWindow(windows[2]);
+        transaction.commit();
+        QCOMPARE(transaction.droppedWrites(), 4);
+        QCOMPARE(activeWindowOnServer(), windows[2]);
+    }
+
+    // only the last value went to the server
+    int changes = 0;
+    while (xcb_generic_event_t *event = xcb_poll_for_event(connection())) {
+        if ((event->response_type & ~0x80) == XCB_PROPERTY_NOTIFY && reinterpret_cast<xcb_property_notify_event_t *>(event)->atom == atom) {
+            ++changes;
+        }
+        free(event);
+    }
+    QCOMPARE(changes, 1);
+
+    // without a transaction the writes go out right away again
+    rootInfo.setActiveWindow(windows[0]);
+    QCOMPARE(activeWindowOnServer(), windows[0]);
+}
+
 void NetRootInfoTestWM::testDesktopGeometry()
 {
     KXUtils::Atom atom(connection(), QByteArrayLiteral("_NET_DESKTOP_GEOMETRY"));
@@ -0,0 +1,91 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "nettracer.h"
+
+// the root properties KX11Extras tracks for INFO_WINDOWS
+static const NET::Properties rootProperties = NET::ClientList | NET::ClientListStacking | NET::Supported | NET::NumberOfDesktops | NET::DesktopGeometry
+    | NET::DesktopViewport | NET::CurrentDesktop | NET::DesktopNames | NET::ActiveWindow | NET::WorkArea;
+
+// what a taskbar shows of a window
+static const NET::Properties windowProperties = NET::WMName | NET::WMVisibleName | NET::WMIconName | NET::WMState | NET::WMDesktop | NET::WMWindowType
+    | NET::WMIcon | NET::WMStrut;
+static const NET::Properties2 windowProperties2 = NET::WM2ExtendedStrut | NET::WM2WindowClass | NET::WM2DesktopFileName | NET::WM2Activities;
+
+NETTracer::NETTracer(xcb_connection_t *c)
+    : NETRootInfo(c, rootProperties, NET::WM2ShowingDesktop, -1, false)
+{
+    const uint32_t values[] = {XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY};
+    xcb_change_window_attributes(c, rootWindow(), XCB_CW_EVENT_MASK, values);
+    activate();
+}
+
+void NETTracer::process(xcb_generic_event_t *event)
+{
+    xcb_window_t window = XCB_WINDOW_NONE;
+    switch (event->response_type & ~0x80) {
+    case XCB_CLIENT_MESSAGE:
+        window = reinterpret_cast<xcb_client_message_event_t *>(event)->window;
+        break;
+    case XCB_PROPERTY_NOTIFY:
+        window = reinterpret_cast<xcb_property_notify_event_t *>(event)->window;
+        break;
+    case XCB_CONFIGURE_NOTIFY:
+        window = reinterpret_cast<xcb_configure_notify_event_t *>(event)->window;
+        break;
+    default:
+        return;
+    }
+
+    NET::Properties properties;
+    NET::Properties2 properties2;
+    if (window == rootWindow()) {
+        NETRootInfo::event(event, &properties, &properties2);
+        if (properties || properties2) {
+            m_changes.append({window, properties, properties2, QByteArray(), NET::States(), currentDesktop(true)});
+        }
+        return;
+    }
+    if (!m_clients.contains(window)) {
+        return;
+    }
+
+    NETWinInfo dirty(xcbConnection(), window, rootWindow(), NET::Properties(), NET::Properties2());
+    dirty.event(event, &properties, &properties2);
+    properties &= windowProperties;
+    properties2 &= windowProperties2;
+    if (!properties && !properties2) {
+        return;
+    }
+    NETWinInfo info(xcbConnection(), window, rootWindow(), properties, properties2);
+    m_changes.append({window, properties, properties2, QByteArray(info.name()), info.state(), info.desktop(true)});
+}
+
+QList<xcb_window_t> NETTracer::trackedClients() const
+{
+    return m_clients;
+}
+
+const QList<NETTracer::Change> &NETTracer::changes() const
+{
+    return m_changes;
+}
+
+void NETTracer::addClient(xcb_window_t window)
+{
+    const uint32_t values[] = {XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY};
+    xcb_change_window_attributes(xcbConnection(), window, XCB_CW_EVENT_MASK, values);
+    m_clients.append(window);
+
+    NETWinInfo info(xcbConnection(), window, rootWindow(), windowProperties, windowProperties2);
+    m_changes.append({window, windowProperties, windowProperties2, QByteArray(info.name()), info.state(), info.desktop(true)});
+}
+
+void NETTracer::removeClient(xcb_window_t window)
+{
+    m_clients.removeOne(window);
+    m_changes.append({window, NET::Properties(), NET::Properties2(), QByteArray(), NET::States(), 0});
+}
@@ -0,0 +1,55 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#ifndef NETTRACER_H
+#define NETTRACER_H
+
+#include <netwm.h>
+
+#include <QByteArray>
+#include <QList>
+
+#include <xcb/xcb.h>
+
+/*
+ * Follows the root window and the clients of a window manager the way a taskbar does:
+ * a NETRootInfo for the root window, NETWinInfo::event() to find out what changed on a
+ * client and a NETWinInfo fetching the changed properties afterwards.
+ *
+ * Run on a connection recorded by KXcbTrace and then on a KXcbTraceReplay of it, it
+ * reads the same replies in the same order, and changes() of both must match.
+ */
+class NETTracer : public NETRootInfo
+{
+public:
+    struct Change {
+        xcb_window_t window;
+        NET::Properties properties;
+        NET::Properties2 properties2;
+        QByteArray name;
+        NET::States state;
+        int desktop;
+
+        bool operator==(const Change &other) const = default;
+    };
+
+    explicit NETTracer(xcb_connection_t *c);
+
+    void process(xcb_generic_event_t *event);
+
+    QList<xcb_window_t> trackedClients() const;
+    const QList<Change> &changes() const;
+
+protected:
+    void addClient(xcb_window_t window) override;
+    void removeClient(xcb_window_t window) override;
+
+private:
+    QList<xcb_window_t> m_clients;
+    QList<Change> m_changes;
+};
+
+#endif
@@ -5,6 +5,7 @@
 */
 
 #include "nettesthelper.h"
+#include "netwm_p.h"
 #include <netwm.h>
 
 #include <QProcess>
@@ -12,6 +13,7 @@
 #include <qtest_widgets.h>
 
 // system
+#include <memory>
 #include <unistd.h>
 
 using Property = UniqueCPointer<xcb_get_property_reply_t>;
@@ -57,7 +59,10 @@ private Q_SLOTS:
     void testHandledIcons_data();
     void testHandledIcons();
     void testPid();
+    void testRequestState();
+    void testRequestDesktop();
     void testName();
+    void testStringsStayValid();
     void testIconName();
     void testExtendedStrut();
     void testIconGeometry();
@@ -68,6 +73,7 @@ private Q_SLOTS:
     void testActivities();
     void testWindowRole();
     void testWindowClass();
+    void testStringInterning();
     void testClientMachine();
     void testGroupLeader();
     void testUrgency_data();
@@ -87,12 +93,15 @@ private Q_SLOTS:
 private:
     void performNameTest(xcb_atom_t atom, const char *(NETWinInfo:: *getter)(void)const, void (NETWinInfo:: *setter)(const char *), NET::Property property);
     void waitForPropertyChange(NETWinInfo *info, xcb_atom_t atom, NET::Property prop, NET::Property2 prop2 = NET::Property2(0));
+    QList<QList<uint32_t>> takeClientMessages(xcb_connection_t *wm, xcb_atom_t type);
+    xcb_connection_t *connectWindowManager();
     xcb_connection_t *connection()
     {
         return m_connection;
     }
     xcb_connection_t *m_connection;
     QList<xcb_connection_t*> m_connections;
+    QByteArray m_display;
     std::unique_ptr<QProcess> m_xvfb;
     xcb_window_t m_rootWindow;
     xcb_window_t m_testWindow;
@@ -139,6 +148,7 @@ void NetWinInfoTestClient::init()
 
     displayNumber.prepend(QByteArray(":"));
     displayNumber.remove(displayNumber.size() -1, 1);
+    m_display = displayNumber;
 
     // create X connection
     int screen = 0;
@@ -361,6 +371,84 @@ void NetWinInfoTestClient::testHandledIcons()
     QCOMPARE(info.handledIcons(), handled);
 }
 
+// A connection getting the requests the clients send to the window manager
+xcb_connection_t *NetWinInfoTestClient::connectWindowManager()
+{
+    xcb_connection_t *wm = xcb_connect(m_display.constData(), nullptr);
+    m_connections << wm;
+    const uint32_t values[] = {XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT};
+    xcb_change_window_attributes(wm, m_rootWindow, XCB_CW_EVENT_MASK, values);
+    free(xcb_get_input_focus_reply(wm, xcb_get_input_focus(wm), nullptr));
+    return wm;
+}
+
+// Returns the data of the client messages of the given type the window manager got for the test window
+QList<QList<uint32_t>> NetWinInfoTestClient::takeClientMessages(xcb_connection_t *wm, xcb_atom_t type)
+{
+    free(xcb_get_input_focus_reply(connection(), xcb_get_input_focus(connection()), nullptr));
+    free(xcb_get_input_focus_reply(wm, xcb_get_input_focus(wm), nullptr));
+    QList<QList<uint32_t>> messages;
+    while (xcb_generic_event_t *event = xcb_poll_for_event(wm)) {
+        if ((event->response_type & ~0x80) == XCB_CLIENT_MESSAGE) {
+            auto message = reinterpret_cast<xcb_client_message_event_t *>(event);
+            if (message->window == m_testWindow && message->type == type) {
+                messages << QList<uint32_t>(std::begin(message->data.data32), std::end(message->data.data32));
+            }
+        }
+        free(event);
+    }
+    return messages;
+}
+
+void NetWinInfoTestClient::testRequestState()
+{
+    QVERIFY(connection());
+    ATOM(_NET_WM_STATE)
+    KXUtils::Atom above(connection(), QByteArrayLiteral("_NET_WM_STATE_ABOVE"));
+    KXUtils::Atom staysOnTop(connection(), QByteArrayLiteral("_NET_WM_STATE_STAYS_ON_TOP"));
+    KXUtils::Atom shaded(connection(), QByteArrayLiteral("_NET_WM_STATE_SHADED"));
+    KXUtils::Atom maxHorz(connection(), QByteArrayLiteral("_NET_WM_STATE_MAXIMIZED_HORZ"));
+    KXUtils::Atom maxVert(connection(), QByteArrayLiteral("_NET_WM_STATE_MAXIMIZED_VERT"));
+    xcb_connection_t *wm = connectWindowManager();
+
+    // nothing is known about the window, every state in the mask gets requested
+    NETWinInfo info(connection(), m_testWindow, m_rootWindow, NET::Properties(), NET::Properties2(), NET::Client);
+    info.requestState(NET::KeepAbove | NET::Max, NET::KeepAbove | NET::Max | NET::Shaded);
+    QCOMPARE(info.state(), NET::States());
+
+    const QList<QList<uint32_t>> messages = takeClientMessages(wm, atom);
+    QCOMPARE(messages.size(), 4);
+    QCOMPARE(messages.at(0).mid(0, 3), (QList<uint32_t>{0, shaded, XCB_ATOM_NONE}));
+    QCOMPARE(messages.at(1).mid(0, 3), (QList<uint32_t>{1, above, XCB_ATOM_NONE}));
+    QCOMPARE(messages.at(2).mid(0, 3), (QList<uint32_t>{1, staysOnTop, XCB_ATOM_NONE}));
+    QCOMPARE(messages.at(3).mid(0, 3), (QList<uint32_t>{1, maxHorz, maxVert}));
+
+    // the directions of the maximization go separately if they differ
+    info.requestState(NET::MaxVert, NET::Max);
+    const QList<QList<uint32_t>> maximize = takeClientMessages(wm, atom);
+    QCOMPARE(maximize.size(), 2);
+    QCOMPARE(maximize.at(0).mid(0, 3), (QList<uint32_t>{0, maxHorz, XCB_ATOM_NONE}));
+    QCOMPARE(maximize.at(1).mid(0, 3), (QList<uint32_t>{1, maxVert, XCB_ATOM_NONE}));
+}
+
+void NetWinInfoTestClient::testRequestDesktop()
+{
+    QVERIFY(connection());
+    ATOM(_NET_WM_DESKTOP)
+    xcb_connection_t *wm = connectWindowManager();
+
+    NETWinInfo info(connection(), m_testWindow, m_rootWindow, NET::Properties(), NET::Properties2(), NET::Client);
+    info.requestDesktop(3);
+    info.requestDesktop(NET::OnAllDesktops);
+    // not possible for managed windows
+    info.requestDesktop(0);
+
+    const QList<QList<uint32_t>> messages = takeClientMessages(wm, atom);
+    QCOMPARE(messages.size(), 2);
+    QCOMPARE(messages.at(0).at(0), uint32_t(2));
+    QCOMPARE(messages.at(1).at(0), uint32_t(0xffffffff));
+}
+
 void NetWinInfoTestClient::testPid()
 {
     QVERIFY(connection());
@@ -431,6 +519,29 @@ void NetWinInfoTestClient::testName()
     performNameTest(atom, &NETWinInfo::name, &NETWinInfo::setName, NET::WMName);
 }
 
+void NetWinInfoTestClient::testStringsStayValid()
+{
+    QVERIFY(connection());
+    INFO
+
+    info.setName("foo");
+    info.setStartupId("bar");
+    const char *name = info.name();
+    const char *startupId = info.startupId();
+
+    // updating other strings, far beyond what fits next to them, must not move these
+    for (int i = 1; i <= 100; ++i) {
+        info.setIconName(QByteArray(i, 'x').constData());
+        info.setDesktopFileName(QByteArray(i, 'y').constData());
+    }
+    QVERIFY(info.name() == name);
+    QVERIFY(info.startupId() == startupId);
+    QCOMPARE(name, "foo");
+    QCOMPARE(startupId, "bar");
+    QCOMPARE(info.iconName(), QByteArray(100, 'x').constData());
+    QCOMPARE(info.desktopFileName(), QByteArray(100, 'y').constData());
+}
+
 void NetWinInfoTestClient::testExtendedStrut()
 {
     QVERIFY(connection());
@@ -876,6 +987,55 @@ void NetWinInfoTestClient::testWindowClass()
     QCOMPARE(info.windowClassClass(), "bar");
 }
 
+void NetWinInfoTestClient::testStringInterning()
+{
+    QVERIFY(connection());
+    QVERIFY(!NETWinInfo::isStringInterningEnabled());
+
+    xcb_window_t otherWindow = xcb_generate_id(connection());
+    xcb_create_window(connection(), XCB_COPY_FROM_PARENT, otherWindow, m_rootWindow,
+                      0, 0, 100, 100, 0, XCB_COPY_FROM_PARENT, XCB_COPY_FROM_PARENT, 0, nullptr);
+    for (xcb_window_t window : {m_testWindow, otherWindow}) {
+        xcb_change_property(connection(), XCB_PROP_MODE_REPLACE, window,
+                            XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 8, 8, "foo\0foo\0");
+        xcb_change_property(connection(), XCB_PROP_MODE_REPLACE, window,
+                            XCB_ATOM_WM_CLIENT_MACHINE, XCB_ATOM_STRING, 8, 9, "localhost");
+    }
+    free(xcb_get_input_focus_reply(connection(), xcb_get_input_focus(connection()), nullptr));
+
+    const NET::Properties2 properties2 = NET::WM2WindowClass | NET::WM2ClientMachine;
+    NETWinInfoFetcher copied(connection(), otherWindow, m_rootWindow, NET::Properties(), properties2);
+
+    NETWinInfo::setStringInterningEnabled(true);
+    auto info = std::make_unique<NETWinInfo>(connection(), m_testWindow, m_rootWindow, NET::Properties(), properties2);
+    NETWinInfoFetcher other(connection(), otherWindow, m_rootWindow, NET::Properties(), properties2);
+    NETWinInfo::setStringInterningEnabled(false);
+
+    // equal strings are shared, between windows as well as within one
+    QCOMPARE(info->windowClassName(), "foo");
+    QCOMPARE(info->clientMachine(), "localhost");
+    QCOMPARE(static_cast<const void *>(info->windowClassName()), static_cast<const void *>(other.windowClassName()));
+    QCOMPARE(static_cast<const void *>(info->windowClassName()), static_cast<const void *>(info->windowClassClass()));
+    QCOMPARE(static_cast<const void *>(info->clientMachine()), static_cast<const void *>(other.clientMachine()));
+
+    // but not with windows read while interning was disabled
+    QCOMPARE(copied.windowClassName(), "foo");
+    QVERIFY(copied.windowClassName() != other.windowClassName());
+
+    // the bytes of an interned string share its data, others are copied
+    QCOMPARE(static_cast<const void *>(other.stringBytes(other.windowClassName()).constData()), static_cast<const void *>(other.windowClassName()));
+    QCOMPARE(copied.stringBytes(copied.windowClassName()), QByteArray("foo"));
+    QVERIFY(copied.stringBytes(copied.windowClassName()).constData() != copied.windowClassName());
+    QVERIFY(copied.stringBytes(nullptr).isNull());
+
+    // and stay around as long as a window holds them
+    info.reset();
+    QCOMPARE(other.windowClassName(), "foo");
+    QCOMPARE(other.clientMachine(), "localhost");
+
+    xcb_destroy_window(connection(), otherWindow);
+}
+
 void NetWinInfoTestClient::testWindowRole()
 {
     QVERIFY(connection());
@@ -0,0 +1,138 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "windowmodel.h"
+
+#include <QAbstractItemModelTester>
+#include <QSignalSpy>
+#include <QWidget>
+
+#include <qtest_widgets.h>
+
+#include <algorithm>
+#include <memory>
+
+class WindowModelTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testInitialRows();
+    void testWindowAddedAndRemoved();
+    void testFirstReadFetches();
+    void testNameChanged();
+};
+
+// -1 if the window has no row
+static int rowOf(const WindowModel &model, WId window)
+{
+    for (int row = 0; row < model.rowCount(); ++row) {
+        if (model.index(row).data(WindowModel::WindowIdRole).value<WId>() == window) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+void WindowModelTest::initTestCase()
+{
+    QCoreApplication::setAttribute(Qt::AA_ForceRasterWidgets);
+}
+
+void WindowModelTest::testInitialRows()
+{
+    QWidget widget;
+    widget.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&widget));
+    QTRY_VERIFY(KX11Extras::windows().contains(widget.winId()));
+
+    WindowModel model;
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+    QCOMPARE(model.rowCount(), KX11Extras::windows().count());
+    for (int row = 0; row < model.rowCount(); ++row) {
+        QCOMPARE(model.index(row).data(WindowModel::WindowIdRole).value<WId>(), KX11Extras::windows().at(row));
+    }
+    QVERIFY(rowOf(model, widget.winId()) != -1);
+}
+
+void WindowModelTest::testWindowAddedAndRemoved()
+{
+    WindowModel model;
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+
+    std::unique_ptr<QWidget> first(new QWidget);
+    std::unique_ptr<QWidget> second(new QWidget);
+    first->show();
+    second->show();
+    QVERIFY(QTest::qWaitForWindowExposed(first.get()));
+    QVERIFY(QTest::qWaitForWindowExposed(second.get()));
+    const WId firstWindow = first->winId();
+    const WId secondWindow = second->winId();
+    QTRY_VERIFY(rowOf(model, firstWindow) != -1);
+    QTRY_VERIFY(rowOf(model, secondWindow) != -1);
+
+    // removing a row in front of another one moves the row of the latter
+    const int rows = model.rowCount();
+    first->hide();
+    QTRY_COMPARE(rowOf(model, firstWindow), -1);
+    QCOMPARE(model.rowCount(), rows - 1);
+    const int secondRow = rowOf(model, secondWindow);
+    QVERIFY(secondRow != -1);
+    QCOMPARE(model.index(secondRow).data(WindowModel::WindowIdRole).value<WId>(), secondWindow);
+
+    second->hide();
+    QTRY_COMPARE(rowOf(model, secondWindow), -1);
+    QCOMPARE(model.rowCount(), rows - 2);
+}
+
+void WindowModelTest::testFirstReadFetches()
+{
+    WindowModel model;
+
+    QWidget widget;
+    widget.setWindowTitle(QStringLiteral("foo"));
+    widget.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&widget));
+    QTRY_VERIFY(rowOf(model, widget.winId()) != -1);
+    const QModelIndex index = model.index(rowOf(model, widget.winId()));
+
+    // the first read doesn't wait for the server, the row changes once the values arrived
+    QSignalSpy changedSpy(&model, &QAbstractItemModel::dataChanged);
+    QVERIFY(!index.data(WindowModel::NameRole).isValid());
+    QVERIFY(!index.data(WindowModel::PidRole).isValid());
+    QTRY_VERIFY(!changedSpy.isEmpty());
+    QCOMPARE(changedSpy.first().at(0).toModelIndex(), index);
+    QVERIFY(changedSpy.first().at(2).value<QList<int>>().contains(WindowModel::NameRole));
+    QCOMPARE(index.data(WindowModel::NameRole).toString(), QStringLiteral("foo"));
+    QCOMPARE(index.data(WindowModel::WindowClassRole).toString(), QString::fromLocal8Bit(KWindowInfo(widget.winId(), NET::Properties(), NET::WM2WindowClass).windowClassClass()));
+}
+
+void WindowModelTest::testNameChanged()
+{
+    WindowModel model;
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+
+    QWidget widget;
+    widget.setWindowTitle(QStringLiteral("foo"));
+    widget.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&widget));
+    QTRY_VERIFY(rowOf(model, widget.winId()) != -1);
+    const QModelIndex index = model.index(rowOf(model, widget.winId()));
+    QTRY_COMPARE(index.data(WindowModel::NameRole).toString(), QStringLiteral("foo"));
+
+    // the row was read, so it is fetched again and reported as changed
+    QSignalSpy changedSpy(&model, &QAbstractItemModel::dataChanged);
+    widget.setWindowTitle(QStringLiteral("bar"));
+    QTRY_VERIFY(std::any_of(changedSpy.cbegin(), changedSpy.cend(), [&index](const QList<QVariant> &args) {
+        return args.at(0).toModelIndex() == index && args.at(2).value<QList<int>>().contains(WindowModel::NameRole);
+    }));
+    QCOMPARE(index.data(WindowModel::NameRole).toString(), QStringLiteral("bar"));
+    QCOMPARE(index.data(Qt::DisplayRole).toString(), QStringLiteral("bar"));
+}
+
+QTEST_MAIN(WindowModelTest)
+
+#include "windowmodeltest.moc"
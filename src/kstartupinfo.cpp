@@ -18,6 +18,7 @@
 
 #include "kstartupinfo.h"
 #include "kwindowsystem_debug.h"
+#include "kxcbinstrumentation_p.h"
 
 #include <QDateTime>
 
@@ -603,6 +604,7 @@ KStartupInfo::startup_t KStartupInfo::Private::check_startup_internal(WId w_P, K
     if (startups.isEmpty()) {
         return NoMatch; // no startups
     }
+    KXcbInstrumentation::Scope scope(QX11Info::connection(), "KStartupInfo::checkStartup");
     // Strategy:
     //
     // Is this a compliant app ?
@@ -724,6 +726,7 @@ QByteArray KStartupInfo::windowStartupId(WId w_P)
     if (!QX11Info::isPlatformX11()) {
         return QByteArray();
     }
+    KXcbInstrumentation::Scope scope(QX11Info::connection(), "KStartupInfo::windowStartupId");
     NETWinInfo info(QX11Info::connection(), w_P, QX11Info::appRootWindow(), NET::Properties(), NET::WM2StartupId | NET::WM2GroupLeader);
     QByteArray ret = info.startupId();
     if (ret.isEmpty() && info.groupLeader() != XCB_WINDOW_NONE) {
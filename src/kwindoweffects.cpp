@@ -5,9 +5,18 @@
 */
 
 #include "kwindoweffects_p.h"
+#include "kwindowsystem_debug.h"
 #include "pluginwrapper_p.h"
+#include <QHash>
 #include <QWindow>
 
+#include <atomic>
+#include <utility>
+
+static std::atomic<quint64> s_simplifiedRegions = 0;
+static std::atomic<quint64> s_rectsBeforeSimplification = 0;
+static std::atomic<quint64> s_rectsAfterSimplification = 0;
+
 KWindowEffectsPrivate::KWindowEffectsPrivate()
 {
 }
@@ -16,6 +25,40 @@ KWindowEffectsPrivate::~KWindowEffectsPrivate()
 {
 }
 
+KWindowEffectsPrivate::RegionSimplificationStats KWindowEffectsPrivate::regionSimplificationStats()
+{
+    RegionSimplificationStats stats;
+    stats.regions = s_simplifiedRegions;
+    stats.rectsBefore = s_rectsBeforeSimplification;
+    stats.rectsAfter = s_rectsAfterSimplification;
+    return stats;
+}
+
+QList<QRect> KWindowEffectsPrivate::simplifiedRects(const QRegion &region)
+{
+    QList<QRect> rects;
+    rects.reserve(region.rectCount());
+    // per horizontal span, the rect that may continue in the next band
+    QHash<std::pair<int, int>, qsizetype> open;
+    for (const QRect &rect : region) {
+        const std::pair<int, int> span(rect.left(), rect.width());
+        if (const auto it = open.constFind(span); it != open.constEnd() && rects.at(*it).bottom() + 1 == rect.top()) {
+            rects[*it].setBottom(rect.bottom());
+            continue;
+        }
+        open.insert(span, rects.size());
+        rects.append(rect);
+    }
+
+    if (rects.size() < region.rectCount()) {
+        ++s_simplifiedRegions;
+        s_rectsBeforeSimplification += region.rectCount();
+        s_rectsAfterSimplification += rects.size();
+        qCDebug(LOG_KWINDOWSYSTEM) << "Simplified effect region from" << region.rectCount() << "to" << rects.size() << "rects";
+    }
+    return rects;
+}
+
 namespace KWindowEffects
 {
 bool isEffectAvailable(Effect effect)
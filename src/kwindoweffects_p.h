@@ -8,6 +8,9 @@
 #define KWINDOWEFFECTS_P_H
 #include "kwindoweffects.h"
 
+#include <QList>
+#include <QRegion>
+
 class KWINDOWSYSTEM_EXPORT KWindowEffectsPrivate
 {
 public:
@@ -22,6 +25,21 @@ public:
                                           qreal saturation = 1,
                                           const QRegion &region = QRegion()) = 0;
 
+    // How much simplifiedRects() saved so far, for all windows
+    struct RegionSimplificationStats {
+        quint64 regions = 0;
+        quint64 rectsBefore = 0;
+        quint64 rectsAfter = 0;
+    };
+    static RegionSimplificationStats regionSimplificationStats();
+
+    /*
+     * Returns the rects of region, with rects merged into the one above them if both span
+     * exactly the same columns. A QRegion splits a rect into a band wherever a rect next to
+     * it starts or ends, this undoes that without covering a single pixel more or less.
+     */
+    static QList<QRect> simplifiedRects(const QRegion &region);
+
 protected:
     KWindowEffectsPrivate();
 };
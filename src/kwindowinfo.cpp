@@ -8,13 +8,18 @@
 #include "kwindowsystem.h"
 #include "kwindowsystem_debug.h"
 #include "kx11extras.h"
+#include "kxcbeventdispatcher_p.h"
+#include "kxcbinstrumentation_p.h"
 #include "netwm.h"
+#include "netwm_p.h"
 
 #include <config-kwindowsystem.h>
 
 #include "private/qtx11extras_p.h"
 #include <QDebug>
+#include <QPromise>
 #include <QRect>
+#include <QThread>
 
 #include "kxerrorhandler_p.h"
 #include <X11/Xatom.h>
@@ -23,27 +28,51 @@
 
 #include "cptr_p.h"
 
+#include <deque>
+#include <optional>
+
 static bool haveXRes()
 {
     static bool s_checked = false;
     static bool s_haveXRes = false;
     if (!s_checked) {
         auto cookie = xcb_res_query_version(QX11Info::connection(), XCB_RES_MAJOR_VERSION, XCB_RES_MINOR_VERSION);
-        UniqueCPointer<xcb_res_query_version_reply_t> reply(xcb_res_query_version_reply(QX11Info::connection(), cookie, nullptr));
+        UniqueCPointer<xcb_res_query_version_reply_t> reply(KXcbInstrumentation::reply(xcb_res_query_version_reply, QX11Info::connection(), cookie, nullptr));
         s_haveXRes = reply != nullptr;
         s_checked = true;
     }
     return s_haveXRes;
 }
 
+static xcb_res_query_client_ids_cookie_t requestPid(WId window)
+{
+    xcb_res_client_id_spec_t specs;
+    specs.client = window;
+    specs.mask = XCB_RES_CLIENT_ID_MASK_LOCAL_CLIENT_PID;
+    return xcb_res_query_client_ids(QX11Info::connection(), 1, &specs);
+}
+
+static int pidFromReply(xcb_res_query_client_ids_reply_t *reply)
+{
+    if (reply && xcb_res_query_client_ids_ids_length(reply) > 0) {
+        return *xcb_res_client_id_value_value((xcb_res_query_client_ids_ids_iterator(reply).data));
+    }
+    return -1;
+}
+
 class Q_DECL_HIDDEN KWindowInfoPrivate : public QSharedData
 {
 public:
+    // Adds the properties the getters fall back to
+    static void completeProperties(NET::Properties &properties, NET::Properties2 &properties2);
+    // Takes the names and the geometry from m_info once it is fetched
+    void readInfo(NET::Properties properties);
+
     WId window;
     NET::Properties properties;
     NET::Properties2 properties2;
 
-    std::unique_ptr<NETWinInfo> m_info;
+    std::unique_ptr<NETWinInfoFetcher> m_info;
     QString m_name;
     QString m_iconic_name;
     QRect m_geometry;
@@ -52,18 +81,8 @@ public:
     bool m_valid = false;
 };
 
-KWindowInfo::KWindowInfo(WId window, NET::Properties properties, NET::Properties2 properties2)
-    : d(new KWindowInfoPrivate)
+void KWindowInfoPrivate::completeProperties(NET::Properties &properties, NET::Properties2 &properties2)
 {
-    d->window = window;
-    d->properties = properties;
-    d->properties2 = properties2;
-
-    if (!KWindowSystem::isPlatformX11()) {
-        return;
-    }
-
-    KXErrorHandler handler;
     if (properties & NET::WMVisibleIconName) {
         properties |= NET::WMIconName | NET::WMVisibleName; // force, in case it will be used as a fallback
     }
@@ -80,42 +99,214 @@ KWindowInfo::KWindowInfo(WId window, NET::Properties properties, NET::Properties
         properties |= NET::WMGeometry; // for viewports, the desktop (workspace) is determined from the geometry
     }
     properties |= NET::XAWMState; // force to get error detection for valid()
-    d->m_info.reset(new NETWinInfo(QX11Info::connection(), d->window, QX11Info::appRootWindow(), properties, properties2));
+}
+
+void KWindowInfoPrivate::readInfo(NET::Properties properties)
+{
     if (properties & NET::WMName) {
-        if (d->m_info->name() && d->m_info->name()[0] != '\0') {
-            d->m_name = QString::fromUtf8(d->m_info->name());
+        if (m_info->name() && m_info->name()[0] != '\0') {
+            m_name = QString::fromUtf8(m_info->name());
         } else {
-            d->m_name = KX11Extras::readNameProperty(d->window, XA_WM_NAME);
+            m_name = KX11Extras::readNameProperty(window, XA_WM_NAME);
         }
     }
     if (properties & NET::WMIconName) {
-        if (d->m_info->iconName() && d->m_info->iconName()[0] != '\0') {
-            d->m_iconic_name = QString::fromUtf8(d->m_info->iconName());
+        if (m_info->iconName() && m_info->iconName()[0] != '\0') {
+            m_iconic_name = QString::fromUtf8(m_info->iconName());
         } else {
-            d->m_iconic_name = KX11Extras::readNameProperty(d->window, XA_WM_ICON_NAME);
+            m_iconic_name = KX11Extras::readNameProperty(window, XA_WM_ICON_NAME);
         }
     }
     if (properties & (NET::WMGeometry | NET::WMFrameExtents)) {
         NETRect frame;
         NETRect geom;
-        d->m_info->kdeGeometry(frame, geom);
-        d->m_geometry.setRect(geom.pos.x, geom.pos.y, geom.size.width, geom.size.height);
-        d->m_frame_geometry.setRect(frame.pos.x, frame.pos.y, frame.size.width, frame.size.height);
+        m_info->kdeGeometry(frame, geom);
+        m_geometry.setRect(geom.pos.x, geom.pos.y, geom.size.width, geom.size.height);
+        m_frame_geometry.setRect(frame.pos.x, frame.pos.y, frame.size.width, frame.size.height);
     }
+}
+
+KWindowInfo::KWindowInfo(WId window, NET::Properties properties, NET::Properties2 properties2)
+    : d(new KWindowInfoPrivate)
+{
+    d->window = window;
+    d->properties = properties;
+    d->properties2 = properties2;
+
+    if (!KWindowSystem::isPlatformX11()) {
+        return;
+    }
+
+    KXcbInstrumentation::Scope scope(QX11Info::connection(), "KWindowInfo::KWindowInfo");
+    KXErrorHandler handler;
+    KWindowInfoPrivate::completeProperties(properties, properties2);
+    d->m_info.reset(new NETWinInfoFetcher(QX11Info::connection(), d->window, QX11Info::appRootWindow(), properties, properties2));
+    d->readInfo(properties);
     d->m_valid = !handler.error(false); // no sync - NETWinInfo did roundtrips
 
     if (haveXRes()) {
-        xcb_res_client_id_spec_t specs;
-        specs.client = win();
-        specs.mask = XCB_RES_CLIENT_ID_MASK_LOCAL_CLIENT_PID;
-        auto cookie = xcb_res_query_client_ids(QX11Info::connection(), 1, &specs);
-
-        UniqueCPointer<xcb_res_query_client_ids_reply_t> reply(xcb_res_query_client_ids_reply(QX11Info::connection(), cookie, nullptr));
-        if (reply && xcb_res_query_client_ids_ids_length(reply.get()) > 0) {
-            uint32_t pid = *xcb_res_client_id_value_value((xcb_res_query_client_ids_ids_iterator(reply.get()).data));
-            d->m_pid = pid;
+        UniqueCPointer<xcb_res_query_client_ids_reply_t> reply(
+            KXcbInstrumentation::reply(xcb_res_query_client_ids_reply, QX11Info::connection(), requestPid(win()), nullptr));
+        d->m_pid = pidFromReply(reply.get());
+    }
+}
+
+KWindowInfo::KWindowInfo(KWindowInfoPrivate *d)
+    : d(d)
+{
+}
+
+// Sends the requests of KWindowInfo::fetch() followed by a property change on syncWindow.
+// Once its PropertyNotify arrives all replies of the fetch have been received and are
+// collected without blocking.
+class KWindowInfoFetcher : public KXcbEventFilter
+{
+public:
+    ~KWindowInfoFetcher() override;
+    static KWindowInfoFetcher *self();
+
+    QFuture<KWindowInfo> fetch(WId window, NET::Properties properties, NET::Properties2 properties2);
+    bool xcbEventFilter(xcb_generic_event_t *event) override;
+
+private:
+    struct Pending {
+        QPromise<KWindowInfo> promise;
+        QExplicitlySharedDataPointer<KWindowInfoPrivate> d;
+        std::unique_ptr<NETWinInfoFetcher> info;
+        NETWinInfoFetchData data;
+        xcb_get_geometry_cookie_t geometryCookie = {};
+        std::optional<xcb_translate_coordinates_cookie_t> translateCookie;
+        std::optional<xcb_res_query_client_ids_cookie_t> pidCookie;
+    };
+    void finish(Pending &entry);
+
+    xcb_window_t syncWindow = XCB_WINDOW_NONE;
+    // in the order of their property changes on syncWindow
+    std::deque<Pending> pending;
+};
+
+Q_GLOBAL_STATIC(KWindowInfoFetcher, s_fetcher)
+
+KWindowInfoFetcher *KWindowInfoFetcher::self()
+{
+    return s_fetcher();
+}
+
+KWindowInfoFetcher::~KWindowInfoFetcher()
+{
+    if (syncWindow != XCB_WINDOW_NONE && QX11Info::connection()) {
+        xcb_destroy_window(QX11Info::connection(), syncWindow);
+    }
+}
+
+QFuture<KWindowInfo> KWindowInfoFetcher::fetch(WId window, NET::Properties properties, NET::Properties2 properties2)
+{
+    xcb_connection_t *c = QX11Info::connection();
+    const xcb_window_t root = QX11Info::appRootWindow();
+
+    if (syncWindow == XCB_WINDOW_NONE) {
+        syncWindow = KXcbEventDispatcher::self()->createSyncWindow(this, c, root);
+    }
+
+    Pending &entry = pending.emplace_back();
+    entry.d.reset(new KWindowInfoPrivate);
+    entry.d->window = window;
+    entry.d->properties = properties;
+    entry.d->properties2 = properties2;
+
+    KWindowInfoPrivate::completeProperties(properties, properties2);
+    entry.info = std::make_unique<NETWinInfoFetcher>(c, window, root, NET::Properties(), NET::Properties2());
+    entry.data.properties = properties;
+    entry.data.properties2 = properties2;
+    entry.info->fetch(NETWinInfoRequestHook, &entry.data);
+
+    // also tells whether the window exists
+    entry.geometryCookie = xcb_get_geometry(c, window);
+    if (properties & (NET::WMGeometry | NET::WMFrameExtents)) {
+        entry.translateCookie = xcb_translate_coordinates(c, window, root, 0, 0);
+    }
+    if (haveXRes()) {
+        entry.pidCookie = requestPid(window);
+    }
+
+    KXcbEventDispatcher::requestSync(c, syncWindow);
+
+    entry.promise.start();
+    return entry.promise.future();
+}
+
+bool KWindowInfoFetcher::xcbEventFilter(xcb_generic_event_t *event)
+{
+    if ((event->response_type & ~0x80) != XCB_PROPERTY_NOTIFY || reinterpret_cast<xcb_property_notify_event_t *>(event)->window != syncWindow) {
+        return false;
+    }
+
+    // every fetch changed the property once, so the oldest one is complete
+    if (!pending.empty()) {
+        Pending entry = std::move(pending.front());
+        pending.pop_front();
+        // may start new fetches from a continuation
+        finish(entry);
+    }
+    return true;
+}
+
+// The replies of a fetch precede the PropertyNotify it is finished on, so this doesn't block
+template<typename Reply>
+static UniqueCPointer<Reply> takeReply(xcb_connection_t *c, unsigned int sequence, bool *failed = nullptr)
+{
+    void *reply = nullptr;
+    xcb_generic_error_t *error = nullptr;
+    xcb_poll_for_reply(c, sequence, &reply, &error);
+    if (failed) {
+        *failed = error != nullptr;
+    }
+    free(error);
+    return UniqueCPointer<Reply>(static_cast<Reply *>(reply));
+}
+
+void KWindowInfoFetcher::finish(Pending &entry)
+{
+    xcb_connection_t *c = QX11Info::connection();
+    KWindowInfoPrivate *d = entry.d.data();
+
+    bool failed = false;
+    const UniqueCPointer<xcb_get_geometry_reply_t> geometry = takeReply<xcb_get_geometry_reply_t>(c, entry.geometryCookie.sequence, &failed);
+    if (entry.translateCookie) {
+        const UniqueCPointer<xcb_translate_coordinates_reply_t> translated = takeReply<xcb_translate_coordinates_reply_t>(c, entry.translateCookie->sequence);
+        if (geometry && translated) {
+            NETRect rect;
+            rect.pos.x = translated->dst_x;
+            rect.pos.y = translated->dst_y;
+            rect.size.width = geometry->width;
+            rect.size.height = geometry->height;
+            entry.data.geometry = rect;
         }
     }
+    entry.info->fetch(NETWinInfoParseHook, &entry.data);
+    d->m_info = std::move(entry.info);
+
+    d->m_valid = geometry && !failed;
+    if (d->m_valid) {
+        // the legacy name fallback is the only request left
+        d->readInfo(entry.data.properties);
+    }
+    if (entry.pidCookie) {
+        d->m_pid = pidFromReply(takeReply<xcb_res_query_client_ids_reply_t>(c, entry.pidCookie->sequence).get());
+    }
+
+    entry.promise.addResult(KWindowInfo(d));
+    entry.promise.finish();
+}
+
+QFuture<KWindowInfo> KWindowInfo::fetch(WId window, NET::Properties properties, NET::Properties2 properties2)
+{
+    // the replies are collected from the events of the main thread
+    if (!KWindowSystem::isPlatformX11() || !QThread::isMainThread()) {
+        return QtFuture::makeReadyValueFuture(KWindowInfo(window, properties, properties2));
+    }
+    KXcbInstrumentation::Scope scope(QX11Info::connection(), "KWindowInfo::fetch");
+    return KWindowInfoFetcher::self()->fetch(window, properties, properties2);
 }
 
 KWindowInfo::KWindowInfo(const KWindowInfo &other)
@@ -484,7 +675,7 @@ QByteArray KWindowInfo::windowClassClass() const
         qWarning() << "Pass NET::WM2WindowClass to KWindowInfo";
     }
 #endif
-    return d->m_info->windowClassClass();
+    return d->m_info->stringBytes(d->m_info->windowClassClass());
 }
 
 QByteArray KWindowInfo::windowClassName() const
@@ -495,7 +686,7 @@ QByteArray KWindowInfo::windowClassName() const
         qWarning() << "Pass NET::WM2WindowClass to KWindowInfo";
     }
 #endif
-    return d->m_info->windowClassName();
+    return d->m_info->stringBytes(d->m_info->windowClassName());
 }
 
 QByteArray KWindowInfo::windowRole() const
@@ -517,7 +708,7 @@ QByteArray KWindowInfo::clientMachine() const
         qWarning() << "Pass NET::WM2ClientMachine to KWindowInfo";
     }
 #endif
-    return d->m_info->clientMachine();
+    return d->m_info->stringBytes(d->m_info->clientMachine());
 }
 
 bool KWindowInfo::allowedActionsSupported() const
@@ -558,7 +749,7 @@ QByteArray KWindowInfo::desktopFileName() const
         qWarning() << "Pass NET::WM2DesktopFileName to KWindowInfo";
     }
 #endif
-    return QByteArray(d->m_info->desktopFileName());
+    return d->m_info->stringBytes(d->m_info->desktopFileName());
 }
 
 QByteArray KWindowInfo::gtkApplicationId() const
@@ -569,7 +760,7 @@ QByteArray KWindowInfo::gtkApplicationId() const
         qWarning() << "Pass NET::WM2DesktopFileName to KWindowInfo";
     }
 #endif
-    return QByteArray(d->m_info->gtkApplicationId());
+    return d->m_info->stringBytes(d->m_info->gtkApplicationId());
 }
 
 QByteArray KWindowInfo::applicationMenuServiceName() const
@@ -13,6 +13,7 @@
 #define KWINDOWINFO_H
 
 #include <QExplicitlySharedDataPointer>
+#include <QFuture>
 #include <QStringList>
 #include <QWidgetList> //For WId
 #include <kwindowsystem_export.h>
@@ -74,6 +75,26 @@ public:
      */
     KWindowInfo(WId window, NET::Properties properties, NET::Properties2 properties2 = NET::Properties2());
     ~KWindowInfo();
+    /*!
+     * Reads the info about the given \a window without blocking.
+     *
+     * Like the constructor, only the information requested through \a properties and
+     * \a properties2 is fetched. The requests are sent right away and the returned future
+     * finishes from the event loop once all replies arrived, so the fetches for many
+     * windows overlap instead of waiting for each other.
+     *
+     * Has to be called from the main thread. Outside of X11 the future is finished
+     * right away with an invalid KWindowInfo.
+     *
+     * \code
+     * KWindowInfo::fetch(window, NET::WMVisibleName).then(this, [](const KWindowInfo &info) {
+     *     qDebug() << info.visibleName();
+     * });
+     * \endcode
+     *
+     * \since 6.30
+     */
+    static QFuture<KWindowInfo> fetch(WId window, NET::Properties properties, NET::Properties2 properties2 = NET::Properties2());
     /*!
      * Returns false if this window info is not valid.
      *
@@ -604,6 +625,8 @@ public:
     KWindowInfo &operator=(const KWindowInfo &);
 
 private:
+    friend class KWindowInfoFetcher;
+    KWINDOWSYSTEM_NO_EXPORT explicit KWindowInfo(KWindowInfoPrivate *d);
     bool KWINDOWSYSTEM_NO_EXPORT icccmCompliantMappingState() const;
     bool KWINDOWSYSTEM_NO_EXPORT allowedActionsSupported() const;
 
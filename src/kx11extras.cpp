@@ -19,21 +19,38 @@
 #include "kwindowsystem.h"
 #include "kwindowsystem_debug.h"
 #include "kxcbevent_p.h"
+#include "kxcbeventdispatcher_p.h"
+#include "kxcbinstrumentation_p.h"
 #include "netwm.h"
+#include "netwm_p.h"
 
-#include <QAbstractNativeEventFilter>
 #include <QGuiApplication>
+#include <QHash>
 #include <QMetaMethod>
+#include <QElapsedTimer>
+#include <QMutex>
 #include <QRect>
 #include <QScreen>
+#include <QSet>
+#include <QSocketNotifier>
+#include <QThread>
+#include <QTimer>
 #include <private/qtx11extras_p.h>
 
 #include <X11/Xatom.h>
 #include <X11/Xutil.h>
-#include <X11/extensions/Xfixes.h>
 #include <xcb/xcb.h>
 #include <xcb/xfixes.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <vector>
+
 // QPoint and QSize all have handy / operators which are useful for scaling, positions and sizes for high DPI support
 // QRect does not, so we create one for internal purposes within this class
 inline QRect operator/(const QRect &rectangle, qreal factor)
@@ -53,7 +70,9 @@ private:
     KX11Extras::FilterInfo m_what;
 };
 
-class NETEventFilter : public NETRootInfo, public QAbstractNativeEventFilter
+struct NETChangeSet;
+
+class NETEventFilter : public NETRootInfo, public KXcbEventFilter
 {
 public:
     NETEventFilter(KX11Extras::FilterInfo _what);
@@ -63,46 +82,207 @@ public:
     QList<WId> stackingOrder;
 
     struct StrutData {
-        StrutData(WId window_, const NETStrut &strut_, int desktop_)
-            : window(window_)
-            , strut(strut_)
+        StrutData(const NETStrut &strut_, const NETExtendedStrut &extendedStrut_, int desktop_)
+            : strut(strut_)
+            , extendedStrut(extendedStrut_)
             , desktop(desktop_)
         {
         }
-        WId window;
+        bool hasExtendedStrut() const
+        {
+            return extendedStrut.left_width || extendedStrut.right_width || extendedStrut.top_width || extendedStrut.bottom_width;
+        }
+        bool isEmpty() const
+        {
+            return !hasExtendedStrut() && !strut.left && !strut.right && !strut.top && !strut.bottom;
+        }
         NETStrut strut;
+        NETExtendedStrut extendedStrut;
         int desktop;
     };
-    QList<StrutData> strutWindows;
+    QHash<WId, StrutData> strutWindows;
     QList<WId> possibleStrutWindows;
+    void resolvePossibleStrutWindows();
+    QRect strutWorkArea(const QList<WId> &exclude, int desktop);
+    // results of strutWorkArea() keyed by desktop and the sorted exclude list,
+    // cleared whenever a strut, the number of desktops or the screens change
+    QHash<QPair<int, QList<WId>>, QRect> workAreaCache;
+    int workAreaCacheGeneration = 0;
     bool strutSignalConnected;
+    bool stackingOrderDeltaConnected;
+    bool windowsChangedConnected;
     bool compositingEnabled;
     bool haveXfixes;
     KX11Extras::FilterInfo what;
     int xfixesEventBase;
     bool mapViewport();
+    // whether the window is in the client list, without starting the tracking
+    static bool isManagedWindow(WId window);
 
-    bool nativeEventFilter(const QByteArray &eventType, void *message, qintptr *) override;
+    bool xcbEventFilter(xcb_generic_event_t *event) override;
+
+    struct RootState {
+        int currentDesktop;
+        xcb_window_t activeWindow;
+        int numberOfDesktops;
+        bool showingDesktop;
+    };
+    RootState rootState();
+    void rootChanged(const RootState &old, NET::Properties properties, NET::Properties2 properties2);
+    void emitWindowChange(WId window, NET::Properties properties, NET::Properties2 properties2);
+
+    // With threaded window tracking the state is fetched by NETTrackingWorker on a connection
+    // of its own and applied here, nothing is read from the main connection
+    const bool threaded;
+    quint64 appliedSerial = 0;
+    void applyChangeSet(const NETChangeSet &changes);
+    void adoptState(const NETEventFilter &other);
+    // takes over the values of other, which may live on another connection, but keeps our own
+    void copyRootValues(const NETRootInfo &other);
+    static void applyTracked(const std::shared_ptr<const NETChangeSet> &changes);
 
     void updateStackingOrder();
     bool removeStrutWindow(WId);
 
+    void queueWindowChange(WId window, NET::Properties properties, NET::Properties2 properties2);
+    void flushWindowChanges();
+    // starts the timer so that windowsChanged() keeps the interval to its last emission
+    void scheduleWindowChanges();
+    QHash<WId, QPair<NET::Properties, NET::Properties2>> pendingWindowChanges;
+    QTimer windowsChangedTimer;
+    QElapsedTimer lastWindowsChanged;
+
+    // Immutable copy of the root state, republished after every processed root event.
+    // The members above are only touched by the main thread, other threads have to go
+    // through snapshot() which never blocks on the main thread.
+    struct Snapshot {
+        QList<WId> windows;
+        QList<WId> stackingOrder;
+        WId activeWindow = XCB_WINDOW_NONE;
+        int currentDesktop = 0;
+        int numberOfDesktops = 0;
+        bool showingDesktop = false;
+        bool compositingEnabled = false;
+    };
+    std::shared_ptr<const Snapshot> snapshot() const;
+    void publishSnapshot();
+
 protected:
     void addClient(xcb_window_t) override;
     void removeClient(xcb_window_t) override;
+    void virtual_hook(int id, void *data) override;
 
 private:
-    bool nativeEventFilter(xcb_generic_event_t *event);
+    void addClients(const QList<xcb_window_t> &clients);
     xcb_window_t winId;
     xcb_window_t m_appRootWindow;
+#ifdef __cpp_lib_atomic_shared_ptr
+    std::atomic<std::shared_ptr<const Snapshot>> m_snapshot;
+#else
+    std::shared_ptr<const Snapshot> m_snapshot;
+#endif
 };
 
-static Atom net_wm_cm;
+static xcb_atom_t net_wm_cm;
+static std::atomic<int> windowsChangedInterval = 0;
+static bool threadedWindowTracking = false;
+static void request_atoms();
 static void create_atoms();
+static void stackingOrderDelta(const QList<WId> &oldOrder, const QList<WId> &newOrder, QList<WId> &removed, QList<QPair<WId, int>> &placed);
+
+// Everything the worker learned from one batch of events, handed to the main thread as a whole.
+// An initial change set carries the complete state instead of the difference.
+struct NETChangeSet {
+    quint64 serial = 0;
+    bool initial = false;
+    // freshly fetched on the worker connection, only set if root properties changed
+    std::unique_ptr<NETRootInfo> rootInfo;
+    NET::Properties rootProperties;
+    NET::Properties2 rootProperties2;
+    QList<WId> added;
+    QList<WId> removed;
+    QList<std::tuple<WId, NET::Properties, NET::Properties2>> windowChanges;
+    // all known struts, only set if they changed
+    std::optional<QHash<WId, NETEventFilter::StrutData>> strutWindows;
+    bool strutChanged = false;
+    std::optional<bool> compositingEnabled;
+};
 
-static inline const QRect &displayGeometry()
+// Tracks the root window and the managed clients on an xcb connection of its own in a worker
+// thread, so that a busy window manager never stalls the main thread on a round-trip.
+class NETTrackingWorker : public QObject
 {
-    static QRect displayGeometry;
+public:
+    // nullptr if the worker connection can't be established
+    static NETTrackingWorker *instance();
+
+    // Starts or widens the tracking without waiting for it, the complete state is posted
+    // as an initial change set once it is fetched
+    void track(KX11Extras::FilterInfo what);
+
+private:
+    class RootInfo : public NETRootInfo
+    {
+    public:
+        RootInfo(NETTrackingWorker *worker, NET::Properties properties, NET::Properties2 properties2);
+
+        // the values fetched so far, without a round-trip and without sharing our private data
+        std::unique_ptr<NETRootInfo> copy();
+
+    protected:
+        void addClient(xcb_window_t window) override;
+        void removeClient(xcb_window_t window) override;
+
+    private:
+        NETTrackingWorker *const m_worker;
+    };
+
+    explicit NETTrackingWorker(xcb_connection_t *connection);
+    ~NETTrackingWorker() override;
+    static void shutdown();
+
+    std::shared_ptr<NETChangeSet> setWhat(KX11Extras::FilterInfo what);
+    void start();
+    void readEvents();
+    void processEvent(xcb_generic_event_t *event, NETChangeSet &changes);
+    void finish(NETChangeSet &changes);
+    void fetchStruts(const QList<WId> &windows, NETChangeSet &changes);
+    void post(std::shared_ptr<NETChangeSet> changes);
+
+    xcb_connection_t *const m_connection;
+    const xcb_window_t m_rootWindow;
+    const int m_screen;
+    KX11Extras::FilterInfo m_what = KX11Extras::INFO_BASIC;
+    std::unique_ptr<RootInfo> m_root;
+    QSocketNotifier *m_notifier = nullptr;
+    bool m_haveXfixes = false;
+    uint8_t m_xfixesEventBase = 0;
+    xcb_atom_t m_cmAtom = XCB_ATOM_NONE;
+    quint64 m_serial = 0;
+    QSet<WId> m_windows;
+    QHash<WId, NETEventFilter::StrutData> m_struts;
+    bool m_strutsChanged = false;
+    // windows whose struts have to be fetched before the change set is posted
+    QList<WId> m_strutDirty;
+    // filled by RootInfo while the client list is updated
+    QList<WId> m_added;
+    QList<WId> m_removed;
+
+    static QThread *s_thread;
+    static NETTrackingWorker *s_worker;
+};
+
+// Screens in device pixels. generation changes whenever the layout is rebuilt,
+// so results derived from it can be cached.
+struct DisplayLayout {
+    QList<QRect> screens;
+    QRect geometry;
+    int generation = 0;
+};
+
+static inline const DisplayLayout &displayLayout()
+{
+    static DisplayLayout layout;
     static bool isDirty = true;
 
     if (isDirty) {
@@ -119,18 +299,26 @@ static inline const QRect &displayGeometry()
         QObject::connect(qApp, &QGuiApplication::screenRemoved, dirtify);
         const QList<QScreen *> screenList = QGuiApplication::screens();
         QRegion region;
+        layout.screens.clear();
         for (int i = 0; i < screenList.count(); ++i) {
             const QScreen *screen = screenList.at(i);
             connections << QObject::connect(screen, &QScreen::geometryChanged, dirtify);
             const QRect geometry = screen->geometry();
             const qreal dpr = screen->devicePixelRatio();
-            region += QRect(geometry.topLeft(), geometry.size() * dpr);
+            layout.screens.append(QRect(geometry.topLeft(), geometry.size() * dpr));
+            region += layout.screens.last();
         }
-        displayGeometry = region.boundingRect();
+        layout.geometry = region.boundingRect();
+        ++layout.generation;
         isDirty = false;
     }
 
-    return displayGeometry;
+    return layout;
+}
+
+static inline const QRect &displayGeometry()
+{
+    return displayLayout().geometry;
 }
 
 static inline int displayWidth()
@@ -177,6 +365,16 @@ MainThreadInstantiator::MainThreadInstantiator(KX11Extras::FilterInfo _what)
 
 NETEventFilter *MainThreadInstantiator::createNETEventFilter()
 {
+    // the changes still waiting for the interval would be lost with the previous filter
+    if (NETEventFilter *const previous = KX11Extras::self()->s_d_func()) {
+        previous->flushWindowChanges();
+    }
+
+    // Sent ahead of the NET atoms NETRootInfo interns when it is first used on the connection,
+    // so both are answered in the same round-trip
+    if (!threadedWindowTracking) {
+        request_atoms();
+    }
     return new NETEventFilter(m_what);
 }
 
@@ -186,22 +384,73 @@ NETEventFilter::NETEventFilter(KX11Extras::FilterInfo _what)
                   _what >= KX11Extras::INFO_WINDOWS ? windowsProperties2 : desktopProperties2,
                   QX11Info::appScreen(),
                   false)
-    , QAbstractNativeEventFilter()
+    , KXcbEventFilter()
     , strutSignalConnected(false)
+    , stackingOrderDeltaConnected(false)
+    , windowsChangedConnected(false)
     , compositingEnabled(false)
     , haveXfixes(false)
     , what(_what)
+    , threaded(threadedWindowTracking && NETTrackingWorker::instance())
     , winId(XCB_WINDOW_NONE)
     , m_appRootWindow(QX11Info::appRootWindow())
 {
-    QCoreApplication::instance()->installNativeEventFilter(this);
+    windowsChangedTimer.setSingleShot(true);
+    windowsChangedTimer.callOnTimeout([this]() {
+        flushWindowChanges();
+    });
+
+    if (threaded) {
+        // only the XFixes check of activate() still uses the main connection
+        xcb_prefetch_extension_data(QX11Info::connection(), &xcb_xfixes_id);
+        return;
+    }
+
+    // Client messages are interpreted relative to the root window whatever window they are sent to,
+    // property and configure notifies only matter for the root and the managed clients
+    KXcbEventDispatcher *dispatcher = KXcbEventDispatcher::self();
+    dispatcher->subscribe(this, XCB_CLIENT_MESSAGE);
+    dispatcher->subscribe(this, XCB_PROPERTY_NOTIFY, m_appRootWindow);
+    dispatcher->subscribe(this, XCB_CONFIGURE_NOTIFY, m_appRootWindow);
+
+    // Only issue the requests here, their replies are collected in activate() so that
+    // they arrive together with the root window properties
+    xcb_prefetch_extension_data(QX11Info::connection(), &xcb_xfixes_id);
+    request_atoms();
+}
+
+NETEventFilter::~NETEventFilter()
+{
+    if (QX11Info::connection() && winId != XCB_WINDOW_NONE) {
+        xcb_destroy_window(QX11Info::connection(), winId);
+        winId = XCB_WINDOW_NONE;
+    }
+}
+
+// not virtual, but it's called directly only from init()
+void NETEventFilter::activate()
+{
+    xcb_connection_t *c = QX11Info::connection();
+
+    if (threaded) {
+        // Qt has queried XFixes itself, so this normally doesn't wait. The worker fetches the
+        // state on its own connection, all later changes are posted by it
+        const xcb_query_extension_reply_t *xfixes = xcb_get_extension_data(c, &xcb_xfixes_id);
+        haveXfixes = xfixes && xfixes->present;
+        NETTrackingWorker::instance()->track(what);
+        return;
+    }
 
-    int errorBase;
-    if ((haveXfixes = XFixesQueryExtension(QX11Info::display(), &xfixesEventBase, &errorBase))) {
+    // Qt has already negotiated the XFixes version on its connection
+    xcb_get_selection_owner_cookie_t ownerCookie = {};
+    const xcb_query_extension_reply_t *xfixes = xcb_get_extension_data(c, &xcb_xfixes_id);
+    if ((haveXfixes = xfixes && xfixes->present)) {
+        xfixesEventBase = xfixes->first_event;
+        KXcbEventDispatcher::self()->subscribe(this, xfixesEventBase + XCB_XFIXES_SELECTION_NOTIFY);
         create_atoms();
-        winId = xcb_generate_id(QX11Info::connection());
+        winId = xcb_generate_id(c);
         uint32_t values[] = {true, XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY};
-        xcb_create_window(QX11Info::connection(),
+        xcb_create_window(c,
                           XCB_COPY_FROM_PARENT,
                           winId,
                           m_appRootWindow,
@@ -214,49 +463,97 @@ NETEventFilter::NETEventFilter(KX11Extras::FilterInfo _what)
                           XCB_COPY_FROM_PARENT,
                           XCB_CW_OVERRIDE_REDIRECT | XCB_CW_EVENT_MASK,
                           values);
-        XFixesSelectSelectionInput(QX11Info::display(),
-                                   winId,
-                                   net_wm_cm,
-                                   XFixesSetSelectionOwnerNotifyMask | XFixesSelectionWindowDestroyNotifyMask | XFixesSelectionClientCloseNotifyMask);
-        compositingEnabled = XGetSelectionOwner(QX11Info::display(), net_wm_cm) != None;
+        xcb_xfixes_select_selection_input(c,
+                                          winId,
+                                          net_wm_cm,
+                                          XCB_XFIXES_SELECTION_EVENT_MASK_SET_SELECTION_OWNER | XCB_XFIXES_SELECTION_EVENT_MASK_SELECTION_WINDOW_DESTROY
+                                              | XCB_XFIXES_SELECTION_EVENT_MASK_SELECTION_CLIENT_CLOSE);
+        ownerCookie = xcb_get_selection_owner_unchecked(c, net_wm_cm);
     }
+
+    // the selection owner is answered while waiting for the root window properties
+    NETRootInfo::activate();
+
+    if (haveXfixes) {
+        UniqueCPointer<xcb_get_selection_owner_reply_t> owner(KXcbInstrumentation::reply(xcb_get_selection_owner_reply, c, ownerCookie, nullptr));
+        compositingEnabled = owner && owner->owner != XCB_WINDOW_NONE;
+    }
+    updateStackingOrder();
+    publishSnapshot();
 }
 
-NETEventFilter::~NETEventFilter()
+std::shared_ptr<const NETEventFilter::Snapshot> NETEventFilter::snapshot() const
 {
-    if (QX11Info::connection() && winId != XCB_WINDOW_NONE) {
-        xcb_destroy_window(QX11Info::connection(), winId);
-        winId = XCB_WINDOW_NONE;
-    }
+#ifdef __cpp_lib_atomic_shared_ptr
+    return m_snapshot.load(std::memory_order_acquire);
+#else
+    return std::atomic_load_explicit(&m_snapshot, std::memory_order_acquire);
+#endif
 }
 
-// not virtual, but it's called directly only from init()
-void NETEventFilter::activate()
+void NETEventFilter::publishSnapshot()
 {
-    NETRootInfo::activate();
-    updateStackingOrder();
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->windows = windows;
+    snapshot->stackingOrder = stackingOrder;
+    snapshot->activeWindow = activeWindow();
+    snapshot->currentDesktop = currentDesktop(true);
+    snapshot->numberOfDesktops = numberOfDesktops(true);
+    snapshot->showingDesktop = showingDesktop();
+    snapshot->compositingEnabled = compositingEnabled;
+#ifdef __cpp_lib_atomic_shared_ptr
+    m_snapshot.store(std::move(snapshot), std::memory_order_release);
+#else
+    std::atomic_store_explicit(&m_snapshot, std::shared_ptr<const Snapshot>(std::move(snapshot)), std::memory_order_release);
+#endif
 }
 
-bool NETEventFilter::nativeEventFilter(const QByteArray &eventType, void *message, qintptr *)
+// Reads which properties an event changed on a managed client, including those only the
+// ICCCM properties report, and returns whether the struts of the window have to be fetched
+// again. Shared by the event filter and the tracking worker.
+static bool clientChanges(xcb_connection_t *c,
+                          xcb_window_t rootWindow,
+                          xcb_window_t window,
+                          xcb_generic_event_t *event,
+                          bool mapViewport,
+                          bool isStrutWindow,
+                          NET::Properties &dirtyProperties,
+                          NET::Properties2 &dirtyProperties2)
 {
-    if (eventType != "xcb_generic_event_t") {
-        // only interested in XCB events of course
-        return false;
+    NETWinInfo ni(c, window, rootWindow, NET::Properties(), NET::Properties2());
+    ni.event(event, &dirtyProperties, &dirtyProperties2);
+    if ((event->response_type & ~0x80) == XCB_PROPERTY_NOTIFY) {
+        const xcb_atom_t atom = reinterpret_cast<xcb_property_notify_event_t *>(event)->atom;
+        if (atom == XCB_ATOM_WM_HINTS) {
+            dirtyProperties |= NET::WMIcon; // support for old icons
+        } else if (atom == XCB_ATOM_WM_NAME) {
+            dirtyProperties |= NET::WMName; // support for old name
+        } else if (atom == XCB_ATOM_WM_ICON_NAME) {
+            dirtyProperties |= NET::WMIconName; // support for old iconic name
+        }
     }
-    return nativeEventFilter(reinterpret_cast<xcb_generic_event_t *>(message));
+    if (mapViewport && (dirtyProperties & (NET::WMState | NET::WMGeometry))) {
+        /* geometry change -> possible viewport change
+         * state change -> possible NET::Sticky change
+         */
+        dirtyProperties |= NET::WMDesktop;
+    }
+    const bool strutDirty = (dirtyProperties & NET::WMStrut) || (dirtyProperties2 & NET::WM2ExtendedStrut);
+    // the desktop of a strut window decides which work areas it affects
+    return strutDirty || ((dirtyProperties & NET::WMDesktop) && isStrutWindow);
 }
 
-bool NETEventFilter::nativeEventFilter(xcb_generic_event_t *ev)
+bool NETEventFilter::xcbEventFilter(xcb_generic_event_t *ev)
 {
-    KWindowSystem *s_q = KWindowSystem::self();
     const uint8_t eventType = ev->response_type & ~0x80;
 
-    if (eventType == xfixesEventBase + XCB_XFIXES_SELECTION_NOTIFY) {
+    if (haveXfixes && eventType == xfixesEventBase + XCB_XFIXES_SELECTION_NOTIFY) {
         xcb_xfixes_selection_notify_event_t *event = reinterpret_cast<xcb_xfixes_selection_notify_event_t *>(ev);
         if (event->window == winId) {
             bool haveOwner = event->owner != XCB_WINDOW_NONE;
             if (compositingEnabled != haveOwner) {
                 compositingEnabled = haveOwner;
+                publishSnapshot();
                 Q_EMIT KX11Extras::self()->compositingChanged(compositingEnabled);
             }
             return true;
@@ -269,6 +566,7 @@ bool NETEventFilter::nativeEventFilter(xcb_generic_event_t *ev)
                 bool haveOwner = event->owner != XCB_WINDOW_NONE;
                 if (compositingEnabled != haveOwner) {
                     compositingEnabled = haveOwner;
+                    publishSnapshot();
                     Q_EMIT KX11Extras::self()->compositingChanged(compositingEnabled);
                 }
                 // NOTICE this is not our event, we just randomly captured it from Qt -> pass on
@@ -292,128 +590,430 @@ bool NETEventFilter::nativeEventFilter(xcb_generic_event_t *ev)
     }
 
     if (eventWindow == m_appRootWindow) {
-        int old_current_desktop = currentDesktop();
-        xcb_window_t old_active_window = activeWindow();
-        int old_number_of_desktops = numberOfDesktops();
-        bool old_showing_desktop = showingDesktop();
+        const RootState old = rootState();
         NET::Properties props;
         NET::Properties2 props2;
         NETRootInfo::event(ev, &props, &props2);
+        rootChanged(old, props, props2);
+    } else if (windows.contains(eventWindow)) {
+        NET::Properties dirtyProperties;
+        NET::Properties2 dirtyProperties2;
+        if (clientChanges(QX11Info::connection(),
+                          m_appRootWindow,
+                          eventWindow,
+                          ev,
+                          mapViewport(),
+                          strutWindows.contains(eventWindow),
+                          dirtyProperties,
+                          dirtyProperties2)) {
+            removeStrutWindow(eventWindow);
+            if (!possibleStrutWindows.contains(eventWindow)) {
+                possibleStrutWindows.append(eventWindow);
+            }
+            workAreaCache.clear();
+        }
+        emitWindowChange(eventWindow, dirtyProperties, dirtyProperties2);
+    }
+
+    return false;
+}
+
+NETEventFilter::RootState NETEventFilter::rootState()
+{
+    return RootState{currentDesktop(), activeWindow(), numberOfDesktops(), showingDesktop()};
+}
 
-        if ((props & CurrentDesktop) && currentDesktop() != old_current_desktop) {
-            Q_EMIT KX11Extras::self()->currentDesktopChanged(currentDesktop());
+void NETEventFilter::rootChanged(const RootState &old, NET::Properties props, NET::Properties2 props2)
+{
+    KWindowSystem *s_q = KWindowSystem::self();
+
+    QList<WId> oldStackingOrder;
+    if (props & ClientListStacking) {
+        oldStackingOrder = stackingOrder;
+        updateStackingOrder();
+    }
+    if (props || props2) {
+        publishSnapshot();
+    }
+
+    if ((props & CurrentDesktop) && currentDesktop() != old.currentDesktop) {
+        Q_EMIT KX11Extras::self()->currentDesktopChanged(currentDesktop());
+    }
+    if ((props & DesktopViewport) && mapViewport() && currentDesktop() != old.currentDesktop) {
+        Q_EMIT KX11Extras::self()->currentDesktopChanged(currentDesktop());
+    }
+    if ((props & ActiveWindow) && activeWindow() != old.activeWindow) {
+        Q_EMIT KX11Extras::self()->activeWindowChanged(activeWindow());
+    }
+    if (props & DesktopNames) {
+        Q_EMIT KX11Extras::self()->desktopNamesChanged();
+    }
+    if ((props & NumberOfDesktops) && numberOfDesktops() != old.numberOfDesktops) {
+        workAreaCache.clear();
+        Q_EMIT KX11Extras::self()->numberOfDesktopsChanged(numberOfDesktops());
+    }
+    if ((props & DesktopGeometry) && mapViewport() && numberOfDesktops() != old.numberOfDesktops) {
+        Q_EMIT KX11Extras::self()->numberOfDesktopsChanged(numberOfDesktops());
+    }
+    if (props & WorkArea) {
+        Q_EMIT KX11Extras::self()->workAreaChanged();
+    }
+    if (props & ClientListStacking) {
+        Q_EMIT KX11Extras::self()->stackingOrderChanged();
+        if (stackingOrderDeltaConnected) {
+            QList<WId> removed;
+            QList<QPair<WId, int>> placed;
+            stackingOrderDelta(oldStackingOrder, stackingOrder, removed, placed);
+            if (!removed.isEmpty() || !placed.isEmpty()) {
+                Q_EMIT KX11Extras::self()->stackingOrderUpdated(removed, placed);
+            }
         }
-        if ((props & DesktopViewport) && mapViewport() && currentDesktop() != old_current_desktop) {
-            Q_EMIT KX11Extras::self()->currentDesktopChanged(currentDesktop());
+    }
+    if ((props2 & WM2ShowingDesktop) && showingDesktop() != old.showingDesktop) {
+        Q_EMIT s_q->showingDesktopChanged(showingDesktop());
+    }
+}
+
+void NETEventFilter::emitWindowChange(WId window, NET::Properties properties, NET::Properties2 properties2)
+{
+    if (!properties && !properties2) {
+        return;
+    }
+
+    Q_EMIT KX11Extras::self()->windowChanged(window, properties, properties2);
+    if (windowsChangedConnected) {
+        queueWindowChange(window, properties, properties2);
+    }
+
+    if ((properties & NET::WMStrut) || (properties2 & NET::WM2ExtendedStrut)) {
+        Q_EMIT KX11Extras::self()->strutChanged();
+    }
+}
+
+void NETEventFilter::applyChangeSet(const NETChangeSet &changes)
+{
+    // change sets still queued when the tracking was widened predate the initial one
+    if (changes.serial <= appliedSerial) {
+        return;
+    }
+    appliedSerial = changes.serial;
+
+    // the snapshot has to list the windows before they are announced
+    QList<WId> added;
+    QList<WId> removed;
+    if (changes.initial) {
+        // like activate() only the windows are announced, not the root properties
+        copyRootValues(*changes.rootInfo);
+        for (auto it = windows.begin(); it != windows.end();) {
+            if (changes.added.contains(*it)) {
+                ++it;
+                continue;
+            }
+            const WId w = *it;
+            it = windows.erase(it);
+            pendingWindowChanges.remove(w);
+            removed.append(w);
         }
-        if ((props & ActiveWindow) && activeWindow() != old_active_window) {
-            Q_EMIT KX11Extras::self()->activeWindowChanged(activeWindow());
+        for (WId w : changes.added) {
+            if (!windows.contains(w)) {
+                windows.append(w);
+                added.append(w);
+            }
         }
-        if (props & DesktopNames) {
-            Q_EMIT KX11Extras::self()->desktopNamesChanged();
+        if (changes.strutWindows) {
+            strutWindows = *changes.strutWindows;
         }
-        if ((props & NumberOfDesktops) && numberOfDesktops() != old_number_of_desktops) {
-            Q_EMIT KX11Extras::self()->numberOfDesktopsChanged(numberOfDesktops());
+        workAreaCache.clear();
+        const bool wasCompositing = std::exchange(compositingEnabled, changes.compositingEnabled.value_or(false));
+        updateStackingOrder();
+        publishSnapshot();
+        for (WId w : std::as_const(removed)) {
+            Q_EMIT KX11Extras::self()->windowRemoved(w);
         }
-        if ((props & DesktopGeometry) && mapViewport() && numberOfDesktops() != old_number_of_desktops) {
-            Q_EMIT KX11Extras::self()->numberOfDesktopsChanged(numberOfDesktops());
+        for (WId w : std::as_const(added)) {
+            Q_EMIT KX11Extras::self()->windowAdded(w);
         }
-        if (props & WorkArea) {
-            Q_EMIT KX11Extras::self()->workAreaChanged();
+        if (wasCompositing != compositingEnabled) {
+            Q_EMIT KX11Extras::self()->compositingChanged(compositingEnabled);
         }
-        if (props & ClientListStacking) {
-            updateStackingOrder();
-            Q_EMIT KX11Extras::self()->stackingOrderChanged();
+        return;
+    }
+
+    const RootState old = rootState();
+    if (changes.rootInfo) {
+        copyRootValues(*changes.rootInfo);
+    }
+    for (WId w : changes.added) {
+        if (!windows.contains(w)) {
+            windows.append(w);
+            added.append(w);
         }
-        if ((props2 & WM2ShowingDesktop) && showingDesktop() != old_showing_desktop) {
-            Q_EMIT s_q->showingDesktopChanged(showingDesktop());
+    }
+    for (WId w : changes.removed) {
+        if (windows.removeAll(w)) {
+            pendingWindowChanges.remove(w);
+            removed.append(w);
         }
-    } else if (windows.contains(eventWindow)) {
-        NETWinInfo ni(QX11Info::connection(), eventWindow, m_appRootWindow, NET::Properties(), NET::Properties2());
-        NET::Properties dirtyProperties;
-        NET::Properties2 dirtyProperties2;
-        ni.event(ev, &dirtyProperties, &dirtyProperties2);
-        if (eventType == XCB_PROPERTY_NOTIFY) {
-            xcb_property_notify_event_t *event = reinterpret_cast<xcb_property_notify_event_t *>(ev);
-            if (event->atom == XCB_ATOM_WM_HINTS) {
-                dirtyProperties |= NET::WMIcon; // support for old icons
-            } else if (event->atom == XCB_ATOM_WM_NAME) {
-                dirtyProperties |= NET::WMName; // support for old name
-            } else if (event->atom == XCB_ATOM_WM_ICON_NAME) {
-                dirtyProperties |= NET::WMIconName; // support for old iconic name
-            }
+    }
+    if (!added.isEmpty() || !removed.isEmpty()) {
+        publishSnapshot();
+    }
+    for (WId w : std::as_const(added)) {
+        Q_EMIT KX11Extras::self()->windowAdded(w);
+    }
+    for (WId w : std::as_const(removed)) {
+        Q_EMIT KX11Extras::self()->windowRemoved(w);
+    }
+    if (changes.strutWindows) {
+        strutWindows = *changes.strutWindows;
+        workAreaCache.clear();
+    }
+    rootChanged(old, changes.rootProperties, changes.rootProperties2);
+
+    for (const auto &[w, properties, properties2] : changes.windowChanges) {
+        if (!windows.contains(w)) {
+            continue;
         }
+        NET::Properties dirtyProperties = properties;
         if (mapViewport() && (dirtyProperties & (NET::WMState | NET::WMGeometry))) {
-            /* geometry change -> possible viewport change
-             * state change -> possible NET::Sticky change
-             */
             dirtyProperties |= NET::WMDesktop;
         }
-        if ((dirtyProperties & NET::WMStrut) != 0) {
-            removeStrutWindow(eventWindow);
-            if (!possibleStrutWindows.contains(eventWindow)) {
-                possibleStrutWindows.append(eventWindow);
-            }
-        }
-        if (dirtyProperties || dirtyProperties2) {
-            Q_EMIT KX11Extras::self()->windowChanged(eventWindow, dirtyProperties, dirtyProperties2);
+        emitWindowChange(w, dirtyProperties, properties2);
+    }
+    if (changes.strutChanged) {
+        Q_EMIT KX11Extras::self()->strutChanged();
+    }
 
-            if ((dirtyProperties & NET::WMStrut) != 0) {
-                Q_EMIT KX11Extras::self()->strutChanged();
-            }
-        }
+    if (changes.compositingEnabled && *changes.compositingEnabled != compositingEnabled) {
+        compositingEnabled = *changes.compositingEnabled;
+        publishSnapshot();
+        Q_EMIT KX11Extras::self()->compositingChanged(compositingEnabled);
+    } else {
+        publishSnapshot();
     }
+}
 
-    return false;
+void NETEventFilter::adoptState(const NETEventFilter &other)
+{
+    copyRootValues(other);
+    windows = other.windows;
+    stackingOrder = other.stackingOrder;
+    strutWindows = other.strutWindows;
+    compositingEnabled = other.compositingEnabled;
+    appliedSerial = other.appliedSerial;
+}
+
+void NETEventFilter::copyRootValues(const NETRootInfo &other)
+{
+    // sharing the private data would also share the connection and its unsynchronized
+    // reference count with the worker thread, the hook only reads other
+    virtual_hook(NETRootInfoCopyValuesHook, const_cast<NETRootInfo *>(&other));
+}
+
+void NETEventFilter::applyTracked(const std::shared_ptr<const NETChangeSet> &changes)
+{
+    if (NETEventFilter *const s_d = KX11Extras::self()->s_d_func(); s_d && s_d->threaded) {
+        s_d->applyChangeSet(*changes);
+    }
 }
 
 bool NETEventFilter::removeStrutWindow(WId w)
 {
-    for (QList<StrutData>::Iterator it = strutWindows.begin(); it != strutWindows.end(); ++it) {
-        if ((*it).window == w) {
-            strutWindows.erase(it);
-            return true;
-        }
+    return strutWindows.remove(w);
+}
+
+void NETEventFilter::queueWindowChange(WId window, NET::Properties properties, NET::Properties2 properties2)
+{
+    auto &pending = pendingWindowChanges[window];
+    pending.first |= properties;
+    pending.second |= properties2;
+    if (!windowsChangedTimer.isActive()) {
+        scheduleWindowChanges();
     }
-    return false;
+}
+
+void NETEventFilter::scheduleWindowChanges()
+{
+    // even without an interval the changes of one event loop iteration go out together
+    qint64 delay = 0;
+    if (lastWindowsChanged.isValid()) {
+        delay = std::max<qint64>(0, windowsChangedInterval - lastWindowsChanged.elapsed());
+    }
+    windowsChangedTimer.start(int(delay));
+}
+
+void NETEventFilter::flushWindowChanges()
+{
+    windowsChangedTimer.stop();
+    if (pendingWindowChanges.isEmpty()) {
+        return;
+    }
+    const auto changes = std::exchange(pendingWindowChanges, {});
+    lastWindowsChanged.start();
+    Q_EMIT KX11Extras::self()->windowsChanged(changes);
 }
 
 void NETEventFilter::updateStackingOrder()
 {
-    stackingOrder.clear();
-    for (int i = 0; i < clientListStackingCount(); i++) {
-        stackingOrder.append(clientListStacking()[i]);
+    const xcb_window_t *list = clientListStacking();
+    stackingOrder = QList<WId>(list, list + clientListStackingCount());
+}
+
+// Computes the windows that have to be removed and (re)placed to turn oldOrder into newOrder.
+// The surviving windows on the longest increasing run of new positions keep their place,
+// everything else is reported in placed, so raising a single window yields a single entry.
+static void stackingOrderDelta(const QList<WId> &oldOrder, const QList<WId> &newOrder, QList<WId> &removed, QList<QPair<WId, int>> &placed)
+{
+    QHash<WId, int> newIndex;
+    newIndex.reserve(newOrder.size());
+    for (int i = 0; i < newOrder.size(); ++i) {
+        newIndex.insert(newOrder.at(i), i);
+    }
+
+    // new positions of the surviving windows, in their old order
+    QList<int> positions;
+    positions.reserve(oldOrder.size());
+    for (WId window : oldOrder) {
+        const auto it = newIndex.constFind(window);
+        if (it == newIndex.constEnd()) {
+            removed.append(window);
+        } else {
+            positions.append(*it);
+        }
+    }
+
+    // patience sorting, tails[k] indexes the smallest tail of an increasing run of length k + 1
+    QList<int> tails;
+    QList<int> predecessors(positions.size(), -1);
+    for (int i = 0; i < positions.size(); ++i) {
+        const auto it = std::lower_bound(tails.begin(), tails.end(), positions.at(i), [&positions](int index, int position) {
+            return positions.at(index) < position;
+        });
+        if (it != tails.begin()) {
+            predecessors[i] = *(it - 1);
+        }
+        if (it == tails.end()) {
+            tails.append(i);
+        } else {
+            *it = i;
+        }
+    }
+
+    QList<bool> stable(newOrder.size(), false);
+    for (int i = tails.isEmpty() ? -1 : tails.last(); i != -1; i = predecessors.at(i)) {
+        stable[positions.at(i)] = true;
+    }
+    for (int i = 0; i < newOrder.size(); ++i) {
+        if (!stable.at(i)) {
+            placed.append(qMakePair(newOrder.at(i), i));
+        }
     }
 }
 
 void NETEventFilter::addClient(xcb_window_t w)
 {
-    if ((what >= KX11Extras::INFO_WINDOWS)) {
-        xcb_connection_t *c = QX11Info::connection();
-        UniqueCPointer<xcb_get_window_attributes_reply_t> attr(xcb_get_window_attributes_reply(c, xcb_get_window_attributes_unchecked(c, w), nullptr));
+    addClients({w});
+}
+
+void NETEventFilter::virtual_hook(int id, void *data)
+{
+    if (id == NETRootInfoAddClientsHook) {
+        auto addClientsData = static_cast<NETRootInfoAddClientsData *>(data);
+        addClients(*addClientsData->clients);
+        addClientsData->handled = true;
+        return;
+    }
+    NETRootInfo::virtual_hook(id, data);
+}
+
+/*
+ * The strut and desktop of a window, fetched like NETWinInfo does but split so that the
+ * requests for several windows can be sent before strutFromFetch() waits for the first reply.
+ */
+struct StrutFetch {
+    std::unique_ptr<NETWinInfoFetcher> info;
+    NETWinInfoFetchData data;
+};
 
-        uint32_t events = XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY;
-        if (attr) {
-            events = events | attr->your_event_mask;
+static StrutFetch requestStrut(xcb_connection_t *c, xcb_window_t root, xcb_window_t window)
+{
+    StrutFetch fetch;
+    fetch.info = std::make_unique<NETWinInfoFetcher>(c, window, root, NET::Properties(), NET::Properties2());
+    fetch.data.properties = NET::WMStrut | NET::WMDesktop;
+    fetch.data.properties2 = NET::WM2ExtendedStrut;
+    fetch.info->fetch(NETWinInfoRequestHook, &fetch.data);
+    return fetch;
+}
+
+static NETEventFilter::StrutData strutFromFetch(StrutFetch &fetch)
+{
+    fetch.info->fetch(NETWinInfoParseHook, &fetch.data);
+    // the struts are kept per desktop, not per viewport
+    return NETEventFilter::StrutData(fetch.info->strut(), fetch.info->extendedStrut(), fetch.info->desktop(true));
+}
+
+void NETEventFilter::addClients(const QList<xcb_window_t> &clients)
+{
+    xcb_connection_t *c = QX11Info::connection();
+
+    // issue the requests for all clients before waiting for the first reply,
+    // so registering hundreds of windows costs about one round-trip
+    QList<xcb_get_window_attributes_cookie_t> attributeCookies;
+    if (what >= KX11Extras::INFO_WINDOWS) {
+        attributeCookies.reserve(clients.size());
+        for (xcb_window_t w : clients) {
+            attributeCookies.append(xcb_get_window_attributes_unchecked(c, w));
+        }
+    }
+
+    std::vector<StrutFetch> strutFetches;
+    if (strutSignalConnected) {
+        strutFetches.reserve(clients.size());
+        for (xcb_window_t w : clients) {
+            strutFetches.push_back(requestStrut(c, QX11Info::appRootWindow(), w));
         }
-        xcb_change_window_attributes(c, w, XCB_CW_EVENT_MASK, &events);
     }
 
     bool emit_strutChanged = false;
+    KXcbEventDispatcher *dispatcher = KXcbEventDispatcher::self();
 
-    if (strutSignalConnected) {
-        NETWinInfo info(QX11Info::connection(), w, QX11Info::appRootWindow(), NET::WMStrut | NET::WMDesktop, NET::Properties2());
-        NETStrut strut = info.strut();
-        if (strut.left || strut.top || strut.right || strut.bottom) {
-            strutWindows.append(StrutData(w, strut, info.desktop()));
-            emit_strutChanged = true;
+    for (int i = 0; i < clients.size(); ++i) {
+        const xcb_window_t w = clients.at(i);
+        dispatcher->subscribe(this, XCB_PROPERTY_NOTIFY, w);
+        dispatcher->subscribe(this, XCB_CONFIGURE_NOTIFY, w);
+
+        if (!attributeCookies.isEmpty()) {
+            UniqueCPointer<xcb_get_window_attributes_reply_t> attr(
+                KXcbInstrumentation::reply(xcb_get_window_attributes_reply, c, attributeCookies.at(i), nullptr));
+
+            uint32_t events = XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+            if (attr) {
+                events = events | attr->your_event_mask;
+            }
+            xcb_change_window_attributes(c, w, XCB_CW_EVENT_MASK, &events);
         }
-    } else {
-        possibleStrutWindows.append(w);
+
+        if (!strutFetches.empty()) {
+            const StrutData data = strutFromFetch(strutFetches[i]);
+            if (!data.isEmpty()) {
+                strutWindows.insert(w, data);
+                emit_strutChanged = true;
+            }
+        } else {
+            possibleStrutWindows.append(w);
+        }
+
+        windows.append(w);
+    }
+    // the snapshot has to list the windows before they are announced
+    publishSnapshot();
+    for (xcb_window_t w : clients) {
+        Q_EMIT KX11Extras::self()->windowAdded(w);
     }
 
-    windows.append(w);
-    Q_EMIT KX11Extras::self()->windowAdded(w);
+    if (emit_strutChanged || strutFetches.empty()) {
+        workAreaCache.clear();
+    }
     if (emit_strutChanged) {
         Q_EMIT KX11Extras::self()->strutChanged();
     }
@@ -423,21 +1023,461 @@ void NETEventFilter::removeClient(xcb_window_t w)
 {
     bool emit_strutChanged = removeStrutWindow(w);
     if (strutSignalConnected && possibleStrutWindows.contains(w)) {
-        NETWinInfo info(QX11Info::connection(), w, QX11Info::appRootWindow(), NET::WMStrut, NET::Properties2());
-        NETStrut strut = info.strut();
-        if (strut.left || strut.top || strut.right || strut.bottom) {
+        NETWinInfo info(QX11Info::connection(), w, QX11Info::appRootWindow(), NET::WMStrut, NET::WM2ExtendedStrut);
+        const StrutData data(info.strut(), info.extendedStrut(), 0);
+        if (!data.isEmpty()) {
             emit_strutChanged = true;
         }
     }
 
-    possibleStrutWindows.removeAll(w);
+    if (possibleStrutWindows.removeAll(w) || emit_strutChanged) {
+        workAreaCache.clear();
+    }
+    pendingWindowChanges.remove(w);
     windows.removeAll(w);
+    publishSnapshot();
+    KXcbEventDispatcher::self()->unsubscribe(this, XCB_PROPERTY_NOTIFY, w);
+    KXcbEventDispatcher::self()->unsubscribe(this, XCB_CONFIGURE_NOTIFY, w);
     Q_EMIT KX11Extras::self()->windowRemoved(w);
     if (emit_strutChanged) {
         Q_EMIT KX11Extras::self()->strutChanged();
     }
 }
 
+void NETEventFilter::resolvePossibleStrutWindows()
+{
+    if (possibleStrutWindows.isEmpty()) {
+        return;
+    }
+
+    const QList<WId> candidates = std::exchange(possibleStrutWindows, {});
+    std::vector<StrutFetch> fetches;
+    fetches.reserve(candidates.size());
+    for (WId w : candidates) {
+        fetches.push_back(requestStrut(QX11Info::connection(), QX11Info::appRootWindow(), w));
+    }
+
+    for (int i = 0; i < candidates.size(); ++i) {
+        const StrutData data = strutFromFetch(fetches[i]);
+        // windows without a strut drop out until their strut changes
+        if (!data.isEmpty()) {
+            strutWindows.insert(candidates.at(i), data);
+        }
+    }
+}
+
+QThread *NETTrackingWorker::s_thread = nullptr;
+NETTrackingWorker *NETTrackingWorker::s_worker = nullptr;
+
+NETTrackingWorker *NETTrackingWorker::instance()
+{
+    static const bool started = [] {
+        Display *display = QX11Info::display();
+        xcb_connection_t *c = xcb_connect(display ? XDisplayString(display) : nullptr, nullptr);
+        if (xcb_connection_has_error(c)) {
+            qCWarning(LOG_KWINDOWSYSTEM) << "Could not open a second X connection, tracking windows on the main thread";
+            xcb_disconnect(c);
+            return false;
+        }
+        s_worker = new NETTrackingWorker(c);
+        s_thread = new QThread;
+        s_thread->setObjectName(QStringLiteral("KX11Extras"));
+        s_worker->moveToThread(s_thread);
+        s_thread->start();
+        qAddPostRoutine(shutdown);
+        return true;
+    }();
+    Q_UNUSED(started)
+    return s_worker;
+}
+
+void NETTrackingWorker::shutdown()
+{
+    s_worker->deleteLater();
+    s_thread->quit();
+    s_thread->wait();
+    delete s_thread;
+    s_thread = nullptr;
+    s_worker = nullptr;
+}
+
+NETTrackingWorker::NETTrackingWorker(xcb_connection_t *connection)
+    : m_connection(connection)
+    , m_rootWindow(QX11Info::appRootWindow())
+    , m_screen(QX11Info::appScreen())
+{
+}
+
+NETTrackingWorker::~NETTrackingWorker()
+{
+    m_root.reset();
+    xcb_disconnect(m_connection);
+}
+
+NETTrackingWorker::RootInfo::RootInfo(NETTrackingWorker *worker, NET::Properties properties, NET::Properties2 properties2)
+    : NETRootInfo(worker->m_connection, properties, properties2, worker->m_screen, false)
+    , m_worker(worker)
+{
+}
+
+std::unique_ptr<NETRootInfo> NETTrackingWorker::RootInfo::copy()
+{
+    auto values = std::make_unique<RootInfo>(m_worker, NET::Properties(), NET::Properties2());
+    values->virtual_hook(NETRootInfoCopyValuesHook, this);
+    return values;
+}
+
+void NETTrackingWorker::RootInfo::addClient(xcb_window_t window)
+{
+    m_worker->m_added.append(window);
+}
+
+void NETTrackingWorker::RootInfo::removeClient(xcb_window_t window)
+{
+    m_worker->m_removed.append(window);
+}
+
+void NETTrackingWorker::track(KX11Extras::FilterInfo what)
+{
+    QMetaObject::invokeMethod(
+        this,
+        [this, what]() {
+            post(setWhat(what));
+        },
+        Qt::QueuedConnection);
+}
+
+void NETTrackingWorker::start()
+{
+    xcb_connection_t *c = m_connection;
+
+    const uint32_t rootEvents = XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+    xcb_change_window_attributes(c, m_rootWindow, XCB_CW_EVENT_MASK, &rootEvents);
+
+    xcb_prefetch_extension_data(c, &xcb_xfixes_id);
+    const QByteArray cmName = QByteArrayLiteral("_NET_WM_CM_S") + QByteArray::number(m_screen);
+    const xcb_intern_atom_cookie_t cmCookie = xcb_intern_atom_unchecked(c, false, cmName.length(), cmName.constData());
+    UniqueCPointer<xcb_intern_atom_reply_t> cmReply(KXcbInstrumentation::reply(xcb_intern_atom_reply, c, cmCookie, nullptr));
+    m_cmAtom = cmReply ? cmReply->atom : XCB_ATOM_NONE;
+
+    // unlike on the main connection nobody negotiated the XFixes version here yet
+    const xcb_query_extension_reply_t *xfixes = xcb_get_extension_data(c, &xcb_xfixes_id);
+    if ((m_haveXfixes = xfixes && xfixes->present)) {
+        m_xfixesEventBase = xfixes->first_event;
+        UniqueCPointer<xcb_xfixes_query_version_reply_t> version(
+            KXcbInstrumentation::reply(xcb_xfixes_query_version_reply,
+                                       c,
+                                       xcb_xfixes_query_version_unchecked(c, XCB_XFIXES_MAJOR_VERSION, XCB_XFIXES_MINOR_VERSION),
+                                       nullptr));
+        xcb_xfixes_select_selection_input(c,
+                                          m_rootWindow,
+                                          m_cmAtom,
+                                          XCB_XFIXES_SELECTION_EVENT_MASK_SET_SELECTION_OWNER | XCB_XFIXES_SELECTION_EVENT_MASK_SELECTION_WINDOW_DESTROY
+                                              | XCB_XFIXES_SELECTION_EVENT_MASK_SELECTION_CLIENT_CLOSE);
+    }
+
+    m_notifier = new QSocketNotifier(xcb_get_file_descriptor(c), QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &NETTrackingWorker::readEvents);
+}
+
+std::shared_ptr<NETChangeSet> NETTrackingWorker::setWhat(KX11Extras::FilterInfo what)
+{
+    if (!m_notifier) {
+        start();
+    }
+    m_what = what;
+
+    xcb_connection_t *c = m_connection;
+    const NET::Properties properties = what >= KX11Extras::INFO_WINDOWS ? windowsProperties : desktopProperties;
+    const NET::Properties2 properties2 = what >= KX11Extras::INFO_WINDOWS ? windowsProperties2 : desktopProperties2;
+    const xcb_get_selection_owner_cookie_t ownerCookie = xcb_get_selection_owner_unchecked(c, m_cmAtom);
+
+    auto changes = std::make_shared<NETChangeSet>();
+    changes->initial = true;
+
+    // one instance follows the events, the other one is handed to the main thread
+    m_added.clear();
+    m_removed.clear();
+    m_root = std::make_unique<RootInfo>(this, properties, properties2);
+    m_root->activate();
+    changes->rootInfo = m_root->copy();
+
+    changes->added = std::exchange(m_added, {});
+    m_windows = QSet<WId>(changes->added.cbegin(), changes->added.cend());
+    m_struts.clear();
+    m_strutDirty.clear();
+    if (what >= KX11Extras::INFO_WINDOWS) {
+        // this connection is ours alone, so there is no previous event mask to preserve
+        const uint32_t events = XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+        for (WId w : std::as_const(changes->added)) {
+            xcb_change_window_attributes(c, w, XCB_CW_EVENT_MASK, &events);
+        }
+        fetchStruts(changes->added, *changes);
+        changes->strutWindows = m_struts;
+    }
+    m_strutsChanged = false;
+
+    UniqueCPointer<xcb_get_selection_owner_reply_t> owner(KXcbInstrumentation::reply(xcb_get_selection_owner_reply, c, ownerCookie, nullptr));
+    changes->compositingEnabled = owner && owner->owner != XCB_WINDOW_NONE;
+    xcb_flush(c);
+
+    // waiting for the replies may have queued events the socket notifier won't report
+    QMetaObject::invokeMethod(this, &NETTrackingWorker::readEvents, Qt::QueuedConnection);
+    return changes;
+}
+
+void NETTrackingWorker::readEvents()
+{
+    UniqueCPointer<xcb_generic_event_t> event(xcb_poll_for_event(m_connection));
+    while (event) {
+        auto changes = std::make_shared<NETChangeSet>();
+        for (; event; event.reset(xcb_poll_for_event(m_connection))) {
+            processEvent(event.get(), *changes);
+        }
+        // fetching the struts and root properties may queue further events
+        finish(*changes);
+        post(std::move(changes));
+        event.reset(xcb_poll_for_queued_event(m_connection));
+    }
+
+    if (xcb_connection_has_error(m_connection)) {
+        qCWarning(LOG_KWINDOWSYSTEM) << "Lost the X connection of the window tracking thread";
+        m_notifier->setEnabled(false);
+    }
+}
+
+void NETTrackingWorker::processEvent(xcb_generic_event_t *event, NETChangeSet &changes)
+{
+    const uint8_t eventType = event->response_type & ~0x80;
+
+    if (m_haveXfixes && eventType == m_xfixesEventBase + XCB_XFIXES_SELECTION_NOTIFY) {
+        auto notify = reinterpret_cast<xcb_xfixes_selection_notify_event_t *>(event);
+        if (notify->selection == m_cmAtom) {
+            changes.compositingEnabled = notify->owner != XCB_WINDOW_NONE;
+        }
+        return;
+    }
+
+    xcb_window_t eventWindow = XCB_WINDOW_NONE;
+    switch (eventType) {
+    case XCB_CLIENT_MESSAGE:
+        eventWindow = reinterpret_cast<xcb_client_message_event_t *>(event)->window;
+        break;
+    case XCB_PROPERTY_NOTIFY:
+        eventWindow = reinterpret_cast<xcb_property_notify_event_t *>(event)->window;
+        break;
+    case XCB_CONFIGURE_NOTIFY:
+        eventWindow = reinterpret_cast<xcb_configure_notify_event_t *>(event)->window;
+        break;
+    }
+
+    if (eventWindow == m_rootWindow) {
+        NET::Properties props;
+        NET::Properties2 props2;
+        m_root->event(event, &props, &props2);
+        changes.rootProperties |= props;
+        changes.rootProperties2 |= props2;
+
+        const uint32_t events = XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+        for (WId w : std::exchange(m_added, {})) {
+            m_windows.insert(w);
+            changes.added.append(w);
+            if (m_what >= KX11Extras::INFO_WINDOWS) {
+                xcb_change_window_attributes(m_connection, w, XCB_CW_EVENT_MASK, &events);
+                m_strutDirty.append(w);
+            }
+        }
+        for (WId w : std::exchange(m_removed, {})) {
+            m_windows.remove(w);
+            changes.removed.append(w);
+            m_strutDirty.removeAll(w);
+            if (m_struts.remove(w)) {
+                m_strutsChanged = true;
+                changes.strutChanged = true;
+            }
+        }
+    } else if (m_what >= KX11Extras::INFO_WINDOWS && m_windows.contains(eventWindow)) {
+        NET::Properties dirtyProperties;
+        NET::Properties2 dirtyProperties2;
+        // mapViewport() is only known to the main thread, which adds NET::WMDesktop there
+        const bool strutDirty =
+            clientChanges(m_connection, m_rootWindow, eventWindow, event, false, m_struts.contains(eventWindow), dirtyProperties, dirtyProperties2);
+        if (strutDirty && !m_strutDirty.contains(eventWindow)) {
+            m_strutDirty.append(eventWindow);
+        }
+        if (dirtyProperties || dirtyProperties2) {
+            changes.windowChanges.append({eventWindow, dirtyProperties, dirtyProperties2});
+        }
+    }
+}
+
+void NETTrackingWorker::finish(NETChangeSet &changes)
+{
+    if (!m_strutDirty.isEmpty()) {
+        fetchStruts(std::exchange(m_strutDirty, {}), changes);
+    }
+    if (m_strutsChanged) {
+        changes.strutWindows = m_struts;
+        m_strutsChanged = false;
+    }
+    if (changes.rootProperties || changes.rootProperties2) {
+        // m_root fetched the changed properties while handling the events
+        changes.rootInfo = m_root->copy();
+    }
+    xcb_flush(m_connection);
+}
+
+void NETTrackingWorker::fetchStruts(const QList<WId> &windows, NETChangeSet &changes)
+{
+    std::vector<StrutFetch> fetches;
+    fetches.reserve(windows.size());
+    for (WId w : windows) {
+        fetches.push_back(requestStrut(m_connection, m_rootWindow, w));
+    }
+
+    for (int i = 0; i < windows.size(); ++i) {
+        const WId w = windows.at(i);
+        const NETEventFilter::StrutData data = strutFromFetch(fetches[i]);
+        const bool known = m_struts.remove(w);
+        if (!data.isEmpty()) {
+            m_struts.insert(w, data);
+            // a changed strut is announced with the window change, a new window has none
+            if (!known && changes.added.contains(w)) {
+                changes.strutChanged = true;
+            }
+        }
+        if (known || !data.isEmpty()) {
+            m_strutsChanged = true;
+        }
+    }
+}
+
+void NETTrackingWorker::post(std::shared_ptr<NETChangeSet> changes)
+{
+    if (!changes->rootInfo && changes->added.isEmpty() && changes->removed.isEmpty() && changes->windowChanges.isEmpty() && !changes->strutWindows
+        && !changes->compositingEnabled) {
+        return;
+    }
+    changes->serial = ++m_serial;
+
+    std::shared_ptr<const NETChangeSet> finished = std::move(changes);
+    QMetaObject::invokeMethod(
+        KX11Extras::self(),
+        [finished]() {
+            NETEventFilter::applyTracked(finished);
+        },
+        Qt::QueuedConnection);
+}
+
+// The part of the display a single strut leaves free. A partial strut only counts if the space it
+// reserves lies on a screen at the outer edge of the display, a panel on an inner screen edge
+// cannot be expressed in a single rectangle.
+static QRect strutFreeArea(const NETEventFilter::StrutData &data, const DisplayLayout &layout)
+{
+    const QRect all = layout.geometry;
+    int left = 0;
+    int right = 0;
+    int top = 0;
+    int bottom = 0;
+
+    if (data.hasExtendedStrut()) {
+        const NETExtendedStrut &strut = data.extendedStrut;
+        auto reservesOuterEdge = [&layout](const QRect &reserved, auto isOuterScreen) {
+            return std::any_of(layout.screens.cbegin(), layout.screens.cend(), [&](const QRect &screen) {
+                return isOuterScreen(screen) && screen.intersects(reserved);
+            });
+        };
+        if (strut.left_width > 0
+            && reservesOuterEdge(QRect(all.left(), strut.left_start, strut.left_width, strut.left_end - strut.left_start + 1), [&all](const QRect &screen) {
+                   return screen.left() == all.left();
+               })) {
+            left = strut.left_width;
+        }
+        if (strut.right_width > 0
+            && reservesOuterEdge(QRect(all.right() - strut.right_width + 1, strut.right_start, strut.right_width, strut.right_end - strut.right_start + 1),
+                                 [&all](const QRect &screen) {
+                                     return screen.right() == all.right();
+                                 })) {
+            right = strut.right_width;
+        }
+        if (strut.top_width > 0
+            && reservesOuterEdge(QRect(strut.top_start, all.top(), strut.top_end - strut.top_start + 1, strut.top_width), [&all](const QRect &screen) {
+                   return screen.top() == all.top();
+               })) {
+            top = strut.top_width;
+        }
+        if (strut.bottom_width > 0
+            && reservesOuterEdge(QRect(strut.bottom_start, all.bottom() - strut.bottom_width + 1, strut.bottom_end - strut.bottom_start + 1, strut.bottom_width),
+                                 [&all](const QRect &screen) {
+                                     return screen.bottom() == all.bottom();
+                                 })) {
+            bottom = strut.bottom_width;
+        }
+    } else {
+        left = data.strut.left;
+        right = data.strut.right;
+        top = data.strut.top;
+        bottom = data.strut.bottom;
+    }
+
+    QRect r = all;
+    if (left > 0) {
+        r.setLeft(r.left() + left);
+    }
+    if (top > 0) {
+        r.setTop(r.top() + top);
+    }
+    if (right > 0) {
+        r.setRight(r.right() - right);
+    }
+    if (bottom > 0) {
+        r.setBottom(r.bottom() - bottom);
+    }
+    return r;
+}
+
+QRect NETEventFilter::strutWorkArea(const QList<WId> &exclude, int desktop)
+{
+    const DisplayLayout &layout = displayLayout();
+    if (workAreaCacheGeneration != layout.generation) {
+        workAreaCache.clear();
+        workAreaCacheGeneration = layout.generation;
+    }
+
+    QList<WId> excluded = exclude;
+    std::sort(excluded.begin(), excluded.end());
+    excluded.erase(std::unique(excluded.begin(), excluded.end()), excluded.end());
+
+    auto key = qMakePair(desktop, excluded);
+    const auto it = workAreaCache.constFind(key);
+    if (it != workAreaCache.constEnd()) {
+        return *it;
+    }
+
+    // Kicker (very) extensively calls this function, causing hundreds of roundtrips just
+    // to repeatedly find out struts of all windows. Therefore the struts are cached in
+    // strutWindows and the result for each desktop and set of excluded windows here.
+    resolvePossibleStrutWindows();
+
+    QRect area = layout.geometry;
+    for (auto strutIt = strutWindows.cbegin(); strutIt != strutWindows.cend(); ++strutIt) {
+        if (std::binary_search(excluded.cbegin(), excluded.cend(), strutIt.key())) {
+            continue;
+        }
+        if (strutIt->desktop != desktop && strutIt->desktop != NETWinInfo::OnAllDesktops) {
+            continue;
+        }
+        area = area.intersected(strutFreeArea(*strutIt, layout));
+    }
+
+    // callers usually only ask for a handful of combinations
+    if (workAreaCache.size() >= 32) {
+        workAreaCache.clear();
+    }
+    workAreaCache.insert(std::move(key), area);
+    return area;
+}
+
 bool NETEventFilter::mapViewport()
 {
     // compiz claims support even though it doesn't use virtual desktops :(
@@ -451,43 +1491,61 @@ bool NETEventFilter::mapViewport()
     return false;
 }
 
-static bool atoms_created = false;
+// request_atoms() and create_atoms() may be called from any thread, the mutex makes sure the
+// requests are sent and their replies are collected exactly once
+static std::atomic<bool> atoms_requested = false;
+static std::atomic<bool> atoms_created = false;
+Q_GLOBAL_STATIC(QMutex, s_atomsMutex)
 
-static Atom _wm_protocols;
-static Atom _wm_change_state;
-static Atom kwm_utf8_string;
+static xcb_atom_t _wm_protocols;
+static xcb_atom_t _wm_change_state;
+static xcb_atom_t kwm_utf8_string;
 
-static void create_atoms()
-{
-    if (!atoms_created) {
-        const int max = 20;
-        Atom *atoms[max];
-        const char *names[max];
-        Atom atoms_return[max];
-        int n = 0;
-
-        atoms[n] = &_wm_protocols;
-        names[n++] = "WM_PROTOCOLS";
+static xcb_atom_t *const atoms[] = {&_wm_protocols, &_wm_change_state, &kwm_utf8_string, &net_wm_cm};
+static xcb_intern_atom_cookie_t atom_cookies[std::size(atoms)];
 
-        atoms[n] = &_wm_change_state;
-        names[n++] = "WM_CHANGE_STATE";
-
-        atoms[n] = &kwm_utf8_string;
-        names[n++] = "UTF8_STRING";
+// only sends the intern requests, create_atoms() collects the replies
+static void request_atoms_locked()
+{
+    if (atoms_requested.load(std::memory_order_relaxed)) {
+        return;
+    }
+    const QByteArray net_wm_cm_name = QByteArrayLiteral("_NET_WM_CM_S") + QByteArray::number(QX11Info::appScreen());
+    const char *names[] = {"WM_PROTOCOLS", "WM_CHANGE_STATE", "UTF8_STRING", net_wm_cm_name.constData()};
+    static_assert(std::size(names) == std::size(atoms));
 
-        char net_wm_cm_name[100];
-        sprintf(net_wm_cm_name, "_NET_WM_CM_S%d", QX11Info::appScreen());
-        atoms[n] = &net_wm_cm;
-        names[n++] = net_wm_cm_name;
+    xcb_connection_t *c = QX11Info::connection();
+    for (size_t i = 0; i < std::size(names); ++i) {
+        atom_cookies[i] = xcb_intern_atom_unchecked(c, false, strlen(names[i]), names[i]);
+    }
+    atoms_requested.store(true, std::memory_order_release);
+}
 
-        // we need a const_cast for the shitty X API
-        XInternAtoms(QX11Info::display(), const_cast<char **>(names), n, false, atoms_return);
-        for (int i = 0; i < n; i++) {
-            *atoms[i] = atoms_return[i];
-        }
+static void request_atoms()
+{
+    if (atoms_requested.load(std::memory_order_acquire)) {
+        return;
+    }
+    QMutexLocker locker(s_atomsMutex());
+    request_atoms_locked();
+}
 
-        atoms_created = True;
+static void create_atoms()
+{
+    if (atoms_created.load(std::memory_order_acquire)) {
+        return;
     }
+    QMutexLocker locker(s_atomsMutex());
+    if (atoms_created.load(std::memory_order_relaxed)) {
+        return;
+    }
+    request_atoms_locked();
+    xcb_connection_t *c = QX11Info::connection();
+    for (size_t i = 0; i < std::size(atoms); ++i) {
+        UniqueCPointer<xcb_intern_atom_reply_t> reply(KXcbInstrumentation::reply(xcb_intern_atom_reply, c, atom_cookies[i], nullptr));
+        *atoms[i] = reply ? reply->atom : XCB_ATOM_NONE;
+    }
+    atoms_created.store(true, std::memory_order_release);
 }
 
 #define CHECK_X11                                                                                                                                              \
@@ -515,7 +1573,10 @@ void KX11Extras::init(FilterInfo what)
     }
 
     if (!s_d || s_d->what < what) {
+        KXcbInstrumentation::Scope scope(QX11Info::connection(), "KX11Extras::init");
         const bool wasCompositing = s_d ? s_d->compositingEnabled : false;
+        const bool wasStackingOrderDeltaConnected = s_d ? s_d->stackingOrderDeltaConnected : false;
+        const bool wasWindowsChangedConnected = s_d ? s_d->windowsChangedConnected : false;
         MainThreadInstantiator instantiator(what);
         NETEventFilter *filter;
         if (instantiator.thread() == QCoreApplication::instance()->thread()) {
@@ -528,7 +1589,13 @@ void KX11Extras::init(FilterInfo what)
             instantiator.moveToThread(QCoreApplication::instance()->thread());
             QMetaObject::invokeMethod(&instantiator, "createNETEventFilter", Qt::BlockingQueuedConnection, Q_RETURN_ARG(NETEventFilter *, filter));
         }
+        if (s_d && s_d->threaded && filter->threaded) {
+            // only the windows that are new to the previous filter get announced again
+            filter->adoptState(*s_d);
+        }
         d.reset(filter);
+        d->stackingOrderDeltaConnected = wasStackingOrderDeltaConnected;
+        d->windowsChangedConnected = wasWindowsChangedConnected;
         d->activate();
         if (wasCompositing != s_d_func()->compositingEnabled) {
             Q_EMIT KX11Extras::self()->compositingChanged(s_d_func()->compositingEnabled);
@@ -536,36 +1603,75 @@ void KX11Extras::init(FilterInfo what)
     }
 }
 
+// Threads other than the main one must not touch the live NETEventFilter state,
+// they get the last published snapshot instead
+static std::shared_ptr<const NETEventFilter::Snapshot> foreignThreadSnapshot(NETEventFilter *s_d)
+{
+    if (!s_d || QThread::isMainThread()) {
+        return nullptr;
+    }
+    return s_d->snapshot();
+}
+
 KX11Extras *KX11Extras::self()
 {
     static KX11Extras instance;
     return &instance;
 }
 
+// Managed windows can be sent requests right away, without first reading whether they
+// are withdrawn
+bool NETEventFilter::isManagedWindow(WId window)
+{
+    NETEventFilter *const s_d = KX11Extras::self()->s_d_func();
+    if (!s_d) {
+        return false;
+    }
+    if (const auto snapshot = foreignThreadSnapshot(s_d)) {
+        return snapshot->windows.contains(window);
+    }
+    return s_d->windows.contains(window);
+}
+
 QList<WId> KX11Extras::windows()
 {
     CHECK_X11
     KX11Extras::self()->init(INFO_BASIC);
-    return KX11Extras::self()->s_d_func()->windows;
+    NETEventFilter *const s_d = KX11Extras::self()->s_d_func();
+    if (const auto snapshot = foreignThreadSnapshot(s_d)) {
+        return snapshot->windows;
+    }
+    return s_d->windows;
 }
 
 bool KX11Extras::hasWId(WId w)
 {
     CHECK_X11
-    return windows().contains(w);
+    KX11Extras::self()->init(INFO_BASIC);
+    // the snapshot is republished after every root event, so it is as current as the
+    // live list on the main thread and safe to read from any other
+    const auto snapshot = KX11Extras::self()->s_d_func()->snapshot();
+    return snapshot && snapshot->windows.contains(w);
 }
 
 QList<WId> KX11Extras::stackingOrder()
 {
     CHECK_X11
     KX11Extras::self()->init(INFO_BASIC);
-    return KX11Extras::self()->s_d_func()->stackingOrder;
+    NETEventFilter *const s_d = KX11Extras::self()->s_d_func();
+    if (const auto snapshot = foreignThreadSnapshot(s_d)) {
+        return snapshot->stackingOrder;
+    }
+    return s_d->stackingOrder;
 }
 
 WId KX11Extras::activeWindow()
 {
     CHECK_X11
     NETEventFilter *const s_d = KX11Extras::self()->s_d_func();
+    if (const auto snapshot = foreignThreadSnapshot(s_d)) {
+        return snapshot->activeWindow;
+    }
     if (s_d) {
         return s_d->activeWindow();
     }
@@ -602,12 +1708,20 @@ void KX11Extras::forceActiveWindow(QWindow *win, long time)
 bool KX11Extras::compositingActive()
 {
     CHECK_X11
+    KXcbInstrumentation::Scope scope(QX11Info::connection(), "KX11Extras::compositingActive");
     KX11Extras::self()->init(INFO_BASIC);
-    if (KX11Extras::self()->s_d_func()->haveXfixes) {
-        return KX11Extras::self()->s_d_func()->compositingEnabled;
+    NETEventFilter *const s_d = KX11Extras::self()->s_d_func();
+    if (s_d->haveXfixes) {
+        if (const auto snapshot = foreignThreadSnapshot(s_d)) {
+            return snapshot->compositingEnabled;
+        }
+        return s_d->compositingEnabled;
     } else {
         create_atoms();
-        return XGetSelectionOwner(QX11Info::display(), net_wm_cm);
+        xcb_connection_t *c = QX11Info::connection();
+        UniqueCPointer<xcb_get_selection_owner_reply_t> owner(
+            KXcbInstrumentation::reply(xcb_get_selection_owner_reply, c, xcb_get_selection_owner_unchecked(c, net_wm_cm), nullptr));
+        return owner && owner->owner != XCB_WINDOW_NONE;
     }
 }
 
@@ -626,6 +1740,9 @@ int KX11Extras::currentDesktop()
     }
 
     NETEventFilter *const s_d = KX11Extras::self()->s_d_func();
+    if (const auto snapshot = foreignThreadSnapshot(s_d)) {
+        return snapshot->currentDesktop;
+    }
     if (s_d) {
         return s_d->currentDesktop(true);
     }
@@ -648,6 +1765,9 @@ int KX11Extras::numberOfDesktops()
     }
 
     NETEventFilter *const s_d = KX11Extras::self()->s_d_func();
+    if (const auto snapshot = foreignThreadSnapshot(s_d)) {
+        return snapshot->numberOfDesktops;
+    }
     if (s_d) {
         return s_d->numberOfDesktops(true);
     }
@@ -684,6 +1804,11 @@ void KX11Extras::setOnAllDesktops(WId win, bool b)
         }
         return;
     }
+    if (b && NETEventFilter::isManagedWindow(win)) {
+        NETWinInfo info(QX11Info::connection(), win, QX11Info::appRootWindow(), NET::Properties(), NET::Properties2());
+        info.requestDesktop(NETWinInfo::OnAllDesktops);
+        return;
+    }
     NETWinInfo info(QX11Info::connection(), win, QX11Info::appRootWindow(), NET::WMDesktop, NET::Properties2());
     if (b) {
         info.setDesktop(NETWinInfo::OnAllDesktops, true);
@@ -735,6 +1860,11 @@ void KX11Extras::setOnDesktop(WId win, int desktop)
         s_d->moveResizeWindowRequest(win, flags, p.x(), p.y(), w, h);
         return;
     }
+    if (NETEventFilter::isManagedWindow(win)) {
+        NETWinInfo info(QX11Info::connection(), win, QX11Info::appRootWindow(), NET::Properties(), NET::Properties2());
+        info.requestDesktop(desktop);
+        return;
+    }
     NETWinInfo info(QX11Info::connection(), win, QX11Info::appRootWindow(), NET::WMDesktop, NET::Properties2());
     info.setDesktop(desktop, true);
 }
@@ -752,6 +1882,15 @@ QPixmap KX11Extras::icon(WId win, int width, int height, bool scale)
     return icon(win, width, height, scale, NETWM | WMHints | ClassHint | XApp);
 }
 
+static QPixmap scaledIcon(const QPixmap &pm, int width, int height, bool scale)
+{
+    if (scale && width > 0 && height > 0 && !pm.isNull() //
+        && (pm.width() != width || pm.height() != height)) {
+        return QPixmap::fromImage(pm.toImage().scaled(width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+    }
+    return pm;
+}
+
 QPixmap iconFromNetWinInfo(int width, int height, bool scale, int flags, NETWinInfo *info)
 {
     QPixmap result;
@@ -777,13 +1916,7 @@ QPixmap iconFromNetWinInfo(int width, int height, bool scale, int flags, NETWinI
         xcb_pixmap_t p_mask = info->icccmIconPixmapMask();
 
         if (p != XCB_PIXMAP_NONE) {
-            QPixmap pm = KXUtils::createPixmapFromHandle(info->xcbConnection(), p, p_mask);
-            if (scale && width > 0 && height > 0 && !pm.isNull() //
-                && (pm.width() != width || pm.height() != height)) {
-                result = QPixmap::fromImage(pm.toImage().scaled(width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
-            } else {
-                result = pm;
-            }
+            result = scaledIcon(KXUtils::createPixmapFromHandle(info->xcbConnection(), p, p_mask), width, height, scale);
         }
     }
 
@@ -838,6 +1971,7 @@ QPixmap iconFromNetWinInfo(int width, int height, bool scale, int flags, NETWinI
 QPixmap KX11Extras::icon(WId win, int width, int height, bool scale, int flags)
 {
     CHECK_X11
+    KXcbInstrumentation::Scope scope(QX11Info::connection(), "KX11Extras::icon");
     NETWinInfo info(QX11Info::connection(), win, QX11Info::appRootWindow(), NET::WMIcon, NET::WM2WindowClass | NET::WM2IconPixmap);
     return iconFromNetWinInfo(width, height, scale, flags, &info);
 }
@@ -849,15 +1983,47 @@ QPixmap KX11Extras::icon(WId win, int width, int height, bool scale, int flags,
     height *= qGuiApp->devicePixelRatio();
 
     if (info) {
+        KXcbInstrumentation::Scope scope(info->xcbConnection(), "KX11Extras::icon");
         return iconFromNetWinInfo(width, height, scale, flags, info);
     }
     CHECK_X11
 
+    KXcbInstrumentation::Scope scope(QX11Info::connection(), "KX11Extras::icon");
     NETWinInfo newInfo(QX11Info::connection(), win, QX11Info::appRootWindow(), NET::WMIcon, NET::WM2WindowClass | NET::WM2IconPixmap);
 
     return iconFromNetWinInfo(width, height, scale, flags, &newInfo);
 }
 
+QList<QPixmap> KX11Extras::wmHintsIcons(const QList<WId> &windows, int width, int height, bool scale)
+{
+    CHECK_X11
+    xcb_connection_t *c = QX11Info::connection();
+    const xcb_window_t root = QX11Info::appRootWindow();
+    KXcbInstrumentation::Scope scope(c, "KX11Extras::wmHintsIcons");
+
+    // WM_HINTS of all windows first, then their pixmaps together
+    std::vector<std::unique_ptr<NETWinInfoFetcher>> infos;
+    std::vector<NETWinInfoFetchData> fetches(windows.size());
+    infos.reserve(windows.size());
+    for (qsizetype i = 0; i < windows.size(); ++i) {
+        auto &info = infos.emplace_back(std::make_unique<NETWinInfoFetcher>(c, windows.at(i), root, NET::Properties(), NET::Properties2()));
+        fetches[i].properties2 = NET::WM2IconPixmap;
+        info->fetch(NETWinInfoRequestHook, &fetches[i]);
+    }
+    QList<std::pair<WId, WId>> handles;
+    handles.reserve(windows.size());
+    for (qsizetype i = 0; i < windows.size(); ++i) {
+        infos[i]->fetch(NETWinInfoParseHook, &fetches[i]);
+        handles.append({infos[i]->icccmIconPixmap(), infos[i]->icccmIconPixmapMask()});
+    }
+
+    QList<QPixmap> icons = KXUtils::createPixmapsFromHandles(c, handles);
+    for (QPixmap &icon : icons) {
+        icon = scaledIcon(icon, width, height, scale);
+    }
+    return icons;
+}
+
 // enum values for ICCCM 4.1.2.4 and 4.1.4, defined to not depend on xcb-icccm
 enum {
     _ICCCM_WM_STATE_WITHDRAWN = 0,
@@ -896,6 +2062,7 @@ void KX11Extras::unminimizeWindow(WId win)
 QRect KX11Extras::workArea(int desktop)
 {
     CHECK_X11
+    KXcbInstrumentation::Scope scope(QX11Info::connection(), "KX11Extras::workArea");
     KX11Extras::self()->init(INFO_BASIC);
     int desk = (desktop > 0 && desktop <= (int)KX11Extras::self()->s_d_func()->numberOfDesktops()) ? desktop : currentDesktop();
     if (desk <= 0) {
@@ -913,69 +2080,15 @@ QRect KX11Extras::workArea(int desktop)
 QRect KX11Extras::workArea(const QList<WId> &exclude, int desktop)
 {
     CHECK_X11
+    KXcbInstrumentation::Scope scope(QX11Info::connection(), "KX11Extras::workArea");
     KX11Extras::self()->init(INFO_WINDOWS); // invalidates s_d_func's return value
     NETEventFilter *const s_d = KX11Extras::self()->s_d_func();
 
-    QRect all = displayGeometry();
-    QRect a = all;
-
     if (desktop == -1) {
         desktop = s_d->currentDesktop();
     }
 
-    QList<WId>::ConstIterator it1;
-    for (it1 = s_d->windows.constBegin(); it1 != s_d->windows.constEnd(); ++it1) {
-        if (exclude.contains(*it1)) {
-            continue;
-        }
-
-        // Kicker (very) extensively calls this function, causing hundreds of roundtrips just
-        // to repeatedly find out struts of all windows. Therefore strut values for strut
-        // windows are cached here.
-        NETStrut strut;
-        auto it2 = s_d->strutWindows.begin();
-        for (; it2 != s_d->strutWindows.end(); ++it2) {
-            if ((*it2).window == *it1) {
-                break;
-            }
-        }
-
-        if (it2 != s_d->strutWindows.end()) {
-            if (!((*it2).desktop == desktop || (*it2).desktop == NETWinInfo::OnAllDesktops)) {
-                continue;
-            }
-
-            strut = (*it2).strut;
-        } else if (s_d->possibleStrutWindows.contains(*it1)) {
-            NETWinInfo info(QX11Info::connection(), (*it1), QX11Info::appRootWindow(), NET::WMStrut | NET::WMDesktop, NET::Properties2());
-            strut = info.strut();
-            s_d->possibleStrutWindows.removeAll(*it1);
-            s_d->strutWindows.append(NETEventFilter::StrutData(*it1, info.strut(), info.desktop()));
-
-            if (!(info.desktop() == desktop || info.desktop() == NETWinInfo::OnAllDesktops)) {
-                continue;
-            }
-        } else {
-            continue; // not a strut window
-        }
-
-        QRect r = all;
-        if (strut.left > 0) {
-            r.setLeft(r.left() + (int)strut.left);
-        }
-        if (strut.top > 0) {
-            r.setTop(r.top() + (int)strut.top);
-        }
-        if (strut.right > 0) {
-            r.setRight(r.right() - (int)strut.right);
-        }
-        if (strut.bottom > 0) {
-            r.setBottom(r.bottom() - (int)strut.bottom);
-        }
-
-        a = a.intersected(r);
-    }
-    return a / qApp->devicePixelRatio();
+    return s_d->strutWorkArea(exclude, desktop) / qApp->devicePixelRatio();
 }
 
 QString KX11Extras::desktopName(int desktop)
@@ -1015,6 +2128,7 @@ void KX11Extras::setDesktopName(int desktop, const QString &name)
 QString KX11Extras::readNameProperty(WId win, unsigned long atom)
 {
     CHECK_X11
+    KXcbInstrumentation::Scope scope(QX11Info::connection(), "KX11Extras::readNameProperty");
     XTextProperty tp;
     char **text = nullptr;
     int count;
@@ -1040,6 +2154,7 @@ QString KX11Extras::readNameProperty(WId win, unsigned long atom)
 bool KX11Extras::mapViewport()
 {
     CHECK_X11
+    KXcbInstrumentation::Scope scope(QX11Info::connection(), "KX11Extras::mapViewport");
     NETEventFilter *const s_d = KX11Extras::self()->s_d_func();
     if (s_d) {
         return s_d->mapViewport();
@@ -1154,6 +2269,8 @@ void KX11Extras::connectNotify(const QMetaMethod &signal)
         what = INFO_WINDOWS;
     } else if (signal == QMetaMethod::fromSignal(&KX11Extras::windowChanged)) {
         what = INFO_WINDOWS;
+    } else if (signal == QMetaMethod::fromSignal(&KX11Extras::windowsChanged)) {
+        what = INFO_WINDOWS;
     }
 
     init(what);
@@ -1161,6 +2278,12 @@ void KX11Extras::connectNotify(const QMetaMethod &signal)
     if (!s_d->strutSignalConnected && signal == QMetaMethod::fromSignal(&KX11Extras::strutChanged)) {
         s_d->strutSignalConnected = true;
     }
+    if (!s_d->stackingOrderDeltaConnected && signal == QMetaMethod::fromSignal(&KX11Extras::stackingOrderUpdated)) {
+        s_d->stackingOrderDeltaConnected = true;
+    }
+    if (!s_d->windowsChangedConnected && signal == QMetaMethod::fromSignal(&KX11Extras::windowsChanged)) {
+        s_d->windowsChangedConnected = true;
+    }
     QObject::connectNotify(signal);
 }
 
@@ -1174,6 +2297,11 @@ void KX11Extras::setType(WId win, NET::WindowType windowType)
 void KX11Extras::setState(WId win, NET::States state)
 {
     CHECK_X11_VOID
+    if (NETEventFilter::isManagedWindow(win)) {
+        NETWinInfo info(QX11Info::connection(), win, QX11Info::appRootWindow(), NET::Properties(), NET::Properties2());
+        info.requestState(state, state);
+        return;
+    }
     NETWinInfo info(QX11Info::connection(), win, QX11Info::appRootWindow(), NET::WMState, NET::Properties2());
     info.setState(state, state);
 }
@@ -1181,10 +2309,63 @@ void KX11Extras::setState(WId win, NET::States state)
 void KX11Extras::clearState(WId win, NET::States state)
 {
     CHECK_X11_VOID
+    if (NETEventFilter::isManagedWindow(win)) {
+        NETWinInfo info(QX11Info::connection(), win, QX11Info::appRootWindow(), NET::Properties(), NET::Properties2());
+        info.requestState(NET::States(), state);
+        return;
+    }
     NETWinInfo info(QX11Info::connection(), win, QX11Info::appRootWindow(), NET::WMState, NET::Properties2());
     info.setState(NET::States(), state);
 }
 
+void KX11Extras::setThreadedWindowTracking(bool enable)
+{
+    CHECK_X11_VOID
+    if (KX11Extras::self()->s_d_func()) {
+        qCWarning(LOG_KWINDOWSYSTEM) << Q_FUNC_INFO << "has to be called before windows are tracked";
+        return;
+    }
+    threadedWindowTracking = enable;
+}
+
+void KX11Extras::setRequestStatisticsEnabled(bool enable)
+{
+    KXcbInstrumentation::setEnabled(enable);
+}
+
+bool KX11Extras::requestStatisticsEnabled()
+{
+    return KXcbInstrumentation::isEnabled();
+}
+
+QHash<QString, KX11Extras::RequestStatistics> KX11Extras::requestStatistics()
+{
+    return KXcbInstrumentation::statistics();
+}
+
+void KX11Extras::resetRequestStatistics()
+{
+    KXcbInstrumentation::reset();
+}
+
+void KX11Extras::dumpRequestStatistics()
+{
+    KXcbInstrumentation::dump();
+}
+
+void KX11Extras::setWindowsChangedInterval(int msec)
+{
+    CHECK_X11_VOID
+    windowsChangedInterval = std::max(0, msec);
+    // the timer belongs to the main thread, a batch already waiting follows the new interval
+    QMetaObject::invokeMethod(QCoreApplication::instance(), []() {
+        NETEventFilter *const s_d = KX11Extras::self()->s_d_func();
+        if (s_d && s_d->windowsChangedTimer.isActive()) {
+            s_d->scheduleWindowChanges();
+        }
+    });
+}
+
 int KX11Extras::viewportToDesktop(const QPoint &p)
 {
     CHECK_X11
@@ -1252,7 +2433,11 @@ QPoint KX11Extras::desktopToViewport(int desktop, bool absolute)
 bool KX11Extras::showingDesktop()
 {
     KX11Extras::self()->init(INFO_BASIC);
-    return KX11Extras::self()->s_d_func()->showingDesktop();
+    NETEventFilter *const s_d = KX11Extras::self()->s_d_func();
+    if (const auto snapshot = foreignThreadSnapshot(s_d)) {
+        return snapshot->showingDesktop;
+    }
+    return s_d->showingDesktop();
 }
 
 void KX11Extras::setShowingDesktop(bool showing)
@@ -9,9 +9,12 @@
 #ifndef KX11EXTRAS_H
 #define KX11EXTRAS_H
 
+#include <QHash>
 #include <QObject>
 #include <QWindow>
 
+#include <chrono>
+
 #include <kwindowsystem_export.h>
 
 #include "netwm_def.h"
@@ -258,6 +261,20 @@ public:
      */
     static QPixmap icon(WId win, int width, int height, bool scale, int flags, NETWinInfo *info);
 
+    /*!
+     * Returns the icons the windows in \a windows set in their WM_HINTS, in the same
+     * order, with a null QPixmap for windows without one.
+     *
+     * This gives the same icons as icon() with the IconSource flag WMHints, but fetches
+     * those of all windows together, so it takes about as long for many windows as
+     * it takes for a single one.
+     *
+     * \a width, \a height and \a scale are used like for icon().
+     *
+     * \since 6.30
+     */
+    static QList<QPixmap> wmHintsIcons(const QList<WId> &windows, int width = -1, int height = -1, bool scale = false);
+
     /*!
      * Minimizes the window with id \a win.
      *
@@ -286,6 +303,11 @@ public:
      * work area if no desktop has been specified.
      *
      * A list of struts belonging to clients can be specified with \a excludes.
+     *
+     * Partial struts (_NET_WM_STRUT_PARTIAL) take precedence over plain ones. Space a partial
+     * strut reserves on an inner screen edge of a multi-screen setup is not subtracted, as the
+     * result is a single rectangle. Results are cached until a strut, the number of desktops
+     * or the screen layout changes.
      */
     static QRect workArea(const QList<WId> &excludes, int desktop = -1);
 
@@ -416,6 +438,110 @@ public:
      */
     static void setState(WId win, NET::States state);
 
+    /*!
+     * Sets the minimum interval in \a msec between two emissions of windowsChanged().
+     *
+     * The default of 0 emits the accumulated changes once per event loop iteration.
+     * A positive value caps the rate, which is useful when windows update their title
+     * or icon many times per second.
+     *
+     * \sa windowsChanged()
+     * \since 6.30
+     */
+    static void setWindowsChangedInterval(int msec);
+
+    /*!
+     * Sets whether the window tracking runs on an X connection of its own in a worker thread.
+     *
+     * By default the windows, the stacking order and the root window properties are fetched
+     * on the connection of the application, so a window manager that is slow to answer stalls
+     * the main thread. With \a enable the worker fetches them and hands every batch of changes
+     * to the main thread at once, the signals are emitted from there as usual. The main thread
+     * never waits for the worker, so right after the first request the state is still empty;
+     * windowAdded() is emitted for every window once the worker delivered it.
+     *
+     * Has to be called before any window information is requested and has no effect afterwards.
+     * KWindowInfo still queries the application connection.
+     *
+     * \since 6.30
+     */
+    static void setThreadedWindowTracking(bool enable);
+
+    /*!
+     * \struct KX11Extras::RequestStatistics
+     * \inmodule KWindowSystem
+     * \brief The X traffic caused by the calls of one function of the library.
+     *
+     * \sa requestStatistics()
+     * \since 6.30
+     */
+    struct RequestStatistics {
+        /*! How often the function was called. */
+        quint64 calls = 0;
+        /*! The number of requests the calls sent to the X server. */
+        quint64 requests = 0;
+        /*! The number of replies the calls took, blocking or not. */
+        quint64 replies = 0;
+        /*! The number of replies that were not there yet and had to be waited for. */
+        quint64 blockingWaits = 0;
+        /*! The time spent in those waits. */
+        std::chrono::nanoseconds waitTime{0};
+        /*! The number of bytes written to the X connection. */
+        quint64 bytesSent = 0;
+        /*! The number of bytes read from the X connection while the calls ran. */
+        quint64 bytesReceived = 0;
+    };
+
+    /*!
+     * Sets whether the X traffic of the public functions of the library is recorded.
+     *
+     * The recording is off by default, as it costs a no-op request and a flush per call.
+     * Setting the environment variable \c KWINDOWSYSTEM_XCB_STATISTICS turns it on from the
+     * start and logs the statistics to the \c kf.windowsystem.xcb.requests category when the
+     * application quits.
+     *
+     * Calls made from within another recorded call are accounted to the outer one, for
+     * example the NETWinInfo used by KWindowInfo counts towards the KWindowInfo constructor.
+     *
+     * \sa requestStatistics(), dumpRequestStatistics()
+     * \since 6.30
+     */
+    static void setRequestStatisticsEnabled(bool enable);
+
+    /*!
+     * Returns whether the X traffic is recorded.
+     *
+     * \sa setRequestStatisticsEnabled()
+     * \since 6.30
+     */
+    static bool requestStatisticsEnabled();
+
+    /*!
+     * Returns the recorded X traffic, keyed by the name of the function that caused it.
+     *
+     * Replies taken outside of any recorded function, such as during event processing,
+     * are listed under \c "(unattributed)".
+     *
+     * \sa setRequestStatisticsEnabled()
+     * \since 6.30
+     */
+    static QHash<QString, RequestStatistics> requestStatistics();
+
+    /*!
+     * Discards the recorded X traffic.
+     *
+     * \since 6.30
+     */
+    static void resetRequestStatistics();
+
+    /*!
+     * Logs the recorded X traffic to the \c kf.windowsystem.xcb.requests category,
+     * one line per function, most time spent waiting first.
+     *
+     * \since 6.30
+     */
+    static void dumpRequestStatistics();
+
 Q_SIGNALS:
 
     /*!
@@ -467,6 +593,22 @@ Q_SIGNALS:
      */
     void stackingOrderChanged();
 
+    /*!
+     * Emitted right after stackingOrderChanged() with the minimal set of changes
+     * that turns the previous stacking order into the current one.
+     *
+     * \a removed holds the windows that left the stacking order. \a placed holds
+     * the windows that were added or moved, each paired with its index in the new
+     * stackingOrder() and sorted by that index. Dropping the windows of both lists
+     * from the previous order and then inserting the windows of \a placed at their
+     * index, front to back, yields the new order.
+     *
+     * Raising or lowering a single window results in a single entry in \a placed.
+     *
+     * \since 6.30
+     */
+    void stackingOrderUpdated(const QList<WId> &removed, const QList<QPair<WId, int>> &placed);
+
     /*!
      * The window with the given \a id changed.
      *
@@ -475,6 +617,21 @@ Q_SIGNALS:
      */
     void windowChanged(WId id, NET::Properties properties, NET::Properties2 properties2);
 
+    /*!
+     * Coalesced variant of windowChanged().
+     *
+     * The NET::Properties and NET::Properties2 that changed since the last emission are
+     * accumulated per window and delivered in one batch in \a changes, at most once per
+     * event loop iteration or per interval set with setWindowsChangedInterval().
+     * Windows removed in the meantime are not part of the batch.
+     *
+     * Accumulating only happens while something is connected to this signal,
+     * windowChanged() is emitted as before.
+     *
+     * \since 6.30
+     */
+    void windowsChanged(const QHash<WId, QPair<NET::Properties, NET::Properties2>> &changes);
+
     /*!
      * Compositing was \a enabled or disabled.
      *
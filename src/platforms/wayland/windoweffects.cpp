@@ -25,7 +25,7 @@
 
 #include <wayland-client-protocol.h>
 
-static wl_region *createRegion(const QRegion &region)
+static wl_region *createRegion(const QList<QRect> &rects)
 {
     auto native = qGuiApp->nativeInterface<QNativeInterface::QWaylandApplication>();
     if (!native) {
@@ -36,7 +36,7 @@ static wl_region *createRegion(const QRegion &region)
         return nullptr;
     }
     auto wl_region = wl_compositor_create_region(compositor);
-    for (const auto &rect : region) {
+    for (const auto &rect : rects) {
         wl_region_add(wl_region, rect.x(), rect.y(), rect.width(), rect.height());
     }
     return wl_region;
@@ -211,6 +211,7 @@ WindowEffects::WindowEffects()
     connect(m_backgroundEffectManager.get(), &BackgroundEffectManager::activeChanged, this, [this]() {
         if (!m_backgroundEffectManager->isActive()) {
             m_backgroundEffects.clear();
+            m_blurSurfaces.clear();
         }
     });
 
@@ -223,6 +224,51 @@ WindowEffects::WindowEffects()
 
 WindowEffects::~WindowEffects()
 {
+    if (isQpaAlive()) {
+        for (const auto &regions : std::as_const(m_regionCache)) {
+            for (const CachedRegion &cached : regions) {
+                wl_region_destroy(cached.wlRegion);
+            }
+        }
+    }
+}
+
+wl_region *WindowEffects::cachedRegion(QWindow *window, const QRegion &region)
+{
+    static constexpr int maxCachedRegions = 2;
+
+    auto &regions = m_regionCache[window];
+    size_t hash = 0;
+    for (const QRect &rect : region) {
+        hash = qHashMulti(hash, rect.x(), rect.y(), rect.width(), rect.height());
+    }
+    for (int i = 0; i < regions.size(); ++i) {
+        if (regions.at(i).hash == hash && regions.at(i).region == region) {
+            regions.move(i, 0);
+            return regions.constFirst().wlRegion;
+        }
+    }
+
+    auto wlRegion = createRegion(simplifiedRects(region));
+    if (!wlRegion) {
+        return nullptr;
+    }
+    if (regions.size() == maxCachedRegions) {
+        wl_region_destroy(regions.takeLast().wlRegion);
+    }
+    regions.prepend(CachedRegion{hash, region, wlRegion});
+    return wlRegion;
+}
+
+void WindowEffects::releaseRegions(QWindow *window)
+{
+    const auto regions = m_regionCache.take(window);
+    if (!isQpaAlive()) {
+        return;
+    }
+    for (const CachedRegion &cached : regions) {
+        wl_region_destroy(cached.wlRegion);
+    }
 }
 
 void WindowEffects::trackWindow(QWindow *window)
@@ -230,11 +276,12 @@ void WindowEffects::trackWindow(QWindow *window)
     if (!m_windowDestroyedWatchers.contains(window)) {
         window->installEventFilter(this);
         m_windowDestroyedWatchers[window] = connect(window, &QObject::destroyed, this, [this, window]() {
-            resetBlur(window);
+            handleSurfaceDestroyed(window);
             m_blurRegions.remove(window);
-            resetContrast(window);
             m_backgroundConstrastRegions.remove(window);
             m_slideMap.remove(window);
+            m_slides.remove(window);
+            releaseRegions(window);
             m_windowDestroyedWatchers.remove(window);
             m_surfaceDestroyedWatchers.remove(window);
         });
@@ -243,8 +290,7 @@ void WindowEffects::trackWindow(QWindow *window)
         auto waylandWindow = window->nativeInterface<QNativeInterface::Private::QWaylandWindow>();
         if (waylandWindow) {
             m_surfaceDestroyedWatchers[window] = connect(waylandWindow, &QNativeInterface::Private::QWaylandWindow::surfaceDestroyed, this, [this, window]() {
-                resetBlur(window);
-                resetContrast(window);
+                handleSurfaceDestroyed(window);
             });
         }
     }
@@ -261,6 +307,7 @@ void WindowEffects::releaseWindow(QWindow *window)
             disconnect(*it);
             m_surfaceDestroyedWatchers.erase(it);
         }
+        releaseRegions(window);
         window->removeEventFilter(this);
     }
 }
@@ -288,6 +335,22 @@ void WindowEffects::resetContrast(QWindow *window, Contrast *contrast)
     replaceValue(m_contrasts, window, contrast);
 }
 
+void WindowEffects::resetSlide(QWindow *window, Slide *slide)
+{
+    replaceValue(m_slides, window, slide);
+}
+
+void WindowEffects::handleSurfaceDestroyed(QWindow *window)
+{
+    resetBlur(window);
+    resetContrast(window);
+    resetSlide(window);
+    // the next surface may be allocated at the same address
+    m_blurSurfaces.remove(window);
+    m_contrastSurfaces.remove(window);
+    m_slideSurfaces.remove(window);
+}
+
 bool WindowEffects::eventFilter(QObject *watched, QEvent *event)
 {
     if (event->type() == QEvent::Expose) {
@@ -296,21 +359,27 @@ bool WindowEffects::eventFilter(QObject *watched, QEvent *event)
             return false;
         }
 
+        // Effects stay attached to the surface they were sent for, so they only
+        // need to be installed again once the window got a new surface
+        wl_surface *surface = surfaceForWindow(window);
+        if (!surface) {
+            return false;
+        }
         {
             auto it = m_blurRegions.constFind(window);
-            if (it != m_blurRegions.constEnd()) {
+            if (it != m_blurRegions.constEnd() && m_blurSurfaces.value(window) != surface) {
                 installBlur(window, true, *it);
             }
         }
         {
             auto it = m_backgroundConstrastRegions.constFind(window);
-            if (it != m_backgroundConstrastRegions.constEnd()) {
+            if (it != m_backgroundConstrastRegions.constEnd() && m_contrastSurfaces.value(window) != surface) {
                 installContrast(window, true, it->contrast, it->intensity, it->saturation, it->region);
             }
         }
         {
             auto it = m_slideMap.constFind(window);
-            if (it != m_slideMap.constEnd()) {
+            if (it != m_slideMap.constEnd() && m_slideSurfaces.value(window) != surface) {
                 installSlide(window, it->location, it->offset);
             }
         }
@@ -328,8 +397,7 @@ bool WindowEffects::eventFilter(QObject *watched, QEvent *event)
             disconnect(*it);
         }
         m_surfaceDestroyedWatchers[window] = connect(waylandWindow, &QNativeInterface::Private::QWaylandWindow::surfaceDestroyed, this, [this, window]() {
-            resetBlur(window);
-            resetContrast(window);
+            handleSurfaceDestroyed(window);
         });
     }
     return false;
@@ -390,6 +458,8 @@ void WindowEffects::installSlide(QWindow *window, KWindowEffects::SlideFromLocat
     if (surface) {
         if (location != KWindowEffects::SlideFromLocation::NoEdge) {
             auto slide = new Slide(m_slideManager->create(surface), window);
+            resetSlide(window, slide);
+            m_slideSurfaces.insert(window, surface);
 
             Slide::location convertedLoc;
             switch (location) {
@@ -412,6 +482,8 @@ void WindowEffects::installSlide(QWindow *window, KWindowEffects::SlideFromLocat
             slide->set_offset(offset);
             slide->commit();
         } else {
+            resetSlide(window);
+            m_slideSurfaces.remove(window);
             m_slideManager->unset(surface);
         }
     }
@@ -458,41 +530,45 @@ void WindowEffects::installBlur(QWindow *window, bool enable, const QRegion &reg
         if (!effect) {
             effect = std::make_unique<BackgroundEffect>(m_backgroundEffectManager->get_background_effect(surface));
         }
+        if (enable) {
+            m_blurSurfaces.insert(window, surface);
+        } else {
+            m_blurSurfaces.remove(window);
+        }
         wl_region *wlRegion = nullptr;
         if (enable) {
             if (region.isEmpty()) {
                 // empty region = cover the whole window
-                wlRegion = createRegion(QRegion{
-                    std::numeric_limits<int>::min() / 2,
-                    std::numeric_limits<int>::min() / 2,
-                    std::numeric_limits<int>::max(),
-                    std::numeric_limits<int>::max(),
-                });
+                wlRegion = cachedRegion(window,
+                                        QRegion{
+                                            std::numeric_limits<int>::min() / 2,
+                                            std::numeric_limits<int>::min() / 2,
+                                            std::numeric_limits<int>::max(),
+                                            std::numeric_limits<int>::max(),
+                                        });
             } else {
-                wlRegion = createRegion(region);
+                wlRegion = cachedRegion(window, region);
             }
         }
         effect->set_blur_region(wlRegion);
-        if (wlRegion) {
-            wl_region_destroy(wlRegion);
-        }
         return;
     }
     if (!m_blurManager->isActive()) {
         return;
     }
     if (enable) {
-        auto wl_region = createRegion(region);
+        auto wl_region = cachedRegion(window, region);
         if (!wl_region) {
             return;
         }
         auto blur = new Blur(m_blurManager->create(surface), window);
         blur->set_region(wl_region);
         blur->commit();
-        wl_region_destroy(wl_region);
         resetBlur(window, blur);
+        m_blurSurfaces.insert(window, surface);
     } else {
         resetBlur(window);
+        m_blurSurfaces.remove(window);
         m_blurManager->unset(surface);
     }
 }
@@ -538,7 +614,7 @@ void WindowEffects::installContrast(QWindow *window, bool enable, qreal contrast
     wl_surface *surface = surfaceForWindow(window);
     if (surface) {
         if (enable) {
-            auto wl_region = createRegion(region);
+            auto wl_region = cachedRegion(window, region);
             if (!wl_region) {
                 return;
             }
@@ -548,10 +624,11 @@ void WindowEffects::installContrast(QWindow *window, bool enable, qreal contrast
             backgroundContrast->set_intensity(wl_fixed_from_double(intensity));
             backgroundContrast->set_saturation(wl_fixed_from_double(saturation));
             backgroundContrast->commit();
-            wl_region_destroy(wl_region);
             resetContrast(window, backgroundContrast);
+            m_contrastSurfaces.insert(window, surface);
         } else {
             resetContrast(window);
+            m_contrastSurfaces.remove(window);
             m_contrastManager->unset(surface);
         }
     }
@@ -18,8 +18,11 @@ class Blur;
 class ContrastManager;
 class Contrast;
 class SlideManager;
+class Slide;
 class BackgroundEffectManager;
 class BackgroundEffect;
+struct wl_region;
+struct wl_surface;
 
 class WindowEffects : public QObject, public KWindowEffectsPrivate
 {
@@ -43,12 +46,18 @@ public:
                                   const QRegion &region = QRegion()) override;
 
 private:
+    friend class WindowEffectsTest;
+
     void installContrast(QWindow *window, bool enable = true, qreal contrast = 1, qreal intensity = 1, qreal saturation = 1, const QRegion &region = QRegion());
     void installBlur(QWindow *window, bool enable, const QRegion &region);
     void installSlide(QWindow *window, KWindowEffects::SlideFromLocation location, int offset);
 
     void resetBlur(QWindow *window, Blur *blur = nullptr);
     void resetContrast(QWindow *window, Contrast *contrast = nullptr);
+    void resetSlide(QWindow *window, Slide *slide = nullptr);
+    void handleSurfaceDestroyed(QWindow *window);
+    wl_region *cachedRegion(QWindow *window, const QRegion &region);
+    void releaseRegions(QWindow *window);
 
     QHash<QWindow *, QMetaObject::Connection> m_windowDestroyedWatchers;
     QHash<QWindow *, QMetaObject::Connection> m_surfaceDestroyedWatchers;
@@ -64,6 +73,20 @@ private:
     QHash<QWindow *, BackgroundContrastData> m_backgroundConstrastRegions;
     QHash<QWindow *, QPointer<Blur>> m_blurs;
     QHash<QWindow *, QPointer<Contrast>> m_contrasts;
+    QHash<QWindow *, QPointer<Slide>> m_slides;
+    // The surface each effect was last sent for. An Expose only needs to
+    // re-send an effect once the window got a new surface.
+    QHash<QWindow *, wl_surface *> m_blurSurfaces;
+    QHash<QWindow *, wl_surface *> m_contrastSurfaces;
+    QHash<QWindow *, wl_surface *> m_slideSurfaces;
+    // wl_regions already sent for a window, reused as long as the QRegion doesn't change.
+    // Blur and contrast usually share the same region, so a couple of entries suffice.
+    struct CachedRegion {
+        size_t hash;
+        QRegion region;
+        wl_region *wlRegion;
+    };
+    QHash<QWindow *, QList<CachedRegion>> m_regionCache;
     struct SlideData {
         KWindowEffects::SlideFromLocation location;
         int offset;
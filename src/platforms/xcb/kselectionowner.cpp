@@ -6,11 +6,12 @@
 
 #include "kselectionowner.h"
 
+#include "cptr_p.h"
 #include "kwindowsystem.h"
 #include "kxcbevent_p.h"
+#include "kxcbeventdispatcher_p.h"
 #include <config-kwindowsystem.h>
 
-#include <QAbstractNativeEventFilter>
 #include <QBasicTimer>
 #include <QDebug>
 #include <QGuiApplication>
@@ -18,18 +19,9 @@
 
 #include <private/qtx11extras_p.h>
 
-static xcb_window_t get_selection_owner(xcb_connection_t *c, xcb_atom_t selection)
-{
-    xcb_window_t owner = XCB_NONE;
-    xcb_get_selection_owner_reply_t *reply = xcb_get_selection_owner_reply(c, xcb_get_selection_owner(c, selection), nullptr);
-
-    if (reply) {
-        owner = reply->owner;
-        free(reply);
-    }
-
-    return owner;
-}
+#include <iterator>
+#include <type_traits>
+#include <utility>
 
 static xcb_atom_t intern_atom(xcb_connection_t *c, const char *name)
 {
@@ -44,12 +36,15 @@ static xcb_atom_t intern_atom(xcb_connection_t *c, const char *name)
     return atom;
 }
 
-class Q_DECL_HIDDEN KSelectionOwner::Private : public QAbstractNativeEventFilter
+class Q_DECL_HIDDEN KSelectionOwner::Private : public KXcbEventFilter
 {
 public:
+    // The claim only waits for PropertyNotify events on our window: each step issues its
+    // requests followed by a property change, once the event arrives the replies are there.
     enum State {
         Idle,
         WaitingForTimestamp,
+        VerifyingOwnership,
         WaitingForPreviousOwner
     };
 
@@ -61,16 +56,28 @@ public:
         , window(XCB_NONE)
         , prev_owner(XCB_NONE)
         , timestamp(XCB_CURRENT_TIME)
+        , claim_timestamp(XCB_CURRENT_TIME)
         , extra1(0)
         , extra2(0)
+        , force(false)
         , force_kill(false)
         , owner(owner_P)
     {
-        QCoreApplication::instance()->installNativeEventFilter(this);
+        KXcbEventDispatcher *dispatcher = KXcbEventDispatcher::self();
+        dispatcher->subscribe(this, XCB_SELECTION_CLEAR, selection);
+        dispatcher->subscribe(this, XCB_SELECTION_REQUEST, selection);
+        dispatcher->subscribe(this, XCB_SELECTION_NOTIFY, selection);
     }
 
+    ~Private() override;
+
     void claimSucceeded();
-    void gotTimestamp();
+    void updateSubscriptions();
+    void requestAtoms();
+    void collectAtoms();
+    void requestPropertyNotify();
+    void gotTimestamp(xcb_timestamp_t time);
+    void ownershipVerified();
     void timeout();
 
     State state;
@@ -79,10 +86,18 @@ public:
     xcb_window_t root;
     xcb_window_t window;
     xcb_window_t prev_owner;
+    // only set while the selection is owned, ownerWindow() and the event handling rely on it
     xcb_timestamp_t timestamp;
+    // the time the running claim sets the selection owner with
+    xcb_timestamp_t claim_timestamp;
     uint32_t extra1, extra2;
     QBasicTimer timer;
+    bool force;
     bool force_kill;
+    // replies collected by the next step of the claim
+    xcb_intern_atom_cookie_t atom_cookies[4] = {};
+    xcb_get_selection_owner_cookie_t owner_cookie = {0};
+    xcb_void_cookie_t prev_owner_cookie = {0};
     static xcb_atom_t manager_atom;
     static xcb_atom_t xa_multiple;
     static xcb_atom_t xa_targets;
@@ -94,16 +109,16 @@ public:
     static Private *create(KSelectionOwner *owner, const char *selection_P, xcb_connection_t *c, xcb_window_t root);
 
 protected:
-    bool nativeEventFilter(const QByteArray &eventType, void *message, qintptr *) override
+    bool xcbEventFilter(xcb_generic_event_t *event) override
     {
-        if (eventType != "xcb_generic_event_t") {
-            return false;
-        }
-        return owner->filterEvent(message);
+        return owner->filterEvent(event);
     }
 
 private:
     KSelectionOwner *owner;
+    // the windows whose events are currently routed to us
+    xcb_window_t subscribed_window = XCB_NONE;
+    xcb_window_t subscribed_prev_owner = XCB_NONE;
 };
 
 KSelectionOwner::Private *KSelectionOwner::Private::create(KSelectionOwner *owner, xcb_atom_t selection_P, int screen_P)
@@ -169,6 +184,81 @@ KSelectionOwner::~KSelectionOwner()
     }
 }
 
+KSelectionOwner::Private::~Private()
+{
+    for (const xcb_intern_atom_cookie_t &cookie : atom_cookies) {
+        if (cookie.sequence) {
+            xcb_discard_reply(connection, cookie.sequence);
+        }
+    }
+    if (owner_cookie.sequence) {
+        xcb_discard_reply(connection, owner_cookie.sequence);
+    }
+    if (prev_owner_cookie.sequence) {
+        xcb_discard_reply(connection, prev_owner_cookie.sequence);
+    }
+}
+
+void KSelectionOwner::Private::requestAtoms()
+{
+    static const char *const names[] = {"MANAGER", "MULTIPLE", "TARGETS", "TIMESTAMP"};
+    static_assert(std::size(names) == std::extent_v<decltype(atom_cookies)>);
+
+    for (size_t i = 0; i < std::size(names); ++i) {
+        atom_cookies[i] = xcb_intern_atom(connection, false, strlen(names[i]), names[i]);
+    }
+}
+
+void KSelectionOwner::Private::collectAtoms()
+{
+    xcb_atom_t *atoms[] = {&manager_atom, &xa_multiple, &xa_targets, &xa_timestamp};
+
+    for (size_t i = 0; i < std::size(atoms); ++i) {
+        if (!atom_cookies[i].sequence) {
+            continue;
+        }
+        UniqueCPointer<xcb_intern_atom_reply_t> reply(xcb_intern_atom_reply(connection, std::exchange(atom_cookies[i], {0}), nullptr));
+        if (reply) {
+            *atoms[i] = reply->atom;
+        }
+    }
+}
+
+void KSelectionOwner::Private::requestPropertyNotify()
+{
+    // The PropertyNotify carries a timestamp and tells that the requests before it were answered
+    xcb_atom_t tmp = XCB_ATOM_ATOM;
+    xcb_change_property(connection, XCB_PROP_MODE_REPLACE, window, XCB_ATOM_ATOM, XCB_ATOM_ATOM, 32, 1, (const void *)&tmp);
+    xcb_flush(connection);
+}
+
+void KSelectionOwner::Private::updateSubscriptions()
+{
+    KXcbEventDispatcher *dispatcher = KXcbEventDispatcher::self();
+
+    if (subscribed_window != window) {
+        if (subscribed_window != XCB_NONE) {
+            dispatcher->unsubscribe(this, XCB_DESTROY_NOTIFY, subscribed_window);
+            dispatcher->unsubscribe(this, XCB_PROPERTY_NOTIFY, subscribed_window);
+        }
+        subscribed_window = window;
+        if (subscribed_window != XCB_NONE) {
+            dispatcher->subscribe(this, XCB_DESTROY_NOTIFY, subscribed_window);
+            dispatcher->subscribe(this, XCB_PROPERTY_NOTIFY, subscribed_window);
+        }
+    }
+
+    if (subscribed_prev_owner != prev_owner) {
+        if (subscribed_prev_owner != XCB_NONE) {
+            dispatcher->unsubscribe(this, XCB_DESTROY_NOTIFY, subscribed_prev_owner);
+        }
+        subscribed_prev_owner = prev_owner;
+        if (subscribed_prev_owner != XCB_NONE) {
+            dispatcher->subscribe(this, XCB_DESTROY_NOTIFY, subscribed_prev_owner);
+        }
+    }
+}
+
 void KSelectionOwner::Private::claimSucceeded()
 {
     state = Idle;
@@ -191,28 +281,82 @@ void KSelectionOwner::Private::claimSucceeded()
     Q_EMIT owner->claimedOwnership();
 }
 
-void KSelectionOwner::Private::gotTimestamp()
+void KSelectionOwner::Private::gotTimestamp(xcb_timestamp_t time)
 {
     Q_ASSERT(state == WaitingForTimestamp);
 
     state = Idle;
+    claim_timestamp = time;
 
     xcb_connection_t *c = connection;
 
-    // Set the selection owner and immediately verify that the claim was successful
-    xcb_set_selection_owner(c, window, selection, timestamp);
-    xcb_window_t new_owner = get_selection_owner(c, selection);
+    // The atoms and the current owner were requested together with the timestamp
+    if (atom_cookies[0].sequence) {
+        collectAtoms();
+        owner->getAtoms();
+    }
+
+    UniqueCPointer<xcb_get_selection_owner_reply_t> owner_reply(xcb_get_selection_owner_reply(c, std::exchange(owner_cookie, {0}), nullptr));
+    prev_owner = owner_reply ? owner_reply->owner : XCB_NONE;
+
+    if (prev_owner != XCB_NONE) {
+        if (!force) {
+            // qDebug() << "Selection already owned, failing";
+            xcb_destroy_window(c, window);
+            window = XCB_NONE;
+            updateSubscriptions();
+
+            Q_EMIT owner->failedToClaimOwnership();
+            return;
+        }
+
+        // Select structure notify events so get an event when the previous owner
+        // destroys the window, an error means it is already gone
+        uint32_t mask = XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+        prev_owner_cookie = xcb_change_window_attributes_checked(c, prev_owner, XCB_CW_EVENT_MASK, &mask);
+        updateSubscriptions();
+    }
+
+    // Set the selection owner and verify with the next PropertyNotify that the claim was successful
+    xcb_set_selection_owner(c, window, selection, claim_timestamp);
+    owner_cookie = xcb_get_selection_owner(c, selection);
+    state = VerifyingOwnership;
+    requestPropertyNotify();
+}
+
+void KSelectionOwner::Private::ownershipVerified()
+{
+    Q_ASSERT(state == VerifyingOwnership);
+
+    state = Idle;
+
+    xcb_connection_t *c = connection;
+
+    UniqueCPointer<xcb_get_selection_owner_reply_t> owner_reply(xcb_get_selection_owner_reply(c, std::exchange(owner_cookie, {0}), nullptr));
+    const xcb_window_t new_owner = owner_reply ? owner_reply->owner : XCB_NONE;
+
+    if (prev_owner_cookie.sequence) {
+        // answered before the PropertyNotify, so this doesn't block
+        UniqueCPointer<xcb_generic_error_t> err(xcb_request_check(c, std::exchange(prev_owner_cookie, {0})));
+        if (err) {
+            prev_owner = XCB_NONE;
+            updateSubscriptions();
+        }
+    }
 
     if (new_owner != window) {
         // qDebug() << "Failed to claim selection : " << new_owner;
         xcb_destroy_window(c, window);
-        timestamp = XCB_CURRENT_TIME;
         window = XCB_NONE;
+        updateSubscriptions();
 
         Q_EMIT owner->failedToClaimOwnership();
         return;
     }
 
+    // the selection is ours from here on
+    timestamp = claim_timestamp;
+
     if (prev_owner != XCB_NONE && force_kill) {
         // qDebug() << "Waiting for previous owner to disown";
         timer.start(1000, owner);
@@ -253,29 +397,19 @@ void KSelectionOwner::claim(bool force_P, bool force_kill_P)
     }
     Q_ASSERT(d->state == Private::Idle);
 
-    if (Private::manager_atom == XCB_NONE) {
-        getAtoms();
-    }
-
     if (d->timestamp != XCB_CURRENT_TIME) {
         release();
     }
 
     xcb_connection_t *c = d->connection;
-    d->prev_owner = get_selection_owner(c, d->selection);
-
-    if (d->prev_owner != XCB_NONE) {
-        if (!force_P) {
-            // qDebug() << "Selection already owned, failing";
-            Q_EMIT failedToClaimOwnership();
-            return;
-        }
 
-        // Select structure notify events so get an event when the previous owner
-        // destroys the window
-        uint32_t mask = XCB_EVENT_MASK_STRUCTURE_NOTIFY;
-        xcb_change_window_attributes(c, d->prev_owner, XCB_CW_EVENT_MASK, &mask);
+    // Nothing is waited for here: the atoms and the current owner are requested in
+    // the same batch as the property change providing the timestamp
+    if (Private::manager_atom == XCB_NONE) {
+        d->requestAtoms();
     }
+    d->owner_cookie = xcb_get_selection_owner(c, d->selection);
+    d->prev_owner = XCB_NONE;
 
     uint32_t values[] = {true, XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY};
 
@@ -293,14 +427,13 @@ void KSelectionOwner::claim(bool force_P, bool force_kill_P)
                       XCB_COPY_FROM_PARENT,
                       XCB_CW_OVERRIDE_REDIRECT | XCB_CW_EVENT_MASK,
                       values);
-
-    // Trigger a property change event so we get a timestamp
-    xcb_atom_t tmp = XCB_ATOM_ATOM;
-    xcb_change_property(c, XCB_PROP_MODE_REPLACE, d->window, XCB_ATOM_ATOM, XCB_ATOM_ATOM, 32, 1, (const void *)&tmp);
+    d->updateSubscriptions();
 
     // Now we have to return to the event loop and wait for the property change event
+    d->force = force_P;
     d->force_kill = force_kill_P;
     d->state = Private::WaitingForTimestamp;
+    d->requestPropertyNotify();
 }
 
 // destroy resource first
@@ -309,12 +442,23 @@ void KSelectionOwner::release()
     if (!d) {
         return;
     }
-    if (d->timestamp == XCB_CURRENT_TIME) {
+    // a claim waiting for its verification has set the selection owner already
+    if (d->timestamp == XCB_CURRENT_TIME && d->state != Private::VerifyingOwnership) {
         return;
     }
 
     xcb_destroy_window(d->connection, d->window); // also makes the selection not owned
     d->window = XCB_NONE;
+    d->updateSubscriptions();
+
+    // a claim waiting for its verification is abandoned
+    if (d->state == Private::VerifyingOwnership) {
+        d->state = Private::Idle;
+        xcb_discard_reply(d->connection, std::exchange(d->owner_cookie, {0}).sequence);
+        if (d->prev_owner_cookie.sequence) {
+            xcb_discard_reply(d->connection, std::exchange(d->prev_owner_cookie, {0}).sequence);
+        }
+    }
 
     // qDebug() << "Releasing selection";
 
@@ -389,6 +533,7 @@ bool KSelectionOwner::filterEvent(void *ev_P)
             // It is possible for the previous owner to be destroyed
             // while we're waiting for the timestamp
             d->prev_owner = XCB_NONE;
+            d->updateSubscriptions();
         }
 
         if (d->timestamp == XCB_CURRENT_TIME || ev->window != d->window) {
@@ -415,8 +560,11 @@ bool KSelectionOwner::filterEvent(void *ev_P)
     case XCB_PROPERTY_NOTIFY: {
         xcb_property_notify_event_t *ev = reinterpret_cast<xcb_property_notify_event_t *>(event);
         if (ev->window == d->window && d->state == Private::WaitingForTimestamp) {
-            d->timestamp = ev->time;
-            d->gotTimestamp();
+            d->gotTimestamp(ev->time);
+            return true;
+        }
+        if (ev->window == d->window && d->state == Private::VerifyingOwnership) {
+            d->ownershipVerified();
             return true;
         }
         return false;
@@ -586,29 +734,8 @@ void KSelectionOwner::getAtoms()
         return;
     }
 
-    xcb_connection_t *c = d->connection;
-
-    struct {
-        const char *name;
-        xcb_atom_t *atom;
-    } atoms[] = {{"MANAGER", &Private::manager_atom},
-                 {"MULTIPLE", &Private::xa_multiple},
-                 {"TARGETS", &Private::xa_targets},
-                 {"TIMESTAMP", &Private::xa_timestamp}};
-
-    const int count = sizeof(atoms) / sizeof(atoms[0]);
-    xcb_intern_atom_cookie_t cookies[count];
-
-    for (int i = 0; i < count; i++) {
-        cookies[i] = xcb_intern_atom(c, false, strlen(atoms[i].name), atoms[i].name);
-    }
-
-    for (int i = 0; i < count; i++) {
-        if (xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(c, cookies[i], nullptr)) {
-            *atoms[i].atom = reply->atom;
-            free(reply);
-        }
-    }
+    d->requestAtoms();
+    d->collectAtoms();
 }
 
 xcb_atom_t KSelectionOwner::Private::manager_atom = XCB_NONE;
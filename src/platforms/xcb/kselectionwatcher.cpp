@@ -6,14 +6,17 @@
 
 #include "kselectionwatcher.h"
 
+#include "cptr_p.h"
 #include "kwindowsystem.h"
+#include "kxcbeventdispatcher_p.h"
 #include <config-kwindowsystem.h>
 
-#include <QAbstractNativeEventFilter>
 #include <QCoreApplication>
 
 #include <private/qtx11extras_p.h>
 
+#include <utility>
+
 static xcb_window_t get_selection_owner(xcb_connection_t *c, xcb_atom_t selection)
 {
     xcb_window_t owner = XCB_NONE;
@@ -44,37 +47,86 @@ static xcb_atom_t intern_atom(xcb_connection_t *c, const char *name)
 // KSelectionWatcher
 //*!*****************************************
 
-class Q_DECL_HIDDEN KSelectionWatcher::Private : public QAbstractNativeEventFilter
+class Q_DECL_HIDDEN KSelectionWatcher::Private : public KXcbEventFilter
 {
 public:
-    Private(KSelectionWatcher *watcher_P, xcb_atom_t selection_P, xcb_connection_t *c, xcb_window_t root)
+    Private(KSelectionWatcher *watcher_P, xcb_atom_t selection_P, xcb_connection_t *c, xcb_window_t root, QueryMode mode)
         : connection(c)
         , root(root)
         , selection(selection_P)
         , selection_owner(XCB_NONE)
+        , asynchronous(mode == QueryMode::Asynchronous)
         , watcher(watcher_P)
     {
-        QCoreApplication::instance()->installNativeEventFilter(this);
     }
+    ~Private() override;
+
+    // Only the destruction of the current owner is of interest
+    void setSelectionOwner(xcb_window_t owner)
+    {
+        if (owner == selection_owner) {
+            return;
+        }
+        if (selection_owner != XCB_NONE) {
+            KXcbEventDispatcher::self()->unsubscribe(this, XCB_DESTROY_NOTIFY, selection_owner);
+        }
+        selection_owner = owner;
+        if (selection_owner != XCB_NONE) {
+            KXcbEventDispatcher::self()->subscribe(this, XCB_DESTROY_NOTIFY, selection_owner);
+        }
+    }
+
+    // The asynchronous mode mirrors KSelectionWatcher::init() and owner() as a state machine.
+    // Each step issues its requests followed by a property change on syncWindow; once its
+    // PropertyNotify arrives all replies of the step have been received and can be read
+    // without blocking.
+    enum class Step {
+        Idle,
+        ResolvingAtoms,
+        QueryingOwner,
+        VerifyingOwner,
+    };
+    void startAsync();
+    void queryOwnerAsync();
+    void requestSync();
+    void syncReached();
 
     xcb_connection_t *connection;
     xcb_window_t root;
-    const xcb_atom_t selection;
+    xcb_atom_t selection;
     xcb_window_t selection_owner;
     static xcb_atom_t manager_atom;
 
-    static Private *create(KSelectionWatcher *watcher, xcb_atom_t selection_P, int screen_P);
-    static Private *create(KSelectionWatcher *watcher, const char *selection_P, int screen_P);
-    static Private *create(KSelectionWatcher *watcher, xcb_atom_t selection_P, xcb_connection_t *c, xcb_window_t root);
-    static Private *create(KSelectionWatcher *watcher, const char *selection_P, xcb_connection_t *c, xcb_window_t root);
+    const bool asynchronous;
+    Step step = Step::Idle;
+    bool requery = false;
+    bool lostPending = false;
+    xcb_window_t syncWindow = XCB_NONE;
+    xcb_window_t candidate = XCB_NONE;
+    xcb_intern_atom_cookie_t selectionCookie = {0};
+    xcb_intern_atom_cookie_t managerCookie = {0};
+    xcb_get_window_attributes_cookie_t rootAttributesCookie = {0};
+    xcb_get_selection_owner_cookie_t ownerCookie = {0};
+    xcb_void_cookie_t selectInputCookie = {0};
+
+    static Private *create(KSelectionWatcher *watcher, xcb_atom_t selection_P, int screen_P, QueryMode mode);
+    static Private *create(KSelectionWatcher *watcher, const char *selection_P, int screen_P, QueryMode mode);
+    static Private *create(KSelectionWatcher *watcher, xcb_atom_t selection_P, xcb_connection_t *c, xcb_window_t root, QueryMode mode);
+    static Private *create(KSelectionWatcher *watcher, const char *selection_P, xcb_connection_t *c, xcb_window_t root, QueryMode mode);
 
 protected:
-    bool nativeEventFilter(const QByteArray &eventType, void *message, qintptr *) override
+    bool xcbEventFilter(xcb_generic_event_t *event) override
     {
-        if (eventType != "xcb_generic_event_t") {
+        if ((event->response_type & ~0x80) == XCB_PROPERTY_NOTIFY) {
+            if (reinterpret_cast<xcb_property_notify_event_t *>(event)->window == syncWindow) {
+                // may delete this
+                syncReached();
+                return true;
+            }
             return false;
         }
-        watcher->filterEvent(message);
+        // may delete this
+        watcher->filterEvent(event);
         return false;
     }
 
@@ -82,56 +134,233 @@ private:
     KSelectionWatcher *watcher;
 };
 
-KSelectionWatcher::Private *KSelectionWatcher::Private::create(KSelectionWatcher *watcher, xcb_atom_t selection_P, int screen_P)
+KSelectionWatcher::Private::~Private()
+{
+    // drop the replies nobody is going to read anymore
+    if (selectionCookie.sequence) {
+        xcb_discard_reply(connection, selectionCookie.sequence);
+    }
+    if (managerCookie.sequence) {
+        xcb_discard_reply(connection, managerCookie.sequence);
+        xcb_discard_reply(connection, rootAttributesCookie.sequence);
+    }
+    if (ownerCookie.sequence) {
+        xcb_discard_reply(connection, ownerCookie.sequence);
+    }
+    if (step == Step::VerifyingOwner) {
+        xcb_discard_reply(connection, selectInputCookie.sequence);
+    }
+    if (syncWindow != XCB_NONE) {
+        xcb_destroy_window(connection, syncWindow);
+    }
+}
+
+KSelectionWatcher::Private *KSelectionWatcher::Private::create(KSelectionWatcher *watcher, xcb_atom_t selection_P, int screen_P, QueryMode mode)
 {
     if (KWindowSystem::isPlatformX11()) {
-        return create(watcher, selection_P, QX11Info::connection(), QX11Info::appRootWindow(screen_P));
+        return create(watcher, selection_P, QX11Info::connection(), QX11Info::appRootWindow(screen_P), mode);
     }
     return nullptr;
 }
 
-KSelectionWatcher::Private *KSelectionWatcher::Private::create(KSelectionWatcher *watcher, xcb_atom_t selection_P, xcb_connection_t *c, xcb_window_t root)
+KSelectionWatcher::Private *
+KSelectionWatcher::Private::create(KSelectionWatcher *watcher, xcb_atom_t selection_P, xcb_connection_t *c, xcb_window_t root, QueryMode mode)
 {
-    return new Private(watcher, selection_P, c, root);
+    return new Private(watcher, selection_P, c, root, mode);
 }
 
-KSelectionWatcher::Private *KSelectionWatcher::Private::create(KSelectionWatcher *watcher, const char *selection_P, int screen_P)
+KSelectionWatcher::Private *KSelectionWatcher::Private::create(KSelectionWatcher *watcher, const char *selection_P, int screen_P, QueryMode mode)
 {
     if (KWindowSystem::isPlatformX11()) {
-        return create(watcher, selection_P, QX11Info::connection(), QX11Info::appRootWindow(screen_P));
+        return create(watcher, selection_P, QX11Info::connection(), QX11Info::appRootWindow(screen_P), mode);
     }
     return nullptr;
 }
 
-KSelectionWatcher::Private *KSelectionWatcher::Private::create(KSelectionWatcher *watcher, const char *selection_P, xcb_connection_t *c, xcb_window_t root)
+KSelectionWatcher::Private *
+KSelectionWatcher::Private::create(KSelectionWatcher *watcher, const char *selection_P, xcb_connection_t *c, xcb_window_t root, QueryMode mode)
 {
-    return new Private(watcher, intern_atom(c, selection_P), c, root);
+    if (mode == QueryMode::Asynchronous) {
+        Private *d = new Private(watcher, XCB_NONE, c, root, mode);
+        d->selectionCookie = xcb_intern_atom(c, false, strlen(selection_P), selection_P);
+        return d;
+    }
+    return new Private(watcher, intern_atom(c, selection_P), c, root, mode);
+}
+
+void KSelectionWatcher::Private::requestSync()
+{
+    if (syncWindow == XCB_NONE) {
+        syncWindow = KXcbEventDispatcher::self()->createSyncWindow(this, connection, root);
+    }
+    KXcbEventDispatcher::requestSync(connection, syncWindow);
+}
+
+void KSelectionWatcher::Private::startAsync()
+{
+    if (manager_atom == XCB_NONE) {
+        managerCookie = xcb_intern_atom(connection, false, strlen("MANAGER"), "MANAGER");
+        rootAttributesCookie = xcb_get_window_attributes(connection, root);
+    }
+
+    if (selectionCookie.sequence || managerCookie.sequence) {
+        step = Step::ResolvingAtoms;
+        requestSync();
+        return;
+    }
+
+    KXcbEventDispatcher::self()->subscribe(this, XCB_CLIENT_MESSAGE, manager_atom);
+    queryOwnerAsync();
+}
+
+void KSelectionWatcher::Private::queryOwnerAsync()
+{
+    if (step != Step::Idle) {
+        // ask again once the running query is done, the owner may have changed in between
+        requery = true;
+        return;
+    }
+    // the selection failed to intern, it can't have an owner and asking raises BadAtom
+    if (selection == XCB_NONE) {
+        return;
+    }
+
+    ownerCookie = xcb_get_selection_owner(connection, selection);
+    step = Step::QueryingOwner;
+    requestSync();
+}
+
+void KSelectionWatcher::Private::syncReached()
+{
+    switch (step) {
+    case Step::Idle:
+        return;
+    case Step::ResolvingAtoms:
+        if (selectionCookie.sequence) {
+            UniqueCPointer<xcb_intern_atom_reply_t> reply(xcb_intern_atom_reply(connection, std::exchange(selectionCookie, {0}), nullptr));
+            if (reply) {
+                selection = reply->atom;
+            }
+        }
+        if (managerCookie.sequence) {
+            UniqueCPointer<xcb_intern_atom_reply_t> atomReply(xcb_intern_atom_reply(connection, std::exchange(managerCookie, {0}), nullptr));
+            UniqueCPointer<xcb_get_window_attributes_reply_t> attr(xcb_get_window_attributes_reply(connection, rootAttributesCookie, nullptr));
+            // another watcher may have resolved it meanwhile
+            if (atomReply && manager_atom == XCB_NONE) {
+                manager_atom = atomReply->atom;
+                if (attr && !(attr->your_event_mask & XCB_EVENT_MASK_STRUCTURE_NOTIFY)) {
+                    const uint32_t event_mask = attr->your_event_mask | XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+                    xcb_change_window_attributes(connection, root, XCB_CW_EVENT_MASK, &event_mask);
+                }
+            }
+        }
+        // without the atom the subscription would match every client message, the
+        // owner is still tracked through its DestroyNotify
+        if (manager_atom != XCB_NONE) {
+            KXcbEventDispatcher::self()->subscribe(this, XCB_CLIENT_MESSAGE, manager_atom);
+        }
+        step = Step::Idle;
+        requery = false;
+        queryOwnerAsync();
+        return;
+    case Step::QueryingOwner: {
+        UniqueCPointer<xcb_get_selection_owner_reply_t> reply(xcb_get_selection_owner_reply(connection, std::exchange(ownerCookie, {0}), nullptr));
+        const xcb_window_t current_owner = reply ? reply->owner : XCB_NONE;
+        if (current_owner != XCB_NONE && current_owner != selection_owner) {
+            // We have a new selection owner - select for structure notify events
+            // and verify that the owner didn't change again meanwhile
+            const uint32_t mask = XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+            candidate = current_owner;
+            selectInputCookie = xcb_change_window_attributes_checked(connection, current_owner, XCB_CW_EVENT_MASK, &mask);
+            ownerCookie = xcb_get_selection_owner(connection, selection);
+            step = Step::VerifyingOwner;
+            requestSync();
+            return;
+        }
+        break;
+    }
+    case Step::VerifyingOwner: {
+        UniqueCPointer<xcb_get_selection_owner_reply_t> reply(xcb_get_selection_owner_reply(connection, std::exchange(ownerCookie, {0}), nullptr));
+        // the PropertyNotify came after the request, checking it doesn't block
+        UniqueCPointer<xcb_generic_error_t> err(xcb_request_check(connection, selectInputCookie));
+        const xcb_window_t new_owner = reply ? reply->owner : XCB_NONE;
+        if (!err && candidate == new_owner) {
+            setSelectionOwner(candidate);
+            step = Step::Idle;
+            lostPending = false;
+            if (std::exchange(requery, false)) {
+                queryOwnerAsync();
+            }
+            Q_EMIT watcher->newOwner(selection_owner);
+            return;
+        }
+        // ### This doesn't look right - the selection could have an owner
+        setSelectionOwner(XCB_NONE);
+        break;
+    }
+    }
+
+    step = Step::Idle;
+    if (std::exchange(requery, false)) {
+        queryOwnerAsync();
+    }
+    if (std::exchange(lostPending, false) && selection_owner == XCB_NONE) {
+        Q_EMIT watcher->lostOwner(); // it must be safe to delete 'this' in a slot
+    }
 }
 
 KSelectionWatcher::KSelectionWatcher(xcb_atom_t selection_P, int screen_P, QObject *parent_P)
     : QObject(parent_P)
-    , d(Private::create(this, selection_P, screen_P))
+    , d(Private::create(this, selection_P, screen_P, QueryMode::Synchronous))
 {
     init();
 }
 
 KSelectionWatcher::KSelectionWatcher(const char *selection_P, int screen_P, QObject *parent_P)
     : QObject(parent_P)
-    , d(Private::create(this, selection_P, screen_P))
+    , d(Private::create(this, selection_P, screen_P, QueryMode::Synchronous))
 {
     init();
 }
 
 KSelectionWatcher::KSelectionWatcher(xcb_atom_t selection, xcb_connection_t *c, xcb_window_t root, QObject *parent)
     : QObject(parent)
-    , d(Private::create(this, selection, c, root))
+    , d(Private::create(this, selection, c, root, QueryMode::Synchronous))
 {
     init();
 }
 
 KSelectionWatcher::KSelectionWatcher(const char *selection, xcb_connection_t *c, xcb_window_t root, QObject *parent)
     : QObject(parent)
-    , d(Private::create(this, selection, c, root))
+    , d(Private::create(this, selection, c, root, QueryMode::Synchronous))
+{
+    init();
+}
+
+KSelectionWatcher::KSelectionWatcher(xcb_atom_t selection, QueryMode mode, int screen, QObject *parent)
+    : QObject(parent)
+    , d(Private::create(this, selection, screen, mode))
+{
+    init();
+}
+
+KSelectionWatcher::KSelectionWatcher(const char *selection, QueryMode mode, int screen, QObject *parent)
+    : QObject(parent)
+    , d(Private::create(this, selection, screen, mode))
+{
+    init();
+}
+
+KSelectionWatcher::KSelectionWatcher(xcb_atom_t selection, QueryMode mode, xcb_connection_t *c, xcb_window_t root, QObject *parent)
+    : QObject(parent)
+    , d(Private::create(this, selection, c, root, mode))
+{
+    init();
+}
+
+KSelectionWatcher::KSelectionWatcher(const char *selection, QueryMode mode, xcb_connection_t *c, xcb_window_t root, QObject *parent)
+    : QObject(parent)
+    , d(Private::create(this, selection, c, root, mode))
 {
     init();
 }
@@ -146,6 +375,10 @@ void KSelectionWatcher::init()
     if (!d) {
         return;
     }
+    if (d->asynchronous) {
+        d->startAsync();
+        return;
+    }
     if (Private::manager_atom == XCB_NONE) {
         xcb_connection_t *c = d->connection;
 
@@ -167,6 +400,9 @@ void KSelectionWatcher::init()
         }
     }
 
+    // MANAGER announcements of all selections share the atom, the selection is checked in filterEvent()
+    KXcbEventDispatcher::self()->subscribe(d, XCB_CLIENT_MESSAGE, Private::manager_atom);
+
     owner(); // trigger reading of current selection status
 }
 
@@ -175,6 +411,9 @@ xcb_window_t KSelectionWatcher::owner()
     if (!d) {
         return XCB_WINDOW_NONE;
     }
+    if (d->asynchronous) {
+        return d->selection_owner;
+    }
     xcb_connection_t *c = d->connection;
 
     xcb_window_t current_owner = get_selection_owner(c, d->selection);
@@ -195,11 +434,11 @@ xcb_window_t KSelectionWatcher::owner()
     xcb_generic_error_t *err = xcb_request_check(c, cookie);
 
     if (!err && current_owner == new_owner) {
-        d->selection_owner = current_owner;
+        d->setSelectionOwner(current_owner);
         Q_EMIT newOwner(d->selection_owner);
     } else {
         // ### This doesn't look right - the selection could have an owner
-        d->selection_owner = XCB_NONE;
+        d->setSelectionOwner(XCB_NONE);
     }
 
     if (err) {
@@ -223,7 +462,11 @@ void KSelectionWatcher::filterEvent(void *ev_P)
             return;
         }
         // owner() checks whether the owner changed and emits newOwner()
-        owner();
+        if (d->asynchronous) {
+            d->queryOwnerAsync();
+        } else {
+            owner();
+        }
         return;
     }
     if (response_type == XCB_DESTROY_NOTIFY) {
@@ -232,8 +475,14 @@ void KSelectionWatcher::filterEvent(void *ev_P)
             return;
         }
 
-        d->selection_owner = XCB_NONE; // in case the exactly same ID gets reused as the owner
+        d->setSelectionOwner(XCB_NONE); // in case the exactly same ID gets reused as the owner
 
+        if (d->asynchronous) {
+            // lostOwner() is emitted once the query confirms there's no new owner
+            d->lostPending = true;
+            d->queryOwnerAsync();
+            return;
+        }
         if (owner() == XCB_NONE) {
             Q_EMIT lostOwner(); // it must be safe to delete 'this' in a slot
         }
@@ -33,6 +33,23 @@ class KWINDOWSYSTEM_EXPORT KSelectionWatcher : public QObject
 {
     Q_OBJECT
 public:
+    /*!
+     * How the watcher talks to the X server.
+     *
+     * \value Synchronous
+     *        Constructing the watcher and owner() wait for the X server to answer.
+     * \value Asynchronous
+     *        The selection atom and its owner are requested without waiting for the replies.
+     *        Construction never blocks, the owner is announced with newOwner() once it is known
+     *        and owner() returns the last known owner.
+     *
+     * \since 6.30
+     */
+    enum class QueryMode {
+        Synchronous,
+        Asynchronous,
+    };
+
     /*!
      * This constructor initializes the object, but doesn't perform any
      * operation on the selection.
@@ -86,11 +103,73 @@ public:
      * \since 5.8
      **/
     explicit KSelectionWatcher(const char *selection, xcb_connection_t *c, xcb_window_t root, QObject *parent = nullptr);
+    /*!
+     * \overload
+     * This constructor lets the watcher work asynchronously when \a mode is
+     * QueryMode::Asynchronous, so that several watchers created at startup
+     * don't wait for the X server one after another.
+     *
+     * \a selection atom representing the manager selection
+     *
+     * \a mode whether the owner is queried synchronously
+     *
+     * \a screen X screen, or -1 for default
+     *
+     * \a parent parent object, or nullptr if there is none
+     *
+     * \since 6.30
+     */
+    KSelectionWatcher(xcb_atom_t selection, QueryMode mode, int screen = -1, QObject *parent = nullptr);
+    /*!
+     * \overload
+     *
+     * \a selection name of the manager selection, the atom is interned without blocking in asynchronous mode
+     *
+     * \a mode whether the atom and the owner are queried synchronously
+     *
+     * \a screen X screen, or -1 for default
+     *
+     * \a parent parent object, or nullptr if there is none
+     *
+     * \since 6.30
+     */
+    KSelectionWatcher(const char *selection, QueryMode mode, int screen = -1, QObject *parent = nullptr);
+    /*!
+     * \overload
+     *
+     * \a selection atom representing the manager selection
+     *
+     * \a mode whether the owner is queried synchronously
+     *
+     * \a c the xcb connection this KSelectionWatcher should use
+     *
+     * \a root the root window this KSelectionWatcher should use
+     *
+     * \since 6.30
+     */
+    KSelectionWatcher(xcb_atom_t selection, QueryMode mode, xcb_connection_t *c, xcb_window_t root, QObject *parent = nullptr);
+    /*!
+     * \overload
+     *
+     * \a selection name of the manager selection, the atom is interned without blocking in asynchronous mode
+     *
+     * \a mode whether the atom and the owner are queried synchronously
+     *
+     * \a c the xcb connection this KSelectionWatcher should use
+     *
+     * \a root the root window this KSelectionWatcher should use
+     *
+     * \since 6.30
+     */
+    KSelectionWatcher(const char *selection, QueryMode mode, xcb_connection_t *c, xcb_window_t root, QObject *parent = nullptr);
     ~KSelectionWatcher() override;
     /*!
      * Return the current owner of the manager selection, if any. Note that if the event
      * informing about the owner change is still in the input queue, newOwner() might
      * have been emitted yet.
+     *
+     * In QueryMode::Asynchronous this doesn't ask the X server but returns the owner
+     * last announced with newOwner(), or XCB_NONE if it is not known yet.
      */
     xcb_window_t owner();
     void filterEvent(void *ev_P); // internal
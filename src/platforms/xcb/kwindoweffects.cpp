@@ -73,6 +73,20 @@ bool KWindowEffectsPrivateX11::isEffectAvailable(Effect effect)
     return false;
 }
 
+// the rects of region in the format of the blur and contrast properties
+static QList<uint32_t> regionData(const QRegion &region)
+{
+    // kwin on X uses device pixels, convert from logical
+    const qreal dpr = qApp->devicePixelRatio();
+    const QList<QRect> rects = KWindowEffectsPrivate::simplifiedRects(region);
+    QList<uint32_t> data;
+    data.reserve(rects.size() * 4);
+    for (const QRect &r : rects) {
+        data << std::floor(r.x() * dpr) << std::floor(r.y() * dpr) << std::ceil(r.width() * dpr) << std::ceil(r.height() * dpr);
+    }
+    return data;
+}
+
 void KWindowEffectsPrivateX11::slideWindow(QWindow *window, SlideFromLocation location, int offset)
 {
     xcb_connection_t *c = QX11Info::connection();
@@ -128,14 +142,7 @@ void KWindowEffectsPrivateX11::enableBlurBehind(QWindow *window, bool enable, co
     }
 
     if (enable) {
-        QList<uint32_t> data;
-        data.reserve(region.rectCount() * 4);
-        for (const QRect &r : region) {
-            // kwin on X uses device pixels, convert from logical
-            auto dpr = qApp->devicePixelRatio();
-            data << std::floor(r.x() * dpr) << std::floor(r.y() * dpr) << std::ceil(r.width() * dpr) << std::ceil(r.height() * dpr);
-        }
-
+        const QList<uint32_t> data = regionData(region);
         xcb_change_property(c, XCB_PROP_MODE_REPLACE, window->winId(), atom->atom, XCB_ATOM_CARDINAL, 32, data.size(), data.constData());
     } else {
         xcb_delete_property(c, window->winId(), atom->atom);
@@ -153,12 +160,8 @@ void KWindowEffectsPrivateX11::enableBackgroundContrast(QWindow *window, bool en
     }
 
     if (enable) {
-        QList<uint32_t> data;
-        data.reserve(region.rectCount() * 4 + 16);
-        for (const QRect &r : region) {
-            auto dpr = qApp->devicePixelRatio();
-            data << std::floor(r.x() * dpr) << std::floor(r.y() * dpr) << std::ceil(r.width() * dpr) << std::ceil(r.height() * dpr);
-        }
+        QList<uint32_t> data = regionData(region);
+        data.reserve(data.size() + 16);
 
         QMatrix4x4 satMatrix; // saturation
         QMatrix4x4 intMatrix; // intensity
@@ -22,6 +22,7 @@ public:
                                   qreal intensity = 1,
                                   qreal saturation = 1,
                                   const QRegion &region = QRegion()) override;
+
 };
 
 #endif
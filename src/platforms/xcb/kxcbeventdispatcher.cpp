@@ -0,0 +1,177 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "kxcbeventdispatcher_p.h"
+
+#include <QCoreApplication>
+
+#include <algorithm>
+#include <iterator>
+
+Q_GLOBAL_STATIC(KXcbEventDispatcher, s_dispatcher)
+
+KXcbEventFilter::~KXcbEventFilter()
+{
+    if (!s_dispatcher.isDestroyed()) {
+        s_dispatcher->unsubscribe(this);
+    }
+}
+
+KXcbEventDispatcher *KXcbEventDispatcher::self()
+{
+    return s_dispatcher();
+}
+
+void KXcbEventDispatcher::ensureInstalled()
+{
+    QCoreApplication *app = QCoreApplication::instance();
+    if (app && app != m_installedOn) {
+        app->installNativeEventFilter(this);
+        m_installedOn = app;
+    }
+}
+
+void KXcbEventDispatcher::subscribe(KXcbEventFilter *filter, uint8_t responseType, uint32_t key)
+{
+    ensureInstalled();
+
+    Route &route = m_routes[responseType & ~0x80];
+    if (key == XCB_NONE) {
+        if (!route.any.contains(filter)) {
+            route.any.append(filter);
+        }
+    } else if (!route.byKey.contains(key, filter)) {
+        route.byKey.insert(key, filter);
+    }
+}
+
+void KXcbEventDispatcher::unsubscribe(KXcbEventFilter *filter, uint8_t responseType, uint32_t key)
+{
+    Route &route = m_routes[responseType & ~0x80];
+    if (key == XCB_NONE) {
+        route.any.removeAll(filter);
+    } else {
+        route.byKey.remove(key, filter);
+    }
+}
+
+void KXcbEventDispatcher::unsubscribe(KXcbEventFilter *filter, uint8_t responseType)
+{
+    Route &route = m_routes[responseType & ~0x80];
+    route.any.removeAll(filter);
+    route.byKey.removeIf([filter](const auto &it) {
+        return it.value() == filter;
+    });
+}
+
+void KXcbEventDispatcher::unsubscribe(KXcbEventFilter *filter)
+{
+    for (uint8_t responseType = 0; responseType < std::size(m_routes); ++responseType) {
+        if (!m_routes[responseType].any.isEmpty() || !m_routes[responseType].byKey.isEmpty()) {
+            unsubscribe(filter, responseType);
+        }
+    }
+
+    for (Targets *targets : std::as_const(m_dispatching)) {
+        std::replace(targets->begin(), targets->end(), filter, static_cast<KXcbEventFilter *>(nullptr));
+    }
+}
+
+xcb_window_t KXcbEventDispatcher::createSyncWindow(KXcbEventFilter *filter, xcb_connection_t *c, xcb_window_t root)
+{
+    const uint32_t values[] = {true, XCB_EVENT_MASK_PROPERTY_CHANGE};
+    const xcb_window_t window = xcb_generate_id(c);
+    xcb_create_window(c,
+                      XCB_COPY_FROM_PARENT,
+                      window,
+                      root,
+                      0,
+                      0,
+                      1,
+                      1,
+                      0,
+                      XCB_WINDOW_CLASS_INPUT_ONLY,
+                      XCB_COPY_FROM_PARENT,
+                      XCB_CW_OVERRIDE_REDIRECT | XCB_CW_EVENT_MASK,
+                      values);
+    subscribe(filter, XCB_PROPERTY_NOTIFY, window);
+    return window;
+}
+
+void KXcbEventDispatcher::requestSync(xcb_connection_t *c, xcb_window_t syncWindow)
+{
+    const xcb_atom_t marker = XCB_ATOM_ATOM;
+    xcb_change_property(c, XCB_PROP_MODE_REPLACE, syncWindow, XCB_ATOM_ATOM, XCB_ATOM_ATOM, 32, 1, &marker);
+    xcb_flush(c);
+}
+
+uint32_t KXcbEventDispatcher::routingKey(const xcb_generic_event_t *event)
+{
+    switch (event->response_type & ~0x80) {
+    case XCB_CLIENT_MESSAGE:
+        return reinterpret_cast<const xcb_client_message_event_t *>(event)->type;
+    case XCB_SELECTION_CLEAR:
+        return reinterpret_cast<const xcb_selection_clear_event_t *>(event)->selection;
+    case XCB_SELECTION_REQUEST:
+        return reinterpret_cast<const xcb_selection_request_event_t *>(event)->selection;
+    case XCB_SELECTION_NOTIFY:
+        return reinterpret_cast<const xcb_selection_notify_event_t *>(event)->selection;
+    case XCB_PROPERTY_NOTIFY:
+        return reinterpret_cast<const xcb_property_notify_event_t *>(event)->window;
+    case XCB_CONFIGURE_NOTIFY:
+        return reinterpret_cast<const xcb_configure_notify_event_t *>(event)->window;
+    case XCB_DESTROY_NOTIFY:
+        return reinterpret_cast<const xcb_destroy_notify_event_t *>(event)->window;
+    case XCB_MAP_NOTIFY:
+        return reinterpret_cast<const xcb_map_notify_event_t *>(event)->window;
+    case XCB_UNMAP_NOTIFY:
+        return reinterpret_cast<const xcb_unmap_notify_event_t *>(event)->window;
+    default:
+        return XCB_NONE;
+    }
+}
+
+bool KXcbEventDispatcher::dispatch(xcb_generic_event_t *event)
+{
+    const Route &route = m_routes[event->response_type & ~0x80];
+    if (route.any.isEmpty() && route.byKey.isEmpty()) {
+        return false;
+    }
+
+    // filters may (un)subscribe or get destroyed from within their callback, so work on a copy
+    Targets targets;
+    if (!route.byKey.isEmpty()) {
+        const auto [begin, end] = route.byKey.equal_range(routingKey(event));
+        for (auto it = begin; it != end; ++it) {
+            targets.append(*it);
+        }
+    }
+    // like Qt, the most recently subscribed filter comes first
+    for (auto it = route.any.crbegin(); it != route.any.crend(); ++it) {
+        targets.append(*it);
+    }
+
+    m_dispatching.append(&targets);
+    bool filtered = false;
+    for (KXcbEventFilter *filter : targets) {
+        if (filter && filter->xcbEventFilter(event)) {
+            filtered = true;
+            break;
+        }
+    }
+    m_dispatching.removeLast();
+
+    return filtered;
+}
+
+bool KXcbEventDispatcher::nativeEventFilter(const QByteArray &eventType, void *message, qintptr *)
+{
+    if (eventType != "xcb_generic_event_t") {
+        return false;
+    }
+    return dispatch(static_cast<xcb_generic_event_t *>(message));
+}
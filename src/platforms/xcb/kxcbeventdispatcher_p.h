@@ -0,0 +1,87 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#ifndef KXCBEVENTDISPATCHER_P_H
+#define KXCBEVENTDISPATCHER_P_H
+
+#include <QAbstractNativeEventFilter>
+#include <QList>
+#include <QMultiHash>
+#include <QVarLengthArray>
+
+#include <xcb/xcb.h>
+
+class QCoreApplication;
+
+/*!
+   Receives the xcb events a filter subscribed to at the KXcbEventDispatcher.
+   Destroying the filter drops all its subscriptions.
+   \internal
+**/
+class KXcbEventFilter
+{
+public:
+    virtual ~KXcbEventFilter();
+
+    /*!
+       Returns true to stop the event from reaching other filters and Qt.
+    **/
+    virtual bool xcbEventFilter(xcb_generic_event_t *event) = 0;
+};
+
+/*!
+   The single native event filter of the library. Instead of every consumer inspecting
+   every event of the application connection, the events are demultiplexed by their
+   response type and a routing key, and only handed to the filters subscribed to them.
+
+   The routing key is the message type for client messages, the selection for selection
+   clear, request and notify events, and the window for property, configure, destroy,
+   map and unmap notify events. Filters subscribed with XCB_NONE as key get every event
+   of the response type.
+   \internal
+**/
+class KXcbEventDispatcher : public QAbstractNativeEventFilter
+{
+public:
+    static KXcbEventDispatcher *self();
+
+    void subscribe(KXcbEventFilter *filter, uint8_t responseType, uint32_t key = XCB_NONE);
+    void unsubscribe(KXcbEventFilter *filter, uint8_t responseType, uint32_t key);
+    void unsubscribe(KXcbEventFilter *filter, uint8_t responseType);
+    void unsubscribe(KXcbEventFilter *filter);
+
+    /*!
+       Creates a 1x1 InputOnly window below \a root that reports its property changes
+       and subscribes \a filter to them. After requestSync() on it the filter gets a
+       PropertyNotify once all requests sent before were handled, so the replies to them
+       can be taken without blocking. The caller destroys the window.
+    **/
+    xcb_window_t createSyncWindow(KXcbEventFilter *filter, xcb_connection_t *c, xcb_window_t root);
+    static void requestSync(xcb_connection_t *c, xcb_window_t syncWindow);
+
+    bool dispatch(xcb_generic_event_t *event);
+    static uint32_t routingKey(const xcb_generic_event_t *event);
+
+    bool nativeEventFilter(const QByteArray &eventType, void *message, qintptr *result) override;
+
+private:
+    struct Route {
+        QList<KXcbEventFilter *> any;
+        QMultiHash<uint32_t, KXcbEventFilter *> byKey;
+    };
+    using Targets = QVarLengthArray<KXcbEventFilter *, 8>;
+
+    void ensureInstalled();
+
+    // indexed by the response type without the send event bit
+    Route m_routes[128];
+    // targets of the dispatches in progress, filters destroyed meanwhile are reset to nullptr
+    QList<Targets *> m_dispatching;
+    QCoreApplication *m_installedOn = nullptr;
+};
+
+#endif
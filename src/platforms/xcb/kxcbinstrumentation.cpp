@@ -0,0 +1,183 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "kxcbinstrumentation_p.h"
+#include "kwindowsystem_xcb_requests_debug.h"
+#include "kxcbtrace_p.h"
+
+#include <QCoreApplication>
+#include <QMutex>
+
+#include <xcb/xcbext.h>
+
+#include <algorithm>
+
+namespace KXcbInstrumentation
+{
+std::atomic<int> s_mode{qEnvironmentVariableIsSet("KWINDOWSYSTEM_XCB_STATISTICS") ? Statistics : 0};
+
+static const bool s_dumpAtExit = qEnvironmentVariableIsSet("KWINDOWSYSTEM_XCB_STATISTICS");
+static std::atomic<bool> s_dumpRegistered{false};
+
+struct Statistics {
+    QMutex mutex;
+    QHash<QString, KX11Extras::RequestStatistics> functions;
+};
+Q_GLOBAL_STATIC(Statistics, s_statistics)
+
+// replies taken by the outermost scope of the thread
+struct ActiveScope {
+    int depth = 0;
+    quint64 replies = 0;
+    quint64 blockingWaits = 0;
+    std::chrono::nanoseconds waitTime{0};
+};
+static thread_local ActiveScope t_scope;
+
+static void merge(const QString &function, const KX11Extras::RequestStatistics &add)
+{
+    QMutexLocker locker(&s_statistics->mutex);
+    KX11Extras::RequestStatistics &statistics = s_statistics->functions[function];
+    statistics.calls += add.calls;
+    statistics.requests += add.requests;
+    statistics.replies += add.replies;
+    statistics.blockingWaits += add.blockingWaits;
+    statistics.waitTime += add.waitTime;
+    statistics.bytesSent += add.bytesSent;
+    statistics.bytesReceived += add.bytesReceived;
+}
+
+void setMode(Mode mode, bool on)
+{
+    if (on) {
+        s_mode.fetch_or(mode, std::memory_order_relaxed);
+    } else {
+        s_mode.fetch_and(~mode, std::memory_order_relaxed);
+    }
+}
+
+void setEnabled(bool enabled)
+{
+    setMode(Statistics, enabled);
+}
+
+QHash<QString, KX11Extras::RequestStatistics> statistics()
+{
+    QMutexLocker locker(&s_statistics->mutex);
+    return s_statistics->functions;
+}
+
+void reset()
+{
+    QMutexLocker locker(&s_statistics->mutex);
+    s_statistics->functions.clear();
+}
+
+void dump()
+{
+    const QHash<QString, KX11Extras::RequestStatistics> functions = statistics();
+    QList<QString> names = functions.keys();
+    std::sort(names.begin(), names.end(), [&functions](const QString &a, const QString &b) {
+        return functions[a].waitTime > functions[b].waitTime;
+    });
+    for (const QString &name : std::as_const(names)) {
+        const KX11Extras::RequestStatistics &s = functions[name];
+        qCInfo(LOG_KWINDOWSYSTEM_XCB_REQUESTS).nospace() << name << ": " << s.calls << " calls, " << s.requests << " requests, " << s.replies << " replies, "
+                                                         << s.blockingWaits << " blocking waits, " << std::chrono::duration<double, std::milli>(s.waitTime).count()
+                                                         << " ms waited, " << s.bytesSent << " bytes sent, " << s.bytesReceived << " bytes received";
+    }
+}
+
+void Scope::begin(xcb_connection_t *c, const char *function)
+{
+    m_function = function;
+    if (t_scope.depth++ > 0 || !c || xcb_connection_has_error(c)) {
+        return;
+    }
+    m_outermost = true;
+    m_connection = c;
+    t_scope.replies = 0;
+    t_scope.blockingWaits = 0;
+    t_scope.waitTime = std::chrono::nanoseconds(0);
+
+    // the sequence of a no-op request tells how many requests are sent in between, the flush
+    // keeps the bytes of earlier calls out of this one
+    m_sequence = xcb_no_operation(c).sequence;
+    xcb_flush(c);
+    m_written = xcb_total_written(c);
+    m_read = xcb_total_read(c);
+}
+
+void Scope::end()
+{
+    --t_scope.depth;
+    if (!m_outermost) {
+        return;
+    }
+
+    const unsigned int sequence = xcb_no_operation(m_connection).sequence;
+    xcb_flush(m_connection);
+    // the closing no-op is not part of the call
+    const uint64_t written = xcb_total_written(m_connection) - m_written;
+
+    KX11Extras::RequestStatistics statistics;
+    statistics.calls = 1;
+    statistics.requests = sequence - m_sequence - 1;
+    statistics.replies = t_scope.replies;
+    statistics.blockingWaits = t_scope.blockingWaits;
+    statistics.waitTime = t_scope.waitTime;
+    statistics.bytesSent = written > 4 ? written - 4 : 0;
+    statistics.bytesReceived = xcb_total_read(m_connection) - m_read;
+    merge(QString::fromLatin1(m_function), statistics);
+
+    if (s_dumpAtExit && QCoreApplication::instance() && !s_dumpRegistered.exchange(true)) {
+        qAddPostRoutine(dump);
+    }
+}
+
+void *waitForReply(xcb_connection_t *c, unsigned int sequence, xcb_generic_error_t **e)
+{
+    const int mode = s_mode.load(std::memory_order_relaxed);
+    void *reply = nullptr;
+    if ((mode & Replaying) && KXcbTrace::replayReply(c, &reply)) {
+        if (e) {
+            *e = nullptr;
+        }
+        return reply;
+    }
+
+    bool blocked = false;
+    std::chrono::nanoseconds waited(0);
+    if (!xcb_poll_for_reply(c, sequence, &reply, e)) {
+        blocked = true;
+        const auto start = std::chrono::steady_clock::now();
+        reply = xcb_wait_for_reply(c, sequence, e);
+        waited = std::chrono::steady_clock::now() - start;
+    }
+
+    if (mode & Recording) {
+        KXcbTrace::recordReply(c, reply);
+    }
+    if (!(mode & Statistics)) {
+        return reply;
+    }
+
+    if (t_scope.depth > 0) {
+        ++t_scope.replies;
+        t_scope.blockingWaits += blocked;
+        t_scope.waitTime += waited;
+        return reply;
+    }
+
+    KX11Extras::RequestStatistics statistics;
+    statistics.replies = 1;
+    statistics.blockingWaits = blocked;
+    statistics.waitTime = waited;
+    merge(QStringLiteral("(unattributed)"), statistics);
+    return reply;
+}
+}
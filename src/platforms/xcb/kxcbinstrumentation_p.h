@@ -0,0 +1,97 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#ifndef KXCBINSTRUMENTATION_P_H
+#define KXCBINSTRUMENTATION_P_H
+
+#include "kx11extras.h"
+#include <kwindowsystem_export.h>
+
+#include <atomic>
+#include <xcb/xcb.h>
+
+/*!
+   Accounting of the X traffic behind KX11Extras::requestStatistics().
+
+   A Scope placed at the top of a public function attributes the requests, replies and
+   bytes of its connection to that function for as long as it lives. Only the outermost
+   scope of a thread records, nested ones are accounted to it. Blocking replies have to
+   be taken through reply() to be counted.
+
+   Replies taken through reply() are also what KXcbTrace records and replays.
+
+   While neither is active both cost a relaxed atomic load. Exported for the copy of
+   kxutils.cpp in the X11 plugin.
+   \internal
+**/
+namespace KXcbInstrumentation
+{
+enum Mode {
+    Statistics = 0x1,
+    Recording = 0x2,
+    Replaying = 0x4,
+};
+extern KWINDOWSYSTEM_EXPORT std::atomic<int> s_mode;
+
+inline bool isEnabled()
+{
+    return s_mode.load(std::memory_order_relaxed) & Statistics;
+}
+
+void setMode(Mode mode, bool on);
+void setEnabled(bool enabled);
+QHash<QString, KX11Extras::RequestStatistics> statistics();
+void reset();
+void dump();
+
+class KWINDOWSYSTEM_EXPORT Scope
+{
+public:
+    Scope(xcb_connection_t *c, const char *function)
+    {
+        if (isEnabled()) {
+            begin(c, function);
+        }
+    }
+    ~Scope()
+    {
+        if (m_function) {
+            end();
+        }
+    }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+private:
+    void begin(xcb_connection_t *c, const char *function);
+    void end();
+
+    xcb_connection_t *m_connection = nullptr;
+    const char *m_function = nullptr;
+    bool m_outermost = false;
+    unsigned int m_sequence = 0;
+    uint64_t m_written = 0;
+    uint64_t m_read = 0;
+};
+
+KWINDOWSYSTEM_EXPORT void *waitForReply(xcb_connection_t *c, unsigned int sequence, xcb_generic_error_t **e);
+
+/*!
+   Takes the reply of \a cookie like \a replyFunction does, counting whether it had to be
+   waited for and for how long.
+**/
+template<typename Reply, typename Cookie>
+inline Reply *reply(Reply *(*replyFunction)(xcb_connection_t *, Cookie, xcb_generic_error_t **), xcb_connection_t *c, Cookie cookie, xcb_generic_error_t **e)
+{
+    if (!s_mode.load(std::memory_order_relaxed)) {
+        return replyFunction(c, cookie, e);
+    }
+    return static_cast<Reply *>(waitForReply(c, cookie.sequence, e));
+}
+}
+
+#endif
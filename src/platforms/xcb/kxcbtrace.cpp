@@ -0,0 +1,153 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "kxcbtrace_p.h"
+#include "kwindowsystem_debug.h"
+#include "kxcbinstrumentation_p.h"
+#include "netwm.h"
+#include "netwm_p.h"
+
+#include <QFile>
+#include <QMutex>
+
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+struct Recorder {
+    QMutex mutex;
+    QFile file;
+    xcb_connection_t *connection = nullptr;
+    QSharedPointer<Atoms> atoms;
+};
+
+struct ReplaySource {
+    QMutex mutex;
+    std::function<void *()> takeReply;
+    QSharedPointer<Atoms> atoms;
+};
+}
+
+Q_GLOBAL_STATIC(Recorder, s_recorder)
+Q_GLOBAL_STATIC(ReplaySource, s_replaySource)
+// the replayed connection, checked for every reply without locking
+static std::atomic<xcb_connection_t *> s_replayConnection{nullptr};
+
+namespace KXcbTrace
+{
+bool startRecording(xcb_connection_t *c, xcb_window_t rootWindow, const QString &fileName)
+{
+    stopRecording();
+    if (!c || xcb_connection_has_error(c)) {
+        return false;
+    }
+
+    Header header;
+    std::memcpy(header.magic, s_magic, sizeof(header.magic));
+    header.version = s_version;
+    header.byteOrder = s_byteOrder;
+    header.rootWindow = rootWindow;
+    header.width = header.height = 0;
+    for (xcb_screen_iterator_t it = xcb_setup_roots_iterator(xcb_get_setup(c)); it.rem; xcb_screen_next(&it)) {
+        if (it.data->root == rootWindow) {
+            header.width = it.data->width_in_pixels;
+            header.height = it.data->height_in_pixels;
+        }
+    }
+    // kept for the recording, interning them again would end up among the replies
+    QSharedPointer<Atoms> atoms = atomsForConnection(c);
+    const QList<xcb_atom_t> table = atoms->table();
+    header.atomCount = table.size();
+
+    QMutexLocker locker(&s_recorder->mutex);
+    s_recorder->file.setFileName(fileName);
+    if (!s_recorder->file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(LOG_KWINDOWSYSTEM) << "Cannot record X trace:" << s_recorder->file.errorString();
+        return false;
+    }
+    s_recorder->file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    s_recorder->file.write(reinterpret_cast<const char *>(table.constData()), table.size() * sizeof(xcb_atom_t));
+    s_recorder->connection = c;
+    s_recorder->atoms = std::move(atoms);
+    KXcbInstrumentation::setMode(KXcbInstrumentation::Recording, true);
+    return true;
+}
+
+void stopRecording()
+{
+    KXcbInstrumentation::setMode(KXcbInstrumentation::Recording, false);
+    QMutexLocker locker(&s_recorder->mutex);
+    s_recorder->file.close();
+    s_recorder->connection = nullptr;
+    s_recorder->atoms.reset();
+}
+
+void recordEvent(xcb_connection_t *c, const xcb_generic_event_t *event)
+{
+    if (!(KXcbInstrumentation::s_mode.load(std::memory_order_relaxed) & KXcbInstrumentation::Recording)) {
+        return;
+    }
+    QMutexLocker locker(&s_recorder->mutex);
+    if (c != s_recorder->connection) {
+        return;
+    }
+    s_recorder->file.putChar(EventRecord);
+    s_recorder->file.write(reinterpret_cast<const char *>(event), s_eventSize);
+}
+
+void recordReply(xcb_connection_t *c, const void *reply)
+{
+    QMutexLocker locker(&s_recorder->mutex);
+    if (c != s_recorder->connection) {
+        return;
+    }
+    if (!reply) {
+        s_recorder->file.putChar(NoReplyRecord);
+        return;
+    }
+    const quint32 size = 32 + static_cast<const xcb_generic_reply_t *>(reply)->length * 4;
+    s_recorder->file.putChar(ReplyRecord);
+    s_recorder->file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    s_recorder->file.write(static_cast<const char *>(reply), size);
+}
+
+bool startReplaying(xcb_connection_t *c, const QList<xcb_atom_t> &atomTable, const std::function<void *()> &takeReply)
+{
+    QMutexLocker locker(&s_replaySource->mutex);
+    if (s_replayConnection.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    s_replaySource->takeReply = takeReply;
+    s_replaySource->atoms = adoptAtomTable(c, atomTable);
+    s_replayConnection.store(c, std::memory_order_release);
+    KXcbInstrumentation::setMode(KXcbInstrumentation::Replaying, true);
+    return true;
+}
+
+void stopReplaying(xcb_connection_t *c)
+{
+    QMutexLocker locker(&s_replaySource->mutex);
+    if (s_replayConnection.load(std::memory_order_relaxed) != c) {
+        return;
+    }
+    KXcbInstrumentation::setMode(KXcbInstrumentation::Replaying, false);
+    s_replayConnection.store(nullptr, std::memory_order_release);
+    releaseAtomTable(c);
+    s_replaySource->atoms.reset();
+    s_replaySource->takeReply = nullptr;
+}
+
+bool replayReply(xcb_connection_t *c, void **reply)
+{
+    if (!c || s_replayConnection.load(std::memory_order_acquire) != c) {
+        return false;
+    }
+    *reply = s_replaySource->takeReply();
+    return true;
+}
+}
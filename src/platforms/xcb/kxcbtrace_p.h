@@ -0,0 +1,84 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#ifndef KXCBTRACE_P_H
+#define KXCBTRACE_P_H
+
+#include <kwindowsystem_export.h>
+
+#include <QList>
+#include <QString>
+
+#include <functional>
+#include <xcb/xcb.h>
+
+/*!
+   Records what the library reads from one xcb connection into a trace file: the events
+   handed to it with recordEvent() and every reply taken through KXcbInstrumentation::reply(),
+   which covers all of NETRootInfo and NETWinInfo.
+
+   A trace starts with a Header and the atoms of the connection, followed by the
+   events and replies in the order they were seen. Events take 33 bytes, replies 5 bytes
+   plus their length. Traces are written in host byte order and can only be replayed
+   by a build with the same atom table.
+
+   The replay itself, serving a connection from a trace, lives with the autotests and
+   benchmarks. The library only takes the replies from it, see startReplaying().
+   \internal
+**/
+namespace KXcbTrace
+{
+struct Header {
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    quint32 rootWindow;
+    quint16 width;
+    quint16 height;
+    quint32 atomCount;
+};
+
+inline constexpr char s_magic[8] = {'K', 'X', 'C', 'B', 'T', 'R', 'C', '\0'};
+inline constexpr quint32 s_version = 1;
+inline constexpr quint32 s_byteOrder = 0x01020304;
+// the core events, xcb appends the full sequence number behind them
+inline constexpr qsizetype s_eventSize = 32;
+
+enum RecordType : char {
+    EventRecord = 'E',
+    // followed by the size of the reply as quint32 and the reply
+    ReplyRecord = 'R',
+    NoReplyRecord = 'N',
+};
+
+/*!
+   Starts recording \a c into \a fileName, replacing a recording in progress. The atoms
+   are interned beforehand, so they don't end up among the replies.
+**/
+KWINDOWSYSTEM_EXPORT bool startRecording(xcb_connection_t *c, xcb_window_t rootWindow, const QString &fileName);
+KWINDOWSYSTEM_EXPORT void stopRecording();
+
+/*!
+   Records \a event if \a c is being recorded.
+**/
+KWINDOWSYSTEM_EXPORT void recordEvent(xcb_connection_t *c, const xcb_generic_event_t *event);
+
+/*!
+   Makes the library use \a atomTable as the atoms of \a c and take every reply for it
+   from \a takeReply instead of the connection, until stopReplaying(). The replies are
+   freed by the library like those of xcb. Returns false if another connection is
+   being replayed already.
+**/
+KWINDOWSYSTEM_EXPORT bool startReplaying(xcb_connection_t *c, const QList<xcb_atom_t> &atomTable, const std::function<void *()> &takeReply);
+KWINDOWSYSTEM_EXPORT void stopReplaying(xcb_connection_t *c);
+
+// used by KXcbInstrumentation
+void recordReply(xcb_connection_t *c, const void *reply);
+bool replayReply(xcb_connection_t *c, void **reply);
+}
+
+#endif
@@ -8,11 +8,12 @@
 #include "kxmessages.h"
 #include "cptr_p.h"
 #include "kxcbevent_p.h"
+#include "kxcbeventdispatcher_p.h"
+#include "kxcbinstrumentation_p.h"
 #include "kxutils_p.h"
 
 #if KWINDOWSYSTEM_HAVE_X11
 
-#include <QAbstractNativeEventFilter>
 #include <QCoreApplication>
 #include <QDebug>
 #include <QWindow> // WId
@@ -80,7 +81,7 @@ private:
         if (m_retrieved || !m_cookie.sequence || !m_connection) {
             return;
         }
-        UniqueCPointer<xcb_intern_atom_reply_t> reply(xcb_intern_atom_reply(m_connection, m_cookie, nullptr));
+        UniqueCPointer<xcb_intern_atom_reply_t> reply(KXcbInstrumentation::reply(xcb_intern_atom_reply, m_connection, m_cookie, nullptr));
         if (reply) {
             m_atom = reply->atom;
         }
@@ -94,7 +95,7 @@ private:
     bool m_onlyIfExists;
 };
 
-class KXMessagesPrivate : public QAbstractNativeEventFilter
+class KXMessagesPrivate : public KXcbEventFilter
 {
 public:
     KXMessagesPrivate(KXMessages *parent, const char *acceptBroadcast, xcb_connection_t *c, xcb_window_t root)
@@ -111,7 +112,8 @@ public:
             accept_atom1.fetch();
             accept_atom2.setConnection(c);
             accept_atom2.fetch();
-            QCoreApplication::instance()->installNativeEventFilter(this);
+            // Until the atoms are known all client messages have to be inspected
+            KXcbEventDispatcher::self()->subscribe(this, XCB_CLIENT_MESSAGE);
         }
     }
     XcbAtom accept_atom1;
@@ -122,17 +124,21 @@ public:
     bool valid;
     xcb_connection_t *connection;
     xcb_window_t rootWindow;
+    bool routedByAtom = false;
 
-    bool nativeEventFilter(const QByteArray &eventType, void *message, qintptr *) override
+    bool xcbEventFilter(xcb_generic_event_t *event) override
     {
-        // A faster comparison than eventType != "xcb_generic_event_t"
-        if (eventType[0] != 'x') {
-            return false;
-        }
-        xcb_generic_event_t *event = reinterpret_cast<xcb_generic_event_t *>(message);
-        uint response_type = event->response_type & ~0x80;
-        if (response_type != XCB_CLIENT_MESSAGE) {
-            return false;
+        if (!routedByAtom) {
+            // Resolving the atoms blocks at most once, afterwards only our own messages get here
+            const xcb_atom_t atom1 = accept_atom1;
+            const xcb_atom_t atom2 = accept_atom2;
+            if (atom1 != XCB_ATOM_NONE && atom2 != XCB_ATOM_NONE) {
+                KXcbEventDispatcher *dispatcher = KXcbEventDispatcher::self();
+                dispatcher->unsubscribe(this, XCB_CLIENT_MESSAGE, XCB_NONE);
+                dispatcher->subscribe(this, XCB_CLIENT_MESSAGE, atom1);
+                dispatcher->subscribe(this, XCB_CLIENT_MESSAGE, atom2);
+                routedByAtom = true;
+            }
         }
         xcb_client_message_event_t *cm_event = reinterpret_cast<xcb_client_message_event_t *>(event);
         if (cm_event->format != 8) {
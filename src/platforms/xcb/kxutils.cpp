@@ -7,6 +7,7 @@
 */
 
 #include "cptr_p.h"
+#include "kxcbinstrumentation_p.h"
 #include "kxutils_p.h"
 #include <QBitmap>
 #include <QDebug>
@@ -15,23 +16,16 @@
 
 #include <xcb/xcb.h>
 
+#include <vector>
+
 namespace KXUtils
 {
-template<typename T>
-T fromNative(xcb_pixmap_t pixmap, xcb_connection_t *c)
+// Turns the image of a pixmap into a QImage, taking ownership of xImage
+static QImage imageFromReply(UniqueCPointer<xcb_get_image_reply_t> xImage, int width, int height)
 {
-    const xcb_get_geometry_cookie_t geoCookie = xcb_get_geometry_unchecked(c, pixmap);
-    UniqueCPointer<xcb_get_geometry_reply_t> geo(xcb_get_geometry_reply(c, geoCookie, nullptr));
-    if (!geo) {
-        // getting geometry for the pixmap failed
-        return T();
-    }
-
-    const xcb_get_image_cookie_t imageCookie = xcb_get_image_unchecked(c, XCB_IMAGE_FORMAT_Z_PIXMAP, pixmap, 0, 0, geo->width, geo->height, ~0);
-    UniqueCPointer<xcb_get_image_reply_t> xImage(xcb_get_image_reply(c, imageCookie, nullptr));
     if (!xImage) {
         // request for image data failed
-        return T();
+        return QImage();
     }
     QImage::Format format = QImage::Format_Invalid;
     switch (xImage->depth) {
@@ -61,12 +55,12 @@ T fromNative(xcb_pixmap_t pixmap, xcb_connection_t *c)
         format = QImage::Format_ARGB32_Premultiplied;
         break;
     default:
-        return T(); // we don't know
+        return QImage(); // we don't know
     }
-    QImage image(xcb_get_image_data(xImage.get()), geo->width, geo->height, xcb_get_image_data_length(xImage.get()) / geo->height, format, free, xImage.get());
+    QImage image(xcb_get_image_data(xImage.get()), width, height, xcb_get_image_data_length(xImage.get()) / height, format, free, xImage.get());
     xImage.release();
     if (image.isNull()) {
-        return T();
+        return QImage();
     }
     if (image.format() == QImage::Format_MonoLSB) {
         // work around an abort in QImage::color
@@ -74,7 +68,7 @@ T fromNative(xcb_pixmap_t pixmap, xcb_connection_t *c)
         image.setColor(0, QColor(Qt::white).rgb());
         image.setColor(1, QColor(Qt::black).rgb());
     }
-    return T::fromImage(image);
+    return image;
 }
 
 // Create QPixmap from X pixmap. Take care of different depths if needed.
@@ -85,25 +79,84 @@ QPixmap createPixmapFromHandle(WId pixmap, WId pixmap_mask)
 
 QPixmap createPixmapFromHandle(xcb_connection_t *c, WId pixmap, WId pixmap_mask)
 {
+    return createPixmapsFromHandles(c, {{pixmap, pixmap_mask}}).constFirst();
+}
+
+QList<QPixmap> createPixmapsFromHandles(xcb_connection_t *c, const QList<std::pair<WId, WId>> &handles)
+{
+    QList<QPixmap> pixmaps(handles.size());
 #if Q_BYTE_ORDER == Q_BIG_ENDIAN
     qDebug() << "Byte order not supported";
-    return QPixmap();
+    return pixmaps;
 #endif
     const xcb_setup_t *setup = xcb_get_setup(c);
     if (setup->image_byte_order != XCB_IMAGE_ORDER_LSB_FIRST) {
         qDebug() << "Byte order not supported";
-        return QPixmap();
+        return pixmaps;
+    }
+
+    // the pixmaps and masks in one list, each of them fetched by a geometry request
+    // followed by an image request. All geometry requests are sent before waiting
+    // for any of them, then all image requests, so it takes two round trips overall.
+    struct Fetch {
+        xcb_pixmap_t pixmap = XCB_PIXMAP_NONE;
+        xcb_get_geometry_cookie_t geometryCookie = {};
+        UniqueCPointer<xcb_get_geometry_reply_t> geometry;
+        xcb_get_image_cookie_t imageCookie = {};
+    };
+    std::vector<Fetch> fetches(handles.size() * 2);
+    for (qsizetype i = 0; i < handles.size(); ++i) {
+        if (handles.at(i).first == XCB_PIXMAP_NONE) {
+            continue;
+        }
+        fetches[2 * i].pixmap = handles.at(i).first;
+        fetches[2 * i + 1].pixmap = handles.at(i).second;
     }
+    for (Fetch &fetch : fetches) {
+        if (fetch.pixmap != XCB_PIXMAP_NONE) {
+            fetch.geometryCookie = xcb_get_geometry_unchecked(c, fetch.pixmap);
+        }
+    }
+    for (Fetch &fetch : fetches) {
+        if (fetch.pixmap == XCB_PIXMAP_NONE) {
+            continue;
+        }
+        // getting geometry for the pixmap may fail
+        fetch.geometry.reset(KXcbInstrumentation::reply(xcb_get_geometry_reply, c, fetch.geometryCookie, nullptr));
+        if (fetch.geometry) {
+            fetch.imageCookie = xcb_get_image_unchecked(c, XCB_IMAGE_FORMAT_Z_PIXMAP, fetch.pixmap, 0, 0, fetch.geometry->width, fetch.geometry->height, ~0);
+        }
+    }
+    const auto takeImage = [c](Fetch &fetch) {
+        if (!fetch.geometry) {
+            return QImage();
+        }
+        return imageFromReply(UniqueCPointer<xcb_get_image_reply_t>(KXcbInstrumentation::reply(xcb_get_image_reply, c, fetch.imageCookie, nullptr)),
+                              fetch.geometry->width,
+                              fetch.geometry->height);
+    };
+
+    for (qsizetype i = 0; i < handles.size(); ++i) {
+        Fetch &pixmapFetch = fetches[2 * i];
+        Fetch &maskFetch = fetches[2 * i + 1];
+        if (pixmapFetch.pixmap == XCB_PIXMAP_NONE) {
+            continue;
+        }
+        // the replies have to be taken even if the pixmap is unusable
+        const QImage pixmapImage = takeImage(pixmapFetch);
+        const QImage maskImage = takeImage(maskFetch);
 
-    QPixmap pix = fromNative<QPixmap>(pixmap, c);
-    if (pixmap_mask != XCB_PIXMAP_NONE) {
-        QBitmap mask = fromNative<QBitmap>(pixmap_mask, c);
-        if (mask.size() != pix.size()) {
-            return QPixmap();
+        QPixmap pix = QPixmap::fromImage(pixmapImage);
+        if (maskFetch.pixmap != XCB_PIXMAP_NONE) {
+            const QBitmap mask = QBitmap::fromImage(maskImage);
+            if (mask.size() != pix.size()) {
+                continue;
+            }
+            pix.setMask(mask);
         }
-        pix.setMask(mask);
+        pixmaps[i] = pix;
     }
-    return pix;
+    return pixmaps;
 }
 
 // Functions for X timestamp comparing. For Time being 32bit they're fairly simple
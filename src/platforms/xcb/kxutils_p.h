@@ -8,9 +8,12 @@
 #ifndef KXUTILS_H
 #define KXUTILS_H
 
+#include <QList>
 #include <QPixmap>
 #include <config-kwindowsystem.h>
 
+#include <utility>
+
 #if KWINDOWSYSTEM_HAVE_X11
 
 #include <kwindowsystem_export.h>
@@ -30,6 +33,14 @@ namespace KXUtils
 QPixmap createPixmapFromHandle(WId pixmap, WId mask = 0);
 QPixmap createPixmapFromHandle(xcb_connection_t *c, WId pixmap, WId mask = 0);
 
+/*!
+ * Like createPixmapFromHandle() for each pair of a pixmap and an optional mask in
+ * \a handles, but sends the requests for all of them together. The result has a null
+ * QPixmap for pairs without a pixmap.
+ * \internal
+ */
+QList<QPixmap> createPixmapsFromHandles(xcb_connection_t *c, const QList<std::pair<WId, WId>> &handles);
+
 /*!
  * Compares two X timestamps, taking into account wrapping and 64bit architectures.
  * Return value is like with strcmp(), 0 for equal, -1 for time1 < time2, 1 for time1 > time2.
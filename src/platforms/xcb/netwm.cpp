@@ -12,12 +12,14 @@
 
 #include "atoms_p.h"
 #include "kxcbevent_p.h"
+#include "kxcbinstrumentation_p.h"
 #include "netwm_p.h"
 
 #if KWINDOWSYSTEM_HAVE_X11 // FIXME
 
 #include <QGuiApplication>
 #include <QHash>
+#include <QMutex>
 
 #include <private/qtx11extras_p.h>
 
@@ -26,6 +28,12 @@
 #include <kx11extras.h>
 #include <kxutils_p.h>
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <utility>
+
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -53,8 +61,12 @@ Q_GLOBAL_STATIC(PersistentAtomHash, s_gAtomsHash)
 typedef QHash<xcb_connection_t *, QWeakPointer<Atoms>> TransientAtomHash;
 Q_GLOBAL_STATIC(TransientAtomHash, s_gTransientAtomsHash)
 
-static QSharedPointer<Atoms> atomsForConnection(xcb_connection_t *c)
+// KX11Extras may track windows on its own connection in a worker thread
+Q_GLOBAL_STATIC(QMutex, s_gAtomsMutex)
+
+QSharedPointer<Atoms> atomsForConnection(xcb_connection_t *c)
 {
+    QMutexLocker locker(s_gAtomsMutex());
     if (QX11Info::isPlatformX11()) {
         auto it = s_gAtomsHash->constFind(c);
         if (it == s_gAtomsHash->constEnd()) {
@@ -82,6 +94,40 @@ Atoms::Atoms(xcb_connection_t *c)
         m_atoms[i] = XCB_ATOM_NONE;
     }
     init();
+    initMeanings();
+}
+
+Atoms::Atoms(xcb_connection_t *c, const QList<xcb_atom_t> &table)
+    : m_connection(c)
+{
+    for (int i = 0; i < KwsAtomCount; ++i) {
+        m_atoms[i] = i < table.size() ? table.at(i) : XCB_ATOM_NONE;
+    }
+    initMeanings();
+}
+
+QList<xcb_atom_t> Atoms::table() const
+{
+    return QList<xcb_atom_t>(std::begin(m_atoms), std::end(m_atoms));
+}
+
+QSharedPointer<Atoms> adoptAtomTable(xcb_connection_t *c, const QList<xcb_atom_t> &table)
+{
+    QMutexLocker locker(s_gAtomsMutex());
+    QSharedPointer<Atoms> atoms(new Atoms(c, table));
+    if (QX11Info::isPlatformX11()) {
+        s_gAtomsHash->insert(c, atoms);
+    } else {
+        s_gTransientAtomsHash->insert(c, atoms);
+    }
+    return atoms;
+}
+
+void releaseAtomTable(xcb_connection_t *c)
+{
+    QMutexLocker locker(s_gAtomsMutex());
+    s_gAtomsHash->remove(c);
+    s_gTransientAtomsHash->remove(c);
 }
 
 static const uint32_t netwm_sendevent_mask = (XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY);
@@ -112,6 +158,310 @@ static char *nstrndup(const char *s1, int l)
     return s2;
 }
 
+namespace
+{
+struct StringPoolEntry {
+    QByteArray bytes;
+    // the number of fields holding it
+    int fields = 0;
+};
+
+struct StringPool {
+    QMutex mutex;
+    // the shared strings by the pointer handed out, which is their data
+    QHash<const char *, StringPoolEntry> strings;
+    // the same strings by their content, only looked up when acquiring one
+    QHash<QByteArrayView, const char *> contents;
+};
+}
+
+Q_GLOBAL_STATIC(StringPool, s_stringPool)
+static std::atomic<bool> s_stringPoolEnabled{false};
+
+bool NETStringPool::isEnabled()
+{
+    return s_stringPoolEnabled.load(std::memory_order_relaxed);
+}
+
+void NETStringPool::setEnabled(bool enabled)
+{
+    s_stringPoolEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+const char *NETStringPool::acquire(const char *value, qsizetype length)
+{
+    // release() only knows the C string
+    length = qstrnlen(value, length);
+    QMutexLocker locker(&s_stringPool->mutex);
+    const char *shared = s_stringPool->contents.value(QByteArrayView(value, length));
+    if (!shared) {
+        // the data of the entry stays where it is when the hashes grow
+        const QByteArray bytes(value, length);
+        shared = bytes.constData();
+        s_stringPool->strings.insert(shared, StringPoolEntry{bytes, 0});
+        s_stringPool->contents.insert(QByteArrayView(bytes), shared);
+    }
+    ++s_stringPool->strings[shared].fields;
+    return shared;
+}
+
+void NETStringPool::release(const char *value)
+{
+    // windows may outlive the pool at exit
+    if (s_stringPool.isDestroyed()) {
+        return;
+    }
+    QMutexLocker locker(&s_stringPool->mutex);
+    const auto it = s_stringPool->strings.find(value);
+    Q_ASSERT(it != s_stringPool->strings.end());
+    if (it != s_stringPool->strings.end() && --it->fields == 0) {
+        s_stringPool->contents.remove(QByteArrayView(it->bytes));
+        s_stringPool->strings.erase(it);
+    }
+}
+
+QByteArray NETStringPool::bytes(const char *value)
+{
+    if (!s_stringPool.isDestroyed()) {
+        QMutexLocker locker(&s_stringPool->mutex);
+        const auto it = s_stringPool->strings.constFind(value);
+        if (it != s_stringPool->strings.constEnd()) {
+            return it->bytes;
+        }
+    }
+    return QByteArray(value);
+}
+
+namespace
+{
+// The strings of the running NETStringArena::begin(), each with the field to point at it
+struct StringStaging {
+    const NETStringArena *arena = nullptr;
+    QByteArray bytes;
+    QList<std::pair<char **, qsizetype>> fields;
+};
+}
+
+static thread_local StringStaging t_staging;
+
+// Every empty string, so the blocks never hold one and the NULs behind a string in a
+// block are room it can grow into
+static char s_emptyString[] = "";
+
+NETStringArena::~NETStringArena()
+{
+    while (m_blocks) {
+        Block *next = m_blocks->next;
+        ::operator delete(m_blocks);
+        m_blocks = next;
+    }
+}
+
+void NETStringArena::begin()
+{
+    // another arena of the same thread in between keeps storing its strings one by one
+    if (!t_staging.arena) {
+        t_staging.arena = this;
+    }
+}
+
+void NETStringArena::commit()
+{
+    if (t_staging.arena != this) {
+        return;
+    }
+    t_staging.arena = nullptr;
+
+    qsizetype size = 0;
+    for (const auto &[field, offset] : std::as_const(t_staging.fields)) {
+        // a value may have been written over by a shorter one
+        size += strlen(*field) + 1;
+    }
+    if (size > 0) {
+        Block *block = static_cast<Block *>(::operator new(sizeof(Block) + size));
+        *block = Block{m_blocks, int(size), int(t_staging.fields.size())};
+        m_blocks = block;
+
+        char *copy = block->data();
+        for (const auto &[field, offset] : std::as_const(t_staging.fields)) {
+            const qsizetype length = strlen(*field) + 1;
+            memcpy(copy, *field, length);
+            *field = copy;
+            copy += length;
+        }
+    }
+    // the buffer is kept for the next update unless it was grown by a huge property
+    if (t_staging.bytes.capacity() > 4096) {
+        t_staging.bytes.clear();
+    } else {
+        t_staging.bytes.resize(0);
+    }
+    t_staging.fields.clear();
+}
+
+void NETStringArena::set(char **field, const char *value)
+{
+    assign(field, value, value ? strlen(value) : 0);
+}
+
+void NETStringArena::set(char **field, const char *value, qsizetype length)
+{
+    assign(field, length == 0 ? nullptr : value, length);
+}
+
+void NETStringArena::intern(char **field, const char *value)
+{
+    if (!value || !NETStringPool::isEnabled()) {
+        set(field, value);
+        return;
+    }
+    share(field, value, strlen(value));
+}
+
+void NETStringArena::intern(char **field, const char *value, qsizetype length)
+{
+    if (!value || length == 0 || !NETStringPool::isEnabled()) {
+        set(field, value, length);
+        return;
+    }
+    share(field, value, length);
+}
+
+bool NETStringArena::owns(const char *value) const
+{
+    return value && (value == s_emptyString || block(value) || isStaged(value));
+}
+
+NETStringArena::Block *NETStringArena::block(const char *value) const
+{
+    // value may be anywhere, unlike the built-in operators std::less orders all pointers
+    const std::less<const char *> before;
+    for (Block *block = m_blocks; block; block = block->next) {
+        if (!before(value, block->data()) && before(value, block->data() + block->size)) {
+            return block;
+        }
+    }
+    return nullptr;
+}
+
+qsizetype NETStringArena::room(const char *value) const
+{
+    if (isStaged(value)) {
+        return strlen(value);
+    }
+    Block *const block = this->block(value);
+    if (!block) {
+        return -1;
+    }
+    const char *const end = block->data() + block->size;
+    // the last string in use in its block may grow up to the end of it
+    if (block->live == 1) {
+        return end - value - 1;
+    }
+    // otherwise up to the next string, released and shortened strings leave NULs
+    const char *next = value + strlen(value);
+    while (next + 1 < end && next[1] == '\0') {
+        ++next;
+    }
+    return next - value;
+}
+
+bool NETStringArena::isStaged(const char *value) const
+{
+    const std::less<const char *> before;
+    return t_staging.arena == this && !before(value, t_staging.bytes.constData())
+        && before(value, t_staging.bytes.constData() + t_staging.bytes.size());
+}
+
+void NETStringArena::assign(char **field, const char *value, qsizetype length)
+{
+    // value may be the string being replaced
+    char *previous = *field;
+    if (value && length == 0) {
+        *field = s_emptyString;
+        release(previous);
+        return;
+    }
+    if (value && previous && length <= room(previous)) {
+        // only this field refers to it, so it can take the new value without allocating
+        const qsizetype previousLength = strlen(previous);
+        memmove(previous, value, length);
+        memset(previous + length, 0, std::max<qsizetype>(previousLength - length, 0) + 1);
+        return;
+    }
+    // a staged value only leaves the list, its bytes stay until commit()
+    if (previous && isStaged(previous)) {
+        release(std::exchange(previous, nullptr));
+    }
+    *field = value ? store(field, value, length) : nullptr;
+    release(previous);
+}
+
+void NETStringArena::share(char **field, const char *value, qsizetype length)
+{
+    const char *previous = *field;
+    *field = const_cast<char *>(NETStringPool::acquire(value, length));
+    release(previous);
+}
+
+char *NETStringArena::store(char **field, const char *value, qsizetype length)
+{
+    if (t_staging.arena == this) {
+        // value may point into the staging buffer, which can move when it grows
+        const QByteArray copy = isStaged(value) ? QByteArray(value, length) : QByteArray::fromRawData(value, length);
+        const char *data = t_staging.bytes.constData();
+        const qsizetype offset = t_staging.bytes.size();
+        t_staging.bytes.append(copy).append('\0');
+        if (t_staging.bytes.constData() != data) {
+            for (const auto &[stagedField, stagedOffset] : std::as_const(t_staging.fields)) {
+                *stagedField = t_staging.bytes.data() + stagedOffset;
+            }
+        }
+        t_staging.fields.append({field, offset});
+        return t_staging.bytes.data() + offset;
+    }
+
+    // the allocator hands out multiples of 16 bytes anyway, the rest is room to grow
+    const qsizetype size = (sizeof(Block) + length + 1 + 15) / 16 * 16 - sizeof(Block);
+    Block *block = static_cast<Block *>(::operator new(sizeof(Block) + size));
+    *block = Block{m_blocks, int(size), 1};
+    m_blocks = block;
+    memcpy(block->data(), value, length);
+    memset(block->data() + length, 0, size - length);
+    return block->data();
+}
+
+void NETStringArena::release(const char *value)
+{
+    if (!value || value == s_emptyString) {
+        return;
+    }
+    if (isStaged(value)) {
+        // left out of the block built by commit()
+        const qsizetype offset = value - t_staging.bytes.constData();
+        t_staging.fields.removeIf([offset](const auto &staged) {
+            return staged.second == offset;
+        });
+        return;
+    }
+    for (Block **link = &m_blocks; *link; link = &(*link)->next) {
+        Block *block = *link;
+        const std::less<const char *> before;
+        if (before(value, block->data()) || !before(value, block->data() + block->size)) {
+            continue;
+        }
+        if (--block->live == 0) {
+            *link = block->next;
+            ::operator delete(block);
+        } else {
+            // room for the string before it
+            memset(const_cast<char *>(value), 0, strlen(value));
+        }
+        return;
+    }
+    NETStringPool::release(value);
+}
+
 static xcb_window_t *nwindup(const xcb_window_t *w1, int n)
 {
     if (!w1 || n == 0) {
@@ -149,6 +499,79 @@ static void refdec_nri(NETRootInfoPrivate *p)
     }
 }
 
+// Copies everything read from the X server, the connection, root window, role and the
+// properties asked for stay those of to. from is only read, operator[] isn't const.
+static void copyRootValues(NETRootInfoPrivate *to, NETRootInfoPrivate *from)
+{
+    if (to == from) {
+        return;
+    }
+
+    to->rootSize = from->rootSize;
+    to->supportwindow = from->supportwindow;
+    delete[] to->name;
+    to->name = nstrdup(from->name);
+
+    to->viewport.reset();
+    for (int i = 0; i < from->viewport.size(); i++) {
+        to->viewport[i] = from->viewport[i];
+    }
+    to->workarea.reset();
+    for (int i = 0; i < from->workarea.size(); i++) {
+        to->workarea[i] = from->workarea[i];
+    }
+    for (int i = 0; i < to->desktop_names.size(); i++) {
+        delete[] to->desktop_names[i];
+    }
+    to->desktop_names.reset();
+    for (int i = 0; i < from->desktop_names.size(); i++) {
+        to->desktop_names[i] = nstrdup(from->desktop_names[i]);
+    }
+
+    to->geometry = from->geometry;
+    to->active = from->active;
+    delete[] to->clients;
+    to->clients = nwindup(from->clients, from->clients_count);
+    to->clients_count = to->clients ? from->clients_count : 0;
+    delete[] to->stacking;
+    to->stacking = nwindup(from->stacking, from->stacking_count);
+    to->stacking_count = to->stacking ? from->stacking_count : 0;
+    delete[] to->virtual_roots;
+    to->virtual_roots = nwindup(from->virtual_roots, from->virtual_roots_count);
+    to->virtual_roots_count = to->virtual_roots ? from->virtual_roots_count : 0;
+    to->number_of_desktops = from->number_of_desktops;
+    to->current_desktop = from->current_desktop;
+    to->showing_desktop = from->showing_desktop;
+    to->desktop_layout_orientation = from->desktop_layout_orientation;
+    to->desktop_layout_corner = from->desktop_layout_corner;
+    to->desktop_layout_columns = from->desktop_layout_columns;
+    to->desktop_layout_rows = from->desktop_layout_rows;
+
+    to->properties = from->properties;
+    to->properties2 = from->properties2;
+    to->windowTypes = from->windowTypes;
+    to->states = from->states;
+    to->actions = from->actions;
+}
+
+// the members kept in NETWinInfoPrivate::strings
+static char *NETWinInfoPrivate::*const s_winInfoStrings[] = {
+    &NETWinInfoPrivate::name,
+    &NETWinInfoPrivate::visible_name,
+    &NETWinInfoPrivate::icon_name,
+    &NETWinInfoPrivate::visible_icon_name,
+    &NETWinInfoPrivate::startup_id,
+    &NETWinInfoPrivate::class_class,
+    &NETWinInfoPrivate::class_name,
+    &NETWinInfoPrivate::window_role,
+    &NETWinInfoPrivate::client_machine,
+    &NETWinInfoPrivate::desktop_file,
+    &NETWinInfoPrivate::appmenu_object_path,
+    &NETWinInfoPrivate::appmenu_service_name,
+    &NETWinInfoPrivate::gtk_application_id,
+    &NETWinInfoPrivate::activities,
+};
+
 static void refdec_nwi(NETWinInfoPrivate *p)
 {
 #ifdef NETWMDEBUG
@@ -160,21 +583,10 @@ static void refdec_nwi(NETWinInfoPrivate *p)
         fprintf(stderr, "NET: \tno more references, deleting\n");
 #endif
 
-        delete[] p->name;
-        delete[] p->visible_name;
-        delete[] p->window_role;
-        delete[] p->icon_name;
-        delete[] p->visible_icon_name;
-        delete[] p->startup_id;
-        delete[] p->class_class;
-        delete[] p->class_name;
-        delete[] p->activities;
-        delete[] p->client_machine;
-        delete[] p->desktop_file;
-        delete[] p->gtk_application_id;
-        delete[] p->appmenu_object_path;
-        delete[] p->appmenu_service_name;
-
+        // hands the interned strings back to the pool, the others go with p->strings
+        for (char *NETWinInfoPrivate::*field : s_winInfoStrings) {
+            p->strings.set(&(p->*field), nullptr);
+        }
         int i;
         for (i = 0; i < p->icons.size(); i++) {
             delete[] p->icons[i].data;
@@ -188,7 +600,7 @@ T get_value_reply(xcb_connection_t *c, const xcb_get_property_cookie_t cookie, x
 {
     T value = def;
 
-    xcb_get_property_reply_t *reply = xcb_get_property_reply(c, cookie, nullptr);
+    xcb_get_property_reply_t *reply = KXcbInstrumentation::reply(xcb_get_property_reply, c, cookie, nullptr);
 
     if (success) {
         *success = false;
@@ -212,7 +624,7 @@ T get_value_reply(xcb_connection_t *c, const xcb_get_property_cookie_t cookie, x
 template<typename T>
 QList<T> get_array_reply(xcb_connection_t *c, const xcb_get_property_cookie_t cookie, xcb_atom_t type)
 {
-    xcb_get_property_reply_t *reply = xcb_get_property_reply(c, cookie, nullptr);
+    xcb_get_property_reply_t *reply = KXcbInstrumentation::reply(xcb_get_property_reply, c, cookie, nullptr);
     if (!reply) {
         return QList<T>();
     }
@@ -232,7 +644,7 @@ QList<T> get_array_reply(xcb_connection_t *c, const xcb_get_property_cookie_t co
 
 static QByteArray get_string_reply(xcb_connection_t *c, const xcb_get_property_cookie_t cookie, xcb_atom_t type)
 {
-    xcb_get_property_reply_t *reply = xcb_get_property_reply(c, cookie, nullptr);
+    xcb_get_property_reply_t *reply = KXcbInstrumentation::reply(xcb_get_property_reply, c, cookie, nullptr);
     if (!reply) {
         return QByteArray();
     }
@@ -254,7 +666,7 @@ static QByteArray get_string_reply(xcb_connection_t *c, const xcb_get_property_c
 
 static QList<QByteArray> get_stringlist_reply(xcb_connection_t *c, const xcb_get_property_cookie_t cookie, xcb_atom_t type)
 {
-    xcb_get_property_reply_t *reply = xcb_get_property_reply(c, cookie, nullptr);
+    xcb_get_property_reply_t *reply = KXcbInstrumentation::reply(xcb_get_property_reply, c, cookie, nullptr);
     if (!reply) {
         return QList<QByteArray>();
     }
@@ -275,12 +687,101 @@ static QList<QByteArray> get_stringlist_reply(xcb_connection_t *c, const xcb_get
     return list;
 }
 
+// Refers to either a predefined atom or one of the atoms interned in Atoms.
+struct NETAtomRef {
+    constexpr NETAtomRef() = default;
+    constexpr NETAtomRef(KwsAtom atom)
+        : kwsAtom(atom)
+        , isKwsAtom(true)
+    {
+    }
+    constexpr NETAtomRef(xcb_atom_enum_t atom)
+        : predefined(atom)
+    {
+    }
+
+    constexpr bool isValid() const
+    {
+        return isKwsAtom || predefined != XCB_ATOM_NONE;
+    }
+
+    xcb_atom_t resolve(const Atoms &atoms) const
+    {
+        return isKwsAtom ? atoms.atom(kwsAtom) : predefined;
+    }
+
+    KwsAtom kwsAtom = KwsAtomCount;
+    xcb_atom_t predefined = XCB_ATOM_NONE;
+    bool isKwsAtom = false;
+};
+
+// One entry of the property tables used by NETRootInfo::update() and NETWinInfo::update().
+// The same table drives both the requests and the parsing of the replies, so the two passes
+// can never get out of step. If companion is set, a second property of the same type and
+// length is requested along with atom and the parser gets both cookies.
+template<typename Target>
+struct NETPropertyFetch {
+    NET::Properties properties;
+    NET::Properties2 properties2;
+    NETAtomRef atom;
+    NETAtomRef type;
+    uint32_t length;
+    void (*parse)(Target *target, const xcb_get_property_cookie_t *cookies);
+    NETAtomRef companion = NETAtomRef();
+
+    bool isDirty(NET::Properties dirty, NET::Properties2 dirty2) const
+    {
+        return (dirty & properties) || (dirty2 & properties2);
+    }
+};
+
+// Sends the requests for all dirty entries of table, cookies must have room for two per entry
+template<typename Target, size_t N>
+static void requestProperties(xcb_connection_t *c,
+                              xcb_window_t window,
+                              const Atoms &atoms,
+                              const NETPropertyFetch<Target> (&table)[N],
+                              NET::Properties dirty,
+                              NET::Properties2 dirty2,
+                              xcb_get_property_cookie_t *cookies)
+{
+    for (const NETPropertyFetch<Target> &entry : table) {
+        if (!entry.isDirty(dirty, dirty2)) {
+            continue;
+        }
+
+        const xcb_atom_t type = entry.type.resolve(atoms);
+        *cookies++ = xcb_get_property(c, false, window, entry.atom.resolve(atoms), type, 0, entry.length);
+        if (entry.companion.isValid()) {
+            *cookies++ = xcb_get_property(c, false, window, entry.companion.resolve(atoms), type, 0, entry.length);
+        }
+    }
+}
+
+// Hands the replies to the requests sent by requestProperties() to the parsers of the table
+template<typename Target, size_t N>
+static void parseProperties(Target *target,
+                            const NETPropertyFetch<Target> (&table)[N],
+                            NET::Properties dirty,
+                            NET::Properties2 dirty2,
+                            const xcb_get_property_cookie_t *cookies)
+{
+    for (const NETPropertyFetch<Target> &entry : table) {
+        if (!entry.isDirty(dirty, dirty2)) {
+            continue;
+        }
+
+        entry.parse(target, cookies);
+        cookies += entry.companion.isValid() ? 2 : 1;
+    }
+}
+
 #ifdef NETWMDEBUG
 static QByteArray get_atom_name(xcb_connection_t *c, xcb_atom_t atom)
 {
     const xcb_get_atom_name_cookie_t cookie = xcb_get_atom_name(c, atom);
 
-    xcb_get_atom_name_reply_t *reply = xcb_get_atom_name_reply(c, cookie, 0);
+    xcb_get_atom_name_reply_t *reply = KXcbInstrumentation::reply(xcb_get_atom_name_reply, c, cookie, 0);
     if (!reply) {
         return QByteArray();
     }
@@ -304,7 +805,7 @@ void Atoms::init()
 
     // Get the replies
     for (int i = 0; i < KwsAtomCount; ++i) {
-        xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(m_connection, cookies[i], nullptr);
+        xcb_intern_atom_reply_t *reply = KXcbInstrumentation::reply(xcb_intern_atom_reply, m_connection, cookies[i], nullptr);
         if (!reply) {
             continue;
         }
@@ -314,6 +815,78 @@ void Atoms::init()
     }
 }
 
+void Atoms::initMeanings()
+{
+    static const std::pair<KwsAtom, NET::State> states[] = {
+        {_NET_WM_STATE_MODAL, NET::Modal},
+        {_NET_WM_STATE_STICKY, NET::Sticky},
+        {_NET_WM_STATE_MAXIMIZED_VERT, NET::MaxVert},
+        {_NET_WM_STATE_MAXIMIZED_HORZ, NET::MaxHoriz},
+        {_NET_WM_STATE_SHADED, NET::Shaded},
+        {_NET_WM_STATE_SKIP_TASKBAR, NET::SkipTaskbar},
+        {_NET_WM_STATE_SKIP_PAGER, NET::SkipPager},
+        {_KDE_NET_WM_STATE_SKIP_SWITCHER, NET::SkipSwitcher},
+        {_NET_WM_STATE_HIDDEN, NET::Hidden},
+        {_NET_WM_STATE_FULLSCREEN, NET::FullScreen},
+        {_NET_WM_STATE_ABOVE, NET::KeepAbove},
+        {_NET_WM_STATE_BELOW, NET::KeepBelow},
+        {_NET_WM_STATE_DEMANDS_ATTENTION, NET::DemandsAttention},
+        {_NET_WM_STATE_STAYS_ON_TOP, NET::KeepAbove},
+        {_NET_WM_STATE_FOCUSED, NET::Focused},
+    };
+    static const std::pair<KwsAtom, NET::WindowType> types[] = {
+        {_NET_WM_WINDOW_TYPE_NORMAL, NET::Normal},
+        {_NET_WM_WINDOW_TYPE_DESKTOP, NET::Desktop},
+        {_NET_WM_WINDOW_TYPE_DOCK, NET::Dock},
+        {_NET_WM_WINDOW_TYPE_TOOLBAR, NET::Toolbar},
+        {_NET_WM_WINDOW_TYPE_MENU, NET::Menu},
+        {_NET_WM_WINDOW_TYPE_DIALOG, NET::Dialog},
+        {_NET_WM_WINDOW_TYPE_UTILITY, NET::Utility},
+        {_NET_WM_WINDOW_TYPE_SPLASH, NET::Splash},
+        {_NET_WM_WINDOW_TYPE_DROPDOWN_MENU, NET::DropdownMenu},
+        {_NET_WM_WINDOW_TYPE_POPUP_MENU, NET::PopupMenu},
+        {_NET_WM_WINDOW_TYPE_TOOLTIP, NET::Tooltip},
+        {_NET_WM_WINDOW_TYPE_NOTIFICATION, NET::Notification},
+        {_NET_WM_WINDOW_TYPE_COMBO, NET::ComboBox},
+        {_NET_WM_WINDOW_TYPE_DND, NET::DNDIcon},
+        {_KDE_NET_WM_WINDOW_TYPE_OVERRIDE, NET::Override},
+        {_KDE_NET_WM_WINDOW_TYPE_TOPMENU, NET::TopMenu},
+        {_KDE_NET_WM_WINDOW_TYPE_ON_SCREEN_DISPLAY, NET::OnScreenDisplay},
+        {_KDE_NET_WM_WINDOW_TYPE_CRITICAL_NOTIFICATION, NET::CriticalNotification},
+        {_KDE_NET_WM_WINDOW_TYPE_APPLET_POPUP, NET::AppletPopup},
+    };
+    static const std::pair<KwsAtom, NET::Action> actions[] = {
+        {_NET_WM_ACTION_MOVE, NET::ActionMove},
+        {_NET_WM_ACTION_RESIZE, NET::ActionResize},
+        {_NET_WM_ACTION_MINIMIZE, NET::ActionMinimize},
+        {_NET_WM_ACTION_SHADE, NET::ActionShade},
+        {_NET_WM_ACTION_STICK, NET::ActionStick},
+        {_NET_WM_ACTION_MAXIMIZE_VERT, NET::ActionMaxVert},
+        {_NET_WM_ACTION_MAXIMIZE_HORZ, NET::ActionMaxHoriz},
+        {_NET_WM_ACTION_FULLSCREEN, NET::ActionFullScreen},
+        {_NET_WM_ACTION_CHANGE_DESKTOP, NET::ActionChangeDesktop},
+        {_NET_WM_ACTION_CLOSE, NET::ActionClose},
+    };
+
+    m_meanings.reserve(std::size(states) + std::size(types) + std::size(actions));
+    // atoms which could not be interned must not match anything
+    for (const auto &[atom, state] : states) {
+        if (m_atoms[atom] != XCB_ATOM_NONE) {
+            m_meanings[m_atoms[atom]].state = state;
+        }
+    }
+    for (const auto &[atom, type] : types) {
+        if (m_atoms[atom] != XCB_ATOM_NONE) {
+            m_meanings[m_atoms[atom]].type = type;
+        }
+    }
+    for (const auto &[atom, action] : actions) {
+        if (m_atoms[atom] != XCB_ATOM_NONE) {
+            m_meanings[m_atoms[atom]].action = action;
+        }
+    }
+}
+
 static void readIcon(xcb_connection_t *c, const xcb_get_property_cookie_t cookie, NETRArray<NETIcon> &icons, int &icon_count)
 {
 #ifdef NETWMDEBUG
@@ -328,7 +901,7 @@ static void readIcon(xcb_connection_t *c, const xcb_get_property_cookie_t cookie
     icons.reset();
     icon_count = 0;
 
-    xcb_get_property_reply_t *reply = xcb_get_property_reply(c, cookie, nullptr);
+    xcb_get_property_reply_t *reply = KXcbInstrumentation::reply(xcb_get_property_reply, c, cookie, nullptr);
 
     if (!reply || reply->value_len < 3 || reply->format != 32 || reply->type != XCB_ATOM_CARDINAL) {
         if (reply) {
@@ -378,6 +951,130 @@ static void readIcon(xcb_connection_t *c, const xcb_get_property_cookie_t cookie
 #endif
 }
 
+namespace
+{
+// the last value written to a property while a transaction is open
+struct PendingWrite {
+    xcb_window_t window;
+    xcb_atom_t property;
+    xcb_atom_t type;
+    uint8_t format;
+    uint32_t length;
+    // null if the property is deleted
+    QByteArray data;
+};
+
+struct PropertyTransaction {
+    int depth = 0;
+    int droppedWrites = 0;
+    // in the order the properties were first written
+    QList<PendingWrite> writes;
+    QHash<QPair<xcb_window_t, xcb_atom_t>, qsizetype> writeIndex;
+};
+}
+
+typedef QHash<xcb_connection_t *, PropertyTransaction> PropertyTransactionHash;
+Q_GLOBAL_STATIC(PropertyTransactionHash, s_propertyTransactions)
+Q_GLOBAL_STATIC(QMutex, s_propertyTransactionsMutex)
+// spares the setters the lock while no transaction is open anywhere
+static std::atomic<int> s_openPropertyTransactions{0};
+
+static bool queuePropertyWrite(xcb_connection_t *c, PendingWrite &&write)
+{
+    if (s_openPropertyTransactions.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+    QMutexLocker locker(s_propertyTransactionsMutex());
+    auto it = s_propertyTransactions->find(c);
+    if (it == s_propertyTransactions->end()) {
+        return false;
+    }
+    const QPair<xcb_window_t, xcb_atom_t> key(write.window, write.property);
+    auto index = it->writeIndex.constFind(key);
+    if (index != it->writeIndex.constEnd()) {
+        it->writes[index.value()] = std::move(write);
+        ++it->droppedWrites;
+    } else {
+        it->writeIndex.insert(key, it->writes.size());
+        it->writes.append(std::move(write));
+    }
+    return true;
+}
+
+static void changeProperty(xcb_connection_t *c, xcb_window_t window, xcb_atom_t property, xcb_atom_t type, uint8_t format, uint32_t length, const void *data)
+{
+    // an empty value still has to be told apart from a deleted property
+    QByteArray value(static_cast<const char *>(data), length * (format / 8));
+    if (value.isNull()) {
+        value = QByteArray("");
+    }
+    if (!queuePropertyWrite(c, PendingWrite{window, property, type, format, length, std::move(value)})) {
+        xcb_change_property(c, XCB_PROP_MODE_REPLACE, window, property, type, format, length, data);
+    }
+}
+
+static void deleteProperty(xcb_connection_t *c, xcb_window_t window, xcb_atom_t property)
+{
+    if (!queuePropertyWrite(c, PendingWrite{window, property, XCB_ATOM_NONE, 0, 0, QByteArray()})) {
+        xcb_delete_property(c, window, property);
+    }
+}
+
+NETPropertyTransaction::NETPropertyTransaction(xcb_connection_t *connection)
+    : m_connection(connection)
+{
+    QMutexLocker locker(s_propertyTransactionsMutex());
+    PropertyTransaction &transaction = (*s_propertyTransactions)[m_connection];
+    if (transaction.depth++ == 0) {
+        s_openPropertyTransactions.fetch_add(1, std::memory_order_release);
+    }
+}
+
+NETPropertyTransaction::~NETPropertyTransaction()
+{
+    commit();
+}
+
+void NETPropertyTransaction::commit()
+{
+    if (m_committed) {
+        return;
+    }
+    m_committed = true;
+
+    PropertyTransaction transaction;
+    {
+        QMutexLocker locker(s_propertyTransactionsMutex());
+        auto it = s_propertyTransactions->find(m_connection);
+        Q_ASSERT(it != s_propertyTransactions->end());
+        m_droppedWrites = it->droppedWrites;
+        if (--it->depth > 0) {
+            return;
+        }
+        transaction = std::move(it.value());
+        s_propertyTransactions->erase(it);
+        s_openPropertyTransactions.fetch_sub(1, std::memory_order_release);
+    }
+
+    for (const PendingWrite &write : std::as_const(transaction.writes)) {
+        if (write.data.isNull()) {
+            xcb_delete_property(m_connection, write.window, write.property);
+        } else {
+            xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, write.window, write.property, write.type, write.format, write.length, write.data.constData());
+        }
+    }
+}
+
+int NETPropertyTransaction::droppedWrites() const
+{
+    if (m_committed) {
+        return m_droppedWrites;
+    }
+    QMutexLocker locker(s_propertyTransactionsMutex());
+    const auto it = s_propertyTransactions->constFind(m_connection);
+    return it != s_propertyTransactions->constEnd() ? it->droppedWrites : m_droppedWrites;
+}
+
 static void send_client_message(xcb_connection_t *c, uint32_t mask, xcb_window_t destination, xcb_window_t window, xcb_atom_t message, const uint32_t data[])
 {
     KXcbEvent<xcb_client_message_event_t> event;
@@ -636,7 +1333,7 @@ void NETRootInfo::setClientList(const xcb_window_t *windows, unsigned int count)
     fprintf(stderr, "NETRootInfo::setClientList: setting list with %ld windows\n", p->clients_count);
 #endif
 
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->root, p->atom(_NET_CLIENT_LIST), XCB_ATOM_WINDOW, 32, p->clients_count, (const void *)windows);
+    changeProperty(p->conn, p->root, p->atom(_NET_CLIENT_LIST), XCB_ATOM_WINDOW, 32, p->clients_count, (const void *)windows);
 }
 
 void NETRootInfo::setClientListStacking(const xcb_window_t *windows, unsigned int count)
@@ -653,14 +1350,7 @@ void NETRootInfo::setClientListStacking(const xcb_window_t *windows, unsigned in
     fprintf(stderr, "NETRootInfo::setClientListStacking: setting list with %ld windows\n", p->clients_count);
 #endif
 
-    xcb_change_property(p->conn,
-                        XCB_PROP_MODE_REPLACE,
-                        p->root,
-                        p->atom(_NET_CLIENT_LIST_STACKING),
-                        XCB_ATOM_WINDOW,
-                        32,
-                        p->stacking_count,
-                        (const void *)windows);
+    changeProperty(p->conn, p->root, p->atom(_NET_CLIENT_LIST_STACKING), XCB_ATOM_WINDOW, 32, p->stacking_count, (const void *)windows);
 }
 
 void NETRootInfo::setNumberOfDesktops(int numberOfDesktops)
@@ -672,7 +1362,7 @@ void NETRootInfo::setNumberOfDesktops(int numberOfDesktops)
     if (p->role == WindowManager) {
         p->number_of_desktops = numberOfDesktops;
         const uint32_t d = numberOfDesktops;
-        xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->root, p->atom(_NET_NUMBER_OF_DESKTOPS), XCB_ATOM_CARDINAL, 32, 1, (const void *)&d);
+        changeProperty(p->conn, p->root, p->atom(_NET_NUMBER_OF_DESKTOPS), XCB_ATOM_CARDINAL, 32, 1, (const void *)&d);
     } else {
         const uint32_t data[5] = {uint32_t(numberOfDesktops), 0, 0, 0, 0};
 
@@ -689,7 +1379,7 @@ void NETRootInfo::setCurrentDesktop(int desktop, bool ignore_viewport)
     if (p->role == WindowManager) {
         p->current_desktop = desktop;
         uint32_t d = p->current_desktop - 1;
-        xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->root, p->atom(_NET_CURRENT_DESKTOP), XCB_ATOM_CARDINAL, 32, 1, (const void *)&d);
+        changeProperty(p->conn, p->root, p->atom(_NET_CURRENT_DESKTOP), XCB_ATOM_CARDINAL, 32, 1, (const void *)&d);
     } else {
         if (!ignore_viewport && KX11Extras::mapViewport()) {
             KX11Extras::setCurrentDesktop(desktop);
@@ -740,7 +1430,7 @@ void NETRootInfo::setDesktopName(int desktop, const char *desktopName)
             proplen);
 #endif
 
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->root, p->atom(_NET_DESKTOP_NAMES), p->atom(UTF8_STRING), 8, proplen, (const void *)prop);
+    changeProperty(p->conn, p->root, p->atom(_NET_DESKTOP_NAMES), p->atom(UTF8_STRING), 8, proplen, (const void *)prop);
 
     delete[] prop;
 }
@@ -758,7 +1448,7 @@ void NETRootInfo::setDesktopGeometry(const NETSize &geometry)
         data[0] = p->geometry.width;
         data[1] = p->geometry.height;
 
-        xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->root, p->atom(_NET_DESKTOP_GEOMETRY), XCB_ATOM_CARDINAL, 32, 2, (const void *)data);
+        changeProperty(p->conn, p->root, p->atom(_NET_DESKTOP_GEOMETRY), XCB_ATOM_CARDINAL, 32, 2, (const void *)data);
     } else {
         uint32_t data[5] = {uint32_t(geometry.width), uint32_t(geometry.height), 0, 0, 0};
 
@@ -789,7 +1479,7 @@ void NETRootInfo::setDesktopViewport(int desktop, const NETPoint &viewport)
             data[i++] = p->viewport[d].y;
         }
 
-        xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->root, p->atom(_NET_DESKTOP_VIEWPORT), XCB_ATOM_CARDINAL, 32, l, (const void *)data);
+        changeProperty(p->conn, p->root, p->atom(_NET_DESKTOP_VIEWPORT), XCB_ATOM_CARDINAL, 32, l, (const void *)data);
 
         delete[] data;
     } else {
@@ -1137,9 +1827,9 @@ void NETRootInfo::setSupported()
         atoms[pnum++] = p->atom(_GTK_SHOW_WINDOW_MENU);
     }
 
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->root, p->atom(_NET_SUPPORTED), XCB_ATOM_ATOM, 32, pnum, (const void *)atoms);
+    changeProperty(p->conn, p->root, p->atom(_NET_SUPPORTED), XCB_ATOM_ATOM, 32, pnum, (const void *)atoms);
 
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->root, p->atom(_NET_SUPPORTING_WM_CHECK), XCB_ATOM_WINDOW, 32, 1, (const void *)&(p->supportwindow));
+    changeProperty(p->conn, p->root, p->atom(_NET_SUPPORTING_WM_CHECK), XCB_ATOM_WINDOW, 32, 1, (const void *)&(p->supportwindow));
 
 #ifdef NETWMDEBUG
     fprintf(stderr,
@@ -1151,28 +1841,23 @@ void NETRootInfo::setSupported()
             p->supportwindow);
 #endif
 
-    xcb_change_property(p->conn,
-                        XCB_PROP_MODE_REPLACE,
-                        p->supportwindow,
-                        p->atom(_NET_SUPPORTING_WM_CHECK),
-                        XCB_ATOM_WINDOW,
-                        32,
-                        1,
-                        (const void *)&(p->supportwindow));
-
-    xcb_change_property(p->conn,
-                        XCB_PROP_MODE_REPLACE,
-                        p->supportwindow,
-                        p->atom(_NET_WM_NAME),
-                        p->atom(UTF8_STRING),
-                        8,
-                        strlen(p->name),
-                        (const void *)p->name);
+    changeProperty(p->conn, p->supportwindow, p->atom(_NET_SUPPORTING_WM_CHECK), XCB_ATOM_WINDOW, 32, 1, (const void *)&(p->supportwindow));
+
+    changeProperty(p->conn, p->supportwindow, p->atom(_NET_WM_NAME), p->atom(UTF8_STRING), 8, strlen(p->name), (const void *)p->name);
 }
 
 void NETRootInfo::updateSupportedProperties(xcb_atom_t atom)
 {
-    if (atom == p->atom(_NET_SUPPORTED)) {
+    // window types, states and actions
+    if (const NETAtomMeaning *meaning = p->atoms->meaning(atom)) {
+        if (meaning->type != Unknown) {
+            p->windowTypes |= WindowTypeMask(1u << meaning->type);
+        }
+        p->states |= meaning->state;
+        p->actions |= meaning->action;
+    }
+
+    else if (atom == p->atom(_NET_SUPPORTED)) {
         p->properties |= Supported;
     }
 
@@ -1269,86 +1954,10 @@ void NETRootInfo::updateSupportedProperties(xcb_atom_t atom)
         p->properties |= WMWindowType;
     }
 
-    // Application window types
-    else if (atom == p->atom(_NET_WM_WINDOW_TYPE_NORMAL)) {
-        p->windowTypes |= NormalMask;
-    } else if (atom == p->atom(_NET_WM_WINDOW_TYPE_DESKTOP)) {
-        p->windowTypes |= DesktopMask;
-    } else if (atom == p->atom(_NET_WM_WINDOW_TYPE_DOCK)) {
-        p->windowTypes |= DockMask;
-    } else if (atom == p->atom(_NET_WM_WINDOW_TYPE_TOOLBAR)) {
-        p->windowTypes |= ToolbarMask;
-    } else if (atom == p->atom(_NET_WM_WINDOW_TYPE_MENU)) {
-        p->windowTypes |= MenuMask;
-    } else if (atom == p->atom(_NET_WM_WINDOW_TYPE_DIALOG)) {
-        p->windowTypes |= DialogMask;
-    } else if (atom == p->atom(_NET_WM_WINDOW_TYPE_UTILITY)) {
-        p->windowTypes |= UtilityMask;
-    } else if (atom == p->atom(_NET_WM_WINDOW_TYPE_SPLASH)) {
-        p->windowTypes |= SplashMask;
-    } else if (atom == p->atom(_NET_WM_WINDOW_TYPE_DROPDOWN_MENU)) {
-        p->windowTypes |= DropdownMenuMask;
-    } else if (atom == p->atom(_NET_WM_WINDOW_TYPE_POPUP_MENU)) {
-        p->windowTypes |= PopupMenuMask;
-    } else if (atom == p->atom(_NET_WM_WINDOW_TYPE_TOOLTIP)) {
-        p->windowTypes |= TooltipMask;
-    } else if (atom == p->atom(_NET_WM_WINDOW_TYPE_NOTIFICATION)) {
-        p->windowTypes |= NotificationMask;
-    } else if (atom == p->atom(_NET_WM_WINDOW_TYPE_COMBO)) {
-        p->windowTypes |= ComboBoxMask;
-    } else if (atom == p->atom(_NET_WM_WINDOW_TYPE_DND)) {
-        p->windowTypes |= DNDIconMask;
-    }
-    // KDE extensions
-    else if (atom == p->atom(_KDE_NET_WM_WINDOW_TYPE_OVERRIDE)) {
-        p->windowTypes |= OverrideMask;
-    } else if (atom == p->atom(_KDE_NET_WM_WINDOW_TYPE_TOPMENU)) {
-        p->windowTypes |= TopMenuMask;
-    } else if (atom == p->atom(_KDE_NET_WM_WINDOW_TYPE_ON_SCREEN_DISPLAY)) {
-        p->windowTypes |= OnScreenDisplayMask;
-    } else if (atom == p->atom(_KDE_NET_WM_WINDOW_TYPE_CRITICAL_NOTIFICATION)) {
-        p->windowTypes |= CriticalNotificationMask;
-    } else if (atom == p->atom(_KDE_NET_WM_WINDOW_TYPE_APPLET_POPUP)) {
-        p->windowTypes |= AppletPopupMask;
-    }
-
     else if (atom == p->atom(_NET_WM_STATE)) {
         p->properties |= WMState;
     }
 
-    // Application window states
-    else if (atom == p->atom(_NET_WM_STATE_MODAL)) {
-        p->states |= Modal;
-    } else if (atom == p->atom(_NET_WM_STATE_STICKY)) {
-        p->states |= Sticky;
-    } else if (atom == p->atom(_NET_WM_STATE_MAXIMIZED_VERT)) {
-        p->states |= MaxVert;
-    } else if (atom == p->atom(_NET_WM_STATE_MAXIMIZED_HORZ)) {
-        p->states |= MaxHoriz;
-    } else if (atom == p->atom(_NET_WM_STATE_SHADED)) {
-        p->states |= Shaded;
-    } else if (atom == p->atom(_NET_WM_STATE_SKIP_TASKBAR)) {
-        p->states |= SkipTaskbar;
-    } else if (atom == p->atom(_NET_WM_STATE_SKIP_PAGER)) {
-        p->states |= SkipPager;
-    } else if (atom == p->atom(_KDE_NET_WM_STATE_SKIP_SWITCHER)) {
-        p->states |= SkipSwitcher;
-    } else if (atom == p->atom(_NET_WM_STATE_HIDDEN)) {
-        p->states |= Hidden;
-    } else if (atom == p->atom(_NET_WM_STATE_FULLSCREEN)) {
-        p->states |= FullScreen;
-    } else if (atom == p->atom(_NET_WM_STATE_ABOVE)) {
-        p->states |= KeepAbove;
-    } else if (atom == p->atom(_NET_WM_STATE_BELOW)) {
-        p->states |= KeepBelow;
-    } else if (atom == p->atom(_NET_WM_STATE_DEMANDS_ATTENTION)) {
-        p->states |= DemandsAttention;
-    } else if (atom == p->atom(_NET_WM_STATE_STAYS_ON_TOP)) {
-        p->states |= KeepAbove;
-    } else if (atom == p->atom(_NET_WM_STATE_FOCUSED)) {
-        p->states |= Focused;
-    }
-
     else if (atom == p->atom(_NET_WM_STRUT)) {
         p->properties |= WMStrut;
     }
@@ -1397,29 +2006,6 @@ void NETRootInfo::updateSupportedProperties(xcb_atom_t atom)
         p->properties2 |= WM2AllowedActions;
     }
 
-    // Actions
-    else if (atom == p->atom(_NET_WM_ACTION_MOVE)) {
-        p->actions |= ActionMove;
-    } else if (atom == p->atom(_NET_WM_ACTION_RESIZE)) {
-        p->actions |= ActionResize;
-    } else if (atom == p->atom(_NET_WM_ACTION_MINIMIZE)) {
-        p->actions |= ActionMinimize;
-    } else if (atom == p->atom(_NET_WM_ACTION_SHADE)) {
-        p->actions |= ActionShade;
-    } else if (atom == p->atom(_NET_WM_ACTION_STICK)) {
-        p->actions |= ActionStick;
-    } else if (atom == p->atom(_NET_WM_ACTION_MAXIMIZE_VERT)) {
-        p->actions |= ActionMaxVert;
-    } else if (atom == p->atom(_NET_WM_ACTION_MAXIMIZE_HORZ)) {
-        p->actions |= ActionMaxHoriz;
-    } else if (atom == p->atom(_NET_WM_ACTION_FULLSCREEN)) {
-        p->actions |= ActionFullScreen;
-    } else if (atom == p->atom(_NET_WM_ACTION_CHANGE_DESKTOP)) {
-        p->actions |= ActionChangeDesktop;
-    } else if (atom == p->atom(_NET_WM_ACTION_CLOSE)) {
-        p->actions |= ActionClose;
-    }
-
     else if (atom == p->atom(_NET_FRAME_EXTENTS)) {
         p->properties |= WMFrameExtents;
     } else if (atom == p->atom(_KDE_NET_WM_FRAME_STRUT)) {
@@ -1481,7 +2067,7 @@ void NETRootInfo::setActiveWindow(xcb_window_t window, NET::RequestSource src, x
     if (p->role == WindowManager) {
         p->active = window;
 
-        xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->root, p->atom(_NET_ACTIVE_WINDOW), XCB_ATOM_WINDOW, 32, 1, (const void *)&(p->active));
+        changeProperty(p->conn, p->root, p->atom(_NET_ACTIVE_WINDOW), XCB_ATOM_WINDOW, 32, 1, (const void *)&(p->active));
     } else {
         const uint32_t data[5] = {src, timestamp, active_window, 0, 0};
 
@@ -1518,7 +2104,7 @@ void NETRootInfo::setWorkArea(int desktop, const NETRect &workarea)
         wa[o++] = p->workarea[i].size.height;
     }
 
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->root, p->atom(_NET_WORKAREA), XCB_ATOM_CARDINAL, 32, p->number_of_desktops * 4, (const void *)wa);
+    changeProperty(p->conn, p->root, p->atom(_NET_WORKAREA), XCB_ATOM_CARDINAL, 32, p->number_of_desktops * 4, (const void *)wa);
 
     delete[] wa;
 }
@@ -1537,14 +2123,7 @@ void NETRootInfo::setVirtualRoots(const xcb_window_t *windows, unsigned int coun
     fprintf(stderr, "NETRootInfo::setVirtualRoots: setting list with %ld windows\n", p->virtual_roots_count);
 #endif
 
-    xcb_change_property(p->conn,
-                        XCB_PROP_MODE_REPLACE,
-                        p->root,
-                        p->atom(_NET_VIRTUAL_ROOTS),
-                        XCB_ATOM_WINDOW,
-                        32,
-                        p->virtual_roots_count,
-                        (const void *)windows);
+    changeProperty(p->conn, p->root, p->atom(_NET_VIRTUAL_ROOTS), XCB_ATOM_WINDOW, 32, p->virtual_roots_count, (const void *)windows);
 }
 
 void NETRootInfo::setDesktopLayout(NET::Orientation orientation, int columns, int rows, NET::DesktopLayoutCorner corner)
@@ -1564,14 +2143,14 @@ void NETRootInfo::setDesktopLayout(NET::Orientation orientation, int columns, in
     data[2] = rows;
     data[3] = corner;
 
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->root, p->atom(_NET_DESKTOP_LAYOUT), XCB_ATOM_CARDINAL, 32, 4, (const void *)data);
+    changeProperty(p->conn, p->root, p->atom(_NET_DESKTOP_LAYOUT), XCB_ATOM_CARDINAL, 32, 4, (const void *)data);
 }
 
 void NETRootInfo::setShowingDesktop(bool showing)
 {
     if (p->role == WindowManager) {
         uint32_t d = p->showing_desktop = showing;
-        xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->root, p->atom(_NET_SHOWING_DESKTOP), XCB_ATOM_CARDINAL, 32, 1, (const void *)&d);
+        changeProperty(p->conn, p->root, p->atom(_NET_SHOWING_DESKTOP), XCB_ATOM_CARDINAL, 32, 1, (const void *)&d);
     } else {
         uint32_t data[5] = {uint32_t(showing ? 1 : 0), 0, 0, 0, 0};
         send_client_message(p->conn, netwm_sendevent_mask, p->root, p->root, p->atom(_NET_SHOWING_DESKTOP), data);
@@ -1902,348 +2481,309 @@ void NETRootInfo::event(xcb_generic_event_t *event, NET::Properties *properties,
 
 void NETRootInfo::update(NET::Properties properties, NET::Properties2 properties2)
 {
-    NET::Properties dirty = properties & p->clientProperties;
-    NET::Properties2 dirty2 = properties2 & p->clientProperties2;
+    static constexpr NETPropertyFetch<NETRootInfo> propertyTable[] = {
+        {Supported, {}, _NET_SUPPORTED, XCB_ATOM_ATOM, MAX_PROP_SIZE, [](NETRootInfo *q, const xcb_get_property_cookie_t *cookies) {
+            NETRootInfoPrivate *p = q->p;
 
-    xcb_get_property_cookie_t cookies[255];
-    xcb_get_property_cookie_t wm_name_cookie;
-    int c = 0;
+            // Only in Client mode
+            p->properties = NET::Properties();
+            p->properties2 = NET::Properties2();
+            p->windowTypes = NET::WindowTypes();
+            p->states = NET::States();
+            p->actions = NET::Actions();
 
-    // Send the property requests
-    if (dirty & Supported) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->root, p->atom(_NET_SUPPORTED), XCB_ATOM_ATOM, 0, MAX_PROP_SIZE);
-    }
+            const QList<xcb_atom_t> atoms = get_array_reply<xcb_atom_t>(p->conn, cookies[0], XCB_ATOM_ATOM);
+            for (const xcb_atom_t atom : atoms) {
+                q->updateSupportedProperties(atom);
+            }
+        }},
+        {ClientList, {}, _NET_CLIENT_LIST, XCB_ATOM_WINDOW, MAX_PROP_SIZE, [](NETRootInfo *q, const xcb_get_property_cookie_t *cookies) {
+            NETRootInfoPrivate *p = q->p;
 
-    if (dirty & ClientList) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->root, p->atom(_NET_CLIENT_LIST), XCB_ATOM_WINDOW, 0, MAX_PROP_SIZE);
-    }
+            QList<xcb_window_t> clientsToRemove;
+            QList<xcb_window_t> clientsToAdd;
 
-    if (dirty & ClientListStacking) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->root, p->atom(_NET_CLIENT_LIST_STACKING), XCB_ATOM_WINDOW, 0, MAX_PROP_SIZE);
-    }
+            QList<xcb_window_t> clients = get_array_reply<xcb_window_t>(p->conn, cookies[0], XCB_ATOM_WINDOW);
+            std::sort(clients.begin(), clients.end());
 
-    if (dirty & NumberOfDesktops) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->root, p->atom(_NET_NUMBER_OF_DESKTOPS), XCB_ATOM_CARDINAL, 0, 1);
-    }
+            if (p->clients) {
+                if (p->role == Client) {
+                    int new_index = 0;
+                    int old_index = 0;
+                    int old_count = p->clients_count;
+                    int new_count = clients.count();
 
-    if (dirty & DesktopGeometry) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->root, p->atom(_NET_DESKTOP_GEOMETRY), XCB_ATOM_CARDINAL, 0, 2);
-    }
+                    while (old_index < old_count || new_index < new_count) {
+                        if (old_index == old_count) {
+                            clientsToAdd.append(clients[new_index++]);
+                        } else if (new_index == new_count) {
+                            clientsToRemove.append(p->clients[old_index++]);
+                        } else {
+                            if (p->clients[old_index] < clients[new_index]) {
+                                clientsToRemove.append(p->clients[old_index++]);
+                            } else if (clients[new_index] < p->clients[old_index]) {
+                                clientsToAdd.append(clients[new_index++]);
+                            } else {
+                                new_index++;
+                                old_index++;
+                            }
+                        }
+                    }
+                }
 
-    if (dirty & DesktopViewport) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->root, p->atom(_NET_DESKTOP_VIEWPORT), XCB_ATOM_CARDINAL, 0, MAX_PROP_SIZE);
-    }
+                delete[] p->clients;
+                p->clients = nullptr;
+            } else {
+#ifdef NETWMDEBUG
+                fprintf(stderr, "NETRootInfo::update: client list null, creating\n");
+#endif
 
-    if (dirty & CurrentDesktop) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->root, p->atom(_NET_CURRENT_DESKTOP), XCB_ATOM_CARDINAL, 0, 1);
-    }
-
-    if (dirty & DesktopNames) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->root, p->atom(_NET_DESKTOP_NAMES), p->atom(UTF8_STRING), 0, MAX_PROP_SIZE);
-    }
-
-    if (dirty & ActiveWindow) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->root, p->atom(_NET_ACTIVE_WINDOW), XCB_ATOM_WINDOW, 0, 1);
-    }
-
-    if (dirty & WorkArea) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->root, p->atom(_NET_WORKAREA), XCB_ATOM_CARDINAL, 0, MAX_PROP_SIZE);
-    }
-
-    if (dirty & SupportingWMCheck) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->root, p->atom(_NET_SUPPORTING_WM_CHECK), XCB_ATOM_WINDOW, 0, 1);
-    }
-
-    if (dirty & VirtualRoots) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->root, p->atom(_NET_VIRTUAL_ROOTS), XCB_ATOM_WINDOW, 0, 1);
-    }
-
-    if (dirty2 & WM2DesktopLayout) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->root, p->atom(_NET_DESKTOP_LAYOUT), XCB_ATOM_CARDINAL, 0, MAX_PROP_SIZE);
-    }
-
-    if (dirty2 & WM2ShowingDesktop) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->root, p->atom(_NET_SHOWING_DESKTOP), XCB_ATOM_CARDINAL, 0, 1);
-    }
+                clientsToAdd.reserve(clients.count());
+                for (int i = 0; i < clients.count(); i++) {
+                    clientsToAdd.append(clients[i]);
+                }
+            }
 
-    // Get the replies
-    c = 0;
-
-    if (dirty & Supported) {
-        // Only in Client mode
-        p->properties = NET::Properties();
-        p->properties2 = NET::Properties2();
-        p->windowTypes = NET::WindowTypes();
-        p->states = NET::States();
-        p->actions = NET::Actions();
-
-        const QList<xcb_atom_t> atoms = get_array_reply<xcb_atom_t>(p->conn, cookies[c++], XCB_ATOM_ATOM);
-        for (const xcb_atom_t atom : atoms) {
-            updateSupportedProperties(atom);
-        }
-    }
-
-    if (dirty & ClientList) {
-        QList<xcb_window_t> clientsToRemove;
-        QList<xcb_window_t> clientsToAdd;
-
-        QList<xcb_window_t> clients = get_array_reply<xcb_window_t>(p->conn, cookies[c++], XCB_ATOM_WINDOW);
-        std::sort(clients.begin(), clients.end());
-
-        if (p->clients) {
-            if (p->role == Client) {
-                int new_index = 0;
-                int old_index = 0;
-                int old_count = p->clients_count;
-                int new_count = clients.count();
-
-                while (old_index < old_count || new_index < new_count) {
-                    if (old_index == old_count) {
-                        clientsToAdd.append(clients[new_index++]);
-                    } else if (new_index == new_count) {
-                        clientsToRemove.append(p->clients[old_index++]);
-                    } else {
-                        if (p->clients[old_index] < clients[new_index]) {
-                            clientsToRemove.append(p->clients[old_index++]);
-                        } else if (clients[new_index] < p->clients[old_index]) {
-                            clientsToAdd.append(clients[new_index++]);
-                        } else {
-                            new_index++;
-                            old_index++;
-                        }
-                    }
+            if (!clients.isEmpty()) {
+                p->clients_count = clients.count();
+                p->clients = new xcb_window_t[clients.count()];
+                for (int i = 0; i < clients.count(); i++) {
+                    p->clients[i] = clients.at(i);
                 }
             }
 
-            delete[] p->clients;
-            p->clients = nullptr;
-        } else {
 #ifdef NETWMDEBUG
-            fprintf(stderr, "NETRootInfo::update: client list null, creating\n");
+            fprintf(stderr, "NETRootInfo::update: client list updated (%ld clients)\n", p->clients_count);
 #endif
 
-            clientsToAdd.reserve(clients.count());
-            for (int i = 0; i < clients.count(); i++) {
-                clientsToAdd.append(clients[i]);
+            for (int i = 0; i < clientsToRemove.size(); ++i) {
+                q->removeClient(clientsToRemove.at(i));
             }
-        }
 
-        if (!clients.isEmpty()) {
-            p->clients_count = clients.count();
-            p->clients = new xcb_window_t[clients.count()];
-            for (int i = 0; i < clients.count(); i++) {
-                p->clients[i] = clients.at(i);
+            if (!clientsToAdd.isEmpty()) {
+                NETRootInfoAddClientsData data{&clientsToAdd};
+                q->virtual_hook(NETRootInfoAddClientsHook, &data);
+                if (!data.handled) {
+                    for (int i = 0; i < clientsToAdd.size(); ++i) {
+                        q->addClient(clientsToAdd.at(i));
+                    }
+                }
             }
-        }
+        }},
+        {ClientListStacking, {}, _NET_CLIENT_LIST_STACKING, XCB_ATOM_WINDOW, MAX_PROP_SIZE, [](NETRootInfo *q, const xcb_get_property_cookie_t *cookies) {
+            NETRootInfoPrivate *p = q->p;
 
-#ifdef NETWMDEBUG
-        fprintf(stderr, "NETRootInfo::update: client list updated (%ld clients)\n", p->clients_count);
-#endif
+            p->stacking_count = 0;
 
-        for (int i = 0; i < clientsToRemove.size(); ++i) {
-            removeClient(clientsToRemove.at(i));
-        }
-
-        for (int i = 0; i < clientsToAdd.size(); ++i) {
-            addClient(clientsToAdd.at(i));
-        }
-    }
-
-    if (dirty & ClientListStacking) {
-        p->stacking_count = 0;
-
-        delete[] p->stacking;
-        p->stacking = nullptr;
+            delete[] p->stacking;
+            p->stacking = nullptr;
 
-        const QList<xcb_window_t> wins = get_array_reply<xcb_window_t>(p->conn, cookies[c++], XCB_ATOM_WINDOW);
+            const QList<xcb_window_t> wins = get_array_reply<xcb_window_t>(p->conn, cookies[0], XCB_ATOM_WINDOW);
 
-        if (!wins.isEmpty()) {
-            p->stacking_count = wins.count();
-            p->stacking = new xcb_window_t[wins.count()];
-            for (int i = 0; i < wins.count(); i++) {
-                p->stacking[i] = wins.at(i);
+            if (!wins.isEmpty()) {
+                p->stacking_count = wins.count();
+                p->stacking = new xcb_window_t[wins.count()];
+                for (int i = 0; i < wins.count(); i++) {
+                    p->stacking[i] = wins.at(i);
+                }
             }
-        }
 
 #ifdef NETWMDEBUG
-        fprintf(stderr, "NETRootInfo::update: client stacking updated (%ld clients)\n", p->stacking_count);
+            fprintf(stderr, "NETRootInfo::update: client stacking updated (%ld clients)\n", p->stacking_count);
 #endif
-    }
+        }},
+        {NumberOfDesktops, {}, _NET_NUMBER_OF_DESKTOPS, XCB_ATOM_CARDINAL, 1, [](NETRootInfo *q, const xcb_get_property_cookie_t *cookies) {
+            NETRootInfoPrivate *p = q->p;
 
-    if (dirty & NumberOfDesktops) {
-        p->number_of_desktops = get_value_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL, 0);
+            p->number_of_desktops = get_value_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL, 0);
 
 #ifdef NETWMDEBUG
-        fprintf(stderr, "NETRootInfo::update: number of desktops = %d\n", p->number_of_desktops);
+            fprintf(stderr, "NETRootInfo::update: number of desktops = %d\n", p->number_of_desktops);
 #endif
-    }
+        }},
+        {DesktopGeometry, {}, _NET_DESKTOP_GEOMETRY, XCB_ATOM_CARDINAL, 2, [](NETRootInfo *q, const xcb_get_property_cookie_t *cookies) {
+            NETRootInfoPrivate *p = q->p;
 
-    if (dirty & DesktopGeometry) {
-        p->geometry = p->rootSize;
+            p->geometry = p->rootSize;
 
-        const QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL);
-        if (data.count() == 2) {
-            p->geometry.width = data.at(0);
-            p->geometry.height = data.at(1);
-        }
+            const QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL);
+            if (data.count() == 2) {
+                p->geometry.width = data.at(0);
+                p->geometry.height = data.at(1);
+            }
 
 #ifdef NETWMDEBUG
-        fprintf(stderr, "NETRootInfo::update: desktop geometry updated\n");
+            fprintf(stderr, "NETRootInfo::update: desktop geometry updated\n");
 #endif
-    }
+        }},
+        {DesktopViewport, {}, _NET_DESKTOP_VIEWPORT, XCB_ATOM_CARDINAL, MAX_PROP_SIZE, [](NETRootInfo *q, const xcb_get_property_cookie_t *cookies) {
+            NETRootInfoPrivate *p = q->p;
 
-    if (dirty & DesktopViewport) {
-        for (int i = 0; i < p->viewport.size(); i++) {
-            p->viewport[i].x = p->viewport[i].y = 0;
-        }
+            for (int i = 0; i < p->viewport.size(); i++) {
+                p->viewport[i].x = p->viewport[i].y = 0;
+            }
 
-        const QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL);
+            const QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL);
 
-        if (data.count() >= 2) {
-            int n = data.count() / 2;
-            for (int d = 0, i = 0; d < n; d++) {
-                p->viewport[d].x = data[i++];
-                p->viewport[d].y = data[i++];
-            }
+            if (data.count() >= 2) {
+                int n = data.count() / 2;
+                for (int d = 0, i = 0; d < n; d++) {
+                    p->viewport[d].x = data[i++];
+                    p->viewport[d].y = data[i++];
+                }
 
 #ifdef NETWMDEBUG
-            fprintf(stderr, "NETRootInfo::update: desktop viewport array updated (%d entries)\n", p->viewport.size());
+                fprintf(stderr, "NETRootInfo::update: desktop viewport array updated (%d entries)\n", p->viewport.size());
 
-            if (data.count() % 2 != 0) {
-                fprintf(stderr,
-                        "NETRootInfo::update(): desktop viewport array "
-                        "size not a multiple of 2\n");
-            }
+                if (data.count() % 2 != 0) {
+                    fprintf(stderr,
+                            "NETRootInfo::update(): desktop viewport array "
+                            "size not a multiple of 2\n");
+                }
 #endif
-        }
-    }
+            }
+        }},
+        {CurrentDesktop, {}, _NET_CURRENT_DESKTOP, XCB_ATOM_CARDINAL, 1, [](NETRootInfo *q, const xcb_get_property_cookie_t *cookies) {
+            NETRootInfoPrivate *p = q->p;
 
-    if (dirty & CurrentDesktop) {
-        p->current_desktop = get_value_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL, 0) + 1;
+            p->current_desktop = get_value_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL, 0) + 1;
 
 #ifdef NETWMDEBUG
-        fprintf(stderr, "NETRootInfo::update: current desktop = %d\n", p->current_desktop);
+            fprintf(stderr, "NETRootInfo::update: current desktop = %d\n", p->current_desktop);
 #endif
-    }
+        }},
+        {DesktopNames, {}, _NET_DESKTOP_NAMES, UTF8_STRING, MAX_PROP_SIZE, [](NETRootInfo *q, const xcb_get_property_cookie_t *cookies) {
+            NETRootInfoPrivate *p = q->p;
 
-    if (dirty & DesktopNames) {
-        for (int i = 0; i < p->desktop_names.size(); ++i) {
-            delete[] p->desktop_names[i];
-        }
+            for (int i = 0; i < p->desktop_names.size(); ++i) {
+                delete[] p->desktop_names[i];
+            }
 
-        p->desktop_names.reset();
+            p->desktop_names.reset();
 
-        const QList<QByteArray> names = get_stringlist_reply(p->conn, cookies[c++], p->atom(UTF8_STRING));
-        for (int i = 0; i < names.count(); i++) {
-            p->desktop_names[i] = nstrndup(names[i].constData(), names[i].length());
-        }
+            const QList<QByteArray> names = get_stringlist_reply(p->conn, cookies[0], p->atom(UTF8_STRING));
+            for (int i = 0; i < names.count(); i++) {
+                p->desktop_names[i] = nstrndup(names[i].constData(), names[i].length());
+            }
 
 #ifdef NETWMDEBUG
-        fprintf(stderr, "NETRootInfo::update: desktop names array updated (%d entries)\n", p->desktop_names.size());
+            fprintf(stderr, "NETRootInfo::update: desktop names array updated (%d entries)\n", p->desktop_names.size());
 #endif
-    }
+        }},
+        {ActiveWindow, {}, _NET_ACTIVE_WINDOW, XCB_ATOM_WINDOW, 1, [](NETRootInfo *q, const xcb_get_property_cookie_t *cookies) {
+            NETRootInfoPrivate *p = q->p;
 
-    if (dirty & ActiveWindow) {
-        p->active = get_value_reply<xcb_window_t>(p->conn, cookies[c++], XCB_ATOM_WINDOW, 0);
+            p->active = get_value_reply<xcb_window_t>(p->conn, cookies[0], XCB_ATOM_WINDOW, 0);
 
 #ifdef NETWMDEBUG
-        fprintf(stderr, "NETRootInfo::update: active window = 0x%lx\n", p->active);
+            fprintf(stderr, "NETRootInfo::update: active window = 0x%lx\n", p->active);
 #endif
-    }
-
-    if (dirty & WorkArea) {
-        p->workarea.reset();
-
-        const QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL);
-        if (data.count() == p->number_of_desktops * 4) {
-            for (int i = 0, j = 0; i < p->number_of_desktops; i++) {
-                p->workarea[i].pos.x = data[j++];
-                p->workarea[i].pos.y = data[j++];
-                p->workarea[i].size.width = data[j++];
-                p->workarea[i].size.height = data[j++];
+        }},
+        {WorkArea, {}, _NET_WORKAREA, XCB_ATOM_CARDINAL, MAX_PROP_SIZE, [](NETRootInfo *q, const xcb_get_property_cookie_t *cookies) {
+            NETRootInfoPrivate *p = q->p;
+
+            p->workarea.reset();
+
+            const QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL);
+            if (data.count() == p->number_of_desktops * 4) {
+                for (int i = 0, j = 0; i < p->number_of_desktops; i++) {
+                    p->workarea[i].pos.x = data[j++];
+                    p->workarea[i].pos.y = data[j++];
+                    p->workarea[i].size.width = data[j++];
+                    p->workarea[i].size.height = data[j++];
+                }
             }
-        }
 
 #ifdef NETWMDEBUG
-        fprintf(stderr, "NETRootInfo::update: work area array updated (%d entries)\n", p->workarea.size());
+            fprintf(stderr, "NETRootInfo::update: work area array updated (%d entries)\n", p->workarea.size());
 #endif
-    }
+        }},
+        {SupportingWMCheck, {}, _NET_SUPPORTING_WM_CHECK, XCB_ATOM_WINDOW, 1, [](NETRootInfo *q, const xcb_get_property_cookie_t *cookies) {
+            NETRootInfoPrivate *p = q->p;
 
-    if (dirty & SupportingWMCheck) {
-        delete[] p->name;
-        p->name = nullptr;
+            delete[] p->name;
+            p->name = nullptr;
 
-        p->supportwindow = get_value_reply<xcb_window_t>(p->conn, cookies[c++], XCB_ATOM_WINDOW, 0);
+            p->supportwindow = get_value_reply<xcb_window_t>(p->conn, cookies[0], XCB_ATOM_WINDOW, 0);
+        }},
+        {VirtualRoots, {}, _NET_VIRTUAL_ROOTS, XCB_ATOM_WINDOW, 1, [](NETRootInfo *q, const xcb_get_property_cookie_t *cookies) {
+            NETRootInfoPrivate *p = q->p;
 
-        // We'll get the reply for this request at the bottom of this function,
-        // after we've processing the other pending replies
-        if (p->supportwindow) {
-            wm_name_cookie = xcb_get_property(p->conn, false, p->supportwindow, p->atom(_NET_WM_NAME), p->atom(UTF8_STRING), 0, MAX_PROP_SIZE);
-        }
-    }
+            p->virtual_roots_count = 0;
 
-    if (dirty & VirtualRoots) {
-        p->virtual_roots_count = 0;
+            delete[] p->virtual_roots;
+            p->virtual_roots = nullptr;
 
-        delete[] p->virtual_roots;
-        p->virtual_roots = nullptr;
-
-        const QList<xcb_window_t> wins = get_array_reply<xcb_window_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL);
+            const QList<xcb_window_t> wins = get_array_reply<xcb_window_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL);
 
-        if (!wins.isEmpty()) {
-            p->virtual_roots_count = wins.count();
-            p->virtual_roots = new xcb_window_t[wins.count()];
-            for (int i = 0; i < wins.count(); i++) {
-                p->virtual_roots[i] = wins.at(i);
+            if (!wins.isEmpty()) {
+                p->virtual_roots_count = wins.count();
+                p->virtual_roots = new xcb_window_t[wins.count()];
+                for (int i = 0; i < wins.count(); i++) {
+                    p->virtual_roots[i] = wins.at(i);
+                }
             }
-        }
 
 #ifdef NETWMDEBUG
-        fprintf(stderr, "NETRootInfo::updated: virtual roots updated (%ld windows)\n", p->virtual_roots_count);
+            fprintf(stderr, "NETRootInfo::updated: virtual roots updated (%ld windows)\n", p->virtual_roots_count);
 #endif
-    }
+        }},
+        {{}, WM2DesktopLayout, _NET_DESKTOP_LAYOUT, XCB_ATOM_CARDINAL, MAX_PROP_SIZE, [](NETRootInfo *q, const xcb_get_property_cookie_t *cookies) {
+            NETRootInfoPrivate *p = q->p;
 
-    if (dirty2 & WM2DesktopLayout) {
-        p->desktop_layout_orientation = OrientationHorizontal;
-        p->desktop_layout_corner = DesktopLayoutCornerTopLeft;
-        p->desktop_layout_columns = p->desktop_layout_rows = 0;
+            p->desktop_layout_orientation = OrientationHorizontal;
+            p->desktop_layout_corner = DesktopLayoutCornerTopLeft;
+            p->desktop_layout_columns = p->desktop_layout_rows = 0;
 
-        const QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL);
-
-        if (data.count() >= 4 && data[3] <= 3) {
-            p->desktop_layout_corner = (NET::DesktopLayoutCorner)data[3];
-        }
+            const QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL);
 
-        if (data.count() >= 3) {
-            if (data[0] <= 1) {
-                p->desktop_layout_orientation = (NET::Orientation)data[0];
+            if (data.count() >= 4 && data[3] <= 3) {
+                p->desktop_layout_corner = (NET::DesktopLayoutCorner)data[3];
             }
 
-            p->desktop_layout_columns = data[1];
-            p->desktop_layout_rows = data[2];
-        }
+            if (data.count() >= 3) {
+                if (data[0] <= 1) {
+                    p->desktop_layout_orientation = (NET::Orientation)data[0];
+                }
+
+                p->desktop_layout_columns = data[1];
+                p->desktop_layout_rows = data[2];
+            }
 
 #ifdef NETWMDEBUG
-        fprintf(stderr,
-                "NETRootInfo::updated: desktop layout updated (%d %d %d %d)\n",
-                p->desktop_layout_orientation,
-                p->desktop_layout_columns,
-                p->desktop_layout_rows,
-                p->desktop_layout_corner);
+            fprintf(stderr,
+                    "NETRootInfo::updated: desktop layout updated (%d %d %d %d)\n",
+                    p->desktop_layout_orientation,
+                    p->desktop_layout_columns,
+                    p->desktop_layout_rows,
+                    p->desktop_layout_corner);
 #endif
-    }
+        }},
+        {{}, WM2ShowingDesktop, _NET_SHOWING_DESKTOP, XCB_ATOM_CARDINAL, 1, [](NETRootInfo *q, const xcb_get_property_cookie_t *cookies) {
+            NETRootInfoPrivate *p = q->p;
 
-    if (dirty2 & WM2ShowingDesktop) {
-        const uint32_t val = get_value_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL, 0);
-        p->showing_desktop = bool(val);
+            const uint32_t val = get_value_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL, 0);
+            p->showing_desktop = bool(val);
 
 #ifdef NETWMDEBUG
-        fprintf(stderr, "NETRootInfo::update: showing desktop = %d\n", p->showing_desktop);
+            fprintf(stderr, "NETRootInfo::update: showing desktop = %d\n", p->showing_desktop);
 #endif
-    }
+        }},
+    };
+
+    KXcbInstrumentation::Scope scope(p->conn, "NETRootInfo::update");
+    NET::Properties dirty = properties & p->clientProperties;
+    NET::Properties2 dirty2 = properties2 & p->clientProperties2;
 
+    xcb_get_property_cookie_t cookies[std::size(propertyTable) * 2];
+    requestProperties(p->conn, p->root, *p->atoms, propertyTable, dirty, dirty2, cookies);
+    parseProperties(this, propertyTable, dirty, dirty2, cookies);
+
+    // The name can only be requested once the supporting window is known
     if ((dirty & SupportingWMCheck) && p->supportwindow) {
-        const QByteArray ba = get_string_reply(p->conn, wm_name_cookie, p->atom(UTF8_STRING));
+        const xcb_get_property_cookie_t cookie =
+            xcb_get_property(p->conn, false, p->supportwindow, p->atom(_NET_WM_NAME), p->atom(UTF8_STRING), 0, MAX_PROP_SIZE);
+        const QByteArray ba = get_string_reply(p->conn, cookie, p->atom(UTF8_STRING));
         if (ba.length() > 0) {
             p->name = nstrndup((const char *)ba.constData(), ba.length());
         }
@@ -2687,7 +3227,7 @@ void NETWinInfo::setIconInternal(NETRArray<NETIcon> &icons, int &icon_count, xcb
         }
     }
 
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, property, XCB_ATOM_CARDINAL, 32, proplen, (const void *)prop);
+    changeProperty(p->conn, p->window, property, XCB_ATOM_CARDINAL, 32, proplen, (const void *)prop);
 
     delete[] prop;
     delete[] p->icon_sizes;
@@ -2709,7 +3249,7 @@ void NETWinInfo::setIconGeometry(NETRect geometry)
     p->icon_geom = geometry;
 
     if (geometry.size.width == 0) { // Empty
-        xcb_delete_property(p->conn, p->window, p->atom(_NET_WM_ICON_GEOMETRY));
+        deleteProperty(p->conn, p->window, p->atom(_NET_WM_ICON_GEOMETRY));
     } else {
         uint32_t data[4];
         data[0] = geometry.pos.x;
@@ -2717,7 +3257,7 @@ void NETWinInfo::setIconGeometry(NETRect geometry)
         data[2] = geometry.size.width;
         data[3] = geometry.size.height;
 
-        xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_NET_WM_ICON_GEOMETRY), XCB_ATOM_CARDINAL, 32, 4, (const void *)data);
+        changeProperty(p->conn, p->window, p->atom(_NET_WM_ICON_GEOMETRY), XCB_ATOM_CARDINAL, 32, 4, (const void *)data);
     }
 }
 
@@ -2743,7 +3283,7 @@ void NETWinInfo::setExtendedStrut(const NETExtendedStrut &extended_strut)
     data[10] = extended_strut.bottom_start;
     data[11] = extended_strut.bottom_end;
 
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_NET_WM_STRUT_PARTIAL), XCB_ATOM_CARDINAL, 32, 12, (const void *)data);
+    changeProperty(p->conn, p->window, p->atom(_NET_WM_STRUT_PARTIAL), XCB_ATOM_CARDINAL, 32, 12, (const void *)data);
 }
 
 void NETWinInfo::setStrut(NETStrut strut)
@@ -2760,7 +3300,7 @@ void NETWinInfo::setStrut(NETStrut strut)
     data[2] = strut.top;
     data[3] = strut.bottom;
 
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_NET_WM_STRUT), XCB_ATOM_CARDINAL, 32, 4, (const void *)data);
+    changeProperty(p->conn, p->window, p->atom(_NET_WM_STRUT), XCB_ATOM_CARDINAL, 32, 4, (const void *)data);
 }
 
 void NETWinInfo::setFullscreenMonitors(NETFullscreenMonitors topology)
@@ -2778,7 +3318,7 @@ void NETWinInfo::setFullscreenMonitors(NETFullscreenMonitors topology)
         data[2] = topology.left;
         data[3] = topology.right;
 
-        xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_NET_WM_FULLSCREEN_MONITORS), XCB_ATOM_CARDINAL, 32, 4, (const void *)data);
+        changeProperty(p->conn, p->window, p->atom(_NET_WM_FULLSCREEN_MONITORS), XCB_ATOM_CARDINAL, 32, 4, (const void *)data);
     }
 }
 
@@ -3009,8 +3549,52 @@ void NETWinInfo::setState(NET::States state, NET::States mask)
         }
 #endif
 
-        xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_NET_WM_STATE), XCB_ATOM_ATOM, 32, count, (const void *)data);
+        changeProperty(p->conn, p->window, p->atom(_NET_WM_STATE), XCB_ATOM_ATOM, 32, count, (const void *)data);
+    }
+}
+
+void NETWinInfo::requestState(NET::States state, NET::States mask)
+{
+    static const std::pair<NET::State, KwsAtom> states[] = {
+        {Modal, _NET_WM_STATE_MODAL},
+        {Sticky, _NET_WM_STATE_STICKY},
+        {Shaded, _NET_WM_STATE_SHADED},
+        {SkipTaskbar, _NET_WM_STATE_SKIP_TASKBAR},
+        {SkipPager, _NET_WM_STATE_SKIP_PAGER},
+        {SkipSwitcher, _KDE_NET_WM_STATE_SKIP_SWITCHER},
+        {Hidden, _NET_WM_STATE_HIDDEN},
+        {FullScreen, _NET_WM_STATE_FULLSCREEN},
+        {KeepAbove, _NET_WM_STATE_ABOVE},
+        // deprecated variant
+        {KeepAbove, _NET_WM_STATE_STAYS_ON_TOP},
+        {KeepBelow, _NET_WM_STATE_BELOW},
+        {DemandsAttention, _NET_WM_STATE_DEMANDS_ATTENTION},
+    };
+
+    auto request = [this](bool add, xcb_atom_t first, xcb_atom_t second) {
+        const uint32_t data[5] = {add ? 1u : 0u, first, second, 0, 0};
+        send_client_message(p->conn, netwm_sendevent_mask, p->root, p->window, p->atom(_NET_WM_STATE), data);
+    };
+
+    for (const auto &[flag, atom] : states) {
+        if (mask & flag) {
+            request(state.testFlag(flag), p->atom(atom), XCB_ATOM_NONE);
+        }
     }
+
+    // both directions of the maximization are changed at once if possible
+    if ((mask & Max) == Max && state.testFlag(MaxHoriz) == state.testFlag(MaxVert)) {
+        request(state.testFlag(MaxHoriz), p->atom(_NET_WM_STATE_MAXIMIZED_HORZ), p->atom(_NET_WM_STATE_MAXIMIZED_VERT));
+    } else {
+        if (mask & MaxHoriz) {
+            request(state.testFlag(MaxHoriz), p->atom(_NET_WM_STATE_MAXIMIZED_HORZ), XCB_ATOM_NONE);
+        }
+        if (mask & MaxVert) {
+            request(state.testFlag(MaxVert), p->atom(_NET_WM_STATE_MAXIMIZED_VERT), XCB_ATOM_NONE);
+        }
+    }
+
+    // Focused is not requested, as in setState()
 }
 
 void NETWinInfo::setWindowType(WindowType type)
@@ -3143,7 +3727,7 @@ void NETWinInfo::setWindowType(WindowType type)
         break;
     }
 
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_NET_WM_WINDOW_TYPE), XCB_ATOM_ATOM, 32, len, (const void *)&data);
+    changeProperty(p->conn, p->window, p->atom(_NET_WM_WINDOW_TYPE), XCB_ATOM_ATOM, 32, len, (const void *)&data);
 }
 
 void NETWinInfo::setName(const char *name)
@@ -3152,13 +3736,12 @@ void NETWinInfo::setName(const char *name)
         return;
     }
 
-    delete[] p->name;
-    p->name = nstrdup(name);
+    p->strings.set(&p->name, name);
 
     if (p->name[0] != '\0') {
-        xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_NET_WM_NAME), p->atom(UTF8_STRING), 8, strlen(p->name), (const void *)p->name);
+        changeProperty(p->conn, p->window, p->atom(_NET_WM_NAME), p->atom(UTF8_STRING), 8, strlen(p->name), (const void *)p->name);
     } else {
-        xcb_delete_property(p->conn, p->window, p->atom(_NET_WM_NAME));
+        deleteProperty(p->conn, p->window, p->atom(_NET_WM_NAME));
     }
 }
 
@@ -3168,20 +3751,12 @@ void NETWinInfo::setVisibleName(const char *visibleName)
         return;
     }
 
-    delete[] p->visible_name;
-    p->visible_name = nstrdup(visibleName);
+    p->strings.set(&p->visible_name, visibleName);
 
     if (p->visible_name[0] != '\0') {
-        xcb_change_property(p->conn,
-                            XCB_PROP_MODE_REPLACE,
-                            p->window,
-                            p->atom(_NET_WM_VISIBLE_NAME),
-                            p->atom(UTF8_STRING),
-                            8,
-                            strlen(p->visible_name),
-                            (const void *)p->visible_name);
+        changeProperty(p->conn, p->window, p->atom(_NET_WM_VISIBLE_NAME), p->atom(UTF8_STRING), 8, strlen(p->visible_name), (const void *)p->visible_name);
     } else {
-        xcb_delete_property(p->conn, p->window, p->atom(_NET_WM_VISIBLE_NAME));
+        deleteProperty(p->conn, p->window, p->atom(_NET_WM_VISIBLE_NAME));
     }
 }
 
@@ -3191,20 +3766,12 @@ void NETWinInfo::setIconName(const char *iconName)
         return;
     }
 
-    delete[] p->icon_name;
-    p->icon_name = nstrdup(iconName);
+    p->strings.set(&p->icon_name, iconName);
 
     if (p->icon_name[0] != '\0') {
-        xcb_change_property(p->conn,
-                            XCB_PROP_MODE_REPLACE,
-                            p->window,
-                            p->atom(_NET_WM_ICON_NAME),
-                            p->atom(UTF8_STRING),
-                            8,
-                            strlen(p->icon_name),
-                            (const void *)p->icon_name);
+        changeProperty(p->conn, p->window, p->atom(_NET_WM_ICON_NAME), p->atom(UTF8_STRING), 8, strlen(p->icon_name), (const void *)p->icon_name);
     } else {
-        xcb_delete_property(p->conn, p->window, p->atom(_NET_WM_ICON_NAME));
+        deleteProperty(p->conn, p->window, p->atom(_NET_WM_ICON_NAME));
     }
 }
 
@@ -3214,20 +3781,18 @@ void NETWinInfo::setVisibleIconName(const char *visibleIconName)
         return;
     }
 
-    delete[] p->visible_icon_name;
-    p->visible_icon_name = nstrdup(visibleIconName);
+    p->strings.set(&p->visible_icon_name, visibleIconName);
 
     if (p->visible_icon_name[0] != '\0') {
-        xcb_change_property(p->conn,
-                            XCB_PROP_MODE_REPLACE,
-                            p->window,
-                            p->atom(_NET_WM_VISIBLE_ICON_NAME),
-                            p->atom(UTF8_STRING),
-                            8,
-                            strlen(p->visible_icon_name),
-                            (const void *)p->visible_icon_name);
+        changeProperty(p->conn,
+                       p->window,
+                       p->atom(_NET_WM_VISIBLE_ICON_NAME),
+                       p->atom(UTF8_STRING),
+                       8,
+                       strlen(p->visible_icon_name),
+                       (const void *)p->visible_icon_name);
     } else {
-        xcb_delete_property(p->conn, p->window, p->atom(_NET_WM_VISIBLE_ICON_NAME));
+        deleteProperty(p->conn, p->window, p->atom(_NET_WM_VISIBLE_ICON_NAME));
     }
 }
 
@@ -3257,14 +3822,24 @@ void NETWinInfo::setDesktop(int desktop, bool ignore_viewport)
         p->desktop = desktop;
 
         if (desktop == 0) {
-            xcb_delete_property(p->conn, p->window, p->atom(_NET_WM_DESKTOP));
+            deleteProperty(p->conn, p->window, p->atom(_NET_WM_DESKTOP));
         } else {
             uint32_t d = (desktop == OnAllDesktops ? 0xffffffff : desktop - 1);
-            xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_NET_WM_DESKTOP), XCB_ATOM_CARDINAL, 32, 1, (const void *)&d);
+            changeProperty(p->conn, p->window, p->atom(_NET_WM_DESKTOP), XCB_ATOM_CARDINAL, 32, 1, (const void *)&d);
         }
     }
 }
 
+void NETWinInfo::requestDesktop(int desktop)
+{
+    if (desktop == 0) {
+        return; // not possible while being managed
+    }
+
+    const uint32_t data[5] = {desktop == OnAllDesktops ? 0xffffffff : desktop - 1, 0, 0, 0, 0};
+    send_client_message(p->conn, netwm_sendevent_mask, p->root, p->window, p->atom(_NET_WM_DESKTOP), data);
+}
+
 void NETWinInfo::setPid(int pid)
 {
     if (p->role != Client) {
@@ -3273,7 +3848,7 @@ void NETWinInfo::setPid(int pid)
 
     p->pid = pid;
     uint32_t d = pid;
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_NET_WM_PID), XCB_ATOM_CARDINAL, 32, 1, (const void *)&d);
+    changeProperty(p->conn, p->window, p->atom(_NET_WM_PID), XCB_ATOM_CARDINAL, 32, 1, (const void *)&d);
 }
 
 void NETWinInfo::setHandledIcons(bool handled)
@@ -3284,7 +3859,7 @@ void NETWinInfo::setHandledIcons(bool handled)
 
     p->handled_icons = handled;
     uint32_t d = handled;
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_NET_WM_HANDLED_ICONS), XCB_ATOM_CARDINAL, 32, 1, (const void *)&d);
+    changeProperty(p->conn, p->window, p->atom(_NET_WM_HANDLED_ICONS), XCB_ATOM_CARDINAL, 32, 1, (const void *)&d);
 }
 
 void NETWinInfo::setStartupId(const char *id)
@@ -3293,17 +3868,9 @@ void NETWinInfo::setStartupId(const char *id)
         return;
     }
 
-    delete[] p->startup_id;
-    p->startup_id = nstrdup(id);
+    p->strings.set(&p->startup_id, id);
 
-    xcb_change_property(p->conn,
-                        XCB_PROP_MODE_REPLACE,
-                        p->window,
-                        p->atom(_NET_STARTUP_ID),
-                        p->atom(UTF8_STRING),
-                        8,
-                        strlen(p->startup_id),
-                        (const void *)p->startup_id);
+    changeProperty(p->conn, p->window, p->atom(_NET_STARTUP_ID), p->atom(UTF8_STRING), 8, strlen(p->startup_id), (const void *)p->startup_id);
 }
 
 void NETWinInfo::setOpacity(unsigned long opacity)
@@ -3311,7 +3878,7 @@ void NETWinInfo::setOpacity(unsigned long opacity)
     //    if (p->role != Client) return;
 
     p->opacity = opacity;
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_NET_WM_WINDOW_OPACITY), XCB_ATOM_CARDINAL, 32, 1, (const void *)&p->opacity);
+    changeProperty(p->conn, p->window, p->atom(_NET_WM_WINDOW_OPACITY), XCB_ATOM_CARDINAL, 32, 1, (const void *)&p->opacity);
 }
 
 void NETWinInfo::setOpacityF(qreal opacity)
@@ -3368,7 +3935,7 @@ void NETWinInfo::setAllowedActions(NET::Actions actions)
     }
 #endif
 
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_NET_WM_ALLOWED_ACTIONS), XCB_ATOM_ATOM, 32, count, (const void *)data);
+    changeProperty(p->conn, p->window, p->atom(_NET_WM_ALLOWED_ACTIONS), XCB_ATOM_ATOM, 32, count, (const void *)data);
 }
 
 void NETWinInfo::setFrameExtents(NETStrut strut)
@@ -3385,8 +3952,8 @@ void NETWinInfo::setFrameExtents(NETStrut strut)
     d[2] = strut.top;
     d[3] = strut.bottom;
 
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_NET_FRAME_EXTENTS), XCB_ATOM_CARDINAL, 32, 4, (const void *)d);
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_KDE_NET_WM_FRAME_STRUT), XCB_ATOM_CARDINAL, 32, 4, (const void *)d);
+    changeProperty(p->conn, p->window, p->atom(_NET_FRAME_EXTENTS), XCB_ATOM_CARDINAL, 32, 4, (const void *)d);
+    changeProperty(p->conn, p->window, p->atom(_KDE_NET_WM_FRAME_STRUT), XCB_ATOM_CARDINAL, 32, 4, (const void *)d);
 }
 
 NETStrut NETWinInfo::frameExtents() const
@@ -3411,7 +3978,7 @@ void NETWinInfo::setFrameOverlap(NETStrut strut)
     d[2] = strut.top;
     d[3] = strut.bottom;
 
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_NET_WM_FRAME_OVERLAP), XCB_ATOM_CARDINAL, 32, 4, (const void *)d);
+    changeProperty(p->conn, p->window, p->atom(_NET_WM_FRAME_OVERLAP), XCB_ATOM_CARDINAL, 32, 4, (const void *)d);
 }
 
 NETStrut NETWinInfo::frameOverlap() const
@@ -3429,7 +3996,7 @@ void NETWinInfo::setGtkFrameExtents(NETStrut strut)
     d[2] = strut.top;
     d[3] = strut.bottom;
 
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_GTK_FRAME_EXTENTS), XCB_ATOM_CARDINAL, 32, 4, (const void *)d);
+    changeProperty(p->conn, p->window, p->atom(_GTK_FRAME_EXTENTS), XCB_ATOM_CARDINAL, 32, 4, (const void *)d);
 }
 
 NETStrut NETWinInfo::gtkFrameExtents() const
@@ -3443,17 +4010,15 @@ void NETWinInfo::setAppMenuObjectPath(const char *name)
         return;
     }
 
-    delete[] p->appmenu_object_path;
-    p->appmenu_object_path = nstrdup(name);
+    p->strings.set(&p->appmenu_object_path, name);
 
-    xcb_change_property(p->conn,
-                        XCB_PROP_MODE_REPLACE,
-                        p->window,
-                        p->atom(_KDE_NET_WM_APPMENU_OBJECT_PATH),
-                        XCB_ATOM_STRING,
-                        8,
-                        strlen(p->appmenu_object_path),
-                        (const void *)p->appmenu_object_path);
+    changeProperty(p->conn,
+                   p->window,
+                   p->atom(_KDE_NET_WM_APPMENU_OBJECT_PATH),
+                   XCB_ATOM_STRING,
+                   8,
+                   strlen(p->appmenu_object_path),
+                   (const void *)p->appmenu_object_path);
 }
 
 void NETWinInfo::setAppMenuServiceName(const char *name)
@@ -3462,17 +4027,15 @@ void NETWinInfo::setAppMenuServiceName(const char *name)
         return;
     }
 
-    delete[] p->appmenu_service_name;
-    p->appmenu_service_name = nstrdup(name);
+    p->strings.set(&p->appmenu_service_name, name);
 
-    xcb_change_property(p->conn,
-                        XCB_PROP_MODE_REPLACE,
-                        p->window,
-                        p->atom(_KDE_NET_WM_APPMENU_SERVICE_NAME),
-                        XCB_ATOM_STRING,
-                        8,
-                        strlen(p->appmenu_service_name),
-                        (const void *)p->appmenu_service_name);
+    changeProperty(p->conn,
+                   p->window,
+                   p->atom(_KDE_NET_WM_APPMENU_SERVICE_NAME),
+                   XCB_ATOM_STRING,
+                   8,
+                   strlen(p->appmenu_service_name),
+                   (const void *)p->appmenu_service_name);
 }
 
 const char *NETWinInfo::appMenuObjectPath() const
@@ -3492,8 +4055,8 @@ void NETWinInfo::kdeGeometry(NETRect &frame, NETRect &window)
 
         const xcb_translate_coordinates_cookie_t translate_cookie = xcb_translate_coordinates(p->conn, p->window, p->root, 0, 0);
 
-        xcb_get_geometry_reply_t *geometry = xcb_get_geometry_reply(p->conn, geometry_cookie, nullptr);
-        xcb_translate_coordinates_reply_t *translated = xcb_translate_coordinates_reply(p->conn, translate_cookie, nullptr);
+        xcb_get_geometry_reply_t *geometry = KXcbInstrumentation::reply(xcb_get_geometry_reply, p->conn, geometry_cookie, nullptr);
+        xcb_translate_coordinates_reply_t *translated = KXcbInstrumentation::reply(xcb_translate_coordinates_reply, p->conn, translate_cookie, nullptr);
 
         if (geometry && translated) {
             p->win_geom.pos.x = translated->dst_x;
@@ -3584,7 +4147,7 @@ void NETWinInfo::setUserTime(xcb_timestamp_t time)
     p->user_time = time;
     uint32_t d = time;
 
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_NET_WM_USER_TIME), XCB_ATOM_CARDINAL, 32, 1, (const void *)&d);
+    changeProperty(p->conn, p->window, p->atom(_NET_WM_USER_TIME), XCB_ATOM_CARDINAL, 32, 1, (const void *)&d);
 }
 
 NET::Properties NETWinInfo::event(xcb_generic_event_t *ev)
@@ -3626,36 +4189,8 @@ void NETWinInfo::event(xcb_generic_event_t *event, NET::Properties *properties,
                 fprintf(stderr, "NETWinInfo::event:  message %ld '%s'\n", message->data.data32[i], ba.constData());
 #endif
 
-                if ((xcb_atom_t)message->data.data32[i] == p->atom(_NET_WM_STATE_MODAL)) {
-                    mask |= Modal;
-                } else if ((xcb_atom_t)message->data.data32[i] == p->atom(_NET_WM_STATE_STICKY)) {
-                    mask |= Sticky;
-                } else if ((xcb_atom_t)message->data.data32[i] == p->atom(_NET_WM_STATE_MAXIMIZED_VERT)) {
-                    mask |= MaxVert;
-                } else if ((xcb_atom_t)message->data.data32[i] == p->atom(_NET_WM_STATE_MAXIMIZED_HORZ)) {
-                    mask |= MaxHoriz;
-                } else if ((xcb_atom_t)message->data.data32[i] == p->atom(_NET_WM_STATE_SHADED)) {
-                    mask |= Shaded;
-                } else if ((xcb_atom_t)message->data.data32[i] == p->atom(_NET_WM_STATE_SKIP_TASKBAR)) {
-                    mask |= SkipTaskbar;
-                } else if ((xcb_atom_t)message->data.data32[i] == p->atom(_NET_WM_STATE_SKIP_PAGER)) {
-                    mask |= SkipPager;
-                } else if ((xcb_atom_t)message->data.data32[i] == p->atom(_KDE_NET_WM_STATE_SKIP_SWITCHER)) {
-                    mask |= SkipSwitcher;
-                } else if ((xcb_atom_t)message->data.data32[i] == p->atom(_NET_WM_STATE_HIDDEN)) {
-                    mask |= Hidden;
-                } else if ((xcb_atom_t)message->data.data32[i] == p->atom(_NET_WM_STATE_FULLSCREEN)) {
-                    mask |= FullScreen;
-                } else if ((xcb_atom_t)message->data.data32[i] == p->atom(_NET_WM_STATE_ABOVE)) {
-                    mask |= KeepAbove;
-                } else if ((xcb_atom_t)message->data.data32[i] == p->atom(_NET_WM_STATE_BELOW)) {
-                    mask |= KeepBelow;
-                } else if ((xcb_atom_t)message->data.data32[i] == p->atom(_NET_WM_STATE_DEMANDS_ATTENTION)) {
-                    mask |= DemandsAttention;
-                } else if ((xcb_atom_t)message->data.data32[i] == p->atom(_NET_WM_STATE_STAYS_ON_TOP)) {
-                    mask |= KeepAbove;
-                } else if ((xcb_atom_t)message->data.data32[i] == p->atom(_NET_WM_STATE_FOCUSED)) {
-                    mask |= Focused;
+                if (const NETAtomMeaning *meaning = p->atoms->meaning(message->data.data32[i])) {
+                    mask |= meaning->state;
                 }
             }
 
@@ -3836,791 +4371,413 @@ void NETWinInfo::updateWMState()
 
 void NETWinInfo::update(NET::Properties dirtyProperties, NET::Properties2 dirtyProperties2)
 {
-    Properties dirty = dirtyProperties & p->properties;
-    Properties2 dirty2 = dirtyProperties2 & p->properties2;
-
-    // We *always* want to update WM_STATE if set in dirty_props
-    if (dirtyProperties & XAWMState) {
-        dirty |= XAWMState;
-    }
-
-    xcb_get_property_cookie_t cookies[255];
-    int c = 0;
-
-    if (dirty & XAWMState) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(WM_STATE), p->atom(WM_STATE), 0, 1);
-    }
-
-    if (dirty & WMState) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_STATE), XCB_ATOM_ATOM, 0, 2048);
-    }
-
-    if (dirty & WMDesktop) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_DESKTOP), XCB_ATOM_CARDINAL, 0, 1);
-    }
-
-    if (dirty & WMName) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_NAME), p->atom(UTF8_STRING), 0, MAX_PROP_SIZE);
-    }
+    static constexpr NETPropertyFetch<NETWinInfoPrivate> propertyTable[] = {
+        {XAWMState, {}, WM_STATE, WM_STATE, 1, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            p->mapping_state = Withdrawn;
 
-    if (dirty & WMVisibleName) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_VISIBLE_NAME), p->atom(UTF8_STRING), 0, MAX_PROP_SIZE);
-    }
+            bool success;
+            uint32_t state = get_value_reply<uint32_t>(p->conn, cookies[0], p->atom(WM_STATE), 0, &success);
 
-    if (dirty & WMIconName) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_ICON_NAME), p->atom(UTF8_STRING), 0, MAX_PROP_SIZE);
-    }
-
-    if (dirty & WMVisibleIconName) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_VISIBLE_ICON_NAME), p->atom(UTF8_STRING), 0, MAX_PROP_SIZE);
-    }
-
-    if (dirty & WMWindowType) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_WINDOW_TYPE), XCB_ATOM_ATOM, 0, 2048);
-    }
-
-    if (dirty & WMStrut) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_STRUT), XCB_ATOM_CARDINAL, 0, 4);
-    }
-
-    if (dirty2 & WM2ExtendedStrut) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_STRUT_PARTIAL), XCB_ATOM_CARDINAL, 0, 12);
-    }
-
-    if (dirty2 & WM2FullscreenMonitors) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_FULLSCREEN_MONITORS), XCB_ATOM_CARDINAL, 0, 4);
-    }
-
-    if (dirty & WMIconGeometry) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_ICON_GEOMETRY), XCB_ATOM_CARDINAL, 0, 4);
-    }
-
-    if (dirty & WMIcon) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_ICON), XCB_ATOM_CARDINAL, 0, 0xffffffff);
-    }
-
-    if (dirty & WMFrameExtents) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_FRAME_EXTENTS), XCB_ATOM_CARDINAL, 0, 4);
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_KDE_NET_WM_FRAME_STRUT), XCB_ATOM_CARDINAL, 0, 4);
-    }
-
-    if (dirty2 & WM2FrameOverlap) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_FRAME_OVERLAP), XCB_ATOM_CARDINAL, 0, 4);
-    }
-
-    if (dirty2 & WM2Activities) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_KDE_NET_WM_ACTIVITIES), XCB_ATOM_STRING, 0, MAX_PROP_SIZE);
-    }
-
-    if (dirty2 & WM2BlockCompositing) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_KDE_NET_WM_BLOCK_COMPOSITING), XCB_ATOM_CARDINAL, 0, 1);
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_BYPASS_COMPOSITOR), XCB_ATOM_CARDINAL, 0, 1);
-    }
-
-    if (dirty & WMPid) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_PID), XCB_ATOM_CARDINAL, 0, 1);
-    }
-
-    if (dirty2 & WM2StartupId) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_STARTUP_ID), p->atom(UTF8_STRING), 0, MAX_PROP_SIZE);
-    }
-
-    if (dirty2 & WM2Opacity) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_WINDOW_OPACITY), XCB_ATOM_CARDINAL, 0, 1);
-    }
-
-    if (dirty2 & WM2AllowedActions) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_ALLOWED_ACTIONS), XCB_ATOM_ATOM, 0, 2048);
-    }
-
-    if (dirty2 & WM2UserTime) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_USER_TIME), XCB_ATOM_CARDINAL, 0, 1);
-    }
-
-    if (dirty2 & WM2TransientFor) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, XCB_ATOM_WM_TRANSIENT_FOR, XCB_ATOM_WINDOW, 0, 1);
-    }
-
-    if (dirty2 & (WM2GroupLeader | WM2Urgency | WM2Input | WM2InitialMappingState | WM2IconPixmap)) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, XCB_ATOM_WM_HINTS, XCB_ATOM_WM_HINTS, 0, 9);
-    }
-
-    if (dirty2 & WM2WindowClass) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 0, MAX_PROP_SIZE);
-    }
-
-    if (dirty2 & WM2WindowRole) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(WM_WINDOW_ROLE), XCB_ATOM_STRING, 0, MAX_PROP_SIZE);
-    }
-
-    if (dirty2 & WM2ClientMachine) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, XCB_ATOM_WM_CLIENT_MACHINE, XCB_ATOM_STRING, 0, MAX_PROP_SIZE);
-    }
-
-    if (dirty2 & WM2Protocols) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(WM_PROTOCOLS), XCB_ATOM_ATOM, 0, 2048);
-    }
-
-    if (dirty2 & WM2OpaqueRegion) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_NET_WM_OPAQUE_REGION), XCB_ATOM_CARDINAL, 0, MAX_PROP_SIZE);
-    }
-
-    if (dirty2 & WM2DesktopFileName) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_KDE_NET_WM_DESKTOP_FILE), p->atom(UTF8_STRING), 0, MAX_PROP_SIZE);
-    }
-
-    if (dirty2 & WM2GTKApplicationId) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_GTK_APPLICATION_ID), p->atom(UTF8_STRING), 0, MAX_PROP_SIZE);
-    }
-
-    if (dirty2 & WM2GTKFrameExtents) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_GTK_FRAME_EXTENTS), XCB_ATOM_CARDINAL, 0, 4);
-    }
-
-    if (dirty2 & WM2AppMenuObjectPath) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_KDE_NET_WM_APPMENU_OBJECT_PATH), XCB_ATOM_STRING, 0, MAX_PROP_SIZE);
-    }
-
-    if (dirty2 & WM2AppMenuServiceName) {
-        cookies[c++] = xcb_get_property(p->conn, false, p->window, p->atom(_KDE_NET_WM_APPMENU_SERVICE_NAME), XCB_ATOM_STRING, 0, MAX_PROP_SIZE);
-    }
-
-    c = 0;
-
-    if (dirty & XAWMState) {
-        p->mapping_state = Withdrawn;
-
-        bool success;
-        uint32_t state = get_value_reply<uint32_t>(p->conn, cookies[c++], p->atom(WM_STATE), 0, &success);
+            if (success) {
+                switch (state) {
+                case 3: // IconicState
+                    p->mapping_state = Iconic;
+                    break;
 
-        if (success) {
-            switch (state) {
-            case 3: // IconicState
-                p->mapping_state = Iconic;
-                break;
+                case 1: // NormalState
+                    p->mapping_state = Visible;
+                    break;
 
-            case 1: // NormalState
-                p->mapping_state = Visible;
-                break;
+                case 0: // WithdrawnState
+                default:
+                    p->mapping_state = Withdrawn;
+                    break;
+                }
 
-            case 0: // WithdrawnState
-            default:
-                p->mapping_state = Withdrawn;
-                break;
+                p->mapping_state_dirty = false;
             }
-
-            p->mapping_state_dirty = false;
-        }
-    }
-
-    if (dirty & WMState) {
-        p->state = NET::States();
-        const QList<xcb_atom_t> states = get_array_reply<xcb_atom_t>(p->conn, cookies[c++], XCB_ATOM_ATOM);
+        }},
+        {WMState, {}, _NET_WM_STATE, XCB_ATOM_ATOM, 2048, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            p->state = NET::States();
+            const QList<xcb_atom_t> states = get_array_reply<xcb_atom_t>(p->conn, cookies[0], XCB_ATOM_ATOM);
 
 #ifdef NETWMDEBUG
-        fprintf(stderr, "NETWinInfo::update: updating window state (%ld)\n", states.count());
+            fprintf(stderr, "NETWinInfo::update: updating window state (%ld)\n", states.count());
 #endif
 
-        for (const xcb_atom_t state : states) {
+            for (const xcb_atom_t state : states) {
 #ifdef NETWMDEBUG
-            const QByteArray ba = get_atom_name(p->conn, state);
-            fprintf(stderr, "NETWinInfo::update:   adding window state %ld '%s'\n", state, ba.constData());
+                const QByteArray ba = get_atom_name(p->conn, state);
+                fprintf(stderr, "NETWinInfo::update:   adding window state %ld '%s'\n", state, ba.constData());
 #endif
-            if (state == p->atom(_NET_WM_STATE_MODAL)) {
-                p->state |= Modal;
-            }
-
-            else if (state == p->atom(_NET_WM_STATE_STICKY)) {
-                p->state |= Sticky;
-            }
-
-            else if (state == p->atom(_NET_WM_STATE_MAXIMIZED_VERT)) {
-                p->state |= MaxVert;
-            }
-
-            else if (state == p->atom(_NET_WM_STATE_MAXIMIZED_HORZ)) {
-                p->state |= MaxHoriz;
+                if (const NETAtomMeaning *meaning = p->atoms->meaning(state)) {
+                    p->state |= meaning->state;
+                }
             }
+        }},
+        {WMDesktop, {}, _NET_WM_DESKTOP, XCB_ATOM_CARDINAL, 1, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            p->desktop = 0;
 
-            else if (state == p->atom(_NET_WM_STATE_SHADED)) {
-                p->state |= Shaded;
-            }
+            bool success;
+            uint32_t desktop = get_value_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL, 0, &success);
 
-            else if (state == p->atom(_NET_WM_STATE_SKIP_TASKBAR)) {
-                p->state |= SkipTaskbar;
+            if (success) {
+                if (desktop != 0xffffffff) {
+                    p->desktop = desktop + 1;
+                } else {
+                    p->desktop = OnAllDesktops;
+                }
             }
+        }},
+        {WMName, {}, _NET_WM_NAME, UTF8_STRING, MAX_PROP_SIZE, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            const QByteArray str = get_string_reply(p->conn, cookies[0], p->atom(UTF8_STRING));
+            p->strings.set(&p->name, str.constData(), str.length());
+        }},
+        {WMVisibleName, {}, _NET_WM_VISIBLE_NAME, UTF8_STRING, MAX_PROP_SIZE, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            const QByteArray str = get_string_reply(p->conn, cookies[0], p->atom(UTF8_STRING));
+            p->strings.set(&p->visible_name, str.constData(), str.length());
+        }},
+        {WMIconName, {}, _NET_WM_ICON_NAME, UTF8_STRING, MAX_PROP_SIZE, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            const QByteArray str = get_string_reply(p->conn, cookies[0], p->atom(UTF8_STRING));
+            p->strings.set(&p->icon_name, str.constData(), str.length());
+        }},
+        {WMVisibleIconName, {}, _NET_WM_VISIBLE_ICON_NAME, UTF8_STRING, MAX_PROP_SIZE, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            const QByteArray str = get_string_reply(p->conn, cookies[0], p->atom(UTF8_STRING));
+            p->strings.set(&p->visible_icon_name, str.constData(), str.length());
+        }},
+        {WMWindowType, {}, _NET_WM_WINDOW_TYPE, XCB_ATOM_ATOM, 2048, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            p->types.reset();
+            p->types[0] = Unknown;
+            p->has_net_support = false;
+
+            const QList<xcb_atom_t> types = get_array_reply<xcb_atom_t>(p->conn, cookies[0], XCB_ATOM_ATOM);
+
+            if (!types.isEmpty()) {
+#ifdef NETWMDEBUG
+                fprintf(stderr, "NETWinInfo::update: getting window type (%ld)\n", types.count());
+#endif
+                p->has_net_support = true;
+                int pos = 0;
 
-            else if (state == p->atom(_NET_WM_STATE_SKIP_PAGER)) {
-                p->state |= SkipPager;
+                for (const xcb_atom_t type : types) {
+#ifdef NETWMDEBUG
+                    const QByteArray name = get_atom_name(p->conn, type);
+                    fprintf(stderr, "NETWinInfo::update:   examining window type %ld %s\n", type, name.constData());
+#endif
+                    const NETAtomMeaning *meaning = p->atoms->meaning(type);
+                    if (meaning && meaning->type != Unknown) {
+                        p->types[pos++] = meaning->type;
+                    }
+                }
             }
-
-            else if (state == p->atom(_KDE_NET_WM_STATE_SKIP_SWITCHER)) {
-                p->state |= SkipSwitcher;
+        }},
+        {WMStrut, {}, _NET_WM_STRUT, XCB_ATOM_CARDINAL, 4, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            p->strut = NETStrut();
+
+            QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL);
+            if (data.count() == 4) {
+                p->strut.left = data[0];
+                p->strut.right = data[1];
+                p->strut.top = data[2];
+                p->strut.bottom = data[3];
             }
-
-            else if (state == p->atom(_NET_WM_STATE_HIDDEN)) {
-                p->state |= Hidden;
+        }},
+        {{}, WM2ExtendedStrut, _NET_WM_STRUT_PARTIAL, XCB_ATOM_CARDINAL, 12, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            p->extended_strut = NETExtendedStrut();
+
+            QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL);
+            if (data.count() == 12) {
+                p->extended_strut.left_width = data[0];
+                p->extended_strut.right_width = data[1];
+                p->extended_strut.top_width = data[2];
+                p->extended_strut.bottom_width = data[3];
+                p->extended_strut.left_start = data[4];
+                p->extended_strut.left_end = data[5];
+                p->extended_strut.right_start = data[6];
+                p->extended_strut.right_end = data[7];
+                p->extended_strut.top_start = data[8];
+                p->extended_strut.top_end = data[9];
+                p->extended_strut.bottom_start = data[10];
+                p->extended_strut.bottom_end = data[11];
             }
-
-            else if (state == p->atom(_NET_WM_STATE_FULLSCREEN)) {
-                p->state |= FullScreen;
+        }},
+        {{}, WM2FullscreenMonitors, _NET_WM_FULLSCREEN_MONITORS, XCB_ATOM_CARDINAL, 4, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            p->fullscreen_monitors = NETFullscreenMonitors();
+
+            QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL);
+            if (data.count() == 4) {
+                p->fullscreen_monitors.top = data[0];
+                p->fullscreen_monitors.bottom = data[1];
+                p->fullscreen_monitors.left = data[2];
+                p->fullscreen_monitors.right = data[3];
             }
-
-            else if (state == p->atom(_NET_WM_STATE_ABOVE)) {
-                p->state |= KeepAbove;
+        }},
+        {WMIconGeometry, {}, _NET_WM_ICON_GEOMETRY, XCB_ATOM_CARDINAL, 4, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            p->icon_geom = NETRect();
+
+            QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL);
+            if (data.count() == 4) {
+                p->icon_geom.pos.x = data[0];
+                p->icon_geom.pos.y = data[1];
+                p->icon_geom.size.width = data[2];
+                p->icon_geom.size.height = data[3];
             }
-
-            else if (state == p->atom(_NET_WM_STATE_BELOW)) {
-                p->state |= KeepBelow;
+        }},
+        {WMIcon, {}, _NET_WM_ICON, XCB_ATOM_CARDINAL, 0xffffffff, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            readIcon(p->conn, cookies[0], p->icons, p->icon_count);
+            delete[] p->icon_sizes;
+            p->icon_sizes = nullptr;
+        }},
+        {WMFrameExtents, {}, _NET_FRAME_EXTENTS, XCB_ATOM_CARDINAL, 4, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            p->frame_strut = NETStrut();
+
+            QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL);
+
+            if (data.isEmpty()) {
+                data = get_array_reply<uint32_t>(p->conn, cookies[1], XCB_ATOM_CARDINAL);
+            } else {
+                xcb_discard_reply(p->conn, cookies[1].sequence);
             }
 
-            else if (state == p->atom(_NET_WM_STATE_DEMANDS_ATTENTION)) {
-                p->state |= DemandsAttention;
+            if (data.count() == 4) {
+                p->frame_strut.left = data[0];
+                p->frame_strut.right = data[1];
+                p->frame_strut.top = data[2];
+                p->frame_strut.bottom = data[3];
             }
-
-            else if (state == p->atom(_NET_WM_STATE_STAYS_ON_TOP)) {
-                p->state |= KeepAbove;
+        }, _KDE_NET_WM_FRAME_STRUT},
+        {{}, WM2FrameOverlap, _NET_WM_FRAME_OVERLAP, XCB_ATOM_CARDINAL, 4, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            p->frame_overlap = NETStrut();
+
+            QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL);
+            if (data.count() == 4) {
+                p->frame_overlap.left = data[0];
+                p->frame_overlap.right = data[1];
+                p->frame_overlap.top = data[2];
+                p->frame_overlap.bottom = data[3];
             }
-
-            else if (state == p->atom(_NET_WM_STATE_FOCUSED)) {
-                p->state |= Focused;
+        }},
+        {{}, WM2Activities, _KDE_NET_WM_ACTIVITIES, XCB_ATOM_STRING, MAX_PROP_SIZE, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            const QByteArray activities = get_string_reply(p->conn, cookies[0], XCB_ATOM_STRING);
+            p->strings.intern(&p->activities, activities.constData(), activities.length());
+        }},
+        {{}, WM2BlockCompositing, _KDE_NET_WM_BLOCK_COMPOSITING, XCB_ATOM_CARDINAL, 1, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            bool success;
+            p->blockCompositing = false;
+
+            // _KDE_NET_WM_BLOCK_COMPOSITING
+            uint32_t data = get_value_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL, 0, &success);
+            if (success) {
+                p->blockCompositing = bool(data);
             }
-        }
-    }
 
-    if (dirty & WMDesktop) {
-        p->desktop = 0;
-
-        bool success;
-        uint32_t desktop = get_value_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL, 0, &success);
-
-        if (success) {
-            if (desktop != 0xffffffff) {
-                p->desktop = desktop + 1;
-            } else {
-                p->desktop = OnAllDesktops;
+            // _NET_WM_BYPASS_COMPOSITOR
+            data = get_value_reply<uint32_t>(p->conn, cookies[1], XCB_ATOM_CARDINAL, 0, &success);
+            if (success) {
+                switch (data) {
+                case 1:
+                    p->blockCompositing = true;
+                    break;
+                case 2:
+                    p->blockCompositing = false;
+                    break;
+                default:
+                    break; // yes, the standard /is/ that stupid.
+                }
             }
-        }
-    }
-
-    if (dirty & WMName) {
-        delete[] p->name;
-        p->name = nullptr;
-
-        const QByteArray str = get_string_reply(p->conn, cookies[c++], p->atom(UTF8_STRING));
-        if (str.length() > 0) {
-            p->name = nstrndup(str.constData(), str.length());
-        }
-    }
-
-    if (dirty & WMVisibleName) {
-        delete[] p->visible_name;
-        p->visible_name = nullptr;
-
-        const QByteArray str = get_string_reply(p->conn, cookies[c++], p->atom(UTF8_STRING));
-        if (str.length() > 0) {
-            p->visible_name = nstrndup(str.constData(), str.length());
-        }
-    }
-
-    if (dirty & WMIconName) {
-        delete[] p->icon_name;
-        p->icon_name = nullptr;
-
-        const QByteArray str = get_string_reply(p->conn, cookies[c++], p->atom(UTF8_STRING));
-        if (str.length() > 0) {
-            p->icon_name = nstrndup(str.constData(), str.length());
-        }
-    }
-
-    if (dirty & WMVisibleIconName) {
-        delete[] p->visible_icon_name;
-        p->visible_icon_name = nullptr;
-
-        const QByteArray str = get_string_reply(p->conn, cookies[c++], p->atom(UTF8_STRING));
-        if (str.length() > 0) {
-            p->visible_icon_name = nstrndup(str.constData(), str.length());
-        }
-    }
-
-    if (dirty & WMWindowType) {
-        p->types.reset();
-        p->types[0] = Unknown;
-        p->has_net_support = false;
-
-        const QList<xcb_atom_t> types = get_array_reply<xcb_atom_t>(p->conn, cookies[c++], XCB_ATOM_ATOM);
-
-        if (!types.isEmpty()) {
+        }, _NET_WM_BYPASS_COMPOSITOR},
+        {WMPid, {}, _NET_WM_PID, XCB_ATOM_CARDINAL, 1, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            p->pid = get_value_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL, 0);
+        }},
+        {{}, WM2StartupId, _NET_STARTUP_ID, UTF8_STRING, MAX_PROP_SIZE, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            const QByteArray id = get_string_reply(p->conn, cookies[0], p->atom(UTF8_STRING));
+            p->strings.set(&p->startup_id, id.constData(), id.length());
+        }},
+        {{}, WM2Opacity, _NET_WM_WINDOW_OPACITY, XCB_ATOM_CARDINAL, 1, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            p->opacity = get_value_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL, 0xffffffff);
+        }},
+        {{}, WM2AllowedActions, _NET_WM_ALLOWED_ACTIONS, XCB_ATOM_ATOM, 2048, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            p->allowed_actions = NET::Actions();
+
+            const QList<xcb_atom_t> actions = get_array_reply<xcb_atom_t>(p->conn, cookies[0], XCB_ATOM_ATOM);
+            if (!actions.isEmpty()) {
 #ifdef NETWMDEBUG
-            fprintf(stderr, "NETWinInfo::update: getting window type (%ld)\n", types.count());
+                fprintf(stderr, "NETWinInfo::update: updating allowed actions (%ld)\n", actions.count());
 #endif
-            p->has_net_support = true;
-            int pos = 0;
 
-            for (const xcb_atom_t type : types) {
+                for (const xcb_atom_t action : actions) {
 #ifdef NETWMDEBUG
-                const QByteArray name = get_atom_name(p->conn, type);
-                fprintf(stderr, "NETWinInfo::update:   examining window type %ld %s\n", type, name.constData());
+                    const QByteArray name = get_atom_name(p->conn, action);
+                    fprintf(stderr, "NETWinInfo::update:   adding allowed action %ld '%s'\n", action, name.constData());
 #endif
-                if (type == p->atom(_NET_WM_WINDOW_TYPE_NORMAL)) {
-                    p->types[pos++] = Normal;
-                }
-
-                else if (type == p->atom(_NET_WM_WINDOW_TYPE_DESKTOP)) {
-                    p->types[pos++] = Desktop;
-                }
-
-                else if (type == p->atom(_NET_WM_WINDOW_TYPE_DOCK)) {
-                    p->types[pos++] = Dock;
-                }
-
-                else if (type == p->atom(_NET_WM_WINDOW_TYPE_TOOLBAR)) {
-                    p->types[pos++] = Toolbar;
-                }
-
-                else if (type == p->atom(_NET_WM_WINDOW_TYPE_MENU)) {
-                    p->types[pos++] = Menu;
-                }
-
-                else if (type == p->atom(_NET_WM_WINDOW_TYPE_DIALOG)) {
-                    p->types[pos++] = Dialog;
-                }
-
-                else if (type == p->atom(_NET_WM_WINDOW_TYPE_UTILITY)) {
-                    p->types[pos++] = Utility;
-                }
-
-                else if (type == p->atom(_NET_WM_WINDOW_TYPE_SPLASH)) {
-                    p->types[pos++] = Splash;
-                }
-
-                else if (type == p->atom(_NET_WM_WINDOW_TYPE_DROPDOWN_MENU)) {
-                    p->types[pos++] = DropdownMenu;
-                }
-
-                else if (type == p->atom(_NET_WM_WINDOW_TYPE_POPUP_MENU)) {
-                    p->types[pos++] = PopupMenu;
-                }
-
-                else if (type == p->atom(_NET_WM_WINDOW_TYPE_TOOLTIP)) {
-                    p->types[pos++] = Tooltip;
-                }
-
-                else if (type == p->atom(_NET_WM_WINDOW_TYPE_NOTIFICATION)) {
-                    p->types[pos++] = Notification;
-                }
-
-                else if (type == p->atom(_NET_WM_WINDOW_TYPE_COMBO)) {
-                    p->types[pos++] = ComboBox;
-                }
-
-                else if (type == p->atom(_NET_WM_WINDOW_TYPE_DND)) {
-                    p->types[pos++] = DNDIcon;
-                }
-
-                else if (type == p->atom(_KDE_NET_WM_WINDOW_TYPE_OVERRIDE)) {
-                    p->types[pos++] = Override;
-                }
-
-                else if (type == p->atom(_KDE_NET_WM_WINDOW_TYPE_TOPMENU)) {
-                    p->types[pos++] = TopMenu;
-                }
-
-                else if (type == p->atom(_KDE_NET_WM_WINDOW_TYPE_ON_SCREEN_DISPLAY)) {
-                    p->types[pos++] = OnScreenDisplay;
-                }
-
-                else if (type == p->atom(_KDE_NET_WM_WINDOW_TYPE_CRITICAL_NOTIFICATION)) {
-                    p->types[pos++] = CriticalNotification;
-                }
-
-                else if (type == p->atom(_KDE_NET_WM_WINDOW_TYPE_APPLET_POPUP)) {
-                    p->types[pos++] = AppletPopup;
+                    if (const NETAtomMeaning *meaning = p->atoms->meaning(action)) {
+                        p->allowed_actions |= meaning->action;
+                    }
                 }
             }
-        }
-    }
-
-    if (dirty & WMStrut) {
-        p->strut = NETStrut();
-
-        QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL);
-        if (data.count() == 4) {
-            p->strut.left = data[0];
-            p->strut.right = data[1];
-            p->strut.top = data[2];
-            p->strut.bottom = data[3];
-        }
-    }
-
-    if (dirty2 & WM2ExtendedStrut) {
-        p->extended_strut = NETExtendedStrut();
-
-        QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL);
-        if (data.count() == 12) {
-            p->extended_strut.left_width = data[0];
-            p->extended_strut.right_width = data[1];
-            p->extended_strut.top_width = data[2];
-            p->extended_strut.bottom_width = data[3];
-            p->extended_strut.left_start = data[4];
-            p->extended_strut.left_end = data[5];
-            p->extended_strut.right_start = data[6];
-            p->extended_strut.right_end = data[7];
-            p->extended_strut.top_start = data[8];
-            p->extended_strut.top_end = data[9];
-            p->extended_strut.bottom_start = data[10];
-            p->extended_strut.bottom_end = data[11];
-        }
-    }
-
-    if (dirty2 & WM2FullscreenMonitors) {
-        p->fullscreen_monitors = NETFullscreenMonitors();
-
-        QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL);
-        if (data.count() == 4) {
-            p->fullscreen_monitors.top = data[0];
-            p->fullscreen_monitors.bottom = data[1];
-            p->fullscreen_monitors.left = data[2];
-            p->fullscreen_monitors.right = data[3];
-        }
-    }
-
-    if (dirty & WMIconGeometry) {
-        p->icon_geom = NETRect();
-
-        QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL);
-        if (data.count() == 4) {
-            p->icon_geom.pos.x = data[0];
-            p->icon_geom.pos.y = data[1];
-            p->icon_geom.size.width = data[2];
-            p->icon_geom.size.height = data[3];
-        }
-    }
+        }},
+        {{}, WM2UserTime, _NET_WM_USER_TIME, XCB_ATOM_CARDINAL, 1, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            p->user_time = -1U;
 
-    if (dirty & WMIcon) {
-        readIcon(p->conn, cookies[c++], p->icons, p->icon_count);
-        delete[] p->icon_sizes;
-        p->icon_sizes = nullptr;
-    }
-
-    if (dirty & WMFrameExtents) {
-        p->frame_strut = NETStrut();
-
-        QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL);
-
-        if (data.isEmpty()) {
-            data = get_array_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL);
-        } else {
-            xcb_discard_reply(p->conn, cookies[c++].sequence);
-        }
-
-        if (data.count() == 4) {
-            p->frame_strut.left = data[0];
-            p->frame_strut.right = data[1];
-            p->frame_strut.top = data[2];
-            p->frame_strut.bottom = data[3];
-        }
-    }
-
-    if (dirty2 & WM2FrameOverlap) {
-        p->frame_overlap = NETStrut();
-
-        QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL);
-        if (data.count() == 4) {
-            p->frame_overlap.left = data[0];
-            p->frame_overlap.right = data[1];
-            p->frame_overlap.top = data[2];
-            p->frame_overlap.bottom = data[3];
-        }
-    }
+            bool success;
+            uint32_t value = get_value_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL, 0, &success);
 
-    if (dirty2 & WM2Activities) {
-        delete[] p->activities;
-        p->activities = nullptr;
-
-        const QByteArray activities = get_string_reply(p->conn, cookies[c++], XCB_ATOM_STRING);
-        if (activities.length() > 0) {
-            p->activities = nstrndup(activities.constData(), activities.length());
-        }
-    }
-
-    if (dirty2 & WM2BlockCompositing) {
-        bool success;
-        p->blockCompositing = false;
-
-        // _KDE_NET_WM_BLOCK_COMPOSITING
-        uint32_t data = get_value_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL, 0, &success);
-        if (success) {
-            p->blockCompositing = bool(data);
-        }
-
-        // _NET_WM_BYPASS_COMPOSITOR
-        data = get_value_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL, 0, &success);
-        if (success) {
-            switch (data) {
-            case 1:
-                p->blockCompositing = true;
-                break;
-            case 2:
-                p->blockCompositing = false;
-                break;
-            default:
-                break; // yes, the standard /is/ that stupid.
+            if (success) {
+                p->user_time = value;
             }
-        }
-    }
-
-    if (dirty & WMPid) {
-        p->pid = get_value_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL, 0);
-    }
-
-    if (dirty2 & WM2StartupId) {
-        delete[] p->startup_id;
-        p->startup_id = nullptr;
-
-        const QByteArray id = get_string_reply(p->conn, cookies[c++], p->atom(UTF8_STRING));
-        if (id.length() > 0) {
-            p->startup_id = nstrndup(id.constData(), id.length());
-        }
-    }
-
-    if (dirty2 & WM2Opacity) {
-        p->opacity = get_value_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL, 0xffffffff);
-    }
-
-    if (dirty2 & WM2AllowedActions) {
-        p->allowed_actions = NET::Actions();
-
-        const QList<xcb_atom_t> actions = get_array_reply<xcb_atom_t>(p->conn, cookies[c++], XCB_ATOM_ATOM);
-        if (!actions.isEmpty()) {
-#ifdef NETWMDEBUG
-            fprintf(stderr, "NETWinInfo::update: updating allowed actions (%ld)\n", actions.count());
-#endif
-
-            for (const xcb_atom_t action : actions) {
-#ifdef NETWMDEBUG
-                const QByteArray name = get_atom_name(p->conn, action);
-                fprintf(stderr, "NETWinInfo::update:   adding allowed action %ld '%s'\n", action, name.constData());
-#endif
-                if (action == p->atom(_NET_WM_ACTION_MOVE)) {
-                    p->allowed_actions |= ActionMove;
+        }},
+        {{}, WM2TransientFor, XCB_ATOM_WM_TRANSIENT_FOR, XCB_ATOM_WINDOW, 1, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            p->transient_for = get_value_reply<xcb_window_t>(p->conn, cookies[0], XCB_ATOM_WINDOW, 0);
+        }},
+        {{}, WM2GroupLeader | WM2Urgency | WM2Input | WM2InitialMappingState | WM2IconPixmap, XCB_ATOM_WM_HINTS, XCB_ATOM_WM_HINTS, 9, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            xcb_get_property_reply_t *reply = KXcbInstrumentation::reply(xcb_get_property_reply, p->conn, cookies[0], nullptr);
+
+            if (reply && reply->format == 32 && reply->value_len == 9 && reply->type == XCB_ATOM_WM_HINTS) {
+                kde_wm_hints *hints = reinterpret_cast<kde_wm_hints *>(xcb_get_property_value(reply));
+
+                if (hints->flags & (1 << 0) /*Input*/) {
+                    p->input = hints->input;
                 }
-
-                else if (action == p->atom(_NET_WM_ACTION_RESIZE)) {
-                    p->allowed_actions |= ActionResize;
-                }
-
-                else if (action == p->atom(_NET_WM_ACTION_MINIMIZE)) {
-                    p->allowed_actions |= ActionMinimize;
-                }
-
-                else if (action == p->atom(_NET_WM_ACTION_SHADE)) {
-                    p->allowed_actions |= ActionShade;
-                }
-
-                else if (action == p->atom(_NET_WM_ACTION_STICK)) {
-                    p->allowed_actions |= ActionStick;
-                }
-
-                else if (action == p->atom(_NET_WM_ACTION_MAXIMIZE_VERT)) {
-                    p->allowed_actions |= ActionMaxVert;
+                if (hints->flags & (1 << 1) /*StateHint*/) {
+                    switch (hints->initial_state) {
+                    case 3: // IconicState
+                        p->initialMappingState = Iconic;
+                        break;
+
+                    case 1: // NormalState
+                        p->initialMappingState = Visible;
+                        break;
+
+                    case 0: // WithdrawnState
+                    default:
+                        p->initialMappingState = Withdrawn;
+                        break;
+                    }
                 }
-
-                else if (action == p->atom(_NET_WM_ACTION_MAXIMIZE_HORZ)) {
-                    p->allowed_actions |= ActionMaxHoriz;
+                if (hints->flags & (1 << 2) /*IconPixmapHint*/) {
+                    p->icon_pixmap = hints->icon_pixmap;
                 }
-
-                else if (action == p->atom(_NET_WM_ACTION_FULLSCREEN)) {
-                    p->allowed_actions |= ActionFullScreen;
+                if (hints->flags & (1 << 5) /*IconMaskHint*/) {
+                    p->icon_mask = hints->icon_mask;
                 }
-
-                else if (action == p->atom(_NET_WM_ACTION_CHANGE_DESKTOP)) {
-                    p->allowed_actions |= ActionChangeDesktop;
-                }
-
-                else if (action == p->atom(_NET_WM_ACTION_CLOSE)) {
-                    p->allowed_actions |= ActionClose;
+                if (hints->flags & (1 << 6) /*WindowGroupHint*/) {
+                    p->window_group = hints->window_group;
                 }
+                p->urgency = (hints->flags & (1 << 8) /*UrgencyHint*/);
             }
-        }
-    }
-
-    if (dirty2 & WM2UserTime) {
-        p->user_time = -1U;
-
-        bool success;
-        uint32_t value = get_value_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL, 0, &success);
-
-        if (success) {
-            p->user_time = value;
-        }
-    }
 
-    if (dirty2 & WM2TransientFor) {
-        p->transient_for = get_value_reply<xcb_window_t>(p->conn, cookies[c++], XCB_ATOM_WINDOW, 0);
-    }
-
-    if (dirty2 & (WM2GroupLeader | WM2Urgency | WM2Input | WM2InitialMappingState | WM2IconPixmap)) {
-        xcb_get_property_reply_t *reply = xcb_get_property_reply(p->conn, cookies[c++], nullptr);
-
-        if (reply && reply->format == 32 && reply->value_len == 9 && reply->type == XCB_ATOM_WM_HINTS) {
-            kde_wm_hints *hints = reinterpret_cast<kde_wm_hints *>(xcb_get_property_value(reply));
-
-            if (hints->flags & (1 << 0) /*Input*/) {
-                p->input = hints->input;
+            if (reply) {
+                free(reply);
             }
-            if (hints->flags & (1 << 1) /*StateHint*/) {
-                switch (hints->initial_state) {
-                case 3: // IconicState
-                    p->initialMappingState = Iconic;
-                    break;
-
-                case 1: // NormalState
-                    p->initialMappingState = Visible;
-                    break;
-
-                case 0: // WithdrawnState
-                default:
-                    p->initialMappingState = Withdrawn;
-                    break;
-                }
+        }},
+        {{}, WM2WindowClass, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, MAX_PROP_SIZE, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            p->strings.set(&p->class_name, nullptr);
+            p->strings.set(&p->class_class, nullptr);
+
+            const QList<QByteArray> list = get_stringlist_reply(p->conn, cookies[0], XCB_ATOM_STRING);
+            if (list.count() == 2) {
+                p->strings.intern(&p->class_name, list.at(0).constData());
+                p->strings.intern(&p->class_class, list.at(1).constData());
+            } else if (list.count() == 1) { // Not fully compliant client. Provides a single string
+                p->strings.intern(&p->class_name, list.at(0).constData());
+                p->strings.intern(&p->class_class, list.at(0).constData());
             }
-            if (hints->flags & (1 << 2) /*IconPixmapHint*/) {
-                p->icon_pixmap = hints->icon_pixmap;
+        }},
+        {{}, WM2WindowRole, WM_WINDOW_ROLE, XCB_ATOM_STRING, MAX_PROP_SIZE, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            const QByteArray role = get_string_reply(p->conn, cookies[0], XCB_ATOM_STRING);
+            p->strings.set(&p->window_role, role.constData(), role.length());
+        }},
+        {{}, WM2ClientMachine, XCB_ATOM_WM_CLIENT_MACHINE, XCB_ATOM_STRING, MAX_PROP_SIZE, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            const QByteArray value = get_string_reply(p->conn, cookies[0], XCB_ATOM_STRING);
+            p->strings.intern(&p->client_machine, value.constData(), value.length());
+        }},
+        {{}, WM2Protocols, WM_PROTOCOLS, XCB_ATOM_ATOM, 2048, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            const QList<xcb_atom_t> protocols = get_array_reply<xcb_atom_t>(p->conn, cookies[0], XCB_ATOM_ATOM);
+            p->protocols = NET::NoProtocol;
+            for (auto it = protocols.begin(); it != protocols.end(); ++it) {
+                if ((*it) == p->atom(WM_TAKE_FOCUS)) {
+                    p->protocols |= TakeFocusProtocol;
+                } else if ((*it) == p->atom(WM_DELETE_WINDOW)) {
+                    p->protocols |= DeleteWindowProtocol;
+                } else if ((*it) == p->atom(_NET_WM_PING)) {
+                    p->protocols |= PingProtocol;
+                } else if ((*it) == p->atom(_NET_WM_SYNC_REQUEST)) {
+                    p->protocols |= SyncRequestProtocol;
+                } else if ((*it) == p->atom(_NET_WM_CONTEXT_HELP)) {
+                    p->protocols |= ContextHelpProtocol;
+                }
             }
-            if (hints->flags & (1 << 5) /*IconMaskHint*/) {
-                p->icon_mask = hints->icon_mask;
+        }},
+        {{}, WM2OpaqueRegion, _NET_WM_OPAQUE_REGION, XCB_ATOM_CARDINAL, MAX_PROP_SIZE, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            const QList<qint32> values = get_array_reply<qint32>(p->conn, cookies[0], XCB_ATOM_CARDINAL);
+            p->opaqueRegion.clear();
+            p->opaqueRegion.reserve(values.count() / 4);
+            for (int i = 0; i < values.count() - 3; i += 4) {
+                NETRect rect;
+                rect.pos.x = values.at(i);
+                rect.pos.y = values.at(i + 1);
+                rect.size.width = values.at(i + 2);
+                rect.size.height = values.at(i + 3);
+                p->opaqueRegion.push_back(rect);
             }
-            if (hints->flags & (1 << 6) /*WindowGroupHint*/) {
-                p->window_group = hints->window_group;
+        }},
+        {{}, WM2DesktopFileName, _KDE_NET_WM_DESKTOP_FILE, UTF8_STRING, MAX_PROP_SIZE, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            const QByteArray id = get_string_reply(p->conn, cookies[0], p->atom(UTF8_STRING));
+            p->strings.intern(&p->desktop_file, id.constData(), id.length());
+        }},
+        {{}, WM2GTKApplicationId, _GTK_APPLICATION_ID, UTF8_STRING, MAX_PROP_SIZE, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            const QByteArray id = get_string_reply(p->conn, cookies[0], p->atom(UTF8_STRING));
+            p->strings.intern(&p->gtk_application_id, id.constData(), id.length());
+        }},
+        {{}, WM2GTKFrameExtents, _GTK_FRAME_EXTENTS, XCB_ATOM_CARDINAL, 4, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            p->gtk_frame_extents = NETStrut();
+
+            QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[0], XCB_ATOM_CARDINAL);
+            if (data.count() == 4) {
+                p->gtk_frame_extents.left = data[0];
+                p->gtk_frame_extents.right = data[1];
+                p->gtk_frame_extents.top = data[2];
+                p->gtk_frame_extents.bottom = data[3];
             }
-            p->urgency = (hints->flags & (1 << 8) /*UrgencyHint*/);
-        }
-
-        if (reply) {
-            free(reply);
-        }
-    }
-
-    if (dirty2 & WM2WindowClass) {
-        delete[] p->class_name;
-        delete[] p->class_class;
-        p->class_name = nullptr;
-        p->class_class = nullptr;
-
-        const QList<QByteArray> list = get_stringlist_reply(p->conn, cookies[c++], XCB_ATOM_STRING);
-        if (list.count() == 2) {
-            p->class_name = nstrdup(list.at(0).constData());
-            p->class_class = nstrdup(list.at(1).constData());
-        } else if (list.count() == 1) { // Not fully compliant client. Provides a single string
-            p->class_name = nstrdup(list.at(0).constData());
-            p->class_class = nstrdup(list.at(0).constData());
-        }
-    }
-
-    if (dirty2 & WM2WindowRole) {
-        delete[] p->window_role;
-        p->window_role = nullptr;
-
-        const QByteArray role = get_string_reply(p->conn, cookies[c++], XCB_ATOM_STRING);
-        if (role.length() > 0) {
-            p->window_role = nstrndup(role.constData(), role.length());
-        }
-    }
-
-    if (dirty2 & WM2ClientMachine) {
-        delete[] p->client_machine;
-        p->client_machine = nullptr;
-
-        const QByteArray value = get_string_reply(p->conn, cookies[c++], XCB_ATOM_STRING);
-        if (value.length() > 0) {
-            p->client_machine = nstrndup(value.constData(), value.length());
-        }
-    }
-
-    if (dirty2 & WM2Protocols) {
-        const QList<xcb_atom_t> protocols = get_array_reply<xcb_atom_t>(p->conn, cookies[c++], XCB_ATOM_ATOM);
-        p->protocols = NET::NoProtocol;
-        for (auto it = protocols.begin(); it != protocols.end(); ++it) {
-            if ((*it) == p->atom(WM_TAKE_FOCUS)) {
-                p->protocols |= TakeFocusProtocol;
-            } else if ((*it) == p->atom(WM_DELETE_WINDOW)) {
-                p->protocols |= DeleteWindowProtocol;
-            } else if ((*it) == p->atom(_NET_WM_PING)) {
-                p->protocols |= PingProtocol;
-            } else if ((*it) == p->atom(_NET_WM_SYNC_REQUEST)) {
-                p->protocols |= SyncRequestProtocol;
-            } else if ((*it) == p->atom(_NET_WM_CONTEXT_HELP)) {
-                p->protocols |= ContextHelpProtocol;
-            }
-        }
-    }
-
-    if (dirty2 & WM2OpaqueRegion) {
-        const QList<qint32> values = get_array_reply<qint32>(p->conn, cookies[c++], XCB_ATOM_CARDINAL);
-        p->opaqueRegion.clear();
-        p->opaqueRegion.reserve(values.count() / 4);
-        for (int i = 0; i < values.count() - 3; i += 4) {
-            NETRect rect;
-            rect.pos.x = values.at(i);
-            rect.pos.y = values.at(i + 1);
-            rect.size.width = values.at(i + 2);
-            rect.size.height = values.at(i + 3);
-            p->opaqueRegion.push_back(rect);
-        }
-    }
-
-    if (dirty2 & WM2DesktopFileName) {
-        delete[] p->desktop_file;
-        p->desktop_file = nullptr;
-
-        const QByteArray id = get_string_reply(p->conn, cookies[c++], p->atom(UTF8_STRING));
-        if (id.length() > 0) {
-            p->desktop_file = nstrndup(id.constData(), id.length());
-        }
-    }
-
-    if (dirty2 & WM2GTKApplicationId) {
-        delete[] p->gtk_application_id;
-        p->gtk_application_id = nullptr;
-
-        const QByteArray id = get_string_reply(p->conn, cookies[c++], p->atom(UTF8_STRING));
-        if (id.length() > 0) {
-            p->gtk_application_id = nstrndup(id.constData(), id.length());
-        }
-    }
-
-    if (dirty2 & WM2GTKFrameExtents) {
-        p->gtk_frame_extents = NETStrut();
+        }},
+        {{}, WM2AppMenuObjectPath, _KDE_NET_WM_APPMENU_OBJECT_PATH, XCB_ATOM_STRING, MAX_PROP_SIZE, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            const QByteArray id = get_string_reply(p->conn, cookies[0], XCB_ATOM_STRING);
+            p->strings.set(&p->appmenu_object_path, id.constData(), id.length());
+        }},
+        {{}, WM2AppMenuServiceName, _KDE_NET_WM_APPMENU_SERVICE_NAME, XCB_ATOM_STRING, MAX_PROP_SIZE, [](NETWinInfoPrivate *p, const xcb_get_property_cookie_t *cookies) {
+            const QByteArray id = get_string_reply(p->conn, cookies[0], XCB_ATOM_STRING);
+            p->strings.set(&p->appmenu_service_name, id.constData(), id.length());
+        }},
+    };
+
+    KXcbInstrumentation::Scope scope(p->conn, "NETWinInfo::update");
+    Properties dirty = dirtyProperties & p->properties;
+    Properties2 dirty2 = dirtyProperties2 & p->properties2;
 
-        QList<uint32_t> data = get_array_reply<uint32_t>(p->conn, cookies[c++], XCB_ATOM_CARDINAL);
-        if (data.count() == 4) {
-            p->gtk_frame_extents.left = data[0];
-            p->gtk_frame_extents.right = data[1];
-            p->gtk_frame_extents.top = data[2];
-            p->gtk_frame_extents.bottom = data[3];
-        }
+    // We *always* want to update WM_STATE if set in dirty_props
+    if (dirtyProperties & XAWMState) {
+        dirty |= XAWMState;
     }
 
-    if (dirty2 & WM2AppMenuObjectPath) {
-        delete[] p->appmenu_object_path;
-        p->appmenu_object_path = nullptr;
-
-        const QByteArray id = get_string_reply(p->conn, cookies[c++], XCB_ATOM_STRING);
-        if (id.length() > 0) {
-            p->appmenu_object_path = nstrndup(id.constData(), id.length());
+    if (NETWinInfoFetchData *fetch = p->fetch) {
+        // split by virtual_hook(), the replies are parsed once the caller has them
+        if (fetch->cookies.isEmpty()) {
+            fetch->cookies.resize(std::size(propertyTable) * 2);
+            requestProperties(p->conn, p->window, *p->atoms, propertyTable, dirty, dirty2, fetch->cookies.data());
+        } else {
+            p->strings.begin();
+            parseProperties(p, propertyTable, dirty, dirty2, fetch->cookies.constData());
+            p->strings.commit();
         }
+        return;
     }
 
-    if (dirty2 & WM2AppMenuServiceName) {
-        delete[] p->appmenu_service_name;
-        p->appmenu_service_name = nullptr;
-
-        const QByteArray id = get_string_reply(p->conn, cookies[c++], XCB_ATOM_STRING);
-        if (id.length() > 0) {
-            p->appmenu_service_name = nstrndup(id.constData(), id.length());
-        }
-    }
+    xcb_get_property_cookie_t cookies[std::size(propertyTable) * 2];
+    requestProperties(p->conn, p->window, *p->atoms, propertyTable, dirty, dirty2, cookies);
+    // the strings of all properties end up in one block
+    p->strings.begin();
+    parseProperties(p, propertyTable, dirty, dirty2, cookies);
+    p->strings.commit();
 }
 
 NETRect NETWinInfo::iconGeometry() const
@@ -4833,19 +4990,17 @@ const char *NETWinInfo::activities() const
 
 void NETWinInfo::setActivities(const char *activities)
 {
-    delete[] p->activities;
-
     if (activities == (char *)nullptr || activities[0] == '\0') {
         // on all activities
         static const char nulluuid[] = KDE_ALL_ACTIVITIES_UUID;
 
-        p->activities = nstrdup(nulluuid);
+        p->strings.intern(&p->activities, nulluuid);
 
     } else {
-        p->activities = nstrdup(activities);
+        p->strings.intern(&p->activities, activities);
     }
 
-    xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_KDE_NET_WM_ACTIVITIES), XCB_ATOM_STRING, 8, strlen(p->activities), p->activities);
+    changeProperty(p->conn, p->window, p->atom(_KDE_NET_WM_ACTIVITIES), XCB_ATOM_STRING, 8, strlen(p->activities), p->activities);
 }
 
 void NETWinInfo::setBlockingCompositing(bool active)
@@ -4857,11 +5012,11 @@ void NETWinInfo::setBlockingCompositing(bool active)
     p->blockCompositing = active;
     if (active) {
         uint32_t d = 1;
-        xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_KDE_NET_WM_BLOCK_COMPOSITING), XCB_ATOM_CARDINAL, 32, 1, (const void *)&d);
-        xcb_change_property(p->conn, XCB_PROP_MODE_REPLACE, p->window, p->atom(_NET_WM_BYPASS_COMPOSITOR), XCB_ATOM_CARDINAL, 32, 1, (const void *)&d);
+        changeProperty(p->conn, p->window, p->atom(_KDE_NET_WM_BLOCK_COMPOSITING), XCB_ATOM_CARDINAL, 32, 1, (const void *)&d);
+        changeProperty(p->conn, p->window, p->atom(_NET_WM_BYPASS_COMPOSITOR), XCB_ATOM_CARDINAL, 32, 1, (const void *)&d);
     } else {
-        xcb_delete_property(p->conn, p->window, p->atom(_KDE_NET_WM_BLOCK_COMPOSITING));
-        xcb_delete_property(p->conn, p->window, p->atom(_NET_WM_BYPASS_COMPOSITOR));
+        deleteProperty(p->conn, p->window, p->atom(_KDE_NET_WM_BLOCK_COMPOSITING));
+        deleteProperty(p->conn, p->window, p->atom(_NET_WM_BYPASS_COMPOSITOR));
     }
 }
 
@@ -4916,17 +5071,9 @@ void NETWinInfo::setDesktopFileName(const char *name)
         return;
     }
 
-    delete[] p->desktop_file;
-    p->desktop_file = nstrdup(name);
+    p->strings.intern(&p->desktop_file, name);
 
-    xcb_change_property(p->conn,
-                        XCB_PROP_MODE_REPLACE,
-                        p->window,
-                        p->atom(_KDE_NET_WM_DESKTOP_FILE),
-                        p->atom(UTF8_STRING),
-                        8,
-                        strlen(p->desktop_file),
-                        (const void *)p->desktop_file);
+    changeProperty(p->conn, p->window, p->atom(_KDE_NET_WM_DESKTOP_FILE), p->atom(UTF8_STRING), 8, strlen(p->desktop_file), (const void *)p->desktop_file);
 }
 
 const char *NETWinInfo::desktopFileName() const
@@ -4939,13 +5086,53 @@ const char *NETWinInfo::gtkApplicationId() const
     return p->gtk_application_id;
 }
 
-void NETRootInfo::virtual_hook(int, void *)
+void NETWinInfo::setStringInterningEnabled(bool enabled)
+{
+    NETStringPool::setEnabled(enabled);
+}
+
+bool NETWinInfo::isStringInterningEnabled()
 {
+    return NETStringPool::isEnabled();
+}
+
+void NETRootInfo::virtual_hook(int id, void *data)
+{
+    if (id == NETRootInfoCopyValuesHook) {
+        copyRootValues(p, static_cast<NETRootInfo *>(data)->p);
+        return;
+    }
     /*BASE::virtual_hook( id, data );*/
 }
 
-void NETWinInfo::virtual_hook(int, void *)
+void NETWinInfo::virtual_hook(int id, void *data)
 {
+    if (id == NETWinInfoRequestHook || id == NETWinInfoParseHook) {
+        auto fetch = static_cast<NETWinInfoFetchData *>(data);
+        if (id == NETWinInfoRequestHook) {
+            fetch->cookies.clear();
+            p->properties = fetch->properties;
+            p->properties2 = fetch->properties2;
+        } else if (fetch->geometry) {
+            p->win_geom = *fetch->geometry;
+        }
+        p->fetch = fetch;
+        update(fetch->properties, fetch->properties2);
+        p->fetch = nullptr;
+        return;
+    }
+    if (id == NETWinInfoStringBytesHook) {
+        auto string = static_cast<NETWinInfoStringBytesData *>(data);
+        // only a string the arena doesn't hold has to be looked up in the pool
+        if (!string->value) {
+            string->bytes = QByteArray();
+        } else if (p->strings.owns(string->value)) {
+            string->bytes = QByteArray(string->value);
+        } else {
+            string->bytes = NETStringPool::bytes(string->value);
+        }
+        return;
+    }
     /*BASE::virtual_hook( id, data );*/
 }
 
@@ -1225,6 +1225,23 @@ public:
     **/
     void setState(NET::States state, NET::States mask);
 
+    /*!
+       Asks the window manager to change the state of the application window, without
+       reading the current state first like setState() has to.
+
+       A request is sent for every state in \a mask, adding it if it is set in \a state
+       and removing it otherwise. Window managers only act on requests for windows they
+       manage, so this is meant for windows that are known to be mapped or iconic, e.g.
+       the ones in the client list.
+
+       \a state the new state
+
+       \a mask the states to change
+
+       \since 6.30
+    **/
+    void requestState(NET::States state, NET::States mask);
+
     /*!
        Sets the window type for this client (see the NET base class
        documentation for a description of the various window types).
@@ -1278,6 +1295,19 @@ public:
     **/
     void setDesktop(int desktop, bool ignore_viewport = false);
 
+    /*!
+       Asks the window manager to move the application window to \a desktop, without
+       reading the mapping state of the window first like setDesktop() has to. Just as
+       requestState() it is meant for windows that are known to be managed.
+
+       Viewports are not taken into account.
+
+       \a desktop the number of the new desktop, or OnAllDesktops
+
+       \since 6.30
+    **/
+    void requestDesktop(int desktop);
+
     /*!
        Set the application window's process id.
 
@@ -1640,6 +1670,28 @@ public:
      **/
     const char *gtkApplicationId() const;
 
+    /*!
+     * Makes all NETWinInfo objects of the process share a single copy of the strings
+     * that are usually the same for many windows: windowClassClass(), windowClassName(),
+     * clientMachine(), activities(), desktopFileName() and gtkApplicationId().
+     *
+     * While enabled, windows with equal values of one of these return the same pointer,
+     * so they can be compared by address. Their memory is released once no window
+     * holds them anymore. Values read before interning was enabled are not shared.
+     *
+     * Disabled by default.
+     *
+     * \since 6.30
+     **/
+    static void setStringInterningEnabled(bool enabled);
+
+    /*!
+     * Returns whether the strings of windows are shared.
+     * \sa setStringInterningEnabled
+     * \since 6.30
+     **/
+    static bool isStringInterningEnabled();
+
     /*!
      * Sets the \a name as the D-BUS service name for the application menu.
      * \since 5.69
@@ -1729,6 +1781,73 @@ private:
     NETWinInfoPrivate *p; // krazy:exclude=dpointer (implicitly shared)
 };
 
+/*!
+   \class NETPropertyTransaction
+   \inheaderfile NETWM
+   \inmodule KWindowSystem
+   \brief Batches the property writes of NETRootInfo and NETWinInfo.
+
+   While a transaction is open on a connection, the setters of NETRootInfo and
+   NETWinInfo on that connection don't write their properties right away. Only the
+   last value written to a property of a window is kept and sent at commit(), so a
+   window manager rewriting e.g. the client list or the state of a window several
+   times during one operation causes a single change on the server and a single
+   PropertyNotify to every client watching it.
+
+   The values the setters store in the NETRootInfo and NETWinInfo objects are
+   updated immediately, but until commit() the server and everybody reading from it
+   still see the old values. The writes are queued on the connection like any other
+   request, flushing them is up to the caller.
+
+   Transactions on the same connection nest, only the outermost commit() writes.
+
+   \code
+   {
+       NETPropertyTransaction transaction(connection);
+       rootInfo.setClientList(clients, count);
+       rootInfo.setActiveWindow(window);
+       winInfo.setState(NET::Focused, NET::Focused);
+   } // committed here
+   \endcode
+
+   \since 6.30
+   \sa NETRootInfo
+   \sa NETWinInfo
+ **/
+class KWINDOWSYSTEM_EXPORT NETPropertyTransaction
+{
+public:
+    /*!
+       Opens a transaction on \a connection.
+    **/
+    explicit NETPropertyTransaction(xcb_connection_t *connection);
+
+    /*!
+       Commits the transaction unless that was done already.
+    **/
+    ~NETPropertyTransaction();
+
+    NETPropertyTransaction(const NETPropertyTransaction &) = delete;
+    NETPropertyTransaction &operator=(const NETPropertyTransaction &) = delete;
+
+    /*!
+       Writes the last value of every property changed since the transaction was
+       opened. Calling it more than once has no effect.
+    **/
+    void commit();
+
+    /*!
+       Returns how many writes on the connection were dropped so far because a later
+       write replaced them. Nested transactions share the count of the outermost one.
+    **/
+    int droppedWrites() const;
+
+private:
+    xcb_connection_t *m_connection;
+    bool m_committed = false;
+    int m_droppedWrites = 0;
+};
+
 // #define KWIN_FOCUS
 
 #endif
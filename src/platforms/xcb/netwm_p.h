@@ -8,26 +8,155 @@
 #ifndef netwm_p_h
 #define netwm_p_h
 
+#include <QByteArray>
+#include <QHash>
+#include <QList>
 #include <QSharedPointer>
 
+#include <optional>
+
 #include "atoms_p.h"
+#include "netwm.h"
+
+/*!
+   What an atom in a _NET_WM_STATE, _NET_WM_WINDOW_TYPE or _NET_WM_ALLOWED_ACTIONS
+   array stands for. Only the member of its kind is set.
+   \internal
+**/
+struct NETAtomMeaning {
+    NET::States state;
+    NET::WindowType type = NET::Unknown;
+    NET::Actions action;
+};
 
 class Atoms
 {
 public:
     explicit Atoms(xcb_connection_t *c);
+    // takes the atoms interned on another connection, in KwsAtom order
+    Atoms(xcb_connection_t *c, const QList<xcb_atom_t> &table);
 
     xcb_atom_t atom(KwsAtom atom) const
     {
         return m_atoms[atom];
     }
 
+    // all of them in KwsAtom order
+    QList<xcb_atom_t> table() const;
+
+    // saves going through all the states, types and actions for every atom decoded
+    const NETAtomMeaning *meaning(xcb_atom_t atom) const
+    {
+        const auto it = m_meanings.constFind(atom);
+        return it != m_meanings.constEnd() ? &it.value() : nullptr;
+    }
+
 private:
     void init();
+    void initMeanings();
     xcb_atom_t m_atoms[KwsAtomCount];
+    QHash<xcb_atom_t, NETAtomMeaning> m_meanings;
     xcb_connection_t *m_connection;
 };
 
+/*!
+   Returns the atoms NETRootInfo and NETWinInfo use on \a c, interning them first if
+   needed. Unless running on X11 they are only kept for as long as someone holds them.
+   \internal
+**/
+QSharedPointer<Atoms> atomsForConnection(xcb_connection_t *c);
+
+/*!
+   Makes NETRootInfo and NETWinInfo on \a c use the atoms of \a table instead of
+   interning them, for replaying what was traced on another connection. They stay
+   in use until releaseAtomTable() is called, or the returned pointer is dropped
+   when not running on X11.
+   \internal
+**/
+QSharedPointer<Atoms> adoptAtomTable(xcb_connection_t *c, const QList<xcb_atom_t> &table);
+void releaseAtomTable(xcb_connection_t *c);
+
+/*!
+   Ids passed to NETRootInfo::virtual_hook().
+   \internal
+**/
+enum NETRootInfoHookId {
+    // data is a NETRootInfoAddClientsData
+    NETRootInfoAddClientsHook = 1,
+    // data is another NETRootInfo, its values are copied without sharing its private data
+    NETRootInfoCopyValuesHook = 2,
+};
+
+/*!
+   Hands all clients added by a single update to the subclass at once, so it can
+   pipeline its per-client requests. If handled is left unset, addClient() is
+   called for every window instead.
+   \internal
+**/
+struct NETRootInfoAddClientsData {
+    const QList<xcb_window_t> *clients;
+    bool handled = false;
+};
+
+/*!
+   Ids passed to NETWinInfo::virtual_hook().
+   \internal
+**/
+enum NETWinInfoHookId {
+    // data is a NETWinInfoFetchData, sends the requests for its properties
+    NETWinInfoRequestHook = 1,
+    // data is the NETWinInfoFetchData passed to NETWinInfoRequestHook, parses the replies
+    NETWinInfoParseHook = 2,
+    // data is a NETWinInfoStringBytesData
+    NETWinInfoStringBytesHook = 3,
+};
+
+/*!
+   Splits the update of a NETWinInfo created without properties into sending the
+   requests and parsing the replies, so the caller can wait for the replies without
+   blocking. If geometry is set before parsing, kdeGeometry() doesn't fetch it again.
+   \internal
+**/
+struct NETWinInfoFetchData {
+    NET::Properties properties;
+    NET::Properties2 properties2;
+    QList<xcb_get_property_cookie_t> cookies;
+    std::optional<NETRect> geometry;
+};
+
+/*!
+   Turns value, one of the strings of the NETWinInfo, into bytes. A string interned in
+   NETStringPool is shared instead of copied.
+   \internal
+**/
+struct NETWinInfoStringBytesData {
+    const char *value;
+    QByteArray bytes;
+};
+
+/*!
+   Gives callers outside of NETWinInfo the update split into requests and replies,
+   see NETWinInfoFetchData, and its strings as shared bytes.
+   \internal
+**/
+class NETWinInfoFetcher : public NETWinInfo
+{
+public:
+    using NETWinInfo::NETWinInfo;
+
+    void fetch(NETWinInfoHookId id, NETWinInfoFetchData *data)
+    {
+        virtual_hook(id, data);
+    }
+
+    QByteArray stringBytes(const char *value)
+    {
+        NETWinInfoStringBytesData data{value, QByteArray()};
+        virtual_hook(NETWinInfoStringBytesHook, &data);
+        return data.bytes;
+    }
+};
+
 /*!
    Resizable array class.
 
@@ -132,6 +261,92 @@ struct NETRootInfoPrivate {
     }
 };
 
+/*!
+   Process wide pool of the strings which are the same for many windows, like WM_CLASS
+   or the desktop file name. Each distinct value is held once with a count of the
+   fields referring to it, and acquire() returns the same pointer for equal values.
+   It is thread safe, as KX11Extras may track windows in a worker thread.
+   \internal
+**/
+namespace NETStringPool
+{
+bool isEnabled();
+void setEnabled(bool enabled);
+
+// returns the shared copy of the length bytes at value, to be given back with release()
+const char *acquire(const char *value, qsizetype length);
+void release(const char *value);
+
+/*!
+   Returns \a value, which was acquired from the pool, as a QByteArray sharing its data.
+   Only the pointer is looked up, other strings are copied.
+**/
+QByteArray bytes(const char *value);
+}
+
+/*!
+   Keeps the strings of a NETWinInfo in blocks instead of allocating each of them on its
+   own. The strings stored between begin() and commit(), all those read by one
+   NETWinInfo::update(), are collected first and then copied into a single block of
+   exactly their size. A string set outside of that gets a block of its own. A new value
+   that fits where the one it replaces is, counting the bytes of strings released or
+   shortened after it, gets written over it. Strings never move once committed, so like
+   before a string is valid until its own field is set again. A block is freed as soon
+   as none of its strings is in use any more.
+
+   Fields set with intern() point into NETStringPool instead, as long as it is enabled.
+   The arena does not know its fields, they have to be cleared before it is destroyed.
+   \internal
+**/
+class NETStringArena
+{
+public:
+    NETStringArena() = default;
+    ~NETStringArena();
+    NETStringArena(const NETStringArena &) = delete;
+    NETStringArena &operator=(const NETStringArena &) = delete;
+
+    // the strings of the fields set until commit() still move, their fields are kept
+    // pointing at them but no other pointer to them may be held
+    void begin();
+    void commit();
+
+    // stores a copy of value in *field, nullptr if value is nullptr
+    void set(char **field, const char *value);
+    // stores a copy of the length bytes at value in *field, nullptr if there are none
+    void set(char **field, const char *value, qsizetype length);
+    // like set(), but shares the value through NETStringPool if it is enabled
+    void intern(char **field, const char *value);
+    void intern(char **field, const char *value, qsizetype length);
+
+    // whether value is one of the strings of this arena rather than one of the pool
+    bool owns(const char *value) const;
+
+private:
+    struct Block {
+        Block *next;
+        int size;
+        // strings in this block still referred to by a field
+        int live;
+        char *data()
+        {
+            return reinterpret_cast<char *>(this + 1);
+        }
+    };
+
+    void assign(char **field, const char *value, qsizetype length);
+    void share(char **field, const char *value, qsizetype length);
+    char *store(char **field, const char *value, qsizetype length);
+    // gives back the previous value of a field, to the pool if it isn't ours
+    void release(const char *value);
+    Block *block(const char *value) const;
+    bool isStaged(const char *value) const;
+    // the length a new value may have to take the place of value, -1 if it isn't ours
+    qsizetype room(const char *value) const;
+
+    Block *m_blocks = nullptr;
+};
+
 /*!
    Private data for the NETWinInfo class.
    \internal
@@ -174,7 +389,7 @@ struct NETWinInfoPrivate {
     NETFullscreenMonitors fullscreen_monitors;
     bool has_net_support;
 
-    const char *activities;
+    char *activities;
     bool blockCompositing;
     bool urgency;
     bool input;
@@ -182,6 +397,12 @@ struct NETWinInfoPrivate {
     NET::Protocols protocols;
     std::vector<NETRect> opaqueRegion;
 
+    // set while update() runs on behalf of NETWinInfo::virtual_hook()
+    NETWinInfoFetchData *fetch = nullptr;
+
+    // holds name, class_class and all the other strings
+    NETStringArena strings;
+
     int ref;
 
     QSharedPointer<Atoms> atoms;
@@ -0,0 +1,20 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+import QtQuick 2.15
+import QtQuick.Controls 2.15 as QQC2
+
+import org.kde.kwindowsystem 1.0
+
+ListView {
+    model: WindowModel {}
+    delegate: QQC2.Label {
+        // the rows scrolled into view are fetched from the X server, and fetched
+        // again without blocking when the window changes
+        text: model.name + (model.active ? " (active)" : "")
+        font.italic: model.minimized
+    }
+}
@@ -0,0 +1,202 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#include "windowmodel.h"
+
+#include <KWindowSystem>
+
+#include <QFuture>
+
+#include <utility>
+
+struct RoleProperties {
+    int role;
+    NET::Properties properties;
+    NET::Properties2 properties2;
+};
+
+// which changes make each role stale
+static const RoleProperties roleProperties[] = {
+    {WindowModel::NameRole, NET::WMVisibleName | NET::WMName, NET::Properties2()},
+    {Qt::DisplayRole, NET::WMVisibleName | NET::WMName, NET::Properties2()},
+    {WindowModel::WindowClassRole, NET::Properties(), NET::WM2WindowClass},
+    {WindowModel::DesktopRole, NET::WMDesktop, NET::Properties2()},
+    {WindowModel::MinimizedRole, NET::WMState | NET::XAWMState, NET::Properties2()},
+    {WindowModel::PidRole, NET::WMPid, NET::Properties2()},
+};
+
+// the roles read from the fetched KWindowInfo
+static const QList<int> infoRoles = {Qt::DisplayRole, WindowModel::NameRole, WindowModel::WindowClassRole, WindowModel::DesktopRole, WindowModel::MinimizedRole, WindowModel::PidRole};
+
+// what a row fetches, the properties of all roles
+static const NET::Properties windowProperties = NET::WMVisibleName | NET::WMName | NET::WMDesktop | NET::WMState | NET::XAWMState | NET::WMPid;
+static const NET::Properties2 windowProperties2 = NET::WM2WindowClass;
+
+WindowModel::WindowModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    if (!KWindowSystem::isPlatformX11()) {
+        return;
+    }
+
+    const QList<WId> windows = KX11Extras::windows();
+    m_windows.reserve(windows.size());
+    m_rows.reserve(windows.size());
+    for (WId window : windows) {
+        m_rows.insert(window, m_windows.count());
+        m_windows.append(Window{window, std::nullopt, false});
+    }
+    m_activeWindow = KX11Extras::activeWindow();
+
+    connect(KX11Extras::self(), &KX11Extras::windowAdded, this, &WindowModel::addWindow);
+    connect(KX11Extras::self(), &KX11Extras::windowRemoved, this, &WindowModel::removeWindow);
+    connect(KX11Extras::self(), &KX11Extras::windowsChanged, this, &WindowModel::updateWindows);
+    connect(KX11Extras::self(), &KX11Extras::activeWindowChanged, this, &WindowModel::updateActiveWindow);
+}
+
+int WindowModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_windows.count();
+}
+
+QVariant WindowModel::data(const QModelIndex &index, int role) const
+{
+    if (!checkIndex(index, CheckIndexOption::IndexIsValid | CheckIndexOption::ParentIsInvalid)) {
+        return QVariant();
+    }
+    const Window &window = m_windows.at(index.row());
+
+    switch (role) {
+    case WindowIdRole:
+        return QVariant::fromValue(window.id);
+    case ActiveRole:
+        return window.id == m_activeWindow;
+    case Qt::DisplayRole:
+    case NameRole:
+    case WindowClassRole:
+    case DesktopRole:
+    case MinimizedRole:
+    case PidRole:
+        break;
+    default:
+        return QVariant();
+    }
+
+    if (!window.info) {
+        if (!window.requested) {
+            window.requested = true;
+            // only sends the requests, the row is updated once the replies arrived
+            const_cast<WindowModel *>(this)->refresh(window.id, infoRoles);
+        }
+        return QVariant();
+    }
+    const KWindowInfo &info = *window.info;
+    switch (role) {
+    case Qt::DisplayRole:
+    case NameRole:
+        return info.visibleName();
+    case WindowClassRole:
+        return QString::fromLocal8Bit(info.windowClassClass());
+    case DesktopRole:
+        return info.desktop();
+    case MinimizedRole:
+        return info.isMinimized();
+    case PidRole:
+        return info.pid();
+    }
+    return QVariant();
+}
+
+QHash<int, QByteArray> WindowModel::roleNames() const
+{
+    return {
+        {Qt::DisplayRole, QByteArrayLiteral("display")},
+        {WindowIdRole, QByteArrayLiteral("windowId")},
+        {NameRole, QByteArrayLiteral("name")},
+        {WindowClassRole, QByteArrayLiteral("windowClass")},
+        {DesktopRole, QByteArrayLiteral("desktop")},
+        {MinimizedRole, QByteArrayLiteral("minimized")},
+        {PidRole, QByteArrayLiteral("pid")},
+        {ActiveRole, QByteArrayLiteral("active")},
+    };
+}
+
+void WindowModel::addWindow(WId window)
+{
+    if (m_rows.contains(window)) {
+        return;
+    }
+    const int row = m_windows.count();
+    beginInsertRows(QModelIndex(), row, row);
+    m_rows.insert(window, row);
+    m_windows.append(Window{window, std::nullopt, false});
+    endInsertRows();
+}
+
+void WindowModel::removeWindow(WId window)
+{
+    const int row = m_rows.value(window, -1);
+    if (row == -1) {
+        return;
+    }
+    beginRemoveRows(QModelIndex(), row, row);
+    m_rows.remove(window);
+    m_windows.removeAt(row);
+    for (int i = row; i < m_windows.count(); ++i) {
+        m_rows[m_windows.at(i).id] = i;
+    }
+    endRemoveRows();
+}
+
+void WindowModel::updateWindows(const QHash<WId, QPair<NET::Properties, NET::Properties2>> &changes)
+{
+    for (auto change = changes.constBegin(); change != changes.constEnd(); ++change) {
+        const int row = m_rows.value(change.key(), -1);
+        // rows nobody has read yet are fetched once they are, a first fetch in flight
+        // may still carry the old values
+        if (row == -1 || !m_windows.at(row).requested) {
+            continue;
+        }
+
+        QList<int> changedRoles;
+        for (const RoleProperties &entry : roleProperties) {
+            if ((entry.properties & change->first) || (entry.properties2 & change->second)) {
+                changedRoles.append(entry.role);
+            }
+        }
+        if (!changedRoles.isEmpty()) {
+            refresh(change.key(), changedRoles);
+        }
+    }
+}
+
+void WindowModel::refresh(WId window, const QList<int> &roles)
+{
+    // the replies for one window arrive in the order of the requests, so the last
+    // refresh to finish has the newest values
+    KWindowInfo::fetch(window, windowProperties, windowProperties2).then(this, [this, window, roles](const KWindowInfo &info) {
+        const int row = m_rows.value(window, -1);
+        if (row == -1) {
+            return;
+        }
+        m_windows[row].info = info;
+        const QModelIndex changedIndex = index(row);
+        Q_EMIT dataChanged(changedIndex, changedIndex, roles);
+    });
+}
+
+void WindowModel::updateActiveWindow(WId window)
+{
+    const WId previous = std::exchange(m_activeWindow, window);
+    for (WId id : {previous, window}) {
+        if (const int row = m_rows.value(id, -1); row != -1) {
+            const QModelIndex changedIndex = index(row);
+            Q_EMIT dataChanged(changedIndex, changedIndex, {ActiveRole});
+        }
+    }
+}
+
+#include "moc_windowmodel.cpp"
@@ -0,0 +1,77 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-or-later
+*/
+
+#ifndef KWINDOWSYSTEM_QML_WINDOWMODEL_H
+#define KWINDOWSYSTEM_QML_WINDOWMODEL_H
+
+#include <QAbstractListModel>
+#include <QQmlEngine>
+
+#include <KWindowInfo>
+#include <KX11Extras>
+
+#include <optional>
+
+/*!
+ * \qmltype WindowModel
+ * \inqmlmodule org.kde.kwindowsystem
+ * \brief List of the toplevel windows managed by the X11 window manager.
+ *
+ * Rows are in the order of creation, as in KX11Extras::windows(). The model is
+ * updated incrementally: added and removed windows insert and remove single rows,
+ * property changes emit dataChanged() only for the roles that changed.
+ *
+ * The window information is requested from the X server without blocking the first
+ * time a row is read, until it arrived the roles that need it are empty. It is kept
+ * for that row, when a property of the window changes the row is fetched again. In
+ * both cases dataChanged() is emitted once the new values arrived.
+ *
+ * The model stays empty on platforms other than X11.
+ */
+class WindowModel : public QAbstractListModel
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+public:
+    enum Roles {
+        WindowIdRole = Qt::UserRole + 1,
+        NameRole,
+        WindowClassRole,
+        DesktopRole,
+        MinimizedRole,
+        PidRole,
+        ActiveRole,
+    };
+    Q_ENUM(Roles)
+
+    explicit WindowModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+private:
+    void addWindow(WId window);
+    void removeWindow(WId window);
+    void updateWindows(const QHash<WId, QPair<NET::Properties, NET::Properties2>> &changes);
+    void updateActiveWindow(WId window);
+    void refresh(WId window, const QList<int> &roles);
+
+    struct Window {
+        WId id;
+        // the properties of all roles, fetched when the row is first read
+        std::optional<KWindowInfo> info;
+        // whether the first fetch was sent
+        mutable bool requested = false;
+    };
+    QList<Window> m_windows;
+    // row of every window in m_windows
+    QHash<WId, int> m_rows;
+    WId m_activeWindow = 0;
+};
+
+#endif